@@ -1,59 +1,204 @@
 #pragma once
-#include "vector.hpp"
+#include "Linxc.h"
 #include "allocators.hpp"
 
+//size of the first chunk requested from the base allocator
+#define ARENA_DEFAULT_CHUNK_SIZE 4096
+//chunks double in size every time we run out of space, up until this size
+#define ARENA_DEFAULT_MAX_CHUNK_SIZE (1024 * 1024)
+//alignment given to every allocation made through AsAllocator(), matches what malloc guarantees
+#define ARENA_DEFAULT_ALIGNMENT 16
+
 inline void *ArenaAllocator_Allocate(void *instance, usize bytes);
 inline void ArenaAllocator_Free(void *instance, void *ptr);
 
-struct ArenaAllocator
+//A block of memory obtained from the base allocator. The usable bytes
+//follow immediately after the header.
+struct ArenaChunk
+{
+    ArenaChunk *next;
+    usize capacity;
+    usize used;
+
+    inline u8 *Data()
+    {
+        return (u8 *)(this + 1);
+    }
+};
+
+//Holds the chunk list. Lives on the heap so that ArenaAllocator can be copied
+//around by value while every copy (and every IAllocator made from it) refers to the same arena
+struct ArenaAllocatorState
 {
-    collections::vector<void*> *ptrs;
     IAllocator baseAllocator;
+    ArenaChunk *firstChunk;
+    ArenaChunk *currentChunk;
+    usize nextChunkSize;
+    usize maxChunkSize;
+
+    inline ArenaChunk *NewChunk(usize minBytes)
+    {
+        usize capacity = nextChunkSize;
+        while (capacity < minBytes)
+        {
+            capacity *= 2;
+        }
+        if (nextChunkSize < maxChunkSize)
+        {
+            nextChunkSize *= 2;
+            if (nextChunkSize > maxChunkSize)
+            {
+                nextChunkSize = maxChunkSize;
+            }
+        }
+        ArenaChunk *chunk = (ArenaChunk *)baseAllocator.Allocate(sizeof(ArenaChunk) + capacity);
+        if (chunk == NULL)
+        {
+            return NULL;
+        }
+        chunk->next = NULL;
+        chunk->capacity = capacity;
+        chunk->used = 0;
+        return chunk;
+    }
+    inline void *Allocate(usize bytes, usize alignment)
+    {
+        ArenaChunk *chunk = currentChunk;
+        while (chunk != NULL)
+        {
+            usize address = (usize)chunk->Data() + chunk->used;
+            usize padding = (alignment - (address & (alignment - 1))) & (alignment - 1);
+            if (chunk->used + padding + bytes <= chunk->capacity)
+            {
+                chunk->used += padding + bytes;
+                currentChunk = chunk;
+                return (void *)(address + padding);
+            }
+            //chunks after the current one are left over from before a Clear(),
+            //so rewind them lazily as we move onto them
+            chunk = chunk->next;
+            if (chunk != NULL)
+            {
+                chunk->used = 0;
+            }
+        }
+
+        //no existing chunk can fit this, request a new one (with enough slack to align)
+        ArenaChunk *newChunk = NewChunk(bytes + alignment);
+        if (newChunk == NULL)
+        {
+            return NULL;
+        }
+        if (currentChunk == NULL)
+        {
+            firstChunk = newChunk;
+        }
+        else
+        {
+            //insert after the current chunk so that leftover chunks can still be reused
+            newChunk->next = currentChunk->next;
+            currentChunk->next = newChunk;
+        }
+        currentChunk = newChunk;
+
+        usize address = (usize)newChunk->Data();
+        usize padding = (alignment - (address & (alignment - 1))) & (alignment - 1);
+        newChunk->used = padding + bytes;
+        return (void *)(address + padding);
+    }
+};
+
+struct ArenaAllocator
+{
+    ArenaAllocatorState *state;
 
     inline ArenaAllocator()
     {
-        ptrs = NULL; //(collections::vector<void *> *)baseAllocator.Allocate(sizeof(collections::vector<void *>)); // collections::vector<void *>();
-        //*ptrs = collections::vector<void *>();
-        baseAllocator = IAllocator();
+        state = NULL;
     }
-    inline ArenaAllocator(IAllocator base)
+    /// @brief Creates a new arena that obtains memory from base in chunks
+    /// @param initialChunkSize size of the first chunk. Each subsequent chunk doubles in size
+    /// @param maxChunkSize the size that chunk growth stops at. Allocations larger than this still get a chunk of their own
+    inline ArenaAllocator(IAllocator base, usize initialChunkSize = ARENA_DEFAULT_CHUNK_SIZE, usize maxChunkSize = ARENA_DEFAULT_MAX_CHUNK_SIZE)
     {
-        ptrs = (collections::vector<void *> *)base.Allocate(sizeof(collections::vector<void *>)); // collections::vector<void *>();
-        *ptrs = collections::vector<void *>(base);
-        this->baseAllocator = base;
+        state = (ArenaAllocatorState *)base.Allocate(sizeof(ArenaAllocatorState));
+        state->baseAllocator = base;
+        state->firstChunk = NULL;
+        state->currentChunk = NULL;
+        state->nextChunkSize = initialChunkSize > 0 ? initialChunkSize : ARENA_DEFAULT_CHUNK_SIZE;
+        state->maxChunkSize = maxChunkSize > state->nextChunkSize ? maxChunkSize : state->nextChunkSize;
     }
     inline IAllocator AsAllocator()
     {
-        return IAllocator(ptrs, &ArenaAllocator_Allocate, &ArenaAllocator_Free);
+        return IAllocator(state, &ArenaAllocator_Allocate, &ArenaAllocator_Free);
+    }
+    /// @brief Allocates memory with a specific alignment. Alignment must be a power of two
+    inline void *AllocateAligned(usize bytes, usize alignment)
+    {
+        return state->Allocate(bytes, alignment);
     }
 
+    /// @brief Rewinds the arena to the start, invalidating all prior allocations.
+    /// Chunks are kept and reused by subsequent allocations.
     inline void Clear()
     {
-        for (usize i = 0; i < this->ptrs->count; i++)
+        if (state != NULL && state->firstChunk != NULL)
         {
-            this->baseAllocator.Free(*this->ptrs->Get(i));
+            state->firstChunk->used = 0;
+            state->currentChunk = state->firstChunk;
         }
-        this->ptrs->Clear();
+    }
+    /// @brief Moves every chunk of other into this arena, so that its allocations live until this arena is deinit, then deinits other.
+    /// Both arenas must use the same base allocator
+    inline void TakeChunks(ArenaAllocator *other)
+    {
+        if (other->state == NULL)
+        {
+            return;
+        }
+        ArenaChunk *first = other->state->firstChunk;
+        if (first != NULL)
+        {
+            ArenaChunk *last = first;
+            while (last->next != NULL)
+            {
+                last = last->next;
+            }
+            //chunks go in front, where Allocate never looks for space until the next Clear()
+            last->next = state->firstChunk;
+            state->firstChunk = first;
+            if (state->currentChunk == NULL)
+            {
+                state->currentChunk = last;
+            }
+            other->state->firstChunk = NULL;
+        }
+        other->deinit();
+        other->state = NULL;
     }
     inline void deinit()
     {
-        for (usize i = 0; i < this->ptrs->count; i++)
+        if (state == NULL)
         {
-            this->baseAllocator.Free(*this->ptrs->Get(i));
+            return;
         }
-        ptrs->deinit();
-        baseAllocator.Free(ptrs);
+        IAllocator base = state->baseAllocator;
+        ArenaChunk *chunk = state->firstChunk;
+        while (chunk != NULL)
+        {
+            ArenaChunk *next = chunk->next;
+            base.Free(chunk);
+            chunk = next;
+        }
+        base.FREEPTR(state);
     }
 };
 
 void* ArenaAllocator_Allocate(void* instance, usize bytes)
 {
-    collections::vector<void *> *self = (collections::vector<void *> *)instance;
-    void* result = self->allocator.Allocate(bytes);
-    self->Add(result);
-    return result;
+    return ((ArenaAllocatorState *)instance)->Allocate(bytes, ARENA_DEFAULT_ALIGNMENT);
 }
 void ArenaAllocator_Free(void* instance, void* ptr)
 {
 
-}
\ No newline at end of file
+}
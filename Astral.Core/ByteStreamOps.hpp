@@ -1,47 +1,519 @@
+#pragma once
+#include "Linxc.h"
 #include "io.hpp"
+#include "hash.hpp"
 #include "assert.h"
+#include <string.h>
+#include <stdio.h>
 
+//bytes a ByteStreamWriter buffers before writing them to its FILE
+#define BYTESTREAM_WRITER_BLOCK_SIZE 65536
+//a u64 takes at most 10 bytes as a varint
+#define BYTESTREAM_MAX_VARINT_SIZE 10
+
+//Byte order of the multi byte values in a stream. Streams that only ever stay on the machine that wrote them can use
+//Native, anything saved for other machines should pick Little or Big
+enum ByteStreamEndian
+{
+    ByteStreamEndian_Native,
+    ByteStreamEndian_Little,
+    ByteStreamEndian_Big
+};
+inline bool ByteStream_ShouldSwap(ByteStreamEndian endian)
+{
+    return endian != ByteStreamEndian_Native && (endian == ByteStreamEndian_Little) != IsLittleEndian();
+}
+//Whether T is a single number, whose bytes can be reversed to change its byte order. Structs are not, even those the
+//size of one, as each of their fields has to be swapped on its own
+template <typename T>
+struct ByteStream_Swappable
+{
+    static const bool value = false;
+};
+#define BYTESTREAM_SWAPPABLE(type) template <> struct ByteStream_Swappable<type> { static const bool value = true; };
+BYTESTREAM_SWAPPABLE(char)
+BYTESTREAM_SWAPPABLE(bool)
+BYTESTREAM_SWAPPABLE(i8)
+BYTESTREAM_SWAPPABLE(u8)
+BYTESTREAM_SWAPPABLE(i16)
+BYTESTREAM_SWAPPABLE(u16)
+BYTESTREAM_SWAPPABLE(i32)
+BYTESTREAM_SWAPPABLE(u32)
+BYTESTREAM_SWAPPABLE(i64)
+BYTESTREAM_SWAPPABLE(u64)
+BYTESTREAM_SWAPPABLE(float)
+BYTESTREAM_SWAPPABLE(double)
+
+//reverses the bytes of a 2, 4 or 8 byte number in place, and leaves single bytes alone
+template <typename T>
+inline void ByteStream_Swap(T *value)
+{
+    assert(ByteStream_Swappable<T>::value);
+    if (sizeof(T) == 2)
+    {
+        u16 bits;
+        memcpy(&bits, value, 2);
+        bits = ByteSwapU16(bits);
+        memcpy(value, &bits, 2);
+    }
+    else if (sizeof(T) == 4)
+    {
+        u32 bits;
+        memcpy(&bits, value, 4);
+        bits = ByteSwapU32(bits);
+        memcpy(value, &bits, 4);
+    }
+    else if (sizeof(T) == 8)
+    {
+        u64 bits;
+        memcpy(&bits, value, 8);
+        bits = ByteSwapU64(bits);
+        memcpy(value, &bits, 8);
+    }
+}
+//maps signed integers to unsigned ones so that small negatives stay small as varints: 0, -1, 1, -2 become 0, 1, 2, 3
+inline u64 ByteStream_ZigZag(i64 value)
+{
+    return ((u64)value << 1) ^ (u64)(value >> 63);
+}
+inline i64 ByteStream_UnZigZag(u64 value)
+{
+    return (i64)(value >> 1) ^ -(i64)(value & 1);
+}
+
+//Reads values out of a block of memory, such as a file read with io::ReadFile or mapped with io::MapFile. Values need not be
+//aligned. Reads never go past length: the first one that would sets failed, and it and every read after it return
+//zeroes, so a whole record can be read before checking failed once
 struct ByteStreamReader
 {
     usize position;
-    u8* stream;
+    const u8 *stream;
+    usize length;
+    bool swapBytes;
+    bool failed;
 
     inline ByteStreamReader()
     {
         position = 0;
         stream = NULL;
+        length = 0;
+        swapBytes = false;
+        failed = false;
+    }
+    inline ByteStreamReader(const void *byteStream, usize streamLength, ByteStreamEndian endian = ByteStreamEndian_Native)
+    {
+        this->position = 0;
+        this->stream = (const u8 *)byteStream;
+        this->length = streamLength;
+        this->swapBytes = ByteStream_ShouldSwap(endian);
+        this->failed = false;
     }
-    inline ByteStreamReader(usize pos, u8* byteStream)
+
+    inline usize Remaining()
+    {
+        return length - position;
+    }
+    //checks that count more bytes can be read, failing the reader if not
+    inline bool Ensure(usize count)
     {
-        this->position = pos;
-        this->stream = byteStream;
+        if (failed || count > length - position)
+        {
+            failed = true;
+            return false;
+        }
+        return true;
     }
-    
+
+    //Reads a number, or a struct as its bytes. Only numbers are byte swapped, so structs must be read a field at a time
+    //on streams that are not native
     template<typename T>
     inline T Read()
     {
-        assert(stream != NULL);
-        T *ptr = (T *)&stream[position];
+        assert(!swapBytes || ByteStream_Swappable<T>::value);
+        T result;
+        if (!Ensure(sizeof(T)))
+        {
+            memset(&result, 0, sizeof(T));
+            return result;
+        }
+        memcpy(&result, stream + position, sizeof(T));
         position += sizeof(T);
-        return *ptr;
+        if (swapBytes)
+        {
+            ByteStream_Swap(&result);
+        }
+        return result;
+    }
+    inline bool ReadBytes(void *output, usize count)
+    {
+        if (!Ensure(count))
+        {
+            memset(output, 0, count);
+            return false;
+        }
+        memcpy(output, stream + position, count);
+        position += count;
+        return true;
     }
+    //Returns the next count bytes without copying them, or NULL. They point into the stream, so live as long as it does
+    inline const u8 *ReadView(usize count)
+    {
+        if (!Ensure(count))
+        {
+            return NULL;
+        }
+        const u8 *result = stream + position;
+        position += count;
+        return result;
+    }
+    //reads count values in one copy, then byte swaps them if needed
+    template<typename T>
+    inline bool ReadArray(T *output, usize count)
+    {
+        //too many for their size to fit a usize, so more than the stream holds and more than output does
+        if (count > ((usize)-1) / sizeof(T))
+        {
+            failed = true;
+            return false;
+        }
+        if (!ReadBytes(output, count * sizeof(T)))
+        {
+            return false;
+        }
+        if (swapBytes)
+        {
+            assert(ByteStream_Swappable<T>::value);
+            for (usize i = 0; i < count; i++)
+            {
+                ByteStream_Swap(&output[i]);
+            }
+        }
+        return true;
+    }
+    //LEB128: 7 bits at a time, lowest first, with the top bit set on every byte but the last
+    inline u64 ReadVarint()
+    {
+        u64 result = 0;
+        for (u32 i = 0; i < BYTESTREAM_MAX_VARINT_SIZE; i++)
+        {
+            if (!Ensure(1))
+            {
+                return 0;
+            }
+            u8 byte = stream[position];
+            position++;
+            //the 10th byte holds only bit 63
+            if (i == BYTESTREAM_MAX_VARINT_SIZE - 1 && byte > 1)
+            {
+                failed = true;
+                return 0;
+            }
+            result |= (u64)(byte & 0x7F) << (i * 7);
+            if ((byte & 0x80) == 0)
+            {
+                return result;
+            }
+        }
+        //longer than any u64
+        failed = true;
+        return 0;
+    }
+    inline i64 ReadVarintSigned()
+    {
+        return ByteStream_UnZigZag(ReadVarint());
+    }
+    //Reads a string written by ByteStreamWriter::WritePrefixedString, a varint length and then the characters.
+    //The result is null terminated, with length counting the terminator, and is empty if the reader failed
+    inline string ReadPrefixedString(IAllocator allocator)
+    {
+        usize stringLength = (usize)ReadVarint();
+        const u8 *chars = ReadView(stringLength);
+        if (chars == NULL)
+        {
+            return string();
+        }
+        return string(allocator, (const char *)chars, stringLength);
+    }
+    //reads characters up to and past a null terminator, failing if the stream ends first
     inline string ReadString(IAllocator allocator)
     {
-        assert(stream != NULL);
-        usize length = 0;
-        while (stream[position + length] != 0)
+        if (failed || position >= length)
+        {
+            failed = true;
+            return string();
+        }
+        const u8 *end = (const u8 *)memchr(stream + position, 0, length - position);
+        if (end == NULL)
         {
-            length++;
+            failed = true;
+            return string();
         }
-        string result = string(allocator, length + 1);
-        memcpy(result.buffer, &stream[position], length);
-        result.buffer[length] = '\0';
-        position += length + 1;
+        usize stringLength = (usize)(end - (stream + position));
+        string result = string(allocator, (const char *)(stream + position), stringLength);
+        position += stringLength + 1;
         return result;
     }
+    inline bool Skip(usize count)
+    {
+        if (!Ensure(count))
+        {
+            return false;
+        }
+        position += count;
+        return true;
+    }
+    //skips to the next multiple of alignment, a power of two, from the start of the stream
+    inline bool Align(usize alignment)
+    {
+        return Skip(((position + alignment - 1) & ~(alignment - 1)) - position);
+    }
 };
+
+//Writes values into a buffer, which either grows to hold the whole stream, to be taken with ToArray, or is written to a
+//FILE in blocks of BYTESTREAM_WRITER_BLOCK_SIZE whenever it fills up, so that many small values reach stdio in a few
+//large writes
 struct ByteStreamWriter
 {
-    usize position;
-    
-};
\ No newline at end of file
+    IAllocator allocator;
+    //NULL when writing to memory
+    FILE *fileStream;
+    u8 *buffer;
+    usize capacity;
+    //bytes in the buffer
+    usize length;
+    //bytes already written to fileStream, so that positions and alignment count from the start of the stream
+    usize flushed;
+    bool swapBytes;
+    //set if a write to fileStream came up short
+    bool failed;
+
+    inline ByteStreamWriter()
+    {
+        allocator = IAllocator{};
+        fileStream = NULL;
+        buffer = NULL;
+        capacity = 0;
+        length = 0;
+        flushed = 0;
+        swapBytes = false;
+        failed = false;
+    }
+    //writes to memory, growing from initialCapacity bytes as needed. See CreateForFile to write to a FILE
+    inline ByteStreamWriter(IAllocator allocator, usize initialCapacity, ByteStreamEndian endian = ByteStreamEndian_Native)
+    {
+        this->allocator = allocator;
+        this->fileStream = NULL;
+        this->capacity = initialCapacity < 16 ? 16 : initialCapacity;
+        this->buffer = (u8 *)allocator.Allocate(this->capacity);
+        this->length = 0;
+        this->flushed = 0;
+        this->swapBytes = ByteStream_ShouldSwap(endian);
+        this->failed = false;
+    }
+    //writes to a file opened in binary mode, which stays open and owned by the caller. Flush or deinit before closing it
+    inline static ByteStreamWriter CreateForFile(IAllocator allocator, FILE *fileStream, ByteStreamEndian endian = ByteStreamEndian_Native)
+    {
+        ByteStreamWriter result;
+        result.allocator = allocator;
+        result.fileStream = fileStream;
+        result.capacity = BYTESTREAM_WRITER_BLOCK_SIZE;
+        result.buffer = (u8 *)allocator.Allocate(result.capacity);
+        result.swapBytes = ByteStream_ShouldSwap(endian);
+        return result;
+    }
+    //flushes anything not yet written to the file, and frees the buffer
+    inline void deinit()
+    {
+        Flush();
+        if (buffer != NULL)
+        {
+            allocator.FREEPTR(buffer);
+        }
+        capacity = 0;
+        length = 0;
+    }
+
+    //bytes written so far, including those already flushed
+    inline usize Position()
+    {
+        return flushed + length;
+    }
+    //writes the buffer to the file. Does nothing when writing to memory
+    inline void Flush()
+    {
+        if (fileStream != NULL && length > 0)
+        {
+            if (fwrite(buffer, 1, length, fileStream) != length)
+            {
+                failed = true;
+            }
+            flushed += length;
+            length = 0;
+        }
+    }
+    inline void MakeRoom(usize count)
+    {
+        if (fileStream != NULL)
+        {
+            Flush();
+            if (count <= capacity)
+            {
+                return;
+            }
+        }
+        usize newCapacity = capacity < 16 ? 16 : capacity * 2;
+        while (newCapacity - length < count)
+        {
+            newCapacity *= 2;
+        }
+        u8 *newBuffer = (u8 *)allocator.Allocate(newCapacity);
+        if (buffer != NULL)
+        {
+            memcpy(newBuffer, buffer, length);
+            allocator.Free(buffer);
+        }
+        buffer = newBuffer;
+        capacity = newCapacity;
+    }
+    //returns space for count bytes at the end of the stream, flushing or growing the buffer as needed
+    inline u8 *Reserve(usize count)
+    {
+        if (capacity - length < count)
+        {
+            MakeRoom(count);
+        }
+        u8 *result = buffer + length;
+        length += count;
+        return result;
+    }
+
+    inline void WriteBytes(const void *data, usize count)
+    {
+        if (capacity - length < count)
+        {
+            //too big to be worth copying through the buffer
+            if (fileStream != NULL && count >= capacity)
+            {
+                Flush();
+                if (fwrite(data, 1, count, fileStream) != count)
+                {
+                    failed = true;
+                }
+                flushed += count;
+                return;
+            }
+            MakeRoom(count);
+        }
+        memcpy(buffer + length, data, count);
+        length += count;
+    }
+    //writes a number, or a struct as its bytes. Only numbers are byte swapped, see ByteStreamReader::Read
+    template<typename T>
+    inline void Write(T value)
+    {
+        assert(!swapBytes || ByteStream_Swappable<T>::value);
+        if (swapBytes)
+        {
+            ByteStream_Swap(&value);
+        }
+        memcpy(Reserve(sizeof(T)), &value, sizeof(T));
+    }
+    //writes count values in one copy, byte swapping them on the way if needed
+    template<typename T>
+    inline void WriteArray(const T *values, usize count)
+    {
+        assert(!swapBytes || ByteStream_Swappable<T>::value);
+        if (!swapBytes || sizeof(T) == 1)
+        {
+            WriteBytes(values, count * sizeof(T));
+            return;
+        }
+        for (usize i = 0; i < count; i++)
+        {
+            Write<T>(values[i]);
+        }
+    }
+    inline void WriteVarint(u64 value)
+    {
+        u8 bytes[BYTESTREAM_MAX_VARINT_SIZE];
+        usize count = 0;
+        while (value >= 0x80)
+        {
+            bytes[count] = (u8)(value | 0x80);
+            value >>= 7;
+            count++;
+        }
+        bytes[count] = (u8)value;
+        count++;
+        WriteBytes(bytes, count);
+    }
+    inline void WriteVarintSigned(i64 value)
+    {
+        WriteVarint(ByteStream_ZigZag(value));
+    }
+    //writes the characters and a null terminator, to be read with ByteStreamReader::ReadString
+    inline void WriteString(const char *chars, usize charsLength)
+    {
+        WriteBytes(chars, charsLength);
+        *Reserve(1) = 0;
+    }
+    inline void WriteString(const char *chars)
+    {
+        WriteString(chars, strlen(chars));
+    }
+    //string's length counts its terminator
+    inline void WriteString(string value)
+    {
+        WriteString(value.buffer, value.length == 0 ? 0 : value.length - 1);
+    }
+    //writes a varint length and then the characters, without a terminator, to be read with ByteStreamReader::ReadPrefixedString
+    inline void WritePrefixedString(const char *chars, usize charsLength)
+    {
+        WriteVarint(charsLength);
+        WriteBytes(chars, charsLength);
+    }
+    inline void WritePrefixedString(const char *chars)
+    {
+        WritePrefixedString(chars, strlen(chars));
+    }
+    inline void WritePrefixedString(string value)
+    {
+        WritePrefixedString(value.buffer, value.length == 0 ? 0 : value.length - 1);
+    }
+    inline void WriteZeroes(usize count)
+    {
+        memset(Reserve(count), 0, count);
+    }
+    //pads with zeroes to the next multiple of alignment, a power of two, from the start of the stream
+    inline void Align(usize alignment)
+    {
+        usize position = Position();
+        WriteZeroes(((position + alignment - 1) & ~(alignment - 1)) - position);
+    }
+    /// @brief Overwrites a value written earlier, such as a size that was not known until later
+    /// @return false if position has already been flushed to the file, or is past the end
+    template<typename T>
+    inline bool WriteAt(usize position, T value)
+    {
+        assert(!swapBytes || ByteStream_Swappable<T>::value);
+        if (position < flushed || position - flushed + sizeof(T) > length)
+        {
+            return false;
+        }
+        if (swapBytes)
+        {
+            ByteStream_Swap(&value);
+        }
+        memcpy(buffer + (position - flushed), &value, sizeof(T));
+        return true;
+    }
+    //Takes what was written to memory, owned by the writer's allocator, leaving the writer empty
+    inline collections::Array<u8> ToArray()
+    {
+        collections::Array<u8> result = collections::Array<u8>(allocator, buffer, length);
+        buffer = NULL;
+        capacity = 0;
+        length = 0;
+        return result;
+    }
+};
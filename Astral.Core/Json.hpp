@@ -7,6 +7,31 @@
 #include "stdio.h"
 #include "Maths/Util.hpp"
 #include "StringRental.hpp"
+#include "ArenaAllocator.hpp"
+#include "UTF8Utils.hpp"
+
+//objects parsed into a JsonDocument with fewer members than this are searched linearly instead of through childObjects
+#define JSON_OBJECT_MAP_THRESHOLD 8
+//bytes classified per step by JsonStructuralScanner
+#define JSON_STRUCTURAL_BLOCK 64
+//token positions a JsonTokenizer holds at once. The scanner runs ahead of the parser by at most this many
+//tokens, so the index stays in cache and never needs memory proportional to the document
+#define JSON_STRUCTURAL_WINDOW 1024
+//set on the position of a string's closing quote when the string contains a backslash
+#define JSON_STRUCTURAL_ESCAPES ((usize)1 << 63)
+//bytes a JsonWriter writing to a FILE buffers before each fwrite
+#define JSON_WRITER_BLOCK_SIZE 65536
+
+#if !defined(FORCE_NO_INTRINSICS) && defined(__AVX2__)
+#include <immintrin.h>
+#define JSON_USE_AVX2
+#elif !defined(FORCE_NO_INTRINSICS) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#include <emmintrin.h>
+#define JSON_USE_SSE2
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
 
 namespace Json
 {
@@ -55,20 +80,155 @@ namespace Json
         JsonTokenType tokenType;
         usize startIndex;
         usize endIndex;
+        //only set on string literals containing a backslash
+        bool hasEscapes;
+    };
+    /// @brief Decodes the escape sequences in the first length bytes of buffer in place, returning the decoded length.
+    /// Decoding never lengthens a string, so no allocation is needed
+    usize UnescapeJsonString(char *buffer, usize length);
+
+    enum JsonValueType
+    {
+        //not converted, such as elements built from text by hand, so the getters work from the text
+        JsonValue_None,
+        JsonValue_String,
+        JsonValue_Integer,
+        //integers above I64Max
+        JsonValue_Unsigned,
+        JsonValue_Double,
+        JsonValue_Bool,
+        JsonValue_Null
+    };
+    //A literal's value, converted once when it is parsed rather than on every access
+    struct JsonScalar
+    {
+        JsonValueType valueType;
+        union
+        {
+            i64 asInteger;
+            u64 asUnsigned;
+            double asDouble;
+            bool asBool;
+        };
+    };
+    /// @brief Parses the number in the first length characters of text, as an integer where it fits in i64 or u64
+    /// and as the nearest double otherwise
+    /// @return false if text is not a number
+    bool ParseJsonNumber(const char *text, usize length, JsonScalar *result);
+    /// @brief Converts a literal of the given token type. For JsonToken_Invalid the type is worked out from the text,
+    /// with anything that is not a bool, null or number being a string
+    JsonScalar ParseJsonScalar(JsonTokenType tokenType, const char *text, usize length);
+
+    //Finds where every token starts, JSON_STRUCTURAL_BLOCK bytes at a time with SSE2 or AVX2 where available:
+    //each { } [ ] : , outside of strings, both quotes of every string, and the first character of every other literal
+    struct JsonStructuralScanner
+    {
+        const char *contents;
+        usize length;
+        //start of the next block to classify
+        usize position;
+        //state carried from one block to the next
+        u64 nextEscaped;
+        u64 previousInString;
+        u64 previousScalar;
+        //the string still open at the end of the last block contains a backslash
+        bool pendingEscapes;
+
+        inline JsonStructuralScanner()
+        {
+            this->contents = NULL;
+            this->length = 0;
+            this->position = 0;
+            this->nextEscaped = 0;
+            this->previousInString = 0;
+            this->previousScalar = 0;
+            this->pendingEscapes = false;
+        }
+        inline JsonStructuralScanner(const char *contents, usize length)
+        {
+            this->contents = contents;
+            this->length = length;
+            this->position = 0;
+            this->nextEscaped = 0;
+            this->previousInString = 0;
+            this->previousScalar = 0;
+            this->pendingEscapes = false;
+        }
+        inline bool IsDone()
+        {
+            return position >= length;
+        }
+        /// @brief Classifies blocks for as long as their token positions are sure to fit in output.
+        /// Positions of closing quotes may have JSON_STRUCTURAL_ESCAPES set
+        /// @return the number of positions written
+        usize Scan(usize *output, usize capacity);
     };
+
     struct JsonTokenizer
     {
         const char *fileContents;
         usize length;
         usize currentIndex;
-        usize currentLine;
+        //when set, fileContents is writable and owned by a JsonDocument, and values are views into it rather than copies
+        bool inPlace;
+        //newlines in fileContents up to linesCountedTo, counted before GetView decodes any escapes there,
+        //since a decoded \n is a newline byte that was not in the source
+        usize linesCounted;
+        usize linesCountedTo;
 
+        JsonStructuralScanner scanner;
+        //positions from scanner that have yet to be read, refilled as tokens are consumed
+        usize structurals[JSON_STRUCTURAL_WINDOW];
+        usize structuralsCount;
+        usize currentStructural;
+        //PeekNext result, kept so that the following Next does not redo it
+        JsonToken peekedToken;
+        usize peekedNextStructural;
+        bool hasPeeked;
+
+        inline JsonTokenizer()
+        {
+            *this = JsonTokenizer(string());
+        }
         inline JsonTokenizer(string contents)
         {
             this->fileContents = contents.buffer;
             this->length = contents.length;
             this->currentIndex = 0;
-            this->currentLine = 0;
+            this->inPlace = false;
+            this->linesCounted = 0;
+            this->linesCountedTo = 0;
+            //length counts the null terminator
+            this->scanner = JsonStructuralScanner(contents.buffer, contents.length > 0 ? contents.length - 1 : 0);
+            this->structuralsCount = 0;
+            this->currentStructural = 0;
+            this->peekedNextStructural = 0;
+            this->hasPeeked = false;
+        }
+        //adds the newlines up to index to linesCounted, which must happen before any text there is rewritten
+        inline void CountLinesTo(usize index)
+        {
+            if (index > length)
+            {
+                index = length;
+            }
+            for (usize i = linesCountedTo; i < index; i++)
+            {
+                if (fileContents[i] == '\n')
+                {
+                    linesCounted++;
+                }
+            }
+            if (index > linesCountedTo)
+            {
+                linesCountedTo = index;
+            }
+        }
+        /// @brief Counts the lines up to the current token, for error messages
+        inline usize GetCurrentLine()
+        {
+            CountLinesTo(currentIndex);
+            return linesCounted + 1;
         }
         inline string GetString(IAllocator allocator, JsonToken token)
         {
@@ -78,50 +238,155 @@ namespace Json
             }
             return string(allocator, fileContents + token.startIndex, token.endIndex - token.startIndex);
         }
-        inline JsonToken PeekNext()
+        /// @brief Gets the token's text without copying it, only valid when inPlace.
+        /// String literals are null terminated by overwriting their closing quote and have their escapes decoded in place,
+        /// so the token must already have been consumed.
+        /// Other literals are not terminated: the delimiter after them sits where the null terminator would be
+        inline string GetView(JsonToken token)
         {
-            usize initialLine = currentLine;
-            usize initialIndex = currentIndex;
-            JsonToken result = Next();
-            currentIndex = initialIndex;
-            currentLine = initialLine;
+            char *contents = (char *)fileContents;
+            string result = string();
+            if (token.tokenType == JsonToken_StringLiteral)
+            {
+                usize stringLength = token.endIndex - token.startIndex - 2;
+                result.buffer = contents + token.startIndex + 1;
+                if (token.hasEscapes)
+                {
+                    CountLinesTo(token.endIndex);
+                    stringLength = UnescapeJsonString(result.buffer, stringLength);
+                }
+                result.buffer[stringLength] = '\0';
+                result.length = stringLength + 1;
+            }
+            else
+            {
+                result.buffer = contents + token.startIndex;
+                result.length = token.endIndex - token.startIndex + 1;
+            }
             return result;
         }
-        JsonToken Next();
+        //Reading a token looks at up to two positions: a string's closing quote, or where a literal ends
+        inline void EnsureStructurals()
+        {
+            if (structuralsCount - currentStructural >= 2 || scanner.IsDone())
+            {
+                return;
+            }
+            usize remaining = structuralsCount - currentStructural;
+            memmove(structurals, structurals + currentStructural, sizeof(usize) * remaining);
+            structuralsCount = remaining;
+            currentStructural = 0;
+            while (structuralsCount < 2 && !scanner.IsDone())
+            {
+                structuralsCount += scanner.Scan(structurals + structuralsCount, JSON_STRUCTURAL_WINDOW - structuralsCount);
+            }
+        }
+        inline JsonToken PeekNext()
+        {
+            if (!hasPeeked)
+            {
+                EnsureStructurals();
+                usize initialStructural = currentStructural;
+                usize initialIndex = currentIndex;
+                peekedToken = ReadToken();
+                peekedNextStructural = currentStructural;
+                currentStructural = initialStructural;
+                currentIndex = initialIndex;
+                hasPeeked = true;
+            }
+            return peekedToken;
+        }
+        inline JsonToken Next()
+        {
+            if (hasPeeked)
+            {
+                hasPeeked = false;
+                currentStructural = peekedNextStructural;
+                currentIndex = peekedToken.endIndex;
+                return peekedToken;
+            }
+            EnsureStructurals();
+            return ReadToken();
+        }
+        JsonToken ReadToken();
     };
+    struct JsonElement;
+    //object members are looked up with an inlined, seeded string hash rather than through function pointers
+    typedef collections::hashmap<string, JsonElement, StringHasher, StringEql> JsonObjectMap;
+
     struct JsonElement
     {
-        collections::hashmap<string, JsonElement> childObjects;
+        JsonObjectMap childObjects;
+        //array members, or object members in the order they were written
         collections::Array<JsonElement> arrayElements;
+        //for objects, the name of each member in arrayElements
+        string *keys;
+        //Copied out of the source text, or a view into it when parsed into a JsonDocument.
+        //length always counts a null terminator, but views of non-string literals are not actually terminated, see ValueEquals
         string value;
         
+        //what value holds, converted when parsed
+        JsonScalar scalar;
+        
         JsonElementType elementType;
+        //value still contains escape sequences, which GetString decodes
+        bool hasEscapes;
 
         inline JsonElement()
         {
             this->value = string();
             elementType = JsonElement_Property;
+            hasEscapes = false;
+            keys = NULL;
+            scalar.valueType = JsonValue_None;
+            scalar.asInteger = 0;
         }
         inline JsonElement(string stringValue)
         {
             this->value = stringValue;
             elementType = JsonElement_Property;
+            hasEscapes = false;
+            keys = NULL;
+            scalar.valueType = JsonValue_None;
+            scalar.asInteger = 0;
         }
-        inline JsonElement(collections::hashmap<string, JsonElement> thisChildObjects)
+        inline JsonElement(JsonObjectMap thisChildObjects)
         {
             this->childObjects = thisChildObjects;
             elementType = JsonElement_Object;
+            hasEscapes = false;
+            keys = NULL;
+            scalar.valueType = JsonValue_None;
+            scalar.asInteger = 0;
         }
         inline JsonElement(collections::Array<JsonElement> childElements)
         {
             this->arrayElements = childElements;
             elementType = JsonElement_Array;
+            hasEscapes = false;
+            keys = NULL;
+            scalar.valueType = JsonValue_None;
+            scalar.asInteger = 0;
+        }
+        //compares by length rather than with strcmp, as values parsed in place are not null terminated
+        inline bool ValueEquals(const char *literal)
+        {
+            usize literalLength = strlen(literal);
+            return value.buffer != NULL && value.length == literalLength + 1 && memcmp(value.buffer, literal, literalLength) == 0;
         }
         
+        //The converted value. Strings and elements that were not parsed are converted from their text each time,
+        //so that numbers, bools and null written as strings read as them like they always have
+        inline JsonScalar GetScalar()
+        {
+            if (scalar.valueType == JsonValue_None || scalar.valueType == JsonValue_String)
+            {
+                return ParseJsonScalar(JsonToken_Invalid, value.buffer, value.buffer == NULL ? 0 : value.length - 1);
+            }
+            return scalar;
+        }
         inline JsonTokenType CheckElementType()
         {
-            JsonTokenType tokenType = JsonToken_IntegerLiteral;
-
             if (this->elementType == JsonElement_Array)
             {
                 return JsonToken_LBracket;
@@ -130,53 +395,20 @@ namespace Json
             {
                 return JsonToken_LBrace;
             }
-            //this is not possible unless we are a string "" so
-            if (this->value.length == 0)
-            {
-                return JsonToken_StringLiteral;
-            }
-            else
-            {
-                for (usize i = 0; i < this->value.length - 1; i++)
-                {
-                    if (!isdigit(this->value.buffer[i]))
-                    {
-                        if (this->value.buffer[i] == '.')
-                        {
-                            if (tokenType == JsonToken_FloatLiteral)
-                            {
-                                tokenType = JsonToken_StringLiteral;
-                            }
-                            else
-                            {
-                                tokenType = JsonToken_FloatLiteral;
-                            }
-                        }
-                        else if (this->value.buffer[i] == '-' && i > 0)
-                        {
-                            tokenType = JsonToken_StringLiteral;
-                            break;
-                        }
-                        else if (this->value.buffer[i] != '-')
-                        {
-                            tokenType = JsonToken_StringLiteral;
-                            break;
-                        }
-                    }
-                }
-            }
-            if (tokenType == JsonToken_StringLiteral)
+            switch (GetScalar().valueType)
             {
-                if (value == "true" || value == "false")
-                {
-                    tokenType = JsonToken_BoolLiteral;
-                }
-                else if (value == "null")
-                {
-                    tokenType = JsonToken_NullLiteral;
-                }
+                case JsonValue_Integer:
+                case JsonValue_Unsigned:
+                    return JsonToken_IntegerLiteral;
+                case JsonValue_Double:
+                    return JsonToken_FloatLiteral;
+                case JsonValue_Bool:
+                    return JsonToken_BoolLiteral;
+                case JsonValue_Null:
+                    return JsonToken_NullLiteral;
+                default:
+                    return JsonToken_StringLiteral;
             }
-            return tokenType;
         }
         inline void GetInteger(void* output, JsonIntegerType* type)
         {
@@ -184,18 +416,29 @@ namespace Json
             {
                 return;
             }
+            JsonScalar number = GetScalar();
+            bool negative = false;
             u64 result = 0;
-            u64 index = 1;
-            for (i64 i = value.length - 1; i >= 0; i--)
+            switch (number.valueType)
             {
-                if (value.buffer[i] >= '0' && value.buffer[i] <= '9')
-                {
-                    u64 amount = index * (value.buffer[i] - (u64)'0');
-                    result += amount;
-                    index *= 10;
-                }
+                case JsonValue_Integer:
+                    negative = number.asInteger < 0;
+                    result = negative ? (u64)0 - number.asUnsigned : number.asUnsigned;
+                    break;
+                case JsonValue_Unsigned:
+                    result = number.asUnsigned;
+                    break;
+                case JsonValue_Double:
+                    negative = number.asDouble < 0.0;
+                    result = (u64)(negative ? -number.asDouble : number.asDouble);
+                    break;
+                case JsonValue_Bool:
+                    result = number.asBool ? 1 : 0;
+                    break;
+                default:
+                    break;
             }
-            if (value.buffer[0] == '-')
+            if (negative)
             {
                 if (result < I8Max)
                 {
@@ -254,51 +497,53 @@ namespace Json
                 }
             }
         }
-        inline i32 GetInt32()
+        inline i64 GetInt64()
         {
             if (elementType != JsonElement_Property)
             {
                 return 0;
             }
-
-            i32 result = 0;
-            i32 index = 1;
-            for (i64 i = value.length - 1; i >= 0; i--)
+            JsonScalar number = GetScalar();
+            switch (number.valueType)
             {
-                if (value.buffer[i] >= '0' && value.buffer[i] <= '9')
-                {
-                    i32 amount = index * (value.buffer[i] - (i32)'0');
-                    result += amount;
-                    index *= 10;
-                }
-                else if (value.buffer[i] == '-' && i == 0)
-                {
-                    result *= -1;
-                }
+                case JsonValue_Integer:
+                case JsonValue_Unsigned:
+                    return number.asInteger;
+                case JsonValue_Double:
+                    return (i64)number.asDouble;
+                case JsonValue_Bool:
+                    return number.asBool ? 1 : 0;
+                default:
+                    return 0;
             }
-
-            return result;
         }
-        inline u32 GetUint32()
+        inline u64 GetUint64()
         {
             if (elementType != JsonElement_Property)
             {
                 return 0;
             }
-
-            u32 result = 0;
-            u32 index = 1;
-            for (i64 i = value.length - 1; i >= 0; i--)
+            JsonScalar number = GetScalar();
+            switch (number.valueType)
             {
-                if (value.buffer[i] >= '0' && value.buffer[i] <= '9')
-                {
-                    u32 amount = index * (value.buffer[i] - (u32)'0');
-                    result += amount;
-                    index *= 10;
-                }
+                case JsonValue_Integer:
+                case JsonValue_Unsigned:
+                    return number.asUnsigned;
+                case JsonValue_Double:
+                    return (u64)number.asDouble;
+                case JsonValue_Bool:
+                    return number.asBool ? 1 : 0;
+                default:
+                    return 0;
             }
-
-            return result;
+        }
+        inline i32 GetInt32()
+        {
+            return (i32)GetInt64();
+        }
+        inline u32 GetUint32()
+        {
+            return (u32)GetUint64();
         }
         inline bool GetBool()
         {
@@ -306,22 +551,12 @@ namespace Json
             {
                 return false;
             }
-
-            if (value == "true")
-            {
-                return true;
-            }
-            return false;
+            JsonScalar boolean = GetScalar();
+            return boolean.valueType == JsonValue_Bool && boolean.asBool;
         }
         inline float GetFloat()
         {
-            if (elementType != JsonElement_Property)
-            {
-                return 0.0f;
-            }
-            double result = atof(value.buffer);
-
-            return (float)result;
+            return (float)GetDouble();
         }
         inline double GetDouble()
         {
@@ -329,9 +564,20 @@ namespace Json
             {
                 return 0.0;
             }
-            double result = atof(value.buffer);
-
-            return result;
+            JsonScalar number = GetScalar();
+            switch (number.valueType)
+            {
+                case JsonValue_Integer:
+                    return (double)number.asInteger;
+                case JsonValue_Unsigned:
+                    return (double)number.asUnsigned;
+                case JsonValue_Double:
+                    return number.asDouble;
+                case JsonValue_Bool:
+                    return number.asBool ? 1.0 : 0.0;
+                default:
+                    return 0.0;
+            }
         }
         #ifdef VEC2_H
         inline Maths::Vec2 GetVec2()
@@ -368,39 +614,21 @@ namespace Json
         #endif
         inline string GetString(IAllocator allocator)
         {
-            collections::vector<CharSlice> charSlices = collections::vector<CharSlice>(GetCAllocator());
-            usize start = 0;
-            for (usize i = 0; i < value.length - 1; i++)
+            if (value.buffer == NULL)
             {
-                if (value.buffer[i] == '\\' && i < value.length - 2)
-                {
-                    if (value.buffer[i + 1] == '\"')
-                    {
-                        charSlices.Add(CharSlice(value.buffer + start, i - start));
-                        charSlices.Add(CharSlice("\""));
-                        i++;
-                        start = i + 1;
-                    }
-                    else if (value.buffer[i + 1] == 'n')
-                    {
-                        charSlices.Add(CharSlice(value.buffer + start, i - start));
-                        charSlices.Add(CharSlice("\n"));
-                        i++;
-                        start = i + 1;
-                    }
-                }
+                return string(allocator);
             }
-            if (start < value.length - 1)
+            string result = string(allocator, value.buffer, value.length - 1);
+            if (hasEscapes)
             {
-                charSlices.Add(CharSlice(value.buffer + start, value.length - 1 - start));
+                result.length = UnescapeJsonString(result.buffer, result.length - 1) + 1;
+                result.buffer[result.length - 1] = '\0';
             }
-            string result = ConcatFromCharSlices(allocator, charSlices.ptr, charSlices.count);
-            charSlices.deinit();
             return result;
         }
         inline string GetStringRaw(IAllocator allocator)
         {
-            return string(allocator, value.buffer);
+            return string(allocator, value.buffer, value.length - 1);
         }
         template<typename T>
         inline T GetBytesAsT()
@@ -414,10 +642,26 @@ namespace Json
             }
             return result;
         }
+        //searches from the back so that duplicate keys resolve to the last one, as they do in childObjects
+        inline JsonElement *FindPropertyLinear(const char *name, usize nameLength)
+        {
+            for (usize i = arrayElements.length; i > 0; i--)
+            {
+                if (keys[i - 1].length == nameLength + 1 && memcmp(keys[i - 1].buffer, name, nameLength) == 0)
+                {
+                    return &arrayElements.data[i - 1];
+                }
+            }
+            return NULL;
+        }
         inline JsonElement *GetProperty(string propertyName)
         {
             if (this->elementType == JsonElement_Object)
             {
+                if (childObjects.entries == NULL && keys != NULL)
+                {
+                    return FindPropertyLinear(propertyName.buffer, propertyName.length - 1);
+                }
                 return childObjects.Get(propertyName);
             }
             return NULL;
@@ -426,6 +670,10 @@ namespace Json
         {
             if (this->elementType == JsonElement_Object)
             {
+                if (childObjects.entries == NULL && keys != NULL)
+                {
+                    return FindPropertyLinear(ptr, strlen(ptr));
+                }
                 IAllocator allocator = GetCAllocator();
                 JsonElement *result;
                 if (stringRentalBuffer == NULL)
@@ -450,13 +698,32 @@ namespace Json
         collections::Array<u8> GetAsRawData(IAllocator allocator);
         void DumpJsonToStdout(i32 indents);
     };
+    //Members of the arrays and objects being parsed, shared down the whole parse so that each container
+    //makes one allocation for its final members rather than growing a vector of its own
+    struct JsonParseStack
+    {
+        collections::vector<JsonElement> elements;
+        collections::vector<string> keys;
+
+        inline JsonParseStack(IAllocator allocator)
+        {
+            this->elements = collections::vector<JsonElement>(allocator);
+            this->keys = collections::vector<string>(allocator);
+        }
+        inline void deinit()
+        {
+            elements.deinit();
+            keys.deinit();
+        }
+    };
     bool ParseJsonElement(IAllocator allocator, JsonTokenizer *tokenizer, JsonElement *result);
+    bool ParseJsonElement(IAllocator allocator, JsonTokenizer *tokenizer, JsonParseStack *stack, JsonElement *result);
     inline usize ParseJsonDocument(IAllocator allocator, string contents, JsonElement* result)
     {
         JsonTokenizer tokenizer = JsonTokenizer(contents);
         if (!ParseJsonElement(allocator, &tokenizer, result))
         {
-            return tokenizer.currentLine;
+            return tokenizer.GetCurrentLine();
         }
         return 0;
     }
@@ -476,39 +743,236 @@ namespace Json
         return parseResult;
     }
 
+    //Owns the source text and everything parsed from it. Keys and values in the tree are views into
+    //the source text rather than copies, so the tree is only valid until the document is deinit
+    struct JsonDocument
+    {
+        ArenaAllocator arena;
+        string contents;
+        JsonElement root;
+        //line of the first syntax error, or 0 if parsing succeeded
+        usize errorLine;
+
+        inline JsonDocument()
+        {
+            arena = ArenaAllocator();
+            contents = string();
+            root = JsonElement();
+            errorLine = 0;
+        }
+        inline void deinit()
+        {
+            arena.deinit();
+            contents.deinit();
+            root = JsonElement();
+        }
+    };
+    /// @brief Parses contents without copying any keys or values out of it. The document takes ownership of contents,
+    /// which must be null terminated and is modified in place. Elements are allocated from an arena using allocator
+    /// @return Whether parsing succeeded. On failure, result->errorLine holds the line of the error
+    inline bool ParseJsonDocumentInPlace(IAllocator allocator, string contents, JsonDocument *result)
+    {
+        *result = JsonDocument();
+        result->arena = ArenaAllocator(allocator);
+        result->contents = contents;
+
+        JsonTokenizer tokenizer = JsonTokenizer(contents);
+        tokenizer.inPlace = true;
+        if (!ParseJsonElement(result->arena.AsAllocator(), &tokenizer, &result->root))
+        {
+            result->errorLine = tokenizer.GetCurrentLine();
+            return false;
+        }
+        return true;
+    }
+    inline bool ReadJsonDocument(IAllocator allocator, const char *fileFullPath, JsonDocument *result)
+    {
+        string fileContents = io::ReadFile(allocator, fileFullPath, false);
+        if (fileContents.buffer == NULL)
+        {
+            *result = JsonDocument();
+            return false;
+        }
+        return ParseJsonDocumentInPlace(allocator, fileContents, result);
+    }
+
+    enum JsonEventType
+    {
+        JsonEvent_Error,
+        JsonEvent_StartObject,
+        JsonEvent_EndObject,
+        JsonEvent_StartArray,
+        JsonEvent_EndArray,
+        JsonEvent_Key,
+        JsonEvent_Value,
+        JsonEvent_EndOfInput
+    };
+    struct JsonEvent
+    {
+        JsonEventType eventType;
+        //for JsonEvent_Value, whether value is a string, number, bool or null
+        JsonTokenType valueType;
+        //Key or value text, a view into the reader's buffer that is only valid until its next call.
+        //Strings are unescaped and null terminated, other literals are bounded by length like the views in a JsonDocument
+        string value;
+
+        //converts value, which is left to the caller so that values it skips over cost nothing
+        inline JsonScalar GetScalar()
+        {
+            return ParseJsonScalar(valueType, value.buffer, value.buffer == NULL ? 0 : value.length - 1);
+        }
+    };
+    //what a JsonReader expects the next token to be
+    enum JsonReaderState
+    {
+        JsonReaderState_Value,
+        JsonReaderState_FirstArrayValue,
+        JsonReaderState_FirstKey,
+        JsonReaderState_Key,
+        JsonReaderState_Colon,
+        JsonReaderState_AfterValue,
+        JsonReaderState_Failed
+    };
+    //reads up to count bytes into buffer, returning 0 once there are none left
+    def_delegate(JsonReadFunc, usize, void *, char *, usize);
+
+    //Parses JSON as a stream of events, reading its input in chunks so that only the token being read and
+    //whatever has been pinned by ReadElement need to be in memory at once.
+    //Several top level values one after the other, as in JSON lines files, are read in turn
+    struct JsonReader
+    {
+        IAllocator allocator;
+        JsonReadFunc readFunc;
+        void *userData;
+
+        //holds the unread part of the input, with a null terminator after bufferLength
+        char *buffer;
+        usize bufferCapacity;
+        usize bufferLength;
+        bool endOfInput;
+        //lines in the input that has already been dropped from buffer
+        usize linesDiscarded;
+        //start of the subtree being read by ReadElement, which must be kept in buffer
+        usize pinnedStart;
+        bool pinned;
+
+        JsonTokenizer tokenizer;
+        //objects and arrays entered but not yet left, as JsonEvent_StartObject or JsonEvent_StartArray
+        collections::vector<JsonEventType> containers;
+        JsonReaderState state;
+        JsonEventType lastEvent;
+        usize lastTokenStart;
+
+        JsonReader();
+        /// @brief Creates a reader that calls readFunc for chunkSize bytes of input at a time.
+        /// chunkSize is rounded up to a whole number of scanner blocks, and the buffer grows if a single token needs more
+        JsonReader(IAllocator allocator, JsonReadFunc readFunc, void *userData, usize chunkSize);
+        //Reads from a file opened with fopen, which is not closed by the reader
+        static JsonReader FromFile(IAllocator allocator, FILE *file, usize chunkSize);
+        //Reads from a file descriptor, which is not closed by the reader
+        static JsonReader FromFileDescriptor(IAllocator allocator, i32 fileDescriptor, usize chunkSize);
+        void deinit();
+
+        JsonEvent Next();
+        /// @brief After JsonEvent_StartObject or JsonEvent_StartArray, skips past the end of that container.
+        /// After JsonEvent_Key, skips that key's value. Skipped containers are only checked for balanced brackets
+        /// @return false if there was nothing to skip or the input ended first
+        bool Skip();
+        /// @brief Like Skip, but parses what would have been skipped into result, copying it with allocator.
+        /// Only the skipped text is held in memory at once, so records can be read one at a time out of a larger file
+        bool ReadElement(IAllocator elementAllocator, JsonElement *result);
+        //line of the last token read, which after an error is where it was found
+        inline usize GetCurrentLine()
+        {
+            return linesDiscarded + tokenizer.GetCurrentLine();
+        }
+
+        void Refill();
+        void EnsureTokens();
+        JsonEvent Fail();
+        bool SkipContainer();
+    };
+
+    //receives count bytes of a JsonWriter's output each time its buffer fills up or is flushed
+    def_delegate(JsonWriteFunc, void, void *, const char *, usize);
+
+    //Writes JSON text into a buffer, which either grows to hold the whole document (see ToMemory) or is handed
+    //to a JsonWriteFunc in blocks whenever it fills up, so output reaches stdio in a few large writes
     struct JsonWriter
     {
+        IAllocator allocator;
+        //NULL when writing to memory
+        JsonWriteFunc writeFunc;
+        void *userData;
+        //only set when writing to a FILE, for SaveAndCloseFile
         FILE *stream;
+
+        char *buffer;
+        usize bufferCapacity;
+        usize bufferLength;
+
         JsonTokenType previousToken;
         collections::vector<JsonTokenType> indentTypes;
         bool shouldIndent;
         bool isBinary;
 
-        inline JsonWriter(IAllocator allocator, FILE *fileStream, bool writerShouldIndent)
-        {
-            stream = fileStream;
-            previousToken = JsonToken_Invalid;
-            shouldIndent = writerShouldIndent;
-            indentTypes = collections::vector<JsonTokenType>(allocator);
-            isBinary = false;
-        }
+        JsonWriter();
+        //Writes to a file opened with fopen in blocks of JSON_WRITER_BLOCK_SIZE
+        JsonWriter(IAllocator allocator, FILE *fileStream, bool writerShouldIndent);
+        //Calls writeFunc with blockSize bytes of output at a time, and once more with the rest on Flush or deinit
+        JsonWriter(IAllocator allocator, JsonWriteFunc writeFunc, void *userData, usize blockSize, bool writerShouldIndent);
+        //Keeps the whole document in memory, to be taken with TakeString once written
+        static JsonWriter ToMemory(IAllocator allocator, usize initialCapacity, bool writerShouldIndent);
+
         inline void SaveAndCloseFile()
         {
+            Flush();
             fflush(stream);
             fclose(stream);
+            stream = NULL;
         }
-        inline void deinit()
+        //flushes anything not yet handed to writeFunc
+        void deinit();
+        //hands everything buffered so far to writeFunc. Does nothing when writing to memory
+        void Flush();
+        //Takes the text written so far, null terminated and owned by the writer's allocator, leaving the buffer empty
+        string TakeString();
+
+        //returns space for length bytes at the end of the buffer, flushing or growing it as needed
+        inline char *Reserve(usize length)
         {
-            indentTypes.deinit();
+            if (bufferCapacity - bufferLength < length)
+            {
+                MakeRoom(length);
+            }
+            char *result = buffer + bufferLength;
+            bufferLength += length;
+            return result;
         }
-        inline void WriteIndents()
+        inline void Write(const char *chars, usize length)
         {
-            if (shouldIndent)
+            if (bufferCapacity - bufferLength < length)
             {
-                for (usize i = 0; i < indentTypes.count; i++)
+                if (writeFunc != NULL && length >= bufferCapacity)
                 {
-                    fprintf(stream, " ");
+                    Flush();
+                    writeFunc(userData, chars, length);
+                    return;
                 }
+                MakeRoom(length);
+            }
+            memcpy(buffer + bufferLength, chars, length);
+            bufferLength += length;
+        }
+        void MakeRoom(usize length);
+        //writes chars in quotes, copying the runs between characters that need escaping in one go
+        void WriteQuoted(const char *chars, usize length);
+
+        inline void WriteIndents()
+        {
+            if (shouldIndent && indentTypes.count > 0)
+            {
+                memset(Reserve(indentTypes.count), ' ', indentTypes.count);
             }
         }
         inline JsonTokenType LatestIndentType()
@@ -535,17 +999,17 @@ namespace Json
                 {
                     if (previousToken == JsonToken_PropertyName)
                     {
-                        fprintf(stream, ":\n");
+                        Write(":\n", 2);
                     }
                     else if (previousToken != JsonToken_LBracket)
                     {
-                        fprintf(stream, ",\n");
+                        Write(",\n", 2);
                     }
                     else
-                        fprintf(stream, "\n");
+                        Write("\n", 1);
                 }
                 WriteIndents();
-                fprintf(stream, "{");
+                Write("{", 1);
                 previousToken = JsonToken_LBrace;
                 indentTypes.Add(JsonToken_LBrace);
                 return true;
@@ -553,6 +1017,10 @@ namespace Json
             return false;
         }
         inline bool WritePropertyName(const char* chars)
+        {
+            return WritePropertyName(chars, strlen(chars));
+        }
+        inline bool WritePropertyName(const char* chars, usize length)
         {
             if (
             previousToken == JsonToken_LBrace || 
@@ -566,145 +1034,111 @@ namespace Json
             {
                 if (previousToken != JsonToken_LBrace)
                 {
-                    fprintf(stream, ",\n");
+                    Write(",\n", 2);
                 }
                 else
-                    fprintf(stream, "\n");
+                    Write("\n", 1);
                 WriteIndents();
-                fprintf(stream, "\"%s\"", chars);
+                WriteQuoted(chars, length);
                 previousToken = JsonToken_PropertyName;
                 return true;
             }
             return false;
         }
-        inline bool WriteIntValue(i64 value)
+        //writes the separator before a value, returning false if a value cannot go here
+        inline bool WriteValueSeparator()
         {
+            //the document itself, which needs no separator
+            if (previousToken == JsonToken_Invalid)
+            {
+                return true;
+            }
             if (previousToken == JsonToken_PropertyName)
             {
-                fprintf(stream, ": %lli", value);
-                previousToken = JsonToken_IntegerLiteral;
+                Write(": ", 2);
                 return true;
             }
             else if (LatestIndentType() == JsonToken_LBracket)
             {
                 if (previousToken != JsonToken_LBracket)
                 {
-                    fprintf(stream, ", ");
+                    Write(", ", 2);
                 }
-                fprintf(stream, "%lli", value);
-                previousToken = JsonToken_IntegerLiteral;
                 return true;
             }
             return false;
         }
-        inline bool WriteUintValue(u64 value)
+        //writes already formatted number text wherever a value may go
+        inline bool WriteNumberText(const char *chars, usize length, JsonTokenType tokenType)
         {
-            if (previousToken == JsonToken_PropertyName)
-            {
-                fprintf(stream, ": %llu", value);
-                previousToken = JsonToken_IntegerLiteral;
-                return true;
-            }
-            else if (LatestIndentType() == JsonToken_LBracket)
+            if (!WriteValueSeparator())
             {
-                if (previousToken != JsonToken_LBracket)
-                {
-                    fprintf(stream, ", ");
-                }
-                fprintf(stream, "%llu", value);
-                previousToken = JsonToken_IntegerLiteral;
-                return true;
+                return false;
             }
-            return false;
+            Write(chars, length);
+            previousToken = tokenType;
+            return true;
+        }
+        inline bool WriteIntValue(i64 value)
+        {
+            char chars[NUMBER_FORMAT_MAX_INTEGER_LENGTH];
+            return WriteNumberText(chars, FormatI64(chars, value), JsonToken_IntegerLiteral);
         }
+        inline bool WriteUintValue(u64 value)
+        {
+            char chars[NUMBER_FORMAT_MAX_INTEGER_LENGTH];
+            return WriteNumberText(chars, FormatU64(chars, value), JsonToken_IntegerLiteral);
+        }
+        //JSON has no infinity or NaN, so those are written as null
         inline bool WriteFloat(double value)
         {
-            if (previousToken == JsonToken_PropertyName)
+            if (!isfinite(value))
             {
-                fprintf(stream, ": %f", value);
-                previousToken = JsonToken_FloatLiteral;
-                return true;
+                return WriteNumberText("null", 4, JsonToken_NullLiteral);
             }
-            else if (LatestIndentType() == JsonToken_LBracket)
+            char chars[NUMBER_FORMAT_MAX_FLOAT_LENGTH];
+            return WriteNumberText(chars, FormatDouble(chars, value), JsonToken_FloatLiteral);
+        }
+        //writes the shortest text for the float itself rather than for its widened double
+        inline bool WriteFloat(float value)
+        {
+            if (!isfinite(value))
             {
-                if (previousToken != JsonToken_LBracket)
-                {
-                    fprintf(stream, ", ");
-                }
-                fprintf(stream, "%f", value);
-                previousToken = JsonToken_FloatLiteral;
-                return true;
+                return WriteNumberText("null", 4, JsonToken_NullLiteral);
             }
-            return false;
+            char chars[NUMBER_FORMAT_MAX_FLOAT_LENGTH];
+            return WriteNumberText(chars, FormatFloat(chars, value), JsonToken_FloatLiteral);
         }
         inline bool WriteBool(bool value)
         {
-            if (previousToken == JsonToken_PropertyName)
+            return value ? WriteNumberText("true", 4, JsonToken_BoolLiteral) : WriteNumberText("false", 5, JsonToken_BoolLiteral);
+        }
+        inline bool WriteString(const char* value)
+        {
+            return WriteString(value, strlen(value));
+        }
+        inline bool WriteString(const char* value, usize length)
+        {
+            if (!WriteValueSeparator())
             {
-                fprintf(stream, ": %s", value ? "true" : "false");
-                previousToken = JsonToken_BoolLiteral;
-                return true;
-            }
-            else if (LatestIndentType() == JsonToken_LBracket)
-            {
-                if (previousToken != JsonToken_LBracket)
-                {
-                    fprintf(stream, ", ");
-                }
-                fprintf(stream, "%s", value ? "true" : "false");
-                previousToken = JsonToken_BoolLiteral;
-                return true;
-            }
-            return false;
-        }
-        inline bool WriteString(const char* value)
-        {
-            if (previousToken == JsonToken_PropertyName)
-            {
-                fprintf(stream, ": \"%s\"", value);
-                previousToken = JsonToken_StringLiteral;
-                return true;
-            }
-            else if (LatestIndentType() == JsonToken_LBracket)
-            {
-                if (previousToken != JsonToken_LBracket)
-                {
-                    fprintf(stream, ", ");
-                }
-                fprintf(stream, "\"%s\"", value);
-                previousToken = JsonToken_StringLiteral;
-                return true;
+                return false;
             }
-            return false;
+            WriteQuoted(value, length);
+            previousToken = JsonToken_StringLiteral;
+            return true;
         }
         inline bool WriteNull()
         {
-            if (previousToken == JsonToken_PropertyName)
-            {
-                fprintf(stream, ": null");
-                previousToken = JsonToken_NullLiteral;
-                return true;
-            }
-            else if (LatestIndentType() == JsonToken_LBracket)
-            {
-                if (previousToken != JsonToken_LBracket)
-                {
-                    fprintf(stream, ", ");
-                }
-                fprintf(stream, "null");
-                previousToken = JsonToken_NullLiteral;
-                return true;
-            }
-            return false;
+            return WriteNumberText("null", 4, JsonToken_NullLiteral);
         }
         inline bool WriteEndObject()
         {
             if (LatestIndentType() == JsonToken_LBrace)
             {
-                fprintf(stream, "\n");
+                Write("\n", 1);
                 indentTypes.RemoveAt_Swap(indentTypes.count - 1);
                 WriteIndents();
-                fprintf(stream, "}");
+                Write("}", 1);
                 previousToken = JsonToken_RBrace;
                 return true;
             }
@@ -712,21 +1146,14 @@ namespace Json
         }
         inline bool WriteStartArray()
         {
-            if (previousToken == JsonToken_PropertyName)
-            {
-                fprintf(stream, ": [");
-                previousToken = JsonToken_LBracket;
-                indentTypes.Add(JsonToken_LBracket);
-                return true;
-            }
-            else if (LatestIndentType() == JsonToken_LBracket)
+            if (!WriteValueSeparator())
             {
-                fprintf(stream, ", [");
-                previousToken = JsonToken_LBracket;
-                indentTypes.Add(JsonToken_LBracket);
-                return true;
+                return false;
             }
-            return false;
+            Write("[", 1);
+            previousToken = JsonToken_LBracket;
+            indentTypes.Add(JsonToken_LBracket);
+            return true;
         }
         inline bool WriteEndArray()
         {
@@ -735,10 +1162,10 @@ namespace Json
                 indentTypes.RemoveAt_Swap(indentTypes.count - 1);
                 if (previousToken == JsonToken_RBrace)
                 {
-                    fprintf(stream, "\n");
+                    Write("\n", 1);
                     WriteIndents();
                 }
-                fprintf(stream, "]");
+                Write("]", 1);
                 previousToken = JsonToken_RBracket;
                 return true;
             }
@@ -774,46 +1201,45 @@ collections::Array<u8> Json::JsonElement::GetAsRawData(IAllocator allocator)
     }
     else if (this->elementType == JsonElement_Property)
     {
-        //have to check the string to know if it's a integer, float or string
-        if (this->value == "true")
+        JsonScalar converted = GetScalar();
+        switch (converted.valueType)
         {
-            results.Add(1);
-        }
-        else if (this->value == "false" || this->value == "null")
-        {
-            results.Add(0);
-        }
-        else
-        {
-            // reuse tokenType;
-            Json::JsonTokenType tokenType = this->CheckElementType();
-
-            if (tokenType == JsonToken_BoolLiteral)
+            case JsonValue_Bool:
+            {
+                results.Add(converted.asBool ? 1 : 0);
+                break;
+            }
+            case JsonValue_Null:
             {
-                results.Add(this->value == "true" ? 1 : 0);
+                results.Add(0);
+                break;
             }
-            if (tokenType == JsonToken_FloatLiteral)
+            case JsonValue_Double:
             {
-                float parsed = atof(this->value.buffer);
+                float parsed = (float)converted.asDouble;
                 for (i32 i = 0; i < 4; i++)
                 {
                     results.Add(((u8*)&parsed)[i]);
                 }
+                break;
             }
-            else if (tokenType == JsonToken_IntegerLiteral)
+            case JsonValue_Integer:
+            case JsonValue_Unsigned:
             {
-                i32 integer = atoi(this->value.buffer);
+                i32 integer = (i32)converted.asInteger;
                 for (i32 i = 0; i < 4; i++)
                 {
                     results.Add(((u8*)&integer)[i]);
                 }
+                break;
             }
-            else
+            default:
             {
                 for (i32 i = 0; i < sizeof(char *); i++)
                 {
                     results.Add(0);
                 }
+                break;
             }
         }
     }
@@ -823,7 +1249,7 @@ void Json::JsonElement::DumpJsonToStdout(i32 indents)
 {
     if (this->elementType == JsonElement_Property)
     {
-        printf("%s", this->value.buffer);
+        printf("%.*s", (i32)this->value.length - 1, this->value.buffer);
     }
     else if (this->elementType == JsonElement_Array)
     {
@@ -834,19 +1260,19 @@ void Json::JsonElement::DumpJsonToStdout(i32 indents)
         }
         for (usize i = 0; i < this->arrayElements.length; i++)
         {
-            for (usize c = 0; c < indents + 1; c++)
+            for (i32 c = 0; c < indents + 1; c++)
             {
                 printf(" ");
             }
             this->arrayElements.data[i].DumpJsonToStdout(indents + 1);
-            if (i < (i32)this->arrayElements.length - 1)
+            if (i + 1 < this->arrayElements.length)
             {
                 printf(",\n");
             }
             else
                 printf("\n");
         }
-        for (usize c = 0; c < indents; c++)
+        for (i32 c = 0; c < indents; c++)
         {
             printf(" ");
         }
@@ -855,225 +1281,1439 @@ void Json::JsonElement::DumpJsonToStdout(i32 indents)
     else
     {
         printf("{\n");
-        usize iterated = 0;
-        for (usize i = 0; i < this->childObjects.bucketsCount; i++)
+        for (usize i = 0; i < this->arrayElements.length; i++)
         {
-            if (this->childObjects.buckets[i].initialized)
+            for (i32 c = 0; c < indents + 1; c++)
             {
-                for (usize j = 0; j < this->childObjects.buckets[i].entries.count; j++)
-                {
-                    for (usize c = 0; c < indents + 1; c++)
-                    {
-                        printf(" ");
-                    }
-                        printf("%s: ", this->childObjects.buckets[i].entries.ptr[j].key.buffer);
-                    this->childObjects.buckets[i].entries.ptr[j].value.DumpJsonToStdout(indents + 1);
-                    if (iterated < this->childObjects.count - 1)
-                    {
-                        printf(",\n");
-                    }
-                    else printf("\n");
-                    iterated++;
-                }
+                printf(" ");
+            }
+            printf("%s: ", this->keys[i].buffer);
+            this->arrayElements.data[i].DumpJsonToStdout(indents + 1);
+            if (i < this->arrayElements.length - 1)
+            {
+                printf(",\n");
             }
+            else printf("\n");
         }
-        for (usize c = 0; c < indents; c++)
+        for (i32 c = 0; c < indents; c++)
         {
             printf(" ");
         }
         printf("}");
     }
 }
-Json::JsonToken Json::JsonTokenizer::Next()
+//value of a hex digit, or -1
+inline i32 Json_HexDigit(char c)
 {
-    JsonToken result;
-    result.tokenType = JsonToken_Invalid;
-
-    while (fileContents[currentIndex] == ' ' || fileContents[currentIndex] == '\n' || fileContents[currentIndex] == '\r')
+    if (c >= '0' && c <= '9')
+    {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f')
+    {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F')
+    {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+//reads the 4 hex digits of a \u escape, or returns false if they are malformed
+inline bool Json_ReadHex4(const char *chars, usize available, u32 *result)
+{
+    if (available < 4)
+    {
+        return false;
+    }
+    u32 value = 0;
+    for (usize i = 0; i < 4; i++)
     {
-        if (fileContents[currentIndex] == '\n')
+        i32 digit = Json_HexDigit(chars[i]);
+        if (digit < 0)
         {
-            currentLine++;
+            return false;
         }
-        currentIndex++;
+        value = (value << 4) | (u32)digit;
     }
-    result.startIndex = currentIndex;
-
-    if (fileContents[currentIndex] == '\"')
+    *result = value;
+    return true;
+}
+usize Json::UnescapeJsonString(char *buffer, usize length)
+{
+    usize write = 0;
+    usize read = 0;
+    while (read < length)
     {
-        currentIndex++;
-        result.tokenType = JsonToken_Eof;
-
-        while(currentIndex < length)
+        //copy everything up to the next escape in one go
+        const char *backslash = (const char *)memchr(buffer + read, '\\', length - read);
+        usize runEnd = backslash == NULL ? length : (usize)(backslash - buffer);
+        if (write != read)
+        {
+            memmove(buffer + write, buffer + read, runEnd - read);
+        }
+        write += runEnd - read;
+        read = runEnd;
+        if (read + 1 >= length)
         {
-            if (fileContents[currentIndex] == '\\')
+            //no escape, or a lone trailing backslash that we keep as is
+            if (read < length)
             {
-                if ((currentIndex + 1 < length) && fileContents[currentIndex + 1] == '\"' || fileContents[currentIndex + 1] == '\\')
-                {
-                    currentIndex += 2;
-                }
-                else
-                    currentIndex += 1;
+                buffer[write++] = buffer[read++];
             }
-            else
-            {
-                if (fileContents[currentIndex] == '\"')
+            break;
+        }
+
+        char escaped = buffer[read + 1];
+        read += 2;
+        switch (escaped)
+        {
+            case '"': buffer[write++] = '"'; break;
+            case '\\': buffer[write++] = '\\'; break;
+            case '/': buffer[write++] = '/'; break;
+            case 'b': buffer[write++] = '\b'; break;
+            case 'f': buffer[write++] = '\f'; break;
+            case 'n': buffer[write++] = '\n'; break;
+            case 'r': buffer[write++] = '\r'; break;
+            case 't': buffer[write++] = '\t'; break;
+            case 'u':
+            {
+                u32 charPoint;
+                if (!Json_ReadHex4(buffer + read, length - read, &charPoint))
                 {
-                    currentIndex++;
-                    result.endIndex = currentIndex;
-                    result.tokenType = JsonToken_StringLiteral;
+                    //malformed, keep the text as written
+                    buffer[write++] = '\\';
+                    buffer[write++] = 'u';
                     break;
                 }
-                currentIndex++;
+                read += 4;
+                //surrogate pairs are written as two escapes, \uD83D\uDE00
+                if (charPoint >= 0xD800 && charPoint <= 0xDBFF && read + 1 < length && buffer[read] == '\\' && buffer[read + 1] == 'u')
+                {
+                    u32 low;
+                    if (Json_ReadHex4(buffer + read + 2, length - read - 2, &low) && low >= 0xDC00 && low <= 0xDFFF)
+                    {
+                        charPoint = 0x10000 + ((charPoint - 0xD800) << 10) + (low - 0xDC00);
+                        read += 6;
+                    }
+                }
+                //at least 6 characters were read, and UTF8 needs at most 4, so this never overtakes read
+                write += CharPointToUTF8(charPoint, buffer + write);
+                break;
+            }
+            default:
+            {
+                buffer[write++] = '\\';
+                buffer[write++] = escaped;
+                break;
             }
         }
     }
-    else if (fileContents[currentIndex] == ':')
+    return write;
+}
+//Doubles are parsed with the Eisel-Lemire algorithm: the decimal mantissa is multiplied by a 128 bit
+//truncation of the power of five, which is enough to round correctly unless more than 19 digits were given
+#define JSON_SMALLEST_POWER_OF_TEN -342
+#define JSON_LARGEST_POWER_OF_TEN 308
+//5^q for q from JSON_SMALLEST_POWER_OF_TEN to JSON_LARGEST_POWER_OF_TEN, shifted so that the top bit is set, high half first
+static const u64 Json_PowersOfFive[] = {
+    0xeef453d6923bd65aULL, 0x113faa2906a13b3fULL,
+    0x9558b4661b6565f8ULL, 0x4ac7ca59a424c507ULL,
+    0xbaaee17fa23ebf76ULL, 0x5d79bcf00d2df649ULL,
+    0xe95a99df8ace6f53ULL, 0xf4d82c2c107973dcULL,
+    0x91d8a02bb6c10594ULL, 0x79071b9b8a4be869ULL,
+    0xb64ec836a47146f9ULL, 0x9748e2826cdee284ULL,
+    0xe3e27a444d8d98b7ULL, 0xfd1b1b2308169b25ULL,
+    0x8e6d8c6ab0787f72ULL, 0xfe30f0f5e50e20f7ULL,
+    0xb208ef855c969f4fULL, 0xbdbd2d335e51a935ULL,
+    0xde8b2b66b3bc4723ULL, 0xad2c788035e61382ULL,
+    0x8b16fb203055ac76ULL, 0x4c3bcb5021afcc31ULL,
+    0xaddcb9e83c6b1793ULL, 0xdf4abe242a1bbf3dULL,
+    0xd953e8624b85dd78ULL, 0xd71d6dad34a2af0dULL,
+    0x87d4713d6f33aa6bULL, 0x8672648c40e5ad68ULL,
+    0xa9c98d8ccb009506ULL, 0x680efdaf511f18c2ULL,
+    0xd43bf0effdc0ba48ULL, 0x0212bd1b2566def2ULL,
+    0x84a57695fe98746dULL, 0x014bb630f7604b57ULL,
+    0xa5ced43b7e3e9188ULL, 0x419ea3bd35385e2dULL,
+    0xcf42894a5dce35eaULL, 0x52064cac828675b9ULL,
+    0x818995ce7aa0e1b2ULL, 0x7343efebd1940993ULL,
+    0xa1ebfb4219491a1fULL, 0x1014ebe6c5f90bf8ULL,
+    0xca66fa129f9b60a6ULL, 0xd41a26e077774ef6ULL,
+    0xfd00b897478238d0ULL, 0x8920b098955522b4ULL,
+    0x9e20735e8cb16382ULL, 0x55b46e5f5d5535b0ULL,
+    0xc5a890362fddbc62ULL, 0xeb2189f734aa831dULL,
+    0xf712b443bbd52b7bULL, 0xa5e9ec7501d523e4ULL,
+    0x9a6bb0aa55653b2dULL, 0x47b233c92125366eULL,
+    0xc1069cd4eabe89f8ULL, 0x999ec0bb696e840aULL,
+    0xf148440a256e2c76ULL, 0xc00670ea43ca250dULL,
+    0x96cd2a865764dbcaULL, 0x380406926a5e5728ULL,
+    0xbc807527ed3e12bcULL, 0xc605083704f5ecf2ULL,
+    0xeba09271e88d976bULL, 0xf7864a44c633682eULL,
+    0x93445b8731587ea3ULL, 0x7ab3ee6afbe0211dULL,
+    0xb8157268fdae9e4cULL, 0x5960ea05bad82964ULL,
+    0xe61acf033d1a45dfULL, 0x6fb92487298e33bdULL,
+    0x8fd0c16206306babULL, 0xa5d3b6d479f8e056ULL,
+    0xb3c4f1ba87bc8696ULL, 0x8f48a4899877186cULL,
+    0xe0b62e2929aba83cULL, 0x331acdabfe94de87ULL,
+    0x8c71dcd9ba0b4925ULL, 0x9ff0c08b7f1d0b14ULL,
+    0xaf8e5410288e1b6fULL, 0x07ecf0ae5ee44dd9ULL,
+    0xdb71e91432b1a24aULL, 0xc9e82cd9f69d6150ULL,
+    0x892731ac9faf056eULL, 0xbe311c083a225cd2ULL,
+    0xab70fe17c79ac6caULL, 0x6dbd630a48aaf406ULL,
+    0xd64d3d9db981787dULL, 0x092cbbccdad5b108ULL,
+    0x85f0468293f0eb4eULL, 0x25bbf56008c58ea5ULL,
+    0xa76c582338ed2621ULL, 0xaf2af2b80af6f24eULL,
+    0xd1476e2c07286faaULL, 0x1af5af660db4aee1ULL,
+    0x82cca4db847945caULL, 0x50d98d9fc890ed4dULL,
+    0xa37fce126597973cULL, 0xe50ff107bab528a0ULL,
+    0xcc5fc196fefd7d0cULL, 0x1e53ed49a96272c8ULL,
+    0xff77b1fcbebcdc4fULL, 0x25e8e89c13bb0f7aULL,
+    0x9faacf3df73609b1ULL, 0x77b191618c54e9acULL,
+    0xc795830d75038c1dULL, 0xd59df5b9ef6a2417ULL,
+    0xf97ae3d0d2446f25ULL, 0x4b0573286b44ad1dULL,
+    0x9becce62836ac577ULL, 0x4ee367f9430aec32ULL,
+    0xc2e801fb244576d5ULL, 0x229c41f793cda73fULL,
+    0xf3a20279ed56d48aULL, 0x6b43527578c1110fULL,
+    0x9845418c345644d6ULL, 0x830a13896b78aaa9ULL,
+    0xbe5691ef416bd60cULL, 0x23cc986bc656d553ULL,
+    0xedec366b11c6cb8fULL, 0x2cbfbe86b7ec8aa8ULL,
+    0x94b3a202eb1c3f39ULL, 0x7bf7d71432f3d6a9ULL,
+    0xb9e08a83a5e34f07ULL, 0xdaf5ccd93fb0cc53ULL,
+    0xe858ad248f5c22c9ULL, 0xd1b3400f8f9cff68ULL,
+    0x91376c36d99995beULL, 0x23100809b9c21fa1ULL,
+    0xb58547448ffffb2dULL, 0xabd40a0c2832a78aULL,
+    0xe2e69915b3fff9f9ULL, 0x16c90c8f323f516cULL,
+    0x8dd01fad907ffc3bULL, 0xae3da7d97f6792e3ULL,
+    0xb1442798f49ffb4aULL, 0x99cd11cfdf41779cULL,
+    0xdd95317f31c7fa1dULL, 0x40405643d711d583ULL,
+    0x8a7d3eef7f1cfc52ULL, 0x482835ea666b2572ULL,
+    0xad1c8eab5ee43b66ULL, 0xda3243650005eecfULL,
+    0xd863b256369d4a40ULL, 0x90bed43e40076a82ULL,
+    0x873e4f75e2224e68ULL, 0x5a7744a6e804a291ULL,
+    0xa90de3535aaae202ULL, 0x711515d0a205cb36ULL,
+    0xd3515c2831559a83ULL, 0x0d5a5b44ca873e03ULL,
+    0x8412d9991ed58091ULL, 0xe858790afe9486c2ULL,
+    0xa5178fff668ae0b6ULL, 0x626e974dbe39a872ULL,
+    0xce5d73ff402d98e3ULL, 0xfb0a3d212dc8128fULL,
+    0x80fa687f881c7f8eULL, 0x7ce66634bc9d0b99ULL,
+    0xa139029f6a239f72ULL, 0x1c1fffc1ebc44e80ULL,
+    0xc987434744ac874eULL, 0xa327ffb266b56220ULL,
+    0xfbe9141915d7a922ULL, 0x4bf1ff9f0062baa8ULL,
+    0x9d71ac8fada6c9b5ULL, 0x6f773fc3603db4a9ULL,
+    0xc4ce17b399107c22ULL, 0xcb550fb4384d21d3ULL,
+    0xf6019da07f549b2bULL, 0x7e2a53a146606a48ULL,
+    0x99c102844f94e0fbULL, 0x2eda7444cbfc426dULL,
+    0xc0314325637a1939ULL, 0xfa911155fefb5308ULL,
+    0xf03d93eebc589f88ULL, 0x793555ab7eba27caULL,
+    0x96267c7535b763b5ULL, 0x4bc1558b2f3458deULL,
+    0xbbb01b9283253ca2ULL, 0x9eb1aaedfb016f16ULL,
+    0xea9c227723ee8bcbULL, 0x465e15a979c1cadcULL,
+    0x92a1958a7675175fULL, 0x0bfacd89ec191ec9ULL,
+    0xb749faed14125d36ULL, 0xcef980ec671f667bULL,
+    0xe51c79a85916f484ULL, 0x82b7e12780e7401aULL,
+    0x8f31cc0937ae58d2ULL, 0xd1b2ecb8b0908810ULL,
+    0xb2fe3f0b8599ef07ULL, 0x861fa7e6dcb4aa15ULL,
+    0xdfbdcece67006ac9ULL, 0x67a791e093e1d49aULL,
+    0x8bd6a141006042bdULL, 0xe0c8bb2c5c6d24e0ULL,
+    0xaecc49914078536dULL, 0x58fae9f773886e18ULL,
+    0xda7f5bf590966848ULL, 0xaf39a475506a899eULL,
+    0x888f99797a5e012dULL, 0x6d8406c952429603ULL,
+    0xaab37fd7d8f58178ULL, 0xc8e5087ba6d33b83ULL,
+    0xd5605fcdcf32e1d6ULL, 0xfb1e4a9a90880a64ULL,
+    0x855c3be0a17fcd26ULL, 0x5cf2eea09a55067fULL,
+    0xa6b34ad8c9dfc06fULL, 0xf42faa48c0ea481eULL,
+    0xd0601d8efc57b08bULL, 0xf13b94daf124da26ULL,
+    0x823c12795db6ce57ULL, 0x76c53d08d6b70858ULL,
+    0xa2cb1717b52481edULL, 0x54768c4b0c64ca6eULL,
+    0xcb7ddcdda26da268ULL, 0xa9942f5dcf7dfd09ULL,
+    0xfe5d54150b090b02ULL, 0xd3f93b35435d7c4cULL,
+    0x9efa548d26e5a6e1ULL, 0xc47bc5014a1a6dafULL,
+    0xc6b8e9b0709f109aULL, 0x359ab6419ca1091bULL,
+    0xf867241c8cc6d4c0ULL, 0xc30163d203c94b62ULL,
+    0x9b407691d7fc44f8ULL, 0x79e0de63425dcf1dULL,
+    0xc21094364dfb5636ULL, 0x985915fc12f542e4ULL,
+    0xf294b943e17a2bc4ULL, 0x3e6f5b7b17b2939dULL,
+    0x979cf3ca6cec5b5aULL, 0xa705992ceecf9c42ULL,
+    0xbd8430bd08277231ULL, 0x50c6ff782a838353ULL,
+    0xece53cec4a314ebdULL, 0xa4f8bf5635246428ULL,
+    0x940f4613ae5ed136ULL, 0x871b7795e136be99ULL,
+    0xb913179899f68584ULL, 0x28e2557b59846e3fULL,
+    0xe757dd7ec07426e5ULL, 0x331aeada2fe589cfULL,
+    0x9096ea6f3848984fULL, 0x3ff0d2c85def7621ULL,
+    0xb4bca50b065abe63ULL, 0x0fed077a756b53a9ULL,
+    0xe1ebce4dc7f16dfbULL, 0xd3e8495912c62894ULL,
+    0x8d3360f09cf6e4bdULL, 0x64712dd7abbbd95cULL,
+    0xb080392cc4349decULL, 0xbd8d794d96aacfb3ULL,
+    0xdca04777f541c567ULL, 0xecf0d7a0fc5583a0ULL,
+    0x89e42caaf9491b60ULL, 0xf41686c49db57244ULL,
+    0xac5d37d5b79b6239ULL, 0x311c2875c522ced5ULL,
+    0xd77485cb25823ac7ULL, 0x7d633293366b828bULL,
+    0x86a8d39ef77164bcULL, 0xae5dff9c02033197ULL,
+    0xa8530886b54dbdebULL, 0xd9f57f830283fdfcULL,
+    0xd267caa862a12d66ULL, 0xd072df63c324fd7bULL,
+    0x8380dea93da4bc60ULL, 0x4247cb9e59f71e6dULL,
+    0xa46116538d0deb78ULL, 0x52d9be85f074e608ULL,
+    0xcd795be870516656ULL, 0x67902e276c921f8bULL,
+    0x806bd9714632dff6ULL, 0x00ba1cd8a3db53b6ULL,
+    0xa086cfcd97bf97f3ULL, 0x80e8a40eccd228a4ULL,
+    0xc8a883c0fdaf7df0ULL, 0x6122cd128006b2cdULL,
+    0xfad2a4b13d1b5d6cULL, 0x796b805720085f81ULL,
+    0x9cc3a6eec6311a63ULL, 0xcbe3303674053bb0ULL,
+    0xc3f490aa77bd60fcULL, 0xbedbfc4411068a9cULL,
+    0xf4f1b4d515acb93bULL, 0xee92fb5515482d44ULL,
+    0x991711052d8bf3c5ULL, 0x751bdd152d4d1c4aULL,
+    0xbf5cd54678eef0b6ULL, 0xd262d45a78a0635dULL,
+    0xef340a98172aace4ULL, 0x86fb897116c87c34ULL,
+    0x9580869f0e7aac0eULL, 0xd45d35e6ae3d4da0ULL,
+    0xbae0a846d2195712ULL, 0x8974836059cca109ULL,
+    0xe998d258869facd7ULL, 0x2bd1a438703fc94bULL,
+    0x91ff83775423cc06ULL, 0x7b6306a34627ddcfULL,
+    0xb67f6455292cbf08ULL, 0x1a3bc84c17b1d542ULL,
+    0xe41f3d6a7377eecaULL, 0x20caba5f1d9e4a93ULL,
+    0x8e938662882af53eULL, 0x547eb47b7282ee9cULL,
+    0xb23867fb2a35b28dULL, 0xe99e619a4f23aa43ULL,
+    0xdec681f9f4c31f31ULL, 0x6405fa00e2ec94d4ULL,
+    0x8b3c113c38f9f37eULL, 0xde83bc408dd3dd04ULL,
+    0xae0b158b4738705eULL, 0x9624ab50b148d445ULL,
+    0xd98ddaee19068c76ULL, 0x3badd624dd9b0957ULL,
+    0x87f8a8d4cfa417c9ULL, 0xe54ca5d70a80e5d6ULL,
+    0xa9f6d30a038d1dbcULL, 0x5e9fcf4ccd211f4cULL,
+    0xd47487cc8470652bULL, 0x7647c3200069671fULL,
+    0x84c8d4dfd2c63f3bULL, 0x29ecd9f40041e073ULL,
+    0xa5fb0a17c777cf09ULL, 0xf468107100525890ULL,
+    0xcf79cc9db955c2ccULL, 0x7182148d4066eeb4ULL,
+    0x81ac1fe293d599bfULL, 0xc6f14cd848405530ULL,
+    0xa21727db38cb002fULL, 0xb8ada00e5a506a7cULL,
+    0xca9cf1d206fdc03bULL, 0xa6d90811f0e4851cULL,
+    0xfd442e4688bd304aULL, 0x908f4a166d1da663ULL,
+    0x9e4a9cec15763e2eULL, 0x9a598e4e043287feULL,
+    0xc5dd44271ad3cdbaULL, 0x40eff1e1853f29fdULL,
+    0xf7549530e188c128ULL, 0xd12bee59e68ef47cULL,
+    0x9a94dd3e8cf578b9ULL, 0x82bb74f8301958ceULL,
+    0xc13a148e3032d6e7ULL, 0xe36a52363c1faf01ULL,
+    0xf18899b1bc3f8ca1ULL, 0xdc44e6c3cb279ac1ULL,
+    0x96f5600f15a7b7e5ULL, 0x29ab103a5ef8c0b9ULL,
+    0xbcb2b812db11a5deULL, 0x7415d448f6b6f0e7ULL,
+    0xebdf661791d60f56ULL, 0x111b495b3464ad21ULL,
+    0x936b9fcebb25c995ULL, 0xcab10dd900beec34ULL,
+    0xb84687c269ef3bfbULL, 0x3d5d514f40eea742ULL,
+    0xe65829b3046b0afaULL, 0x0cb4a5a3112a5112ULL,
+    0x8ff71a0fe2c2e6dcULL, 0x47f0e785eaba72abULL,
+    0xb3f4e093db73a093ULL, 0x59ed216765690f56ULL,
+    0xe0f218b8d25088b8ULL, 0x306869c13ec3532cULL,
+    0x8c974f7383725573ULL, 0x1e414218c73a13fbULL,
+    0xafbd2350644eeacfULL, 0xe5d1929ef90898faULL,
+    0xdbac6c247d62a583ULL, 0xdf45f746b74abf39ULL,
+    0x894bc396ce5da772ULL, 0x6b8bba8c328eb783ULL,
+    0xab9eb47c81f5114fULL, 0x066ea92f3f326564ULL,
+    0xd686619ba27255a2ULL, 0xc80a537b0efefebdULL,
+    0x8613fd0145877585ULL, 0xbd06742ce95f5f36ULL,
+    0xa798fc4196e952e7ULL, 0x2c48113823b73704ULL,
+    0xd17f3b51fca3a7a0ULL, 0xf75a15862ca504c5ULL,
+    0x82ef85133de648c4ULL, 0x9a984d73dbe722fbULL,
+    0xa3ab66580d5fdaf5ULL, 0xc13e60d0d2e0ebbaULL,
+    0xcc963fee10b7d1b3ULL, 0x318df905079926a8ULL,
+    0xffbbcfe994e5c61fULL, 0xfdf17746497f7052ULL,
+    0x9fd561f1fd0f9bd3ULL, 0xfeb6ea8bedefa633ULL,
+    0xc7caba6e7c5382c8ULL, 0xfe64a52ee96b8fc0ULL,
+    0xf9bd690a1b68637bULL, 0x3dfdce7aa3c673b0ULL,
+    0x9c1661a651213e2dULL, 0x06bea10ca65c084eULL,
+    0xc31bfa0fe5698db8ULL, 0x486e494fcff30a62ULL,
+    0xf3e2f893dec3f126ULL, 0x5a89dba3c3efccfaULL,
+    0x986ddb5c6b3a76b7ULL, 0xf89629465a75e01cULL,
+    0xbe89523386091465ULL, 0xf6bbb397f1135823ULL,
+    0xee2ba6c0678b597fULL, 0x746aa07ded582e2cULL,
+    0x94db483840b717efULL, 0xa8c2a44eb4571cdcULL,
+    0xba121a4650e4ddebULL, 0x92f34d62616ce413ULL,
+    0xe896a0d7e51e1566ULL, 0x77b020baf9c81d17ULL,
+    0x915e2486ef32cd60ULL, 0x0ace1474dc1d122eULL,
+    0xb5b5ada8aaff80b8ULL, 0x0d819992132456baULL,
+    0xe3231912d5bf60e6ULL, 0x10e1fff697ed6c69ULL,
+    0x8df5efabc5979c8fULL, 0xca8d3ffa1ef463c1ULL,
+    0xb1736b96b6fd83b3ULL, 0xbd308ff8a6b17cb2ULL,
+    0xddd0467c64bce4a0ULL, 0xac7cb3f6d05ddbdeULL,
+    0x8aa22c0dbef60ee4ULL, 0x6bcdf07a423aa96bULL,
+    0xad4ab7112eb3929dULL, 0x86c16c98d2c953c6ULL,
+    0xd89d64d57a607744ULL, 0xe871c7bf077ba8b7ULL,
+    0x87625f056c7c4a8bULL, 0x11471cd764ad4972ULL,
+    0xa93af6c6c79b5d2dULL, 0xd598e40d3dd89bcfULL,
+    0xd389b47879823479ULL, 0x4aff1d108d4ec2c3ULL,
+    0x843610cb4bf160cbULL, 0xcedf722a585139baULL,
+    0xa54394fe1eedb8feULL, 0xc2974eb4ee658828ULL,
+    0xce947a3da6a9273eULL, 0x733d226229feea32ULL,
+    0x811ccc668829b887ULL, 0x0806357d5a3f525fULL,
+    0xa163ff802a3426a8ULL, 0xca07c2dcb0cf26f7ULL,
+    0xc9bcff6034c13052ULL, 0xfc89b393dd02f0b5ULL,
+    0xfc2c3f3841f17c67ULL, 0xbbac2078d443ace2ULL,
+    0x9d9ba7832936edc0ULL, 0xd54b944b84aa4c0dULL,
+    0xc5029163f384a931ULL, 0x0a9e795e65d4df11ULL,
+    0xf64335bcf065d37dULL, 0x4d4617b5ff4a16d5ULL,
+    0x99ea0196163fa42eULL, 0x504bced1bf8e4e45ULL,
+    0xc06481fb9bcf8d39ULL, 0xe45ec2862f71e1d6ULL,
+    0xf07da27a82c37088ULL, 0x5d767327bb4e5a4cULL,
+    0x964e858c91ba2655ULL, 0x3a6a07f8d510f86fULL,
+    0xbbe226efb628afeaULL, 0x890489f70a55368bULL,
+    0xeadab0aba3b2dbe5ULL, 0x2b45ac74ccea842eULL,
+    0x92c8ae6b464fc96fULL, 0x3b0b8bc90012929dULL,
+    0xb77ada0617e3bbcbULL, 0x09ce6ebb40173744ULL,
+    0xe55990879ddcaabdULL, 0xcc420a6a101d0515ULL,
+    0x8f57fa54c2a9eab6ULL, 0x9fa946824a12232dULL,
+    0xb32df8e9f3546564ULL, 0x47939822dc96abf9ULL,
+    0xdff9772470297ebdULL, 0x59787e2b93bc56f7ULL,
+    0x8bfbea76c619ef36ULL, 0x57eb4edb3c55b65aULL,
+    0xaefae51477a06b03ULL, 0xede622920b6b23f1ULL,
+    0xdab99e59958885c4ULL, 0xe95fab368e45ecedULL,
+    0x88b402f7fd75539bULL, 0x11dbcb0218ebb414ULL,
+    0xaae103b5fcd2a881ULL, 0xd652bdc29f26a119ULL,
+    0xd59944a37c0752a2ULL, 0x4be76d3346f0495fULL,
+    0x857fcae62d8493a5ULL, 0x6f70a4400c562ddbULL,
+    0xa6dfbd9fb8e5b88eULL, 0xcb4ccd500f6bb952ULL,
+    0xd097ad07a71f26b2ULL, 0x7e2000a41346a7a7ULL,
+    0x825ecc24c873782fULL, 0x8ed400668c0c28c8ULL,
+    0xa2f67f2dfa90563bULL, 0x728900802f0f32faULL,
+    0xcbb41ef979346bcaULL, 0x4f2b40a03ad2ffb9ULL,
+    0xfea126b7d78186bcULL, 0xe2f610c84987bfa8ULL,
+    0x9f24b832e6b0f436ULL, 0x0dd9ca7d2df4d7c9ULL,
+    0xc6ede63fa05d3143ULL, 0x91503d1c79720dbbULL,
+    0xf8a95fcf88747d94ULL, 0x75a44c6397ce912aULL,
+    0x9b69dbe1b548ce7cULL, 0xc986afbe3ee11abaULL,
+    0xc24452da229b021bULL, 0xfbe85badce996168ULL,
+    0xf2d56790ab41c2a2ULL, 0xfae27299423fb9c3ULL,
+    0x97c560ba6b0919a5ULL, 0xdccd879fc967d41aULL,
+    0xbdb6b8e905cb600fULL, 0x5400e987bbc1c920ULL,
+    0xed246723473e3813ULL, 0x290123e9aab23b68ULL,
+    0x9436c0760c86e30bULL, 0xf9a0b6720aaf6521ULL,
+    0xb94470938fa89bceULL, 0xf808e40e8d5b3e69ULL,
+    0xe7958cb87392c2c2ULL, 0xb60b1d1230b20e04ULL,
+    0x90bd77f3483bb9b9ULL, 0xb1c6f22b5e6f48c2ULL,
+    0xb4ecd5f01a4aa828ULL, 0x1e38aeb6360b1af3ULL,
+    0xe2280b6c20dd5232ULL, 0x25c6da63c38de1b0ULL,
+    0x8d590723948a535fULL, 0x579c487e5a38ad0eULL,
+    0xb0af48ec79ace837ULL, 0x2d835a9df0c6d851ULL,
+    0xdcdb1b2798182244ULL, 0xf8e431456cf88e65ULL,
+    0x8a08f0f8bf0f156bULL, 0x1b8e9ecb641b58ffULL,
+    0xac8b2d36eed2dac5ULL, 0xe272467e3d222f3fULL,
+    0xd7adf884aa879177ULL, 0x5b0ed81dcc6abb0fULL,
+    0x86ccbb52ea94baeaULL, 0x98e947129fc2b4e9ULL,
+    0xa87fea27a539e9a5ULL, 0x3f2398d747b36224ULL,
+    0xd29fe4b18e88640eULL, 0x8eec7f0d19a03aadULL,
+    0x83a3eeeef9153e89ULL, 0x1953cf68300424acULL,
+    0xa48ceaaab75a8e2bULL, 0x5fa8c3423c052dd7ULL,
+    0xcdb02555653131b6ULL, 0x3792f412cb06794dULL,
+    0x808e17555f3ebf11ULL, 0xe2bbd88bbee40bd0ULL,
+    0xa0b19d2ab70e6ed6ULL, 0x5b6aceaeae9d0ec4ULL,
+    0xc8de047564d20a8bULL, 0xf245825a5a445275ULL,
+    0xfb158592be068d2eULL, 0xeed6e2f0f0d56712ULL,
+    0x9ced737bb6c4183dULL, 0x55464dd69685606bULL,
+    0xc428d05aa4751e4cULL, 0xaa97e14c3c26b886ULL,
+    0xf53304714d9265dfULL, 0xd53dd99f4b3066a8ULL,
+    0x993fe2c6d07b7fabULL, 0xe546a8038efe4029ULL,
+    0xbf8fdb78849a5f96ULL, 0xde98520472bdd033ULL,
+    0xef73d256a5c0f77cULL, 0x963e66858f6d4440ULL,
+    0x95a8637627989aadULL, 0xdde7001379a44aa8ULL,
+    0xbb127c53b17ec159ULL, 0x5560c018580d5d52ULL,
+    0xe9d71b689dde71afULL, 0xaab8f01e6e10b4a6ULL,
+    0x9226712162ab070dULL, 0xcab3961304ca70e8ULL,
+    0xb6b00d69bb55c8d1ULL, 0x3d607b97c5fd0d22ULL,
+    0xe45c10c42a2b3b05ULL, 0x8cb89a7db77c506aULL,
+    0x8eb98a7a9a5b04e3ULL, 0x77f3608e92adb242ULL,
+    0xb267ed1940f1c61cULL, 0x55f038b237591ed3ULL,
+    0xdf01e85f912e37a3ULL, 0x6b6c46dec52f6688ULL,
+    0x8b61313bbabce2c6ULL, 0x2323ac4b3b3da015ULL,
+    0xae397d8aa96c1b77ULL, 0xabec975e0a0d081aULL,
+    0xd9c7dced53c72255ULL, 0x96e7bd358c904a21ULL,
+    0x881cea14545c7575ULL, 0x7e50d64177da2e54ULL,
+    0xaa242499697392d2ULL, 0xdde50bd1d5d0b9e9ULL,
+    0xd4ad2dbfc3d07787ULL, 0x955e4ec64b44e864ULL,
+    0x84ec3c97da624ab4ULL, 0xbd5af13bef0b113eULL,
+    0xa6274bbdd0fadd61ULL, 0xecb1ad8aeacdd58eULL,
+    0xcfb11ead453994baULL, 0x67de18eda5814af2ULL,
+    0x81ceb32c4b43fcf4ULL, 0x80eacf948770ced7ULL,
+    0xa2425ff75e14fc31ULL, 0xa1258379a94d028dULL,
+    0xcad2f7f5359a3b3eULL, 0x096ee45813a04330ULL,
+    0xfd87b5f28300ca0dULL, 0x8bca9d6e188853fcULL,
+    0x9e74d1b791e07e48ULL, 0x775ea264cf55347eULL,
+    0xc612062576589ddaULL, 0x95364afe032a819eULL,
+    0xf79687aed3eec551ULL, 0x3a83ddbd83f52205ULL,
+    0x9abe14cd44753b52ULL, 0xc4926a9672793543ULL,
+    0xc16d9a0095928a27ULL, 0x75b7053c0f178294ULL,
+    0xf1c90080baf72cb1ULL, 0x5324c68b12dd6339ULL,
+    0x971da05074da7beeULL, 0xd3f6fc16ebca5e04ULL,
+    0xbce5086492111aeaULL, 0x88f4bb1ca6bcf585ULL,
+    0xec1e4a7db69561a5ULL, 0x2b31e9e3d06c32e6ULL,
+    0x9392ee8e921d5d07ULL, 0x3aff322e62439fd0ULL,
+    0xb877aa3236a4b449ULL, 0x09befeb9fad487c3ULL,
+    0xe69594bec44de15bULL, 0x4c2ebe687989a9b4ULL,
+    0x901d7cf73ab0acd9ULL, 0x0f9d37014bf60a11ULL,
+    0xb424dc35095cd80fULL, 0x538484c19ef38c95ULL,
+    0xe12e13424bb40e13ULL, 0x2865a5f206b06fbaULL,
+    0x8cbccc096f5088cbULL, 0xf93f87b7442e45d4ULL,
+    0xafebff0bcb24aafeULL, 0xf78f69a51539d749ULL,
+    0xdbe6fecebdedd5beULL, 0xb573440e5a884d1cULL,
+    0x89705f4136b4a597ULL, 0x31680a88f8953031ULL,
+    0xabcc77118461cefcULL, 0xfdc20d2b36ba7c3eULL,
+    0xd6bf94d5e57a42bcULL, 0x3d32907604691b4dULL,
+    0x8637bd05af6c69b5ULL, 0xa63f9a49c2c1b110ULL,
+    0xa7c5ac471b478423ULL, 0x0fcf80dc33721d54ULL,
+    0xd1b71758e219652bULL, 0xd3c36113404ea4a9ULL,
+    0x83126e978d4fdf3bULL, 0x645a1cac083126eaULL,
+    0xa3d70a3d70a3d70aULL, 0x3d70a3d70a3d70a4ULL,
+    0xccccccccccccccccULL, 0xcccccccccccccccdULL,
+    0x8000000000000000ULL, 0x0000000000000000ULL,
+    0xa000000000000000ULL, 0x0000000000000000ULL,
+    0xc800000000000000ULL, 0x0000000000000000ULL,
+    0xfa00000000000000ULL, 0x0000000000000000ULL,
+    0x9c40000000000000ULL, 0x0000000000000000ULL,
+    0xc350000000000000ULL, 0x0000000000000000ULL,
+    0xf424000000000000ULL, 0x0000000000000000ULL,
+    0x9896800000000000ULL, 0x0000000000000000ULL,
+    0xbebc200000000000ULL, 0x0000000000000000ULL,
+    0xee6b280000000000ULL, 0x0000000000000000ULL,
+    0x9502f90000000000ULL, 0x0000000000000000ULL,
+    0xba43b74000000000ULL, 0x0000000000000000ULL,
+    0xe8d4a51000000000ULL, 0x0000000000000000ULL,
+    0x9184e72a00000000ULL, 0x0000000000000000ULL,
+    0xb5e620f480000000ULL, 0x0000000000000000ULL,
+    0xe35fa931a0000000ULL, 0x0000000000000000ULL,
+    0x8e1bc9bf04000000ULL, 0x0000000000000000ULL,
+    0xb1a2bc2ec5000000ULL, 0x0000000000000000ULL,
+    0xde0b6b3a76400000ULL, 0x0000000000000000ULL,
+    0x8ac7230489e80000ULL, 0x0000000000000000ULL,
+    0xad78ebc5ac620000ULL, 0x0000000000000000ULL,
+    0xd8d726b7177a8000ULL, 0x0000000000000000ULL,
+    0x878678326eac9000ULL, 0x0000000000000000ULL,
+    0xa968163f0a57b400ULL, 0x0000000000000000ULL,
+    0xd3c21bcecceda100ULL, 0x0000000000000000ULL,
+    0x84595161401484a0ULL, 0x0000000000000000ULL,
+    0xa56fa5b99019a5c8ULL, 0x0000000000000000ULL,
+    0xcecb8f27f4200f3aULL, 0x0000000000000000ULL,
+    0x813f3978f8940984ULL, 0x4000000000000000ULL,
+    0xa18f07d736b90be5ULL, 0x5000000000000000ULL,
+    0xc9f2c9cd04674edeULL, 0xa400000000000000ULL,
+    0xfc6f7c4045812296ULL, 0x4d00000000000000ULL,
+    0x9dc5ada82b70b59dULL, 0xf020000000000000ULL,
+    0xc5371912364ce305ULL, 0x6c28000000000000ULL,
+    0xf684df56c3e01bc6ULL, 0xc732000000000000ULL,
+    0x9a130b963a6c115cULL, 0x3c7f400000000000ULL,
+    0xc097ce7bc90715b3ULL, 0x4b9f100000000000ULL,
+    0xf0bdc21abb48db20ULL, 0x1e86d40000000000ULL,
+    0x96769950b50d88f4ULL, 0x1314448000000000ULL,
+    0xbc143fa4e250eb31ULL, 0x17d955a000000000ULL,
+    0xeb194f8e1ae525fdULL, 0x5dcfab0800000000ULL,
+    0x92efd1b8d0cf37beULL, 0x5aa1cae500000000ULL,
+    0xb7abc627050305adULL, 0xf14a3d9e40000000ULL,
+    0xe596b7b0c643c719ULL, 0x6d9ccd05d0000000ULL,
+    0x8f7e32ce7bea5c6fULL, 0xe4820023a2000000ULL,
+    0xb35dbf821ae4f38bULL, 0xdda2802c8a800000ULL,
+    0xe0352f62a19e306eULL, 0xd50b2037ad200000ULL,
+    0x8c213d9da502de45ULL, 0x4526f422cc340000ULL,
+    0xaf298d050e4395d6ULL, 0x9670b12b7f410000ULL,
+    0xdaf3f04651d47b4cULL, 0x3c0cdd765f114000ULL,
+    0x88d8762bf324cd0fULL, 0xa5880a69fb6ac800ULL,
+    0xab0e93b6efee0053ULL, 0x8eea0d047a457a00ULL,
+    0xd5d238a4abe98068ULL, 0x72a4904598d6d880ULL,
+    0x85a36366eb71f041ULL, 0x47a6da2b7f864750ULL,
+    0xa70c3c40a64e6c51ULL, 0x999090b65f67d924ULL,
+    0xd0cf4b50cfe20765ULL, 0xfff4b4e3f741cf6dULL,
+    0x82818f1281ed449fULL, 0xbff8f10e7a8921a4ULL,
+    0xa321f2d7226895c7ULL, 0xaff72d52192b6a0dULL,
+    0xcbea6f8ceb02bb39ULL, 0x9bf4f8a69f764490ULL,
+    0xfee50b7025c36a08ULL, 0x02f236d04753d5b4ULL,
+    0x9f4f2726179a2245ULL, 0x01d762422c946590ULL,
+    0xc722f0ef9d80aad6ULL, 0x424d3ad2b7b97ef5ULL,
+    0xf8ebad2b84e0d58bULL, 0xd2e0898765a7deb2ULL,
+    0x9b934c3b330c8577ULL, 0x63cc55f49f88eb2fULL,
+    0xc2781f49ffcfa6d5ULL, 0x3cbf6b71c76b25fbULL,
+    0xf316271c7fc3908aULL, 0x8bef464e3945ef7aULL,
+    0x97edd871cfda3a56ULL, 0x97758bf0e3cbb5acULL,
+    0xbde94e8e43d0c8ecULL, 0x3d52eeed1cbea317ULL,
+    0xed63a231d4c4fb27ULL, 0x4ca7aaa863ee4bddULL,
+    0x945e455f24fb1cf8ULL, 0x8fe8caa93e74ef6aULL,
+    0xb975d6b6ee39e436ULL, 0xb3e2fd538e122b44ULL,
+    0xe7d34c64a9c85d44ULL, 0x60dbbca87196b616ULL,
+    0x90e40fbeea1d3a4aULL, 0xbc8955e946fe31cdULL,
+    0xb51d13aea4a488ddULL, 0x6babab6398bdbe41ULL,
+    0xe264589a4dcdab14ULL, 0xc696963c7eed2dd1ULL,
+    0x8d7eb76070a08aecULL, 0xfc1e1de5cf543ca2ULL,
+    0xb0de65388cc8ada8ULL, 0x3b25a55f43294bcbULL,
+    0xdd15fe86affad912ULL, 0x49ef0eb713f39ebeULL,
+    0x8a2dbf142dfcc7abULL, 0x6e3569326c784337ULL,
+    0xacb92ed9397bf996ULL, 0x49c2c37f07965404ULL,
+    0xd7e77a8f87daf7fbULL, 0xdc33745ec97be906ULL,
+    0x86f0ac99b4e8dafdULL, 0x69a028bb3ded71a3ULL,
+    0xa8acd7c0222311bcULL, 0xc40832ea0d68ce0cULL,
+    0xd2d80db02aabd62bULL, 0xf50a3fa490c30190ULL,
+    0x83c7088e1aab65dbULL, 0x792667c6da79e0faULL,
+    0xa4b8cab1a1563f52ULL, 0x577001b891185938ULL,
+    0xcde6fd5e09abcf26ULL, 0xed4c0226b55e6f86ULL,
+    0x80b05e5ac60b6178ULL, 0x544f8158315b05b4ULL,
+    0xa0dc75f1778e39d6ULL, 0x696361ae3db1c721ULL,
+    0xc913936dd571c84cULL, 0x03bc3a19cd1e38e9ULL,
+    0xfb5878494ace3a5fULL, 0x04ab48a04065c723ULL,
+    0x9d174b2dcec0e47bULL, 0x62eb0d64283f9c76ULL,
+    0xc45d1df942711d9aULL, 0x3ba5d0bd324f8394ULL,
+    0xf5746577930d6500ULL, 0xca8f44ec7ee36479ULL,
+    0x9968bf6abbe85f20ULL, 0x7e998b13cf4e1ecbULL,
+    0xbfc2ef456ae276e8ULL, 0x9e3fedd8c321a67eULL,
+    0xefb3ab16c59b14a2ULL, 0xc5cfe94ef3ea101eULL,
+    0x95d04aee3b80ece5ULL, 0xbba1f1d158724a12ULL,
+    0xbb445da9ca61281fULL, 0x2a8a6e45ae8edc97ULL,
+    0xea1575143cf97226ULL, 0xf52d09d71a3293bdULL,
+    0x924d692ca61be758ULL, 0x593c2626705f9c56ULL,
+    0xb6e0c377cfa2e12eULL, 0x6f8b2fb00c77836cULL,
+    0xe498f455c38b997aULL, 0x0b6dfb9c0f956447ULL,
+    0x8edf98b59a373fecULL, 0x4724bd4189bd5eacULL,
+    0xb2977ee300c50fe7ULL, 0x58edec91ec2cb657ULL,
+    0xdf3d5e9bc0f653e1ULL, 0x2f2967b66737e3edULL,
+    0x8b865b215899f46cULL, 0xbd79e0d20082ee74ULL,
+    0xae67f1e9aec07187ULL, 0xecd8590680a3aa11ULL,
+    0xda01ee641a708de9ULL, 0xe80e6f4820cc9495ULL,
+    0x884134fe908658b2ULL, 0x3109058d147fdcddULL,
+    0xaa51823e34a7eedeULL, 0xbd4b46f0599fd415ULL,
+    0xd4e5e2cdc1d1ea96ULL, 0x6c9e18ac7007c91aULL,
+    0x850fadc09923329eULL, 0x03e2cf6bc604ddb0ULL,
+    0xa6539930bf6bff45ULL, 0x84db8346b786151cULL,
+    0xcfe87f7cef46ff16ULL, 0xe612641865679a63ULL,
+    0x81f14fae158c5f6eULL, 0x4fcb7e8f3f60c07eULL,
+    0xa26da3999aef7749ULL, 0xe3be5e330f38f09dULL,
+    0xcb090c8001ab551cULL, 0x5cadf5bfd3072cc5ULL,
+    0xfdcb4fa002162a63ULL, 0x73d9732fc7c8f7f6ULL,
+    0x9e9f11c4014dda7eULL, 0x2867e7fddcdd9afaULL,
+    0xc646d63501a1511dULL, 0xb281e1fd541501b8ULL,
+    0xf7d88bc24209a565ULL, 0x1f225a7ca91a4226ULL,
+    0x9ae757596946075fULL, 0x3375788de9b06958ULL,
+    0xc1a12d2fc3978937ULL, 0x0052d6b1641c83aeULL,
+    0xf209787bb47d6b84ULL, 0xc0678c5dbd23a49aULL,
+    0x9745eb4d50ce6332ULL, 0xf840b7ba963646e0ULL,
+    0xbd176620a501fbffULL, 0xb650e5a93bc3d898ULL,
+    0xec5d3fa8ce427affULL, 0xa3e51f138ab4cebeULL,
+    0x93ba47c980e98cdfULL, 0xc66f336c36b10137ULL,
+    0xb8a8d9bbe123f017ULL, 0xb80b0047445d4184ULL,
+    0xe6d3102ad96cec1dULL, 0xa60dc059157491e5ULL,
+    0x9043ea1ac7e41392ULL, 0x87c89837ad68db2fULL,
+    0xb454e4a179dd1877ULL, 0x29babe4598c311fbULL,
+    0xe16a1dc9d8545e94ULL, 0xf4296dd6fef3d67aULL,
+    0x8ce2529e2734bb1dULL, 0x1899e4a65f58660cULL,
+    0xb01ae745b101e9e4ULL, 0x5ec05dcff72e7f8fULL,
+    0xdc21a1171d42645dULL, 0x76707543f4fa1f73ULL,
+    0x899504ae72497ebaULL, 0x6a06494a791c53a8ULL,
+    0xabfa45da0edbde69ULL, 0x0487db9d17636892ULL,
+    0xd6f8d7509292d603ULL, 0x45a9d2845d3c42b6ULL,
+    0x865b86925b9bc5c2ULL, 0x0b8a2392ba45a9b2ULL,
+    0xa7f26836f282b732ULL, 0x8e6cac7768d7141eULL,
+    0xd1ef0244af2364ffULL, 0x3207d795430cd926ULL,
+    0x8335616aed761f1fULL, 0x7f44e6bd49e807b8ULL,
+    0xa402b9c5a8d3a6e7ULL, 0x5f16206c9c6209a6ULL,
+    0xcd036837130890a1ULL, 0x36dba887c37a8c0fULL,
+    0x802221226be55a64ULL, 0xc2494954da2c9789ULL,
+    0xa02aa96b06deb0fdULL, 0xf2db9baa10b7bd6cULL,
+    0xc83553c5c8965d3dULL, 0x6f92829494e5acc7ULL,
+    0xfa42a8b73abbf48cULL, 0xcb772339ba1f17f9ULL,
+    0x9c69a97284b578d7ULL, 0xff2a760414536efbULL,
+    0xc38413cf25e2d70dULL, 0xfef5138519684abaULL,
+    0xf46518c2ef5b8cd1ULL, 0x7eb258665fc25d69ULL,
+    0x98bf2f79d5993802ULL, 0xef2f773ffbd97a61ULL,
+    0xbeeefb584aff8603ULL, 0xaafb550ffacfd8faULL,
+    0xeeaaba2e5dbf6784ULL, 0x95ba2a53f983cf38ULL,
+    0x952ab45cfa97a0b2ULL, 0xdd945a747bf26183ULL,
+    0xba756174393d88dfULL, 0x94f971119aeef9e4ULL,
+    0xe912b9d1478ceb17ULL, 0x7a37cd5601aab85dULL,
+    0x91abb422ccb812eeULL, 0xac62e055c10ab33aULL,
+    0xb616a12b7fe617aaULL, 0x577b986b314d6009ULL,
+    0xe39c49765fdf9d94ULL, 0xed5a7e85fda0b80bULL,
+    0x8e41ade9fbebc27dULL, 0x14588f13be847307ULL,
+    0xb1d219647ae6b31cULL, 0x596eb2d8ae258fc8ULL,
+    0xde469fbd99a05fe3ULL, 0x6fca5f8ed9aef3bbULL,
+    0x8aec23d680043beeULL, 0x25de7bb9480d5854ULL,
+    0xada72ccc20054ae9ULL, 0xaf561aa79a10ae6aULL,
+    0xd910f7ff28069da4ULL, 0x1b2ba1518094da04ULL,
+    0x87aa9aff79042286ULL, 0x90fb44d2f05d0842ULL,
+    0xa99541bf57452b28ULL, 0x353a1607ac744a53ULL,
+    0xd3fa922f2d1675f2ULL, 0x42889b8997915ce8ULL,
+    0x847c9b5d7c2e09b7ULL, 0x69956135febada11ULL,
+    0xa59bc234db398c25ULL, 0x43fab9837e699095ULL,
+    0xcf02b2c21207ef2eULL, 0x94f967e45e03f4bbULL,
+    0x8161afb94b44f57dULL, 0x1d1be0eebac278f5ULL,
+    0xa1ba1ba79e1632dcULL, 0x6462d92a69731732ULL,
+    0xca28a291859bbf93ULL, 0x7d7b8f7503cfdcfeULL,
+    0xfcb2cb35e702af78ULL, 0x5cda735244c3d43eULL,
+    0x9defbf01b061adabULL, 0x3a0888136afa64a7ULL,
+    0xc56baec21c7a1916ULL, 0x088aaa1845b8fdd0ULL,
+    0xf6c69a72a3989f5bULL, 0x8aad549e57273d45ULL,
+    0x9a3c2087a63f6399ULL, 0x36ac54e2f678864bULL,
+    0xc0cb28a98fcf3c7fULL, 0x84576a1bb416a7ddULL,
+    0xf0fdf2d3f3c30b9fULL, 0x656d44a2a11c51d5ULL,
+    0x969eb7c47859e743ULL, 0x9f644ae5a4b1b325ULL,
+    0xbc4665b596706114ULL, 0x873d5d9f0dde1feeULL,
+    0xeb57ff22fc0c7959ULL, 0xa90cb506d155a7eaULL,
+    0x9316ff75dd87cbd8ULL, 0x09a7f12442d588f2ULL,
+    0xb7dcbf5354e9beceULL, 0x0c11ed6d538aeb2fULL,
+    0xe5d3ef282a242e81ULL, 0x8f1668c8a86da5faULL,
+    0x8fa475791a569d10ULL, 0xf96e017d694487bcULL,
+    0xb38d92d760ec4455ULL, 0x37c981dcc395a9acULL,
+    0xe070f78d3927556aULL, 0x85bbe253f47b1417ULL,
+    0x8c469ab843b89562ULL, 0x93956d7478ccec8eULL,
+    0xaf58416654a6babbULL, 0x387ac8d1970027b2ULL,
+    0xdb2e51bfe9d0696aULL, 0x06997b05fcc0319eULL,
+    0x88fcf317f22241e2ULL, 0x441fece3bdf81f03ULL,
+    0xab3c2fddeeaad25aULL, 0xd527e81cad7626c3ULL,
+    0xd60b3bd56a5586f1ULL, 0x8a71e223d8d3b074ULL,
+    0x85c7056562757456ULL, 0xf6872d5667844e49ULL,
+    0xa738c6bebb12d16cULL, 0xb428f8ac016561dbULL,
+    0xd106f86e69d785c7ULL, 0xe13336d701beba52ULL,
+    0x82a45b450226b39cULL, 0xecc0024661173473ULL,
+    0xa34d721642b06084ULL, 0x27f002d7f95d0190ULL,
+    0xcc20ce9bd35c78a5ULL, 0x31ec038df7b441f4ULL,
+    0xff290242c83396ceULL, 0x7e67047175a15271ULL,
+    0x9f79a169bd203e41ULL, 0x0f0062c6e984d386ULL,
+    0xc75809c42c684dd1ULL, 0x52c07b78a3e60868ULL,
+    0xf92e0c3537826145ULL, 0xa7709a56ccdf8a82ULL,
+    0x9bbcc7a142b17ccbULL, 0x88a66076400bb691ULL,
+    0xc2abf989935ddbfeULL, 0x6acff893d00ea435ULL,
+    0xf356f7ebf83552feULL, 0x0583f6b8c4124d43ULL,
+    0x98165af37b2153deULL, 0xc3727a337a8b704aULL,
+    0xbe1bf1b059e9a8d6ULL, 0x744f18c0592e4c5cULL,
+    0xeda2ee1c7064130cULL, 0x1162def06f79df73ULL,
+    0x9485d4d1c63e8be7ULL, 0x8addcb5645ac2ba8ULL,
+    0xb9a74a0637ce2ee1ULL, 0x6d953e2bd7173692ULL,
+    0xe8111c87c5c1ba99ULL, 0xc8fa8db6ccdd0437ULL,
+    0x910ab1d4db9914a0ULL, 0x1d9c9892400a22a2ULL,
+    0xb54d5e4a127f59c8ULL, 0x2503beb6d00cab4bULL,
+    0xe2a0b5dc971f303aULL, 0x2e44ae64840fd61dULL,
+    0x8da471a9de737e24ULL, 0x5ceaecfed289e5d2ULL,
+    0xb10d8e1456105dadULL, 0x7425a83e872c5f47ULL,
+    0xdd50f1996b947518ULL, 0xd12f124e28f77719ULL,
+    0x8a5296ffe33cc92fULL, 0x82bd6b70d99aaa6fULL,
+    0xace73cbfdc0bfb7bULL, 0x636cc64d1001550bULL,
+    0xd8210befd30efa5aULL, 0x3c47f7e05401aa4eULL,
+    0x8714a775e3e95c78ULL, 0x65acfaec34810a71ULL,
+    0xa8d9d1535ce3b396ULL, 0x7f1839a741a14d0dULL,
+    0xd31045a8341ca07cULL, 0x1ede48111209a050ULL,
+    0x83ea2b892091e44dULL, 0x934aed0aab460432ULL,
+    0xa4e4b66b68b65d60ULL, 0xf81da84d5617853fULL,
+    0xce1de40642e3f4b9ULL, 0x36251260ab9d668eULL,
+    0x80d2ae83e9ce78f3ULL, 0xc1d72b7c6b426019ULL,
+    0xa1075a24e4421730ULL, 0xb24cf65b8612f81fULL,
+    0xc94930ae1d529cfcULL, 0xdee033f26797b627ULL,
+    0xfb9b7cd9a4a7443cULL, 0x169840ef017da3b1ULL,
+    0x9d412e0806e88aa5ULL, 0x8e1f289560ee864eULL,
+    0xc491798a08a2ad4eULL, 0xf1a6f2bab92a27e2ULL,
+    0xf5b5d7ec8acb58a2ULL, 0xae10af696774b1dbULL,
+    0x9991a6f3d6bf1765ULL, 0xacca6da1e0a8ef29ULL,
+    0xbff610b0cc6edd3fULL, 0x17fd090a58d32af3ULL,
+    0xeff394dcff8a948eULL, 0xddfc4b4cef07f5b0ULL,
+    0x95f83d0a1fb69cd9ULL, 0x4abdaf101564f98eULL,
+    0xbb764c4ca7a4440fULL, 0x9d6d1ad41abe37f1ULL,
+    0xea53df5fd18d5513ULL, 0x84c86189216dc5edULL,
+    0x92746b9be2f8552cULL, 0x32fd3cf5b4e49bb4ULL,
+    0xb7118682dbb66a77ULL, 0x3fbc8c33221dc2a1ULL,
+    0xe4d5e82392a40515ULL, 0x0fabaf3feaa5334aULL,
+    0x8f05b1163ba6832dULL, 0x29cb4d87f2a7400eULL,
+    0xb2c71d5bca9023f8ULL, 0x743e20e9ef511012ULL,
+    0xdf78e4b2bd342cf6ULL, 0x914da9246b255416ULL,
+    0x8bab8eefb6409c1aULL, 0x1ad089b6c2f7548eULL,
+    0xae9672aba3d0c320ULL, 0xa184ac2473b529b1ULL,
+    0xda3c0f568cc4f3e8ULL, 0xc9e5d72d90a2741eULL,
+    0x8865899617fb1871ULL, 0x7e2fa67c7a658892ULL,
+    0xaa7eebfb9df9de8dULL, 0xddbb901b98feeab7ULL,
+    0xd51ea6fa85785631ULL, 0x552a74227f3ea565ULL,
+    0x8533285c936b35deULL, 0xd53a88958f87275fULL,
+    0xa67ff273b8460356ULL, 0x8a892abaf368f137ULL,
+    0xd01fef10a657842cULL, 0x2d2b7569b0432d85ULL,
+    0x8213f56a67f6b29bULL, 0x9c3b29620e29fc73ULL,
+    0xa298f2c501f45f42ULL, 0x8349f3ba91b47b8fULL,
+    0xcb3f2f7642717713ULL, 0x241c70a936219a73ULL,
+    0xfe0efb53d30dd4d7ULL, 0xed238cd383aa0110ULL,
+    0x9ec95d1463e8a506ULL, 0xf4363804324a40aaULL,
+    0xc67bb4597ce2ce48ULL, 0xb143c6053edcd0d5ULL,
+    0xf81aa16fdc1b81daULL, 0xdd94b7868e94050aULL,
+    0x9b10a4e5e9913128ULL, 0xca7cf2b4191c8326ULL,
+    0xc1d4ce1f63f57d72ULL, 0xfd1c2f611f63a3f0ULL,
+    0xf24a01a73cf2dccfULL, 0xbc633b39673c8cecULL,
+    0x976e41088617ca01ULL, 0xd5be0503e085d813ULL,
+    0xbd49d14aa79dbc82ULL, 0x4b2d8644d8a74e18ULL,
+    0xec9c459d51852ba2ULL, 0xddf8e7d60ed1219eULL,
+    0x93e1ab8252f33b45ULL, 0xcabb90e5c942b503ULL,
+    0xb8da1662e7b00a17ULL, 0x3d6a751f3b936243ULL,
+    0xe7109bfba19c0c9dULL, 0x0cc512670a783ad4ULL,
+    0x906a617d450187e2ULL, 0x27fb2b80668b24c5ULL,
+    0xb484f9dc9641e9daULL, 0xb1f9f660802dedf6ULL,
+    0xe1a63853bbd26451ULL, 0x5e7873f8a0396973ULL,
+    0x8d07e33455637eb2ULL, 0xdb0b487b6423e1e8ULL,
+    0xb049dc016abc5e5fULL, 0x91ce1a9a3d2cda62ULL,
+    0xdc5c5301c56b75f7ULL, 0x7641a140cc7810fbULL,
+    0x89b9b3e11b6329baULL, 0xa9e904c87fcb0a9dULL,
+    0xac2820d9623bf429ULL, 0x546345fa9fbdcd44ULL,
+    0xd732290fbacaf133ULL, 0xa97c177947ad4095ULL,
+    0x867f59a9d4bed6c0ULL, 0x49ed8eabcccc485dULL,
+    0xa81f301449ee8c70ULL, 0x5c68f256bfff5a74ULL,
+    0xd226fc195c6a2f8cULL, 0x73832eec6fff3111ULL,
+    0x83585d8fd9c25db7ULL, 0xc831fd53c5ff7eabULL,
+    0xa42e74f3d032f525ULL, 0xba3e7ca8b77f5e55ULL,
+    0xcd3a1230c43fb26fULL, 0x28ce1bd2e55f35ebULL,
+    0x80444b5e7aa7cf85ULL, 0x7980d163cf5b81b3ULL,
+    0xa0555e361951c366ULL, 0xd7e105bcc332621fULL,
+    0xc86ab5c39fa63440ULL, 0x8dd9472bf3fefaa7ULL,
+    0xfa856334878fc150ULL, 0xb14f98f6f0feb951ULL,
+    0x9c935e00d4b9d8d2ULL, 0x6ed1bf9a569f33d3ULL,
+    0xc3b8358109e84f07ULL, 0x0a862f80ec4700c8ULL,
+    0xf4a642e14c6262c8ULL, 0xcd27bb612758c0faULL,
+    0x98e7e9cccfbd7dbdULL, 0x8038d51cb897789cULL,
+    0xbf21e44003acdd2cULL, 0xe0470a63e6bd56c3ULL,
+    0xeeea5d5004981478ULL, 0x1858ccfce06cac74ULL,
+    0x95527a5202df0ccbULL, 0x0f37801e0c43ebc8ULL,
+    0xbaa718e68396cffdULL, 0xd30560258f54e6baULL,
+    0xe950df20247c83fdULL, 0x47c6b82ef32a2069ULL,
+    0x91d28b7416cdd27eULL, 0x4cdc331d57fa5441ULL,
+    0xb6472e511c81471dULL, 0xe0133fe4adf8e952ULL,
+    0xe3d8f9e563a198e5ULL, 0x58180fddd97723a6ULL,
+    0x8e679c2f5e44ff8fULL, 0x570f09eaa7ea7648ULL
+};
+//exactly representable, so that small exponents take the fast path of one multiplication or division
+static const double Json_PowersOfTen[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+//returns the low half of a * b
+inline u64 Json_Multiply128(u64 a, u64 b, u64 *high)
+{
+#if defined(_MSC_VER) && defined(_M_X64)
+    return _umul128(a, b, high);
+#elif defined(__SIZEOF_INT128__)
+    unsigned __int128 product = (unsigned __int128)a * b;
+    *high = (u64)(product >> 64);
+    return (u64)product;
+#else
+    u64 aLow = a & 0xFFFFFFFF;
+    u64 aHigh = a >> 32;
+    u64 bLow = b & 0xFFFFFFFF;
+    u64 bHigh = b >> 32;
+    u64 lowLow = aLow * bLow;
+    u64 middle = aHigh * bLow + (lowLow >> 32);
+    u64 middle2 = aLow * bHigh + (middle & 0xFFFFFFFF);
+    *high = aHigh * bHigh + (middle >> 32) + (middle2 >> 32);
+    return (middle2 << 32) | (lowLow & 0xFFFFFFFF);
+#endif
+}
+inline u32 Json_LeadingZeros64(u64 mask)
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanReverse64(&index, mask);
+    return 63 - (u32)index;
+#else
+    return (u32)__builtin_clzll(mask);
+#endif
+}
+//The bits of the double nearest to mantissa * 10^exponent, for a non zero mantissa
+u64 Json_EiselLemire(u64 mantissa, i64 exponent)
+{
+    const u64 infinity = (u64)0x7FF << 52;
+    if (exponent < JSON_SMALLEST_POWER_OF_TEN)
     {
-        result.tokenType = JsonToken_Colon;
-        currentIndex++;
-        result.endIndex = currentIndex;
+        return 0;
     }
-    else if (fileContents[currentIndex] == ',')
+    if (exponent > JSON_LARGEST_POWER_OF_TEN)
     {
-        result.tokenType = JsonToken_Comma;
-        currentIndex++;
-        result.endIndex = currentIndex;
+        return infinity;
     }
-    else if (fileContents[currentIndex] == '{')
+    u32 leadingZeros = Json_LeadingZeros64(mantissa);
+    mantissa <<= leadingZeros;
+
+    usize index = 2 * (usize)(exponent - JSON_SMALLEST_POWER_OF_TEN);
+    u64 high;
+    u64 low = Json_Multiply128(mantissa, Json_PowersOfFive[index], &high);
+    //the bits below the 55 that are kept are all set, so the truncated low half of the power could carry into them
+    const u64 precisionMask = (u64)0xFFFFFFFFFFFFFFFF >> 55;
+    if ((high & precisionMask) == precisionMask)
     {
-        result.tokenType = JsonToken_LBrace;
-        currentIndex++;
-        result.endIndex = currentIndex;
+        u64 secondHigh;
+        Json_Multiply128(mantissa, Json_PowersOfFive[index + 1], &secondHigh);
+        low += secondHigh;
+        if (secondHigh > low)
+        {
+            high++;
+        }
     }
-    else if (fileContents[currentIndex] == '}')
+
+    u32 upperBit = (u32)(high >> 63);
+    u32 shift = upperBit + 64 - 52 - 3;
+    u64 result = high >> shift;
+    //floor(log2(10^exponent)) + 63, plus the bias of 1023
+    i32 power2 = (i32)((((152170 + 65536) * (i32)exponent) >> 16) + 63) + (i32)upperBit - (i32)leadingZeros + 1023;
+    if (power2 <= 0)
     {
-        result.tokenType = JsonToken_RBrace;
-        currentIndex++;
-        result.endIndex = currentIndex;
+        //subnormal
+        if (-power2 + 1 >= 64)
+        {
+            return 0;
+        }
+        result >>= -power2 + 1;
+        result += result & 1;
+        result >>= 1;
+        //rounding up may have made it the smallest normal double, whose exponent bit is now set in result
+        return result;
     }
-    else if (fileContents[currentIndex] == '[')
+    //exactly halfway between two doubles, which rounds to the even one
+    if (low <= 1 && exponent >= -4 && exponent <= 23 && (result & 3) == 1 && (result << shift) == high)
     {
-        result.tokenType = JsonToken_LBracket;
-        currentIndex++;
-        result.endIndex = currentIndex;
+        result &= ~(u64)1;
     }
-    else if (fileContents[currentIndex] == ']')
+    result += result & 1;
+    result >>= 1;
+    if (result >= ((u64)2 << 52))
     {
-        result.tokenType = JsonToken_RBracket;
-        currentIndex++;
-        result.endIndex = currentIndex;
+        result = (u64)1 << 52;
+        power2++;
+    }
+    result &= ~((u64)1 << 52);
+    if (power2 >= 0x7FF)
+    {
+        return infinity;
+    }
+    return result | ((u64)power2 << 52);
+}
+bool Json::ParseJsonNumber(const char *text, usize length, JsonScalar *result)
+{
+    usize i = 0;
+    bool negative = false;
+    if (i < length && text[i] == '-')
+    {
+        negative = true;
+        i++;
+    }
+    usize integerStart = i;
+    //up to 19 significant digits always fit, beyond that only whether any were not zero matters
+    u64 mantissa = 0;
+    u32 significantDigits = 0;
+    bool truncated = false;
+    i64 exponent = 0;
+    while (i < length && (u8)(text[i] - '0') < 10)
+    {
+        u32 digit = (u32)(text[i] - '0');
+        if (significantDigits < 19)
+        {
+            mantissa = mantissa * 10 + digit;
+            significantDigits += mantissa != 0;
+        }
+        else
+        {
+            exponent++;
+            truncated = truncated || digit != 0;
+        }
+        i++;
     }
-    else if (fileContents[currentIndex] == '-')
+    usize integerEnd = i;
+    if (integerEnd == integerStart)
     {
-        currentIndex++;
-        if (isdigit(fileContents[currentIndex]))
+        return false;
+    }
+    bool isInteger = true;
+    if (i < length && text[i] == '.')
+    {
+        isInteger = false;
+        i++;
+        while (i < length && (u8)(text[i] - '0') < 10)
         {
-            result.tokenType = JsonToken_IntegerLiteral;
-            while (isdigit(fileContents[currentIndex]) || fileContents[currentIndex] == '.')
+            u32 digit = (u32)(text[i] - '0');
+            if (significantDigits < 19)
             {
-                if (fileContents[currentIndex] == '.')
-                {
-                    //cannot do 0..0
-                    if (result.tokenType == JsonToken_FloatLiteral)
-                    {
-                        result.tokenType = JsonToken_Invalid;
-                        return result;
-                    }
-                    result.tokenType = JsonToken_FloatLiteral;
-                }
-                currentIndex += 1;
-                result.endIndex = currentIndex;
+                mantissa = mantissa * 10 + digit;
+                significantDigits += mantissa != 0;
+                exponent--;
+            }
+            else
+            {
+                truncated = truncated || digit != 0;
             }
+            i++;
         }
     }
-    else if (isdigit(fileContents[currentIndex]))
+    if (i < length && (text[i] | 0x20) == 'e')
     {
-        result.tokenType = JsonToken_IntegerLiteral;
-        while (isdigit(fileContents[currentIndex]) || fileContents[currentIndex] == '.')
+        isInteger = false;
+        i++;
+        bool negativeExponent = false;
+        if (i < length && (text[i] == '+' || text[i] == '-'))
+        {
+            negativeExponent = text[i] == '-';
+            i++;
+        }
+        usize exponentStart = i;
+        i64 explicitExponent = 0;
+        while (i < length && (u8)(text[i] - '0') < 10)
         {
-            if (fileContents[currentIndex] == '.')
+            //anything this large is already zero or infinity
+            if (explicitExponent < 100000)
             {
-                //cannot do 0..0
-                if (result.tokenType == JsonToken_FloatLiteral)
-                {
-                    result.tokenType = JsonToken_Invalid;
-                    return result;
-                }
-                result.tokenType = JsonToken_FloatLiteral;
+                explicitExponent = explicitExponent * 10 + (text[i] - '0');
             }
-            currentIndex += 1;
-            result.endIndex = currentIndex;
+            i++;
+        }
+        if (i == exponentStart)
+        {
+            return false;
         }
+        exponent += negativeExponent ? -explicitExponent : explicitExponent;
     }
-    else if (currentIndex + 4 < this->length && 
-    fileContents[currentIndex] == 't' && 
-    fileContents[currentIndex + 1] == 'r' && 
-    fileContents[currentIndex + 2] == 'u' && 
-    fileContents[currentIndex + 3] == 'e')
+    if (i != length)
     {
-        currentIndex += 4;
-        result.endIndex = currentIndex;
-        result.tokenType = JsonToken_BoolLiteral;
+        return false;
     }
-    else if (currentIndex + 4 < this->length && 
-    fileContents[currentIndex] == 'n' && 
-    fileContents[currentIndex + 1] == 'u' && 
-    fileContents[currentIndex + 2] == 'l' && 
-    fileContents[currentIndex + 3] == 'l')
+
+    if (isInteger)
     {
-        currentIndex += 4;
-        result.endIndex = currentIndex;
-        result.tokenType = JsonToken_NullLiteral;
+        u64 value = 0;
+        bool overflowed = false;
+        for (usize j = integerStart; j < integerEnd; j++)
+        {
+            u64 digit = (u64)(text[j] - '0');
+            if (value > (U64Max - digit) / 10)
+            {
+                overflowed = true;
+                break;
+            }
+            value = value * 10 + digit;
+        }
+        if (!overflowed && negative && value <= (u64)I64Max + 1)
+        {
+            result->valueType = JsonValue_Integer;
+            result->asUnsigned = (u64)0 - value;
+            return true;
+        }
+        if (!overflowed && !negative)
+        {
+            result->valueType = value <= (u64)I64Max ? JsonValue_Integer : JsonValue_Unsigned;
+            result->asUnsigned = value;
+            return true;
+        }
+    }
+
+    result->valueType = JsonValue_Double;
+    if (truncated)
+    {
+        //rare enough that the C library can deal with it, given a terminated copy
+        char *copy = (char *)malloc(length + 1);
+        memcpy(copy, text, length);
+        copy[length] = '\0';
+        result->asDouble = strtod(copy, NULL);
+        free(copy);
+        return true;
+    }
+    double value;
+    if (mantissa == 0)
+    {
+        value = 0.0;
+    }
+    else if (exponent >= -22 && exponent <= 22 && mantissa <= ((u64)1 << 53))
+    {
+        value = (double)mantissa;
+        value = exponent < 0 ? value / Json_PowersOfTen[-exponent] : value * Json_PowersOfTen[exponent];
+    }
+    else
+    {
+        u64 bits = Json_EiselLemire(mantissa, exponent);
+        memcpy(&value, &bits, sizeof(double));
+    }
+    result->asDouble = negative ? -value : value;
+    return true;
+}
+Json::JsonScalar Json::ParseJsonScalar(JsonTokenType tokenType, const char *text, usize length)
+{
+    JsonScalar result;
+    result.valueType = JsonValue_String;
+    result.asInteger = 0;
+    switch (tokenType)
+    {
+        case JsonToken_StringLiteral:
+            break;
+        case JsonToken_BoolLiteral:
+            result.valueType = JsonValue_Bool;
+            result.asBool = text[0] == 't';
+            break;
+        case JsonToken_NullLiteral:
+            result.valueType = JsonValue_Null;
+            break;
+        case JsonToken_IntegerLiteral:
+        case JsonToken_FloatLiteral:
+            ParseJsonNumber(text, length, &result);
+            break;
+        default:
+        {
+            if ((length == 4 && memcmp(text, "true", 4) == 0) || (length == 5 && memcmp(text, "false", 5) == 0))
+            {
+                result.valueType = JsonValue_Bool;
+                result.asBool = length == 4;
+            }
+            else if (length == 4 && memcmp(text, "null", 4) == 0)
+            {
+                result.valueType = JsonValue_Null;
+            }
+            else if (!ParseJsonNumber(text, length, &result))
+            {
+                result.valueType = JsonValue_String;
+                result.asInteger = 0;
+            }
+            break;
+        }
+    }
+    return result;
+}
+//Bitmasks of one JSON_STRUCTURAL_BLOCK of input, bit i standing for byte i
+struct JsonBlockMasks
+{
+    u64 quote;
+    u64 backslash;
+    //{ } [ ] : ,
+    u64 op;
+    u64 whitespace;
+};
+inline u32 Json_LowestBit64(u64 mask)
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward64(&index, mask);
+    return (u32)index;
+#else
+    return (u32)__builtin_ctzll(mask);
+#endif
+}
+//bit i of the result is the xor of bits 0 to i, which turns quote positions into a mask of what is inside strings
+inline u64 Json_PrefixXor(u64 mask)
+{
+    mask ^= mask << 1;
+    mask ^= mask << 2;
+    mask ^= mask << 4;
+    mask ^= mask << 8;
+    mask ^= mask << 16;
+    mask ^= mask << 32;
+    return mask;
+}
+inline u32 Json_PopCount64(u64 mask)
+{
+#if defined(_MSC_VER)
+    return (u32)__popcnt64(mask);
+#else
+    return (u32)__builtin_popcountll(mask);
+#endif
+}
+#if defined(JSON_USE_AVX2)
+//classifies 32 bytes, each result having one bit per byte
+inline void Json_ClassifyAVX2(const char *chunk, u32 *quote, u32 *backslash, u32 *op, u32 *whitespace)
+{
+    __m256i bytes = _mm256_loadu_si256((const __m256i *)chunk);
+    //[ and ] differ from { and } only by 0x20
+    __m256i braces = _mm256_or_si256(bytes, _mm256_set1_epi8(0x20));
+    __m256i ops = _mm256_or_si256(
+        _mm256_or_si256(_mm256_cmpeq_epi8(braces, _mm256_set1_epi8('{')), _mm256_cmpeq_epi8(braces, _mm256_set1_epi8('}'))),
+        _mm256_or_si256(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(':')), _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(','))));
+    __m256i spaces = _mm256_or_si256(
+        _mm256_or_si256(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(' ')), _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('\n'))),
+        _mm256_or_si256(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('\r')), _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('\t'))));
+    *quote = (u32)_mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('"')));
+    *backslash = (u32)_mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('\\')));
+    *op = (u32)_mm256_movemask_epi8(ops);
+    *whitespace = (u32)_mm256_movemask_epi8(spaces);
+}
+#elif defined(JSON_USE_SSE2)
+//classifies 16 bytes, each result having one bit per byte
+inline void Json_ClassifySSE2(const char *chunk, u32 *quote, u32 *backslash, u32 *op, u32 *whitespace)
+{
+    __m128i bytes = _mm_loadu_si128((const __m128i *)chunk);
+    __m128i braces = _mm_or_si128(bytes, _mm_set1_epi8(0x20));
+    __m128i ops = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(braces, _mm_set1_epi8('{')), _mm_cmpeq_epi8(braces, _mm_set1_epi8('}'))),
+        _mm_or_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8(':')), _mm_cmpeq_epi8(bytes, _mm_set1_epi8(','))));
+    __m128i spaces = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(bytes, _mm_set1_epi8('\n'))),
+        _mm_or_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8('\r')), _mm_cmpeq_epi8(bytes, _mm_set1_epi8('\t'))));
+    *quote = (u32)_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8('"')));
+    *backslash = (u32)_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8('\\')));
+    *op = (u32)_mm_movemask_epi8(ops);
+    *whitespace = (u32)_mm_movemask_epi8(spaces);
+}
+#endif
+inline void Json_ClassifyBlock(const char *block, JsonBlockMasks *masks)
+{
+    masks->quote = 0;
+    masks->backslash = 0;
+    masks->op = 0;
+    masks->whitespace = 0;
+#if defined(JSON_USE_AVX2) || defined(JSON_USE_SSE2)
+#if defined(JSON_USE_AVX2)
+    const u32 chunkSize = 32;
+#else
+    const u32 chunkSize = 16;
+#endif
+    for (u32 i = 0; i < JSON_STRUCTURAL_BLOCK; i += chunkSize)
+    {
+        u32 quote, backslash, op, whitespace;
+#if defined(JSON_USE_AVX2)
+        Json_ClassifyAVX2(block + i, &quote, &backslash, &op, &whitespace);
+#else
+        Json_ClassifySSE2(block + i, &quote, &backslash, &op, &whitespace);
+#endif
+        masks->quote |= (u64)quote << i;
+        masks->backslash |= (u64)backslash << i;
+        masks->op |= (u64)op << i;
+        masks->whitespace |= (u64)whitespace << i;
+    }
+#else
+    for (u32 i = 0; i < JSON_STRUCTURAL_BLOCK; i++)
+    {
+        u64 bit = (u64)1 << i;
+        switch (block[i])
+        {
+            case '"': masks->quote |= bit; break;
+            case '\\': masks->backslash |= bit; break;
+            case '{': case '}': case '[': case ']': case ':': case ',': masks->op |= bit; break;
+            case ' ': case '\n': case '\r': case '\t': masks->whitespace |= bit; break;
+            default: break;
+        }
     }
-    else if (currentIndex + 5 < this->length && 
-    fileContents[currentIndex] == 'f' && 
-    fileContents[currentIndex + 1] == 'a' && 
-    fileContents[currentIndex + 2] == 'l' && 
-    fileContents[currentIndex + 3] == 's' &&
-    fileContents[currentIndex + 4] == 'e')
+#endif
+}
+usize Json::JsonStructuralScanner::Scan(usize *output, usize capacity)
+{
+    usize written = 0;
+    char lastBlock[JSON_STRUCTURAL_BLOCK];
+    //a block yields at most one position per byte
+    while (position < length && capacity - written >= JSON_STRUCTURAL_BLOCK)
     {
-        currentIndex += 5;
+        const char *block = contents + position;
+        if (length - position < JSON_STRUCTURAL_BLOCK)
+        {
+            //pad the final block with whitespace, which never produces a token
+            memset(lastBlock, ' ', JSON_STRUCTURAL_BLOCK);
+            memcpy(lastBlock, block, length - position);
+            block = lastBlock;
+        }
+        JsonBlockMasks masks;
+        Json_ClassifyBlock(block, &masks);
+
+        //Characters following an unescaped backslash are escaped. Backslashes are rare
+        //outside of text heavy files, so walking them one by one is cheaper than doing this with bit tricks
+        u64 escaped = nextEscaped;
+        u64 backslash = masks.backslash & ~nextEscaped;
+        nextEscaped = 0;
+        while (backslash != 0)
+        {
+            u32 bit = Json_LowestBit64(backslash);
+            if (bit == 63)
+            {
+                nextEscaped = 1;
+                break;
+            }
+            escaped |= (u64)2 << bit;
+            backslash &= ~((u64)3 << bit);
+        }
+
+        u64 quote = masks.quote & ~escaped;
+        //includes opening quotes but not closing ones
+        u64 inString = Json_PrefixXor(quote) ^ previousInString;
+        previousInString = (u64)((i64)inString >> 63);
+
+        //literals such as numbers, true and null are marked at their first character only
+        u64 scalar = ~(masks.op | masks.whitespace | quote) & ~inString;
+        u64 scalarStart = scalar & ~((scalar << 1) | previousScalar);
+        previousScalar = scalar >> 63;
+
+        u64 structural = (masks.op & ~inString) | quote | scalarStart;
+        usize blockStart = written;
+        usize count = Json_PopCount64(structural);
+        u64 remaining = structural;
+        //written four at a time without checking each bit, as a block's worth of capacity is always free.
+        //Whatever goes past count is overwritten by the next block or never read.
+        //Setting the top bit keeps the lowest bit of an emptied mask defined without changing any other result
+        const u64 topBit = (u64)1 << 63;
+        for (usize i = 0; i < count; i += 4)
+        {
+            output[written + i] = position + Json_LowestBit64(remaining | topBit);
+            remaining &= remaining - 1;
+            output[written + i + 1] = position + Json_LowestBit64(remaining | topBit);
+            remaining &= remaining - 1;
+            output[written + i + 2] = position + Json_LowestBit64(remaining | topBit);
+            remaining &= remaining - 1;
+            output[written + i + 3] = position + Json_LowestBit64(remaining | topBit);
+            remaining &= remaining - 1;
+        }
+        written += count;
+
+        //flag the closing quotes of strings with backslashes in them, so that the parser knows which need unescaping
+        u64 stringBackslashes = masks.backslash & inString;
+        if (stringBackslashes != 0 || pendingEscapes)
+        {
+            u64 closingQuotes = quote & ~inString;
+            while (closingQuotes != 0)
+            {
+                u64 before = (closingQuotes & (0 - closingQuotes)) - 1;
+                if (pendingEscapes || (stringBackslashes & before) != 0)
+                {
+                    output[blockStart + Json_PopCount64(structural & before)] |= JSON_STRUCTURAL_ESCAPES;
+                }
+                pendingEscapes = false;
+                stringBackslashes &= ~before;
+                closingQuotes &= closingQuotes - 1;
+            }
+            //anything left belongs to a string that continues into the next block
+            pendingEscapes = pendingEscapes || stringBackslashes != 0;
+        }
+        position += JSON_STRUCTURAL_BLOCK;
+    }
+    return written;
+}
+Json::JsonToken Json::JsonTokenizer::ReadToken()
+{
+    JsonToken result;
+    result.tokenType = JsonToken_Invalid;
+    result.hasEscapes = false;
+    if (currentStructural >= structuralsCount)
+    {
+        result.startIndex = currentIndex;
         result.endIndex = currentIndex;
-        result.tokenType = JsonToken_BoolLiteral;
+        return result;
     }
+    usize start = structurals[currentStructural];
+    currentStructural++;
+    result.startIndex = start;
+    result.endIndex = start + 1;
 
+    switch (fileContents[start])
+    {
+        case '{': result.tokenType = JsonToken_LBrace; break;
+        case '}': result.tokenType = JsonToken_RBrace; break;
+        case '[': result.tokenType = JsonToken_LBracket; break;
+        case ']': result.tokenType = JsonToken_RBracket; break;
+        case ':': result.tokenType = JsonToken_Colon; break;
+        case ',': result.tokenType = JsonToken_Comma; break;
+        case '"':
+        {
+            //nothing inside a string is indexed, so the next entry is its closing quote
+            if (currentStructural >= structuralsCount)
+            {
+                result.tokenType = JsonToken_Eof;
+                result.endIndex = length;
+                break;
+            }
+            usize end = structurals[currentStructural];
+            currentStructural++;
+            result.hasEscapes = (end & JSON_STRUCTURAL_ESCAPES) != 0;
+            result.endIndex = (end & ~JSON_STRUCTURAL_ESCAPES) + 1;
+            result.tokenType = JsonToken_StringLiteral;
+            break;
+        }
+        default:
+        {
+            //a literal runs up to the next token, less any whitespace in between
+            usize end = currentStructural < structuralsCount ? structurals[currentStructural] : length;
+            while (end > start + 1 && (fileContents[end - 1] == ' ' || fileContents[end - 1] == '\n' || fileContents[end - 1] == '\r' || fileContents[end - 1] == '\t' || fileContents[end - 1] == '\0'))
+            {
+                end--;
+            }
+            result.endIndex = end;
+            const char *literal = fileContents + start;
+            usize literalLength = end - start;
+            if ((literalLength == 4 && memcmp(literal, "true", 4) == 0) || (literalLength == 5 && memcmp(literal, "false", 5) == 0))
+            {
+                result.tokenType = JsonToken_BoolLiteral;
+            }
+            else if (literalLength == 4 && memcmp(literal, "null", 4) == 0)
+            {
+                result.tokenType = JsonToken_NullLiteral;
+            }
+            else
+            {
+                //an optional minus, digits, then an optional fraction and exponent
+                usize i = literal[0] == '-' ? 1 : 0;
+                usize digitsStart = i;
+                while (i < literalLength && (u8)(literal[i] - '0') < 10)
+                {
+                    i++;
+                }
+                if (i > digitsStart)
+                {
+                    result.tokenType = JsonToken_IntegerLiteral;
+                    if (i < literalLength && literal[i] == '.')
+                    {
+                        result.tokenType = JsonToken_FloatLiteral;
+                        i++;
+                        while (i < literalLength && (u8)(literal[i] - '0') < 10)
+                        {
+                            i++;
+                        }
+                    }
+                    if (i < literalLength && (literal[i] | 0x20) == 'e')
+                    {
+                        i++;
+                        if (i < literalLength && (literal[i] == '+' || literal[i] == '-'))
+                        {
+                            i++;
+                        }
+                        usize exponentStart = i;
+                        while (i < literalLength && (u8)(literal[i] - '0') < 10)
+                        {
+                            i++;
+                        }
+                        result.tokenType = i > exponentStart ? JsonToken_FloatLiteral : JsonToken_Invalid;
+                    }
+                    if (i != literalLength)
+                    {
+                        result.tokenType = JsonToken_Invalid;
+                    }
+                }
+            }
+            break;
+        }
+    }
+    currentIndex = result.endIndex;
     return result;
 }
 bool Json::ParseJsonElement(IAllocator allocator, JsonTokenizer *tokenizer, JsonElement *result)
+{
+    JsonParseStack stack = JsonParseStack(GetCAllocator());
+    bool success = ParseJsonElement(allocator, tokenizer, &stack, result);
+    stack.deinit();
+    return success;
+}
+bool Json::ParseJsonElement(IAllocator allocator, JsonTokenizer *tokenizer, JsonParseStack *stack, JsonElement *result)
 {
     JsonToken peekNext = tokenizer->PeekNext();
     if (peekNext.tokenType == JsonToken_StringLiteral || peekNext.tokenType == JsonToken_IntegerLiteral || peekNext.tokenType == JsonToken_FloatLiteral || peekNext.tokenType == JsonToken_BoolLiteral || peekNext.tokenType == JsonToken_NullLiteral)
     {
-        *result = JsonElement(tokenizer->GetString(allocator, peekNext));
         tokenizer->Next();
+        if (tokenizer->inPlace)
+        {
+            *result = JsonElement(tokenizer->GetView(peekNext));
+        }
+        else
+        {
+            *result = JsonElement(tokenizer->GetString(allocator, peekNext));
+            result->hasEscapes = peekNext.hasEscapes;
+        }
+        result->scalar = ParseJsonScalar(peekNext.tokenType, result->value.buffer, result->value.length - 1);
         return true;
     }
     else if (peekNext.tokenType == JsonToken_LBracket) //[]
     {
-        //printf("Entering array\n");
-        IAllocator cAllocator = GetCAllocator();
-
-        collections::vector<JsonElement> arrayMembers = collections::vector<JsonElement>(cAllocator);
+        //members go on top of the stack, above those of any containers still being parsed
+        usize stackStart = stack->elements.count;
         tokenizer->Next();
         //empty array
         if (tokenizer->PeekNext().tokenType == JsonToken_RBracket)
         {
             tokenizer->Next();
-
         }
         else
         {
             while(true)
             {
                 JsonElement arrayMember;
-                if (!ParseJsonElement(allocator, tokenizer, &arrayMember))
+                if (!ParseJsonElement(allocator, tokenizer, stack, &arrayMember))
                 {
-                    //printf("Unable to parse array member\n");
-                    arrayMembers.deinit();
+                    stack->elements.count = stackStart;
                     return false;
                 }
-                arrayMembers.Add(arrayMember);
+                stack->elements.Add(arrayMember);
 
                 // dont actually just peek next here as if it has an error, 
                 //the resulting data won't matter even if it has been read out of order
@@ -1084,25 +2724,37 @@ bool Json::ParseJsonElement(IAllocator allocator, JsonTokenizer *tokenizer, Json
                 }
                 else if (peekNext.tokenType == JsonToken_Comma)
                 {
+                    //a comma after the last member is allowed, as it is for objects
+                    if (tokenizer->PeekNext().tokenType == JsonToken_RBracket)
+                    {
+                        tokenizer->Next();
+                        break;
+                    }
                     continue;
                 }
                 else
                 {
-                    arrayMembers.deinit();
+                    stack->elements.count = stackStart;
                     return false;
                 }
             }
         }
 
-        *result = JsonElement(arrayMembers.ToOwnedArrayWith(allocator));
+        usize membersCount = stack->elements.count - stackStart;
+        collections::Array<JsonElement> arrayMembers = collections::Array<JsonElement>(allocator, membersCount);
+        if (membersCount > 0)
+        {
+            memcpy(arrayMembers.data, stack->elements.ptr + stackStart, sizeof(JsonElement) * membersCount);
+        }
+        stack->elements.count = stackStart;
+        *result = JsonElement(arrayMembers);
         return true;
     }
     else if (peekNext.tokenType == JsonToken_LBrace) //{}
     {
-        *result = JsonElement(collections::hashmap<string, JsonElement>(allocator, &stringHash, &stringEql));
         tokenizer->Next();
-
-        collections::vector<JsonElement> childObjectsOrdered = collections::vector<JsonElement>(GetCAllocator());
+        usize stackStart = stack->elements.count;
+        usize keysStart = stack->keys.count;
 
         while (true)
         {
@@ -1113,22 +2765,41 @@ bool Json::ParseJsonElement(IAllocator allocator, JsonTokenizer *tokenizer, Json
             }
             else if (propertyNameToken.tokenType != JsonToken_StringLiteral)
             {
+                stack->elements.count = stackStart;
+                stack->keys.count = keysStart;
                 return false;
             }
-            string propertyName = tokenizer->GetString(allocator, propertyNameToken); // string(allocator, tokenizer->fileContents + propertyNameToken.startIndex + 1, propertyNameToken.endIndex - 1 - propertyNameToken.startIndex - 1);
+            string propertyName;
+            if (tokenizer->inPlace)
+            {
+                propertyName = tokenizer->GetView(propertyNameToken);
+            }
+            else
+            {
+                propertyName = tokenizer->GetString(allocator, propertyNameToken);
+                if (propertyNameToken.hasEscapes)
+                {
+                    propertyName.length = UnescapeJsonString(propertyName.buffer, propertyName.length - 1) + 1;
+                    propertyName.buffer[propertyName.length - 1] = '\0';
+                }
+            }
 
             if (tokenizer->Next().tokenType != JsonToken_Colon)
             {
+                stack->elements.count = stackStart;
+                stack->keys.count = keysStart;
                 return false;
             }
 
             JsonElement subElementResult;
-            if (!ParseJsonElement(allocator, tokenizer, &subElementResult))
+            if (!ParseJsonElement(allocator, tokenizer, stack, &subElementResult))
             {
+                stack->elements.count = stackStart;
+                stack->keys.count = keysStart;
                 return false;
             }
-            result->childObjects.Add(propertyName, subElementResult);
-            childObjectsOrdered.Add(subElementResult);
+            stack->keys.Add(propertyName);
+            stack->elements.Add(subElementResult);
 
             if (tokenizer->PeekNext().tokenType == JsonToken_Comma)
             {
@@ -1136,9 +2807,596 @@ bool Json::ParseJsonElement(IAllocator allocator, JsonTokenizer *tokenizer, Json
                 continue;
             }
         }
-        result->arrayElements = childObjectsOrdered.ToOwnedArrayWith(allocator);
+
+        usize membersCount = stack->elements.count - stackStart;
+        string *keys = stack->keys.ptr + keysStart;
+        JsonElement *members = stack->elements.ptr + stackStart;
+
+        //small objects in a JsonDocument skip the map, as a table sized for HASHMAP_MIN_CAPACITY
+        //members would be most of the document's memory. GetProperty searches their keys instead
+        JsonObjectMap childObjects = JsonObjectMap();
+        if (!tokenizer->inPlace || membersCount >= JSON_OBJECT_MAP_THRESHOLD)
+        {
+            childObjects = JsonObjectMap(allocator, StringHasher(), StringEql());
+            childObjects.AddMany(keys, members, membersCount);
+        }
+        *result = JsonElement(childObjects);
+        result->arrayElements = collections::Array<JsonElement>(allocator, membersCount);
+        if (membersCount > 0)
+        {
+            result->keys = (string *)allocator.Allocate(sizeof(string) * membersCount);
+            memcpy(result->keys, keys, sizeof(string) * membersCount);
+            memcpy(result->arrayElements.data, members, sizeof(JsonElement) * membersCount);
+        }
+        stack->elements.count = stackStart;
+        stack->keys.count = keysStart;
         return true;
     }
     return false;
 }
+
+usize Json_ReadFromFile(void *file, char *buffer, usize count)
+{
+    return fread(buffer, sizeof(char), count, (FILE *)file);
+}
+usize Json_ReadFromFileDescriptor(void *fileDescriptor, char *buffer, usize count)
+{
+    i64 bytesRead = 0;
+#if WINDOWS
+    bytesRead = _read((i32)(i64)fileDescriptor, buffer, (u32)count);
+#elif POSIX
+    bytesRead = read((i32)(i64)fileDescriptor, buffer, count);
+#else
+    //no platform to read with, so the input is always empty
+    (void)fileDescriptor;
+    (void)buffer;
+    (void)count;
+#endif
+    //errors end the input the same way running out of it does
+    return bytesRead > 0 ? (usize)bytesRead : 0;
+}
+Json::JsonReader::JsonReader()
+{
+    this->allocator = IAllocator{};
+    this->readFunc = NULL;
+    this->userData = NULL;
+    this->buffer = NULL;
+    this->bufferCapacity = 0;
+    this->bufferLength = 0;
+    this->endOfInput = true;
+    this->linesDiscarded = 0;
+    this->pinnedStart = 0;
+    this->pinned = false;
+    this->tokenizer = JsonTokenizer();
+    this->containers = collections::vector<JsonEventType>();
+    this->state = JsonReaderState_Value;
+    this->lastEvent = JsonEvent_EndOfInput;
+    this->lastTokenStart = 0;
+}
+Json::JsonReader::JsonReader(IAllocator allocator, JsonReadFunc readFunc, void *userData, usize chunkSize)
+{
+    this->allocator = allocator;
+    this->readFunc = readFunc;
+    this->userData = userData;
+    this->bufferCapacity = (chunkSize + JSON_STRUCTURAL_BLOCK - 1) / JSON_STRUCTURAL_BLOCK * JSON_STRUCTURAL_BLOCK;
+    if (this->bufferCapacity == 0)
+    {
+        this->bufferCapacity = JSON_STRUCTURAL_BLOCK;
+    }
+    this->buffer = (char *)allocator.Allocate(this->bufferCapacity + 1);
+    this->buffer[0] = '\0';
+    this->bufferLength = 0;
+    this->endOfInput = false;
+    this->linesDiscarded = 0;
+    this->pinnedStart = 0;
+    this->pinned = false;
+    this->tokenizer = JsonTokenizer();
+    this->tokenizer.fileContents = this->buffer;
+    this->tokenizer.length = 1;
+    this->tokenizer.inPlace = true;
+    this->tokenizer.scanner = JsonStructuralScanner(this->buffer, 0);
+    this->containers = collections::vector<JsonEventType>(allocator);
+    this->state = JsonReaderState_Value;
+    this->lastEvent = JsonEvent_EndOfInput;
+    this->lastTokenStart = 0;
+}
+Json::JsonReader Json::JsonReader::FromFile(IAllocator allocator, FILE *file, usize chunkSize)
+{
+    return JsonReader(allocator, &Json_ReadFromFile, file, chunkSize);
+}
+Json::JsonReader Json::JsonReader::FromFileDescriptor(IAllocator allocator, i32 fileDescriptor, usize chunkSize)
+{
+    return JsonReader(allocator, &Json_ReadFromFileDescriptor, (void *)(i64)fileDescriptor, chunkSize);
+}
+void Json::JsonReader::deinit()
+{
+    if (buffer != NULL)
+    {
+        allocator.FREEPTR(buffer);
+    }
+    containers.deinit();
+}
+void Json::JsonReader::Refill()
+{
+    //everything before the next unread token has been consumed, unless ReadElement still needs it
+    usize keep = tokenizer.scanner.position;
+    if (tokenizer.currentStructural < tokenizer.structuralsCount)
+    {
+        usize next = tokenizer.structurals[tokenizer.currentStructural] & ~JSON_STRUCTURAL_ESCAPES;
+        if (next < keep)
+        {
+            keep = next;
+        }
+    }
+    if (pinned && pinnedStart < keep)
+    {
+        keep = pinnedStart;
+    }
+    if (keep > 0)
+    {
+        //the tokenizer's count skips escapes already decoded in place, so it is used rather than counting the buffer again
+        tokenizer.CountLinesTo(keep);
+        linesDiscarded += tokenizer.linesCounted;
+        tokenizer.linesCounted = 0;
+        tokenizer.linesCountedTo -= keep;
+        memmove(buffer, buffer + keep, bufferLength - keep);
+        bufferLength -= keep;
+        tokenizer.scanner.position -= keep;
+        for (usize i = tokenizer.currentStructural; i < tokenizer.structuralsCount; i++)
+        {
+            tokenizer.structurals[i] -= keep;
+        }
+        tokenizer.currentIndex = tokenizer.currentIndex > keep ? tokenizer.currentIndex - keep : 0;
+        if (pinned)
+        {
+            pinnedStart -= keep;
+        }
+    }
+    //a token longer than the buffer
+    if (bufferLength == bufferCapacity)
+    {
+        char *newBuffer = (char *)allocator.Allocate(bufferCapacity * 2 + 1);
+        memcpy(newBuffer, buffer, bufferLength);
+        allocator.Free(buffer);
+        buffer = newBuffer;
+        bufferCapacity *= 2;
+    }
+
+    usize bytesRead = readFunc(userData, buffer + bufferLength, bufferCapacity - bufferLength);
+    if (bytesRead == 0)
+    {
+        endOfInput = true;
+    }
+    bufferLength += bytesRead;
+    buffer[bufferLength] = '\0';
+
+    tokenizer.fileContents = buffer;
+    tokenizer.length = bufferLength + 1;
+    tokenizer.scanner.contents = buffer;
+    //until the input ends only whole blocks are scanned, as the scanner pads a partial block as if it were the last
+    usize unscanned = bufferLength - tokenizer.scanner.position;
+    tokenizer.scanner.length = endOfInput ? bufferLength : bufferLength - unscanned % JSON_STRUCTURAL_BLOCK;
+}
+//Reading a token needs the position after it too, see JsonTokenizer::EnsureStructurals
+void Json::JsonReader::EnsureTokens()
+{
+    while (true)
+    {
+        tokenizer.EnsureStructurals();
+        if (tokenizer.structuralsCount - tokenizer.currentStructural >= 2 || (endOfInput && tokenizer.scanner.IsDone()))
+        {
+            return;
+        }
+        Refill();
+    }
+}
+Json::JsonEvent Json::JsonReader::Fail()
+{
+    state = JsonReaderState_Failed;
+    lastEvent = JsonEvent_Error;
+    JsonEvent result;
+    result.eventType = JsonEvent_Error;
+    result.valueType = JsonToken_Invalid;
+    result.value = string();
+    return result;
+}
+Json::JsonEvent Json::JsonReader::Next()
+{
+    JsonEvent result;
+    result.eventType = JsonEvent_Error;
+    result.valueType = JsonToken_Invalid;
+    result.value = string();
+    if (state == JsonReaderState_Failed)
+    {
+        return result;
+    }
+    while (true)
+    {
+        EnsureTokens();
+        if (tokenizer.currentStructural >= tokenizer.structuralsCount)
+        {
+            if (containers.count == 0 && (state == JsonReaderState_Value || state == JsonReaderState_AfterValue))
+            {
+                result.eventType = JsonEvent_EndOfInput;
+                lastEvent = result.eventType;
+                return result;
+            }
+            return Fail();
+        }
+        JsonToken token = tokenizer.Next();
+        lastTokenStart = token.startIndex;
+
+        switch (state)
+        {
+            case JsonReaderState_AfterValue:
+            {
+                //another top level value
+                if (containers.count == 0)
+                {
+                    break;
+                }
+                JsonEventType container = containers.ptr[containers.count - 1];
+                if (token.tokenType == JsonToken_Comma)
+                {
+                    state = container == JsonEvent_StartObject ? JsonReaderState_Key : JsonReaderState_Value;
+                    continue;
+                }
+                if (token.tokenType != (container == JsonEvent_StartObject ? JsonToken_RBrace : JsonToken_RBracket))
+                {
+                    return Fail();
+                }
+                containers.count--;
+                result.eventType = container == JsonEvent_StartObject ? JsonEvent_EndObject : JsonEvent_EndArray;
+                lastEvent = result.eventType;
+                return result;
+            }
+            case JsonReaderState_FirstArrayValue:
+            {
+                if (token.tokenType == JsonToken_RBracket)
+                {
+                    containers.count--;
+                    state = JsonReaderState_AfterValue;
+                    result.eventType = JsonEvent_EndArray;
+                    lastEvent = result.eventType;
+                    return result;
+                }
+                break;
+            }
+            case JsonReaderState_FirstKey:
+            case JsonReaderState_Key:
+            {
+                if (state == JsonReaderState_FirstKey && token.tokenType == JsonToken_RBrace)
+                {
+                    containers.count--;
+                    state = JsonReaderState_AfterValue;
+                    result.eventType = JsonEvent_EndObject;
+                    lastEvent = result.eventType;
+                    return result;
+                }
+                if (token.tokenType != JsonToken_StringLiteral)
+                {
+                    return Fail();
+                }
+                //the colon is left for the next call, as reading it may move the buffer out from under the key
+                state = JsonReaderState_Colon;
+                result.eventType = JsonEvent_Key;
+                result.valueType = JsonToken_StringLiteral;
+                result.value = tokenizer.GetView(token);
+                lastEvent = result.eventType;
+                return result;
+            }
+            case JsonReaderState_Colon:
+            {
+                if (token.tokenType != JsonToken_Colon)
+                {
+                    return Fail();
+                }
+                state = JsonReaderState_Value;
+                continue;
+            }
+            default:
+                break;
+        }
+
+        switch (token.tokenType)
+        {
+            case JsonToken_LBrace:
+                containers.Add(JsonEvent_StartObject);
+                state = JsonReaderState_FirstKey;
+                result.eventType = JsonEvent_StartObject;
+                break;
+            case JsonToken_LBracket:
+                containers.Add(JsonEvent_StartArray);
+                state = JsonReaderState_FirstArrayValue;
+                result.eventType = JsonEvent_StartArray;
+                break;
+            case JsonToken_StringLiteral:
+            case JsonToken_IntegerLiteral:
+            case JsonToken_FloatLiteral:
+            case JsonToken_BoolLiteral:
+            case JsonToken_NullLiteral:
+                state = JsonReaderState_AfterValue;
+                result.eventType = JsonEvent_Value;
+                result.valueType = token.tokenType;
+                result.value = tokenizer.GetView(token);
+                break;
+            default:
+                return Fail();
+        }
+        lastEvent = result.eventType;
+        return result;
+    }
+}
+//Skips to the end of the container whose opening bracket was just read, using the token positions alone
+bool Json::JsonReader::SkipContainer()
+{
+    usize depth = 1;
+    while (depth > 0)
+    {
+        EnsureTokens();
+        if (tokenizer.currentStructural >= tokenizer.structuralsCount)
+        {
+            return false;
+        }
+        usize position = tokenizer.structurals[tokenizer.currentStructural] & ~JSON_STRUCTURAL_ESCAPES;
+        tokenizer.currentStructural++;
+        tokenizer.currentIndex = position + 1;
+        switch (buffer[position])
+        {
+            case '{':
+            case '[':
+                depth++;
+                break;
+            case '}':
+            case ']':
+                depth--;
+                break;
+            case '"':
+            {
+                //the string's closing quote is always the next position
+                if (tokenizer.currentStructural >= tokenizer.structuralsCount)
+                {
+                    return false;
+                }
+                tokenizer.currentIndex = (tokenizer.structurals[tokenizer.currentStructural] & ~JSON_STRUCTURAL_ESCAPES) + 1;
+                tokenizer.currentStructural++;
+                break;
+            }
+            default:
+                break;
+        }
+    }
+    return true;
+}
+bool Json::JsonReader::Skip()
+{
+    if (lastEvent == JsonEvent_Key)
+    {
+        JsonEvent value = Next();
+        if (value.eventType == JsonEvent_Value)
+        {
+            return true;
+        }
+        if (value.eventType != JsonEvent_StartObject && value.eventType != JsonEvent_StartArray)
+        {
+            return false;
+        }
+    }
+    else if (lastEvent != JsonEvent_StartObject && lastEvent != JsonEvent_StartArray)
+    {
+        return false;
+    }
+    if (!SkipContainer())
+    {
+        Fail();
+        return false;
+    }
+    lastEvent = containers.ptr[containers.count - 1] == JsonEvent_StartObject ? JsonEvent_EndObject : JsonEvent_EndArray;
+    containers.count--;
+    state = JsonReaderState_AfterValue;
+    return true;
+}
+bool Json::JsonReader::ReadElement(IAllocator elementAllocator, JsonElement *result)
+{
+    if (lastEvent == JsonEvent_Key)
+    {
+        JsonEvent value = Next();
+        if (value.eventType == JsonEvent_Value)
+        {
+            //strings in value are already unescaped
+            *result = JsonElement(string(elementAllocator, value.value.buffer, value.value.length - 1));
+            result->scalar = value.GetScalar();
+            return true;
+        }
+        if (value.eventType != JsonEvent_StartObject && value.eventType != JsonEvent_StartArray)
+        {
+            return false;
+        }
+    }
+    else if (lastEvent != JsonEvent_StartObject && lastEvent != JsonEvent_StartArray)
+    {
+        return false;
+    }
+    //keep the container's text in the buffer while skipping over it, then parse that text on its own
+    pinned = true;
+    pinnedStart = lastTokenStart;
+    bool skipped = Skip();
+    pinned = false;
+    if (!skipped)
+    {
+        return false;
+    }
+    string text = string();
+    text.buffer = buffer + pinnedStart;
+    //the scanner stops at length - 1, so this does not need to be null terminated
+    text.length = tokenizer.currentIndex - pinnedStart + 1;
+    if (ParseJsonDocument(elementAllocator, text, result) != 0)
+    {
+        Fail();
+        return false;
+    }
+    return true;
+}
+
+void Json_WriteToFile(void *file, const char *chars, usize count)
+{
+    fwrite(chars, 1, count, (FILE *)file);
+}
+Json::JsonWriter::JsonWriter()
+{
+    this->allocator = IAllocator{};
+    this->writeFunc = NULL;
+    this->userData = NULL;
+    this->stream = NULL;
+    this->buffer = NULL;
+    this->bufferCapacity = 0;
+    this->bufferLength = 0;
+    this->previousToken = JsonToken_Invalid;
+    this->indentTypes = collections::vector<JsonTokenType>();
+    this->shouldIndent = false;
+    this->isBinary = false;
+}
+Json::JsonWriter::JsonWriter(IAllocator allocator, JsonWriteFunc writeFunc, void *userData, usize blockSize, bool writerShouldIndent)
+{
+    this->allocator = allocator;
+    this->writeFunc = writeFunc;
+    this->userData = userData;
+    this->stream = NULL;
+    //one more byte than the capacity, for TakeString's null terminator
+    this->buffer = (char *)allocator.Allocate(blockSize + 1);
+    this->bufferCapacity = blockSize;
+    this->bufferLength = 0;
+    this->previousToken = JsonToken_Invalid;
+    this->indentTypes = collections::vector<JsonTokenType>(allocator);
+    this->shouldIndent = writerShouldIndent;
+    this->isBinary = false;
+}
+Json::JsonWriter::JsonWriter(IAllocator allocator, FILE *fileStream, bool writerShouldIndent)
+{
+    *this = JsonWriter(allocator, &Json_WriteToFile, fileStream, JSON_WRITER_BLOCK_SIZE, writerShouldIndent);
+    this->stream = fileStream;
+}
+Json::JsonWriter Json::JsonWriter::ToMemory(IAllocator allocator, usize initialCapacity, bool writerShouldIndent)
+{
+    return JsonWriter(allocator, NULL, NULL, initialCapacity, writerShouldIndent);
+}
+void Json::JsonWriter::deinit()
+{
+    Flush();
+    if (buffer != NULL)
+    {
+        allocator.FREEPTR(buffer);
+    }
+    bufferCapacity = 0;
+    indentTypes.deinit();
+}
+void Json::JsonWriter::Flush()
+{
+    if (writeFunc != NULL && bufferLength > 0)
+    {
+        writeFunc(userData, buffer, bufferLength);
+        bufferLength = 0;
+    }
+}
+string Json::JsonWriter::TakeString()
+{
+    string result = string(allocator);
+    if (buffer != NULL)
+    {
+        buffer[bufferLength] = '\0';
+        result.buffer = buffer;
+        result.length = bufferLength + 1;
+    }
+    buffer = NULL;
+    bufferCapacity = 0;
+    bufferLength = 0;
+    return result;
+}
+void Json::JsonWriter::MakeRoom(usize length)
+{
+    if (writeFunc != NULL)
+    {
+        Flush();
+        if (length <= bufferCapacity)
+        {
+            return;
+        }
+    }
+    usize newCapacity = bufferCapacity * 2;
+    if (newCapacity < bufferLength + length)
+    {
+        newCapacity = bufferLength + length;
+    }
+    char *newBuffer = (char *)allocator.Allocate(newCapacity + 1);
+    if (buffer != NULL)
+    {
+        memcpy(newBuffer, buffer, bufferLength);
+        allocator.Free(buffer);
+    }
+    buffer = newBuffer;
+    bufferCapacity = newCapacity;
+}
+//index of the first character from start on that must be escaped inside a JSON string, or length if there is none
+inline usize Json_FindEscape(const char *chars, usize start, usize length)
+{
+    usize i = start;
+#if defined(JSON_USE_AVX2) || defined(JSON_USE_SSE2)
+    for (; i + 16 <= length; i += 16)
+    {
+        __m128i bytes = _mm_loadu_si128((const __m128i *)(chars + i));
+        //control characters are the bytes that an unsigned max with 0x1F leaves as 0x1F
+        __m128i control = _mm_cmpeq_epi8(_mm_max_epu8(bytes, _mm_set1_epi8(0x1F)), _mm_set1_epi8(0x1F));
+        __m128i special = _mm_or_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8('"')), _mm_cmpeq_epi8(bytes, _mm_set1_epi8('\\')));
+        u32 mask = (u32)_mm_movemask_epi8(_mm_or_si128(control, special));
+        if (mask != 0)
+        {
+            return i + Json_LowestBit64(mask);
+        }
+    }
+#endif
+    for (; i < length; i++)
+    {
+        u8 c = (u8)chars[i];
+        if (c < 0x20 || c == '"' || c == '\\')
+        {
+            return i;
+        }
+    }
+    return length;
+}
+void Json::JsonWriter::WriteQuoted(const char *chars, usize length)
+{
+    Write("\"", 1);
+    usize runStart = 0;
+    while (true)
+    {
+        usize escapeIndex = Json_FindEscape(chars, runStart, length);
+        Write(chars + runStart, escapeIndex - runStart);
+        if (escapeIndex == length)
+        {
+            break;
+        }
+        u8 c = (u8)chars[escapeIndex];
+        switch (c)
+        {
+            case '"': Write("\\\"", 2); break;
+            case '\\': Write("\\\\", 2); break;
+            case '\b': Write("\\b", 2); break;
+            case '\f': Write("\\f", 2); break;
+            case '\n': Write("\\n", 2); break;
+            case '\r': Write("\\r", 2); break;
+            case '\t': Write("\\t", 2); break;
+            default:
+            {
+                char *escaped = Reserve(6);
+                memcpy(escaped, "\\u00", 4);
+                escaped[4] = "0123456789abcdef"[c >> 4];
+                escaped[5] = "0123456789abcdef"[c & 0xF];
+                break;
+            }
+        }
+        runStart = escapeIndex + 1;
+    }
+    Write("\"", 1);
+}
 #endif
\ No newline at end of file
@@ -2,215 +2,684 @@
 #include "Json.hpp"
 #include "binaryio.hpp"
 #include "ByteStreamOps.hpp"
+#include "filecache.hpp"
 
+//"BFMT" read as a little endian u32
+#define JSON_BFMT_MAGIC 0x544D4642u
+//Version 1 was the old headerless stream of tagged values. Key hashes are part of the format, so a change to Hash64 needs a new version
+#define JSON_BFMT_VERSION 2
+#define JSON_BFMT_HEADER_SIZE 16
+
+//A bfmt document is laid out so it can be read straight out of a mapped file without being deserialized.
+//All values are little endian, and offsets are u32s from the start of the document, so documents are under 4GB.
+//
+//header: u32 magic, u32 version, u32 document size, u32 offset of the root node
+//every node starts with a u32 JsonBfmtType, then:
+//  Object:   u32 count, u32 hash table size, u32 unused,
+//            u32 key hash[count], u32 key offset[count], u32 value offset[count], u32 table[hash table size]
+//  Array:    u32 count, u32 value offset[count]
+//  String:   u32 length, then the characters and a null terminator. Object keys are String nodes too
+//  Bool:     u32 0 or 1
+//  Null:     u32 unused
+//  Integer, Unsigned, Double: u32 unused, then the 8 byte value. These nodes are 8 byte aligned
+//
+//Objects with at least JSON_OBJECT_MAP_THRESHOLD members have a power of two sized, linearly probed hash table
+//of member index + 1, with 0 for empty slots. Smaller objects are searched through their key hashes instead
 namespace Json
 {
+    enum JsonBfmtType
+    {
+        JsonBfmt_Invalid,
+        JsonBfmt_Object,
+        JsonBfmt_Array,
+        JsonBfmt_String,
+        JsonBfmt_Integer,
+        JsonBfmt_Unsigned,
+        JsonBfmt_Double,
+        JsonBfmt_Bool,
+        JsonBfmt_Null
+    };
+
+    inline u32 JsonBfmtHashKey(const char *key, usize keyLength)
+    {
+        return (u32)Hash64(key, keyLength);
+    }
+
+    //A node of a bfmt document, read in place. Values returned from a missing key or an out of range index are invalid,
+    //and every getter on an invalid value returns nothing, so lookups can be chained without checks in between
+    struct JsonBfmtValue
+    {
+        const u8 *document;
+        u32 offset;
+
+        inline JsonBfmtValue()
+        {
+            document = NULL;
+            offset = 0;
+        }
+        inline JsonBfmtValue(const u8 *document, u32 offset)
+        {
+            this->document = document;
+            this->offset = offset;
+        }
+        inline u32 ReadU32(u32 byteOffset)
+        {
+            return *(const u32 *)(document + offset + byteOffset);
+        }
+        inline bool IsValid()
+        {
+            return document != NULL;
+        }
+        inline JsonBfmtType GetType()
+        {
+            return document == NULL ? JsonBfmt_Invalid : (JsonBfmtType)ReadU32(0);
+        }
+        //members of an object or elements of an array
+        inline u32 GetCount()
+        {
+            JsonBfmtType type = GetType();
+            return type == JsonBfmt_Object || type == JsonBfmt_Array ? ReadU32(4) : 0;
+        }
+        //an array's element or an object's member value, in the order they were written
+        inline JsonBfmtValue GetIndex(u32 index)
+        {
+            JsonBfmtType type = GetType();
+            if (type == JsonBfmt_Array && index < ReadU32(4))
+            {
+                return JsonBfmtValue(document, ReadU32(8 + index * 4));
+            }
+            if (type == JsonBfmt_Object && index < ReadU32(4))
+            {
+                return JsonBfmtValue(document, ReadU32(16 + ReadU32(4) * 8 + index * 4));
+            }
+            return JsonBfmtValue();
+        }
+        //the name of an object's member, as a string node
+        inline JsonBfmtValue GetKey(u32 index)
+        {
+            if (GetType() == JsonBfmt_Object && index < ReadU32(4))
+            {
+                return JsonBfmtValue(document, ReadU32(16 + ReadU32(4) * 4 + index * 4));
+            }
+            return JsonBfmtValue();
+        }
+        //hash must be JsonBfmtHashKey(key, keyLength), which callers looking up the same key many times can compute once
+        JsonBfmtValue GetChild(const char *key, usize keyLength, u32 hash);
+        inline JsonBfmtValue GetChild(const char *key, usize keyLength)
+        {
+            return GetChild(key, keyLength, JsonBfmtHashKey(key, keyLength));
+        }
+        inline JsonBfmtValue GetChild(const char *key)
+        {
+            return GetChild(key, strlen(key));
+        }
+        //takes an int rather than a u32 so that [0] is not ambiguous with the key overload
+        inline JsonBfmtValue operator[](i32 index)
+        {
+            return GetIndex((u32)index);
+        }
+        inline JsonBfmtValue operator[](const char *key)
+        {
+            return GetChild(key);
+        }
+        /// @brief Gets a string node's text without copying it.
+        /// The result points into the document, so it must not be deinit, and is null terminated with length counting the terminator
+        inline string GetString()
+        {
+            string result = string();
+            if (GetType() == JsonBfmt_String)
+            {
+                result.buffer = (char *)(document + offset + 8);
+                result.length = ReadU32(4) + 1;
+            }
+            return result;
+        }
+        //the node's value, with valueType JsonValue_None for objects, arrays and invalid values
+        JsonScalar GetScalar();
+        //copies this node and everything under it into a JsonElement
+        void ToElement(IAllocator allocator, JsonElement *result);
+    };
+
+    /// @brief Checks the header of a bfmt document and returns its root node, which is invalid if the header is not one this
+    /// version can read. The contents are not validated past the header, so only open documents from trusted sources.
+    /// data must stay alive and unmoved while the document is used, and be at least 8 byte aligned
+    JsonBfmtValue OpenJsonBfmt(const void *data, usize length);
+    //Converts json to a bfmt document. Returns an empty array if the document would not fit in 4GB
+    collections::Array<u8> JsonConvertToBfmt(IAllocator allocator, JsonElement *json);
+    //writes json as a bfmt document to a file opened in binary mode
     void JsonConvertToBinary(FILE *fs, JsonElement *json);
+    //Reads the bfmt document at the reader's position, padded to a multiple of 8, fully into result, and moves past it.
+    //result is left as an empty element if the header is invalid or the stream's memory leaves the document misaligned
     void ParseJsonBfmtElement(IAllocator allocator, ByteStreamReader *reader, JsonElement *result);
 
-    enum JsonBinaryFieldType
-    {
-        JsonBinaryField_Property,
-        JsonBinaryField_Array,
-        JsonBinaryField_String,
-        JsonBinaryField_Float,
-        JsonBinaryField_Bool,
-        JsonBinaryField_Null,
-        JsonBinaryField_Int8,
-        JsonBinaryField_Int16,
-        JsonBinaryField_Int32,
-        JsonBinaryField_Int64
+    //A bfmt document held in a file cache's mapped artifact, or in memory when the artifact could not be stored
+    struct JsonCachedBfmt
+    {
+        io::MappedFile mapped;
+        collections::Array<u8> bytes;
+        JsonBfmtValue root;
+
+        inline JsonCachedBfmt()
+        {
+            mapped = io::MappedFile();
+            bytes = collections::Array<u8>();
+            root = JsonBfmtValue();
+        }
+        inline void deinit()
+        {
+            mapped.deinit();
+            bytes.deinit();
+            bytes = collections::Array<u8>();
+            root = JsonBfmtValue();
+        }
     };
+    /// @brief Opens the bfmt form of the json file at path from cache, so that reading an unchanged file again does no text parsing.
+    /// On a miss the file is parsed with allocator, converted and stored in the cache under the artifact name "bfmt"
+    /// @return false if the file cannot be read or is not valid json
+    bool ReadJsonBfmtCached(IAllocator allocator, io::FileCache *cache, const char *path, JsonCachedBfmt *result);
 }
 
 #ifdef ASTRALCORE_JSON_IMPL
 
-void Json::ParseJsonBfmtElement(IAllocator allocator, ByteStreamReader *reader, JsonElement *result)
+Json::JsonBfmtValue Json::OpenJsonBfmt(const void *data, usize length)
+{
+    const u8 *document = (const u8 *)data;
+    if (document == NULL || length < JSON_BFMT_HEADER_SIZE)
+    {
+        return JsonBfmtValue();
+    }
+    const u32 *header = (const u32 *)document;
+    if (header[0] != JSON_BFMT_MAGIC || header[1] != JSON_BFMT_VERSION || header[2] > length || header[3] < JSON_BFMT_HEADER_SIZE || header[3] + 8 > header[2])
+    {
+        return JsonBfmtValue();
+    }
+    return JsonBfmtValue(document, header[3]);
+}
+
+Json::JsonBfmtValue Json::JsonBfmtValue::GetChild(const char *key, usize keyLength, u32 hash)
+{
+    if (GetType() != JsonBfmt_Object)
+    {
+        return JsonBfmtValue();
+    }
+    u32 count = ReadU32(4);
+    u32 tableSize = ReadU32(8);
+    const u32 *hashes = (const u32 *)(document + offset + 16);
+    const u32 *keyOffsets = hashes + count;
+    const u32 *valueOffsets = keyOffsets + count;
+
+    if (tableSize == 0)
+    {
+        for (u32 i = 0; i < count; i++)
+        {
+            if (hashes[i] == hash)
+            {
+                const u8 *keyNode = document + keyOffsets[i];
+                if (*(const u32 *)(keyNode + 4) == keyLength && memcmp(keyNode + 8, key, keyLength) == 0)
+                {
+                    return JsonBfmtValue(document, valueOffsets[i]);
+                }
+            }
+        }
+        return JsonBfmtValue();
+    }
+    const u32 *table = valueOffsets + count;
+    for (u32 slot = hash & (tableSize - 1); table[slot] != 0; slot = (slot + 1) & (tableSize - 1))
+    {
+        u32 index = table[slot] - 1;
+        if (hashes[index] == hash)
+        {
+            const u8 *keyNode = document + keyOffsets[index];
+            if (*(const u32 *)(keyNode + 4) == keyLength && memcmp(keyNode + 8, key, keyLength) == 0)
+            {
+                return JsonBfmtValue(document, valueOffsets[index]);
+            }
+        }
+    }
+    return JsonBfmtValue();
+}
+
+Json::JsonScalar Json::JsonBfmtValue::GetScalar()
 {
-    JsonBinaryFieldType fieldType = (JsonBinaryFieldType)reader->Read<u8>();
-    if (fieldType == JsonBinaryField_Property)
+    JsonScalar result;
+    result.valueType = JsonValue_None;
+    result.asInteger = 0;
+    switch (GetType())
     {
-        u32 count = reader->Read<u32>();
+        case JsonBfmt_String:
+            result.valueType = JsonValue_String;
+            break;
+        case JsonBfmt_Integer:
+            result.valueType = JsonValue_Integer;
+            result.asInteger = *(const i64 *)(document + offset + 8);
+            break;
+        case JsonBfmt_Unsigned:
+            result.valueType = JsonValue_Unsigned;
+            result.asUnsigned = *(const u64 *)(document + offset + 8);
+            break;
+        case JsonBfmt_Double:
+            result.valueType = JsonValue_Double;
+            result.asDouble = *(const double *)(document + offset + 8);
+            break;
+        case JsonBfmt_Bool:
+            result.valueType = JsonValue_Bool;
+            result.asBool = ReadU32(4) != 0;
+            break;
+        case JsonBfmt_Null:
+            result.valueType = JsonValue_Null;
+            break;
+        default:
+            break;
+    }
+    return result;
+}
 
-        *result = JsonElement(collections::hashmap<string, JsonElement>(allocator, &stringHash, &stringEql));
+void Json::JsonBfmtValue::ToElement(IAllocator allocator, JsonElement *result)
+{
+    JsonBfmtType type = GetType();
+    if (type == JsonBfmt_Object)
+    {
+        u32 count = ReadU32(4);
+        *result = JsonElement(JsonObjectMap(allocator, StringHasher(), StringEql()));
         result->arrayElements = collections::Array<JsonElement>(allocator, count);
+        result->keys = count == 0 ? NULL : (string *)allocator.Allocate(sizeof(string) * count);
         for (u32 i = 0; i < count; i++)
         {
-            string key = reader->ReadString(allocator);
+            string keyView = GetKey(i).GetString();
+            string key = string(allocator, keyView.buffer, keyView.length - 1);
             JsonElement value;
-            ParseJsonBfmtElement(allocator, reader, &value);
+            GetIndex(i).ToElement(allocator, &value);
             result->childObjects.Add(key, value);
             result->arrayElements.data[i] = value;
+            result->keys[i] = key;
         }
     }
-    else if (fieldType == JsonBinaryField_Array)
+    else if (type == JsonBfmt_Array)
     {
-        u32 count = reader->Read<u32>();
-
+        u32 count = ReadU32(4);
         *result = JsonElement(collections::Array<JsonElement>(allocator, count));
         for (u32 i = 0; i < count; i++)
         {
-            JsonElement value;
-            ParseJsonBfmtElement(allocator, reader, &value);
-            result->arrayElements.data[i] = value;
+            GetIndex(i).ToElement(allocator, &result->arrayElements.data[i]);
         }
     }
+    else if (type == JsonBfmt_String)
+    {
+        string view = GetString();
+        *result = JsonElement(string(allocator, view.buffer, view.length - 1));
+        result->scalar.valueType = JsonValue_String;
+    }
     else
     {
-        result->value = string();
-        result->value.allocator = allocator;
-        switch (fieldType)
+        *result = JsonElement(string(allocator));
+        result->scalar = GetScalar();
+    }
+}
+
+//builds a bfmt document in one growing buffer, with nodes referring to each other by offset as the buffer moves
+struct JsonBfmtBuilder
+{
+    IAllocator allocator;
+    u8 *data;
+    usize length;
+    usize capacity;
+    bool tooLarge;
+    //string nodes already written, so that repeated keys and values are stored once
+    collections::hashmap<string, u32, StringHasher, StringEql> strings;
+
+    //starts a document with space for its header, which Finish fills in
+    inline JsonBfmtBuilder(IAllocator allocator)
+    {
+        this->allocator = allocator;
+        this->data = NULL;
+        this->length = 0;
+        this->capacity = 0;
+        this->tooLarge = false;
+        this->strings = collections::hashmap<string, u32, StringHasher, StringEql>(allocator, StringHasher(), StringEql());
+        Reserve(JSON_BFMT_HEADER_SIZE, 8);
+    }
+    //zero filled space for bytes at the next multiple of alignment, returning its offset
+    inline u32 Reserve(usize bytes, usize alignment)
+    {
+        usize start = (length + alignment - 1) & ~(alignment - 1);
+        if (start + bytes > U32Max)
         {
-            case JsonBinaryField_Null:
-            {
-                result->value = string();
-                break;
-            }
-            case JsonBinaryField_String:
-            {
-                result->value = reader->ReadString(allocator);
-                break;
-            }
-            case JsonBinaryField_Bool:
-            {
-                result->value.length = 1;
-                result->value.buffer = (char *)malloc(1);
-                result->value.buffer[0] = reader->Read<bool>() ? 1 : 0;
-                break;
-            }
-            case JsonBinaryField_Float:
-            {
-                result->value.length = 4;
-                result->value.buffer = (char *)malloc(4);
-                *(float *)result->value.buffer = reader->Read<float>();
-                break;
-            }
-            case JsonBinaryField_Int8:
-            {
-                result->value.length = 1;
-                result->value.buffer = (char *)malloc(1);
-                result->value.buffer[0] = reader->Read<u8>();
-                break;
-            }
-            case JsonBinaryField_Int16:
+            tooLarge = true;
+            return 0;
+        }
+        if (start + bytes > capacity)
+        {
+            usize newCapacity = capacity * 2;
+            if (newCapacity < start + bytes)
             {
-                result->value.length = 2;
-                result->value.buffer = (char *)malloc(2);
-                *(u16 *)result->value.buffer = reader->Read<u16>();
-                break;
+                newCapacity = start + bytes;
             }
-            case JsonBinaryField_Int32:
+            u8 *newData = (u8 *)allocator.Allocate(newCapacity);
+            if (data != NULL)
             {
-                result->value.length = 4;
-                result->value.buffer = (char *)malloc(4);
-                *(u32 *)result->value.buffer = reader->Read<u32>();
-                break;
+                memcpy(newData, data, length);
+                allocator.Free(data);
             }
-            case JsonBinaryField_Int64:
+            data = newData;
+            capacity = newCapacity;
+        }
+        memset(data + length, 0, start + bytes - length);
+        length = start + bytes;
+        return (u32)start;
+    }
+    inline void WriteU32(u32 offset, u32 value)
+    {
+        if (!tooLarge)
+        {
+            *(u32 *)(data + offset) = value;
+        }
+    }
+    inline u32 AddString(const char *chars, usize charsLength)
+    {
+        u32 offset = Reserve(8 + charsLength + 1, 4);
+        if (!tooLarge)
+        {
+            WriteU32(offset, Json::JsonBfmt_String);
+            WriteU32(offset + 4, (u32)charsLength);
+            if (charsLength > 0)
             {
-                result->value.length = 8;
-                result->value.buffer = (char *)malloc(8);
-                *(u64 *)result->value.buffer = reader->Read<u64>();
-                break;
+                memcpy(data + offset + 8, chars, charsLength);
             }
-            default:
-                break;
         }
+        return offset;
+    }
+    //text must be null terminated, and stay alive until the builder is done
+    inline u32 AddSharedString(string text)
+    {
+        if (text.buffer == NULL)
+        {
+            text.buffer = (char *)"";
+            text.length = 1;
+        }
+        u32 *existing = strings.Get(text);
+        if (existing != NULL)
+        {
+            return *existing;
+        }
+        u32 offset = AddString(text.buffer, text.length - 1);
+        if (!tooLarge)
+        {
+            strings.Add(text, offset);
+        }
+        return offset;
+    }
+    inline u32 AddScalar(Json::JsonBfmtType type, u64 bits)
+    {
+        u32 offset = Reserve(16, 8);
+        if (!tooLarge)
+        {
+            WriteU32(offset, type);
+            *(u64 *)(data + offset + 8) = bits;
+        }
+        return offset;
+    }
+    inline u32 AddSmall(Json::JsonBfmtType type, u32 value)
+    {
+        u32 offset = Reserve(8, 4);
+        WriteU32(offset, type);
+        WriteU32(offset + 4, value);
+        return offset;
+    }
+    inline u32 AddDouble(double value)
+    {
+        u64 bits;
+        memcpy(&bits, &value, sizeof(double));
+        return AddScalar(Json::JsonBfmt_Double, bits);
+    }
+
+    //writes an array node whose elements are then filled in with SetElement
+    inline u32 BeginArray(usize count)
+    {
+        if (count > U32Max / 4)
+        {
+            tooLarge = true;
+            return 0;
+        }
+        u32 offset = Reserve(8 + count * 4, 4);
+        WriteU32(offset, Json::JsonBfmt_Array);
+        WriteU32(offset + 4, (u32)count);
+        return offset;
+    }
+    inline void SetElement(u32 arrayOffset, usize index, u32 valueOffset)
+    {
+        WriteU32(arrayOffset + 8 + (u32)index * 4, valueOffset);
+    }
+    //writes an object node whose members are then filled in with SetMember, and its hash table by EndObject
+    u32 BeginObject(usize count);
+    //key must be null terminated, and stay alive until the builder is done
+    void SetMember(u32 objectOffset, usize index, string key, u32 valueOffset);
+    void EndObject(u32 objectOffset);
+
+    u32 AddObject(Json::JsonElement *json);
+    u32 AddElement(Json::JsonElement *json);
+    //writes the header and hands over the document, or frees it and returns an empty array if it did not fit in 4GB
+    collections::Array<u8> Finish(u32 rootOffset);
+};
+
+u32 JsonBfmtBuilder::BeginObject(usize count)
+{
+    if (count > U32Max / 16)
+    {
+        tooLarge = true;
+        return 0;
+    }
+    u32 tableSize = 0;
+    if (count >= JSON_OBJECT_MAP_THRESHOLD)
+    {
+        tableSize = 1;
+        while (tableSize < count * 2)
+        {
+            tableSize *= 2;
+        }
+    }
+    u32 offset = Reserve(16 + count * 12 + tableSize * 4, 4);
+    WriteU32(offset, Json::JsonBfmt_Object);
+    WriteU32(offset + 4, (u32)count);
+    WriteU32(offset + 8, tableSize);
+    return offset;
+}
+void JsonBfmtBuilder::SetMember(u32 objectOffset, usize index, string key, u32 valueOffset)
+{
+    u32 keyOffset = AddSharedString(key);
+    if (tooLarge)
+    {
+        return;
+    }
+    u32 count = *(u32 *)(data + objectOffset + 4);
+    u32 hashesOffset = objectOffset + 16;
+    WriteU32(hashesOffset + (u32)index * 4, Json::JsonBfmtHashKey(key.buffer == NULL ? "" : key.buffer, key.buffer == NULL ? 0 : key.length - 1));
+    WriteU32(hashesOffset + (count + (u32)index) * 4, keyOffset);
+    WriteU32(hashesOffset + (count * 2 + (u32)index) * 4, valueOffset);
+}
+void JsonBfmtBuilder::EndObject(u32 objectOffset)
+{
+    if (tooLarge)
+    {
+        return;
+    }
+    u32 count = *(u32 *)(data + objectOffset + 4);
+    u32 tableSize = *(u32 *)(data + objectOffset + 8);
+    if (tableSize == 0)
+    {
+        return;
+    }
+    u32 *hashes = (u32 *)(data + objectOffset + 16);
+    u32 *table = hashes + count * 3;
+    for (u32 i = 0; i < count; i++)
+    {
+        u32 slot = hashes[i] & (tableSize - 1);
+        while (table[slot] != 0)
+        {
+            slot = (slot + 1) & (tableSize - 1);
+        }
+        table[slot] = i + 1;
     }
 }
 
-void Json::JsonConvertToBinary(FILE *fs, JsonElement *json)
+u32 JsonBfmtBuilder::AddObject(Json::JsonElement *json)
 {
-    switch (json->elementType)
+    //objects built by hand may only have childObjects, parsed ones always have keys in order
+    usize count = json->keys != NULL ? json->arrayElements.length : json->childObjects.count;
+    u32 offset = BeginObject(count);
+    auto iterator = json->childObjects.GetIterator();
+    for (usize i = 0; i < count && !tooLarge; i++)
     {
-        case JsonElement_Property:
+        if (json->keys != NULL)
         {
-            Binary_WriteData<u8>(fs, (u8)JsonBinaryField_Property);
-            Binary_WriteData<u32>(fs, (u32)json->childObjects.count);
-            
-            auto iterator = json->childObjects.GetIterator();
-            foreach (kvp, iterator)
-            {
-                Binary_WriteString(fs, kvp->key);
-                JsonConvertToBinary(fs, &kvp->value);
-            }
-            break;
+            u32 valueOffset = AddElement(&json->arrayElements.data[i]);
+            SetMember(offset, i, json->keys[i], valueOffset);
         }
-        case JsonElement_Array:
+        else
         {
-            Binary_WriteData<u8>(fs, (u8)JsonBinaryField_Array);
-            Binary_WriteData<u32>(fs, (u32)json->arrayElements.length);
-            for (usize i = 0; i < json->arrayElements.length; i++)
-            {
-                JsonConvertToBinary(fs, &json->arrayElements.data[i]);
-            }
-            break;
+            auto kvp = iterator.Next();
+            u32 valueOffset = AddElement(&kvp->value);
+            SetMember(offset, i, kvp->key, valueOffset);
         }
-        case JsonElement_Object:
+    }
+    EndObject(offset);
+    return offset;
+}
+
+u32 JsonBfmtBuilder::AddElement(Json::JsonElement *json)
+{
+    if (json->elementType == Json::JsonElement_Object)
+    {
+        return AddObject(json);
+    }
+    if (json->elementType == Json::JsonElement_Array)
+    {
+        usize count = json->arrayElements.length;
+        u32 offset = BeginArray(count);
+        for (usize i = 0; i < count && !tooLarge; i++)
         {
-            Json::JsonTokenType elemType = json->CheckElementType();
-            switch (elemType)
+            SetElement(offset, i, AddElement(&json->arrayElements.data[i]));
+        }
+        return offset;
+    }
+
+    //strings that look like numbers keep their type when it is known, GetScalar would convert them
+    Json::JsonScalar scalar = json->scalar.valueType == Json::JsonValue_None ? json->GetScalar() : json->scalar;
+    switch (scalar.valueType)
+    {
+        case Json::JsonValue_Integer:
+            return AddScalar(Json::JsonBfmt_Integer, (u64)scalar.asInteger);
+        case Json::JsonValue_Unsigned:
+            return AddScalar(Json::JsonBfmt_Unsigned, scalar.asUnsigned);
+        case Json::JsonValue_Double:
+            return AddDouble(scalar.asDouble);
+        case Json::JsonValue_Bool:
+            return AddSmall(Json::JsonBfmt_Bool, scalar.asBool ? 1 : 0);
+        case Json::JsonValue_Null:
+            return AddSmall(Json::JsonBfmt_Null, 0);
+        default:
+        {
+            if (!json->hasEscapes)
             {
-                case JsonToken_StringLiteral:
-                {
-                    Binary_WriteData<u8>(fs, (u8)JsonBinaryField_String);
-                    Binary_WriteString(fs, json->value);
-                    break;
-                }
-                case JsonToken_FloatLiteral:
-                {
-                    Binary_WriteData<u8>(fs, (u8)JsonBinaryField_Float);
-                    Binary_WriteData<float>(fs, json->GetFloat());
-                    break;
-                }
-                case JsonToken_BoolLiteral:
-                {
-                    Binary_WriteData<u8>(fs, (u8)JsonBinaryField_Bool);
-                    Binary_WriteData<bool>(fs, json->GetBool());
-                    break;
-                }
-                case JsonToken_NullLiteral:
-                {
-                    Binary_WriteData<u8>(fs, (u8)JsonBinaryField_Null);
-                    Binary_WriteText(fs, "null");
-                    break;
-                }
-                case JsonToken_IntegerLiteral:
-                {
-                    i64 output = 0;
-                    Json::JsonIntegerType type;
-                    json->GetInteger(&output, &type);
-                    if (type == Json::JsonInteger_I8 || type == Json::JsonInteger_U8)
-                    {
-                        i8 data = (i8)output;
-                        Binary_WriteData<u8>(fs, (u8)JsonBinaryField_Int8);
-                        Binary_WriteData<i8>(fs, data);
-                    }
-                    else if (type == Json::JsonInteger_I16 || type == Json::JsonInteger_U16)
-                    {
-                        i16 data = (i16)output;
-                        Binary_WriteData<u8>(fs, (u8)JsonBinaryField_Int16);
-                        Binary_WriteData<i16>(fs, data);
-                    }
-                    else if (type == Json::JsonInteger_I32 || type == Json::JsonInteger_U32)
-                    {
-                        i32 data = (i32)output;
-                        Binary_WriteData<u8>(fs, (u8)JsonBinaryField_Int32);
-                        Binary_WriteData<i32>(fs, data);
-                    }
-                    else
-                    {
-                        Binary_WriteData<u8>(fs, (u8)JsonBinaryField_Int64);
-                        Binary_WriteData<i64>(fs, output);
-                    }
-                    break;
-                }
-                default:
-                    break;
+                return AddSharedString(json->value);
             }
-            break;
+            string decoded = json->GetString(allocator);
+            u32 offset = AddString(decoded.buffer, decoded.length - 1);
+            decoded.deinit();
+            return offset;
         }
     }
 }
 
-#endif
\ No newline at end of file
+collections::Array<u8> JsonBfmtBuilder::Finish(u32 rootOffset)
+{
+    strings.deinit();
+    if (tooLarge)
+    {
+        if (data != NULL)
+        {
+            allocator.Free(data);
+        }
+        return collections::Array<u8>(allocator);
+    }
+    WriteU32(0, JSON_BFMT_MAGIC);
+    WriteU32(4, JSON_BFMT_VERSION);
+    WriteU32(8, (u32)length);
+    WriteU32(12, rootOffset);
+    return collections::Array<u8>(allocator, data, length);
+}
+
+collections::Array<u8> Json::JsonConvertToBfmt(IAllocator allocator, JsonElement *json)
+{
+    JsonBfmtBuilder builder = JsonBfmtBuilder(allocator);
+    u32 rootOffset = builder.AddElement(json);
+    return builder.Finish(rootOffset);
+}
+
+void Json::JsonConvertToBinary(FILE *fs, JsonElement *json)
+{
+    collections::Array<u8> bytes = JsonConvertToBfmt(GetCAllocator(), json);
+    fwrite(bytes.data, 1, bytes.length, fs);
+    bytes.deinit();
+}
+
+void Json::ParseJsonBfmtElement(IAllocator allocator, ByteStreamReader *reader, JsonElement *result)
+{
+    //the document is read in place through u32 and u64 loads, so it has to start 8 byte aligned in memory, not just in the stream
+    const u8 *document = reader->Align(8) ? reader->stream + reader->position : NULL;
+    JsonBfmtValue root = ((usize)document & 7) == 0 ? OpenJsonBfmt(document, reader->Remaining()) : JsonBfmtValue();
+    if (!root.IsValid())
+    {
+        *result = JsonElement();
+        return;
+    }
+    root.ToElement(allocator, result);
+    reader->Skip(8);
+    u32 documentLength = reader->Read<u32>();
+    reader->Skip(documentLength - 12);
+}
+
+bool Json::ReadJsonBfmtCached(IAllocator allocator, io::FileCache *cache, const char *path, JsonCachedBfmt *result)
+{
+    *result = JsonCachedBfmt();
+    result->mapped = cache->MapArtifact(path, "bfmt");
+    if (result->mapped.IsValid())
+    {
+        result->root = OpenJsonBfmt(result->mapped.data, result->mapped.length);
+        if (result->root.IsValid())
+        {
+            return true;
+        }
+        //written by another version of the format, so convert it again over the top
+        result->mapped.deinit();
+    }
+
+    JsonDocument document;
+    if (!ReadJsonDocument(allocator, path, &document))
+    {
+        document.deinit();
+        return false;
+    }
+    collections::Array<u8> bytes = JsonConvertToBfmt(allocator, &document.root);
+    document.deinit();
+    if (bytes.data == NULL)
+    {
+        return false;
+    }
+    if (cache->StoreArtifact(path, "bfmt", bytes.data, bytes.length))
+    {
+        result->mapped = cache->MapArtifact(path, "bfmt");
+    }
+    if (result->mapped.IsValid())
+    {
+        bytes.deinit();
+        result->root = OpenJsonBfmt(result->mapped.data, result->mapped.length);
+    }
+    else
+    {
+        result->bytes = bytes;
+        result->root = OpenJsonBfmt(bytes.data, bytes.length);
+    }
+    return result->root.IsValid();
+}
+
+#endif
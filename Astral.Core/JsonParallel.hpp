@@ -0,0 +1,267 @@
+#pragma once
+#include "Json.hpp"
+#include "jobs.hpp"
+
+//documents smaller than this are parsed on the calling thread, as splitting them costs more than it saves
+#define JSON_PARALLEL_MIN_CHUNK_SIZE (64 * 1024)
+
+namespace Json
+{
+    /// @brief Parses contents like ParseJsonDocumentInPlace, but when the root is a large array, its elements are parsed
+    /// in chunks on jobSystem's workers. A structural scan first finds where the top level elements begin, then each chunk
+    /// is parsed into its own arena, and the arenas are moved into the document's once every chunk is done.
+    /// Any other document is parsed on the calling thread. allocator is called from several threads, so must be thread safe
+    /// @return Whether parsing succeeded. On failure, result->errorLine holds the line of the error
+    bool ParseJsonDocumentParallel(IAllocator allocator, threading::JobSystem jobSystem, string contents, JsonDocument *result);
+    inline bool ReadJsonDocumentParallel(IAllocator allocator, threading::JobSystem jobSystem, const char *fileFullPath, JsonDocument *result)
+    {
+        string fileContents = io::ReadFile(allocator, fileFullPath, false);
+        if (fileContents.buffer == NULL)
+        {
+            *result = JsonDocument();
+            return false;
+        }
+        return ParseJsonDocumentParallel(allocator, jobSystem, fileContents, result);
+    }
+}
+
+#ifdef ASTRALCORE_JSON_IMPL
+
+//whether chars holds nothing but whitespace
+inline bool Json_IsBlank(const char *chars, usize length)
+{
+    for (usize i = 0; i < length; i++)
+    {
+        if (chars[i] != ' ' && chars[i] != '\t' && chars[i] != '\n' && chars[i] != '\r')
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+//A run of consecutive elements of the root array, parsed by one job
+struct Json_ParallelChunk
+{
+    const char *contents;
+    //from just after the [ or , before the first element, up to the , or ] after the last
+    usize start;
+    usize end;
+    Json::JsonElement *elements;
+    usize elementsCount;
+    IAllocator baseAllocator;
+    ArenaAllocator arena;
+    //line of the first syntax error counted from start, or 0 if the chunk parsed
+    usize errorLine;
+    //newlines before linesCountedTo, which the tokenizer counted before decoding any escapes in place.
+    //Nothing after linesCountedTo has been rewritten, so the rest of the chunk's lines can still be counted once it is done
+    usize linesCounted;
+    usize linesCountedTo;
+};
+
+void Json_ParseParallelChunk(void *data)
+{
+    Json_ParallelChunk *chunk = (Json_ParallelChunk *)data;
+    chunk->arena = ArenaAllocator(chunk->baseAllocator);
+    IAllocator allocator = chunk->arena.AsAllocator();
+
+    //positions stay relative to the whole document, so that error lines and views come out the same as a single threaded parse
+    Json::JsonTokenizer tokenizer = Json::JsonTokenizer(string());
+    tokenizer.fileContents = chunk->contents;
+    tokenizer.length = chunk->end;
+    tokenizer.currentIndex = chunk->start;
+    tokenizer.inPlace = true;
+    tokenizer.scanner = Json::JsonStructuralScanner(chunk->contents, chunk->end);
+    tokenizer.scanner.position = chunk->start;
+    //lines are counted from the start of the chunk, as the text before it may be being rewritten by another job
+    tokenizer.linesCountedTo = chunk->start;
+
+    Json::JsonParseStack stack = Json::JsonParseStack(GetCAllocator());
+    for (usize i = 0; i < chunk->elementsCount; i++)
+    {
+        if (!Json::ParseJsonElement(allocator, &tokenizer, &stack, &chunk->elements[i]))
+        {
+            chunk->errorLine = tokenizer.GetCurrentLine();
+            break;
+        }
+        //the scan already found the commas, so anything else here is a second value where one was expected
+        Json::JsonToken separator = tokenizer.Next();
+        bool isLast = i + 1 == chunk->elementsCount;
+        if (isLast ? separator.startIndex != separator.endIndex : separator.tokenType != Json::JsonToken_Comma)
+        {
+            chunk->errorLine = tokenizer.GetCurrentLine();
+            break;
+        }
+    }
+    chunk->linesCounted = tokenizer.linesCounted;
+    chunk->linesCountedTo = tokenizer.linesCountedTo;
+    stack.deinit();
+}
+//newlines in chars[start..end)
+inline usize Json_CountLines(const char *chars, usize start, usize end)
+{
+    usize lines = 0;
+    for (usize i = start; i < end; i++)
+    {
+        if (chars[i] == '\n')
+        {
+            lines++;
+        }
+    }
+    return lines;
+}
+
+bool Json::ParseJsonDocumentParallel(IAllocator allocator, threading::JobSystem jobSystem, string contents, JsonDocument *result)
+{
+    usize length = contents.length > 0 ? contents.length - 1 : 0;
+    if (jobSystem == NULL || length < JSON_PARALLEL_MIN_CHUNK_SIZE * 2)
+    {
+        return ParseJsonDocumentInPlace(allocator, contents, result);
+    }
+    //a few chunks per thread, including the caller, so that uneven elements still spread out
+    usize targetChunks = (threading::GetWorkerCount(jobSystem) + 1) * 4;
+    usize chunkSize = length / targetChunks;
+    if (chunkSize < JSON_PARALLEL_MIN_CHUNK_SIZE)
+    {
+        chunkSize = JSON_PARALLEL_MIN_CHUNK_SIZE;
+    }
+
+    //Find the commas between elements of the root array. Nothing inside a string is structural,
+    //so brackets are counted without having to look at what is in between
+    collections::vector<Json_ParallelChunk> chunks = collections::vector<Json_ParallelChunk>(allocator);
+    JsonStructuralScanner scanner = JsonStructuralScanner(contents.buffer, length);
+    usize *positions = (usize *)allocator.Allocate(sizeof(usize) * JSON_STRUCTURAL_WINDOW);
+    usize depth = 0;
+    usize elementsCount = 0;
+    Json_ParallelChunk chunk = Json_ParallelChunk();
+    bool isArray = false;
+    bool ended = false;
+    //the most recent comma between elements of the root array, to tell whether the array ends with a trailing one
+    usize lastComma = 0;
+    while (!scanner.IsDone() && !ended)
+    {
+        usize count = scanner.Scan(positions, JSON_STRUCTURAL_WINDOW);
+        for (usize i = 0; i < count; i++)
+        {
+            usize position = positions[i] & ~JSON_STRUCTURAL_ESCAPES;
+            char c = contents.buffer[position];
+            if (depth == 0 && !isArray)
+            {
+                if (c != '[')
+                {
+                    ended = true;
+                    break;
+                }
+                isArray = true;
+                depth = 1;
+                chunk.start = position + 1;
+                chunk.elementsCount = 1;
+                continue;
+            }
+            if (c == '[' || c == '{')
+            {
+                depth++;
+            }
+            else if (c == ']' || c == '}')
+            {
+                depth--;
+                if (depth == 0)
+                {
+                    //the root must close with the bracket it opened with, leave anything else for the parser to report
+                    isArray = c == ']';
+                    chunk.end = position;
+                    //the single threaded parser accepts a comma after the last element, so an empty element after it is dropped
+                    if (lastComma > 0 && Json_IsBlank(contents.buffer + lastComma + 1, position - lastComma - 1))
+                    {
+                        chunk.end = lastComma;
+                        chunk.elementsCount--;
+                    }
+                    if (chunk.elementsCount > 0)
+                    {
+                        chunks.Add(chunk);
+                        elementsCount += chunk.elementsCount;
+                    }
+                    ended = true;
+                    break;
+                }
+            }
+            else if (c == ',' && depth == 1)
+            {
+                lastComma = position;
+                if (position - chunk.start >= chunkSize)
+                {
+                    chunk.end = position;
+                    chunks.Add(chunk);
+                    elementsCount += chunk.elementsCount;
+                    chunk.start = position + 1;
+                    chunk.elementsCount = 0;
+                }
+                chunk.elementsCount++;
+            }
+        }
+    }
+    allocator.Free(positions);
+
+    //an unclosed array, something other than an array, or too small a one to split is left to the single threaded parser
+    if (!isArray || depth != 0 || chunks.count < 2)
+    {
+        chunks.deinit();
+        return ParseJsonDocumentInPlace(allocator, contents, result);
+    }
+
+    *result = JsonDocument();
+    result->arena = ArenaAllocator(allocator);
+    result->contents = contents;
+    collections::Array<JsonElement> elements = collections::Array<JsonElement>(result->arena.AsAllocator(), elementsCount);
+
+    threading::Job *jobs = (threading::Job *)allocator.Allocate(sizeof(threading::Job) * chunks.count);
+    usize firstElement = 0;
+    for (usize i = 0; i < chunks.count; i++)
+    {
+        Json_ParallelChunk *current = &chunks.ptr[i];
+        current->contents = contents.buffer;
+        current->elements = elements.data + firstElement;
+        current->baseAllocator = allocator;
+        current->arena = ArenaAllocator();
+        current->errorLine = 0;
+        current->linesCounted = 0;
+        current->linesCountedTo = current->start;
+        firstElement += current->elementsCount;
+        jobs[i] = threading::Job(&Json_ParseParallelChunk, current);
+    }
+    threading::JobCounter counter = threading::JobCounter();
+    threading::RunJobs(jobSystem, jobs, chunks.count, &counter);
+    threading::WaitForCounter(jobSystem, &counter);
+    allocator.Free(jobs);
+
+    //the first error is on its chunk's line plus the lines of everything before the chunk, none of which is read until
+    //every job is done. The chunks before it parsed, so were only rewritten up to their linesCountedTo
+    usize linesBefore = Json_CountLines(contents.buffer, 0, chunks.ptr[0].start);
+    for (usize i = 0; i < chunks.count; i++)
+    {
+        Json_ParallelChunk *current = &chunks.ptr[i];
+        if (result->errorLine == 0)
+        {
+            if (current->errorLine != 0)
+            {
+                result->errorLine = linesBefore + current->errorLine;
+            }
+            else
+            {
+                //the comma between chunks is not a newline, so nothing between them needs counting
+                linesBefore += current->linesCounted + Json_CountLines(contents.buffer, current->linesCountedTo, current->end);
+            }
+        }
+        result->arena.TakeChunks(&current->arena);
+    }
+    chunks.deinit();
+
+    if (result->errorLine != 0)
+    {
+        return false;
+    }
+    result->root = JsonElement(elements);
+    return true;
+}
+
+#endif
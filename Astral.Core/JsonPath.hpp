@@ -0,0 +1,299 @@
+#pragma once
+#include "Json.hpp"
+#include "JsonBinary.hpp"
+
+//index of a segment that cannot be read as an array index
+#define JSON_PATH_NO_INDEX ((usize)-1)
+
+//JSON Pointers (RFC 6901) compiled once into segments that keep their decoded key, its hashes and its array index,
+//so that evaluating them again, against any number of documents, does no parsing or hashing:
+//
+//  Json::JsonPath path;
+//  Json::CompileJsonPath(allocator, "/entities/3/transform/position", &path);
+//  JsonElement *position = path.Find(&document.root);
+//
+//A segment that is just * matches every member of an object or element of an array, unless wildcards are turned off,
+//in which case it is the key "*". "" is the whole document, and ~0 and ~1 stand for ~ and /
+namespace Json
+{
+    enum JsonPathSegmentType
+    {
+        JsonPathSegment_Key,
+        JsonPathSegment_Wildcard
+    };
+    struct JsonPathSegment
+    {
+        JsonPathSegmentType segmentType;
+        //decoded and null terminated, with length counting the terminator
+        string key;
+        //the key's JsonObjectMap::HashOf, for maps using the default seed
+        u64 mapHash;
+        u32 bfmtHash;
+        //the key as an array index, or JSON_PATH_NO_INDEX
+        usize index;
+    };
+    struct JsonPath
+    {
+        IAllocator allocator;
+        //segments and their keys share one allocation
+        JsonPathSegment *segments;
+        usize segmentsCount;
+
+        inline JsonPath()
+        {
+            allocator = IAllocator{};
+            segments = NULL;
+            segmentsCount = 0;
+        }
+        inline void deinit()
+        {
+            if (segments != NULL)
+            {
+                allocator.Free(segments);
+                segments = NULL;
+            }
+            segmentsCount = 0;
+        }
+        //the first element the path leads to, or NULL if there is none
+        JsonElement *Find(JsonElement *root);
+        //adds every element the path leads to onto results, in document order, and returns how many were added
+        usize FindAll(JsonElement *root, collections::vector<JsonElement *> *results);
+        JsonBfmtValue Find(JsonBfmtValue root);
+        usize FindAll(JsonBfmtValue root, collections::vector<JsonBfmtValue> *results);
+    };
+    /// @brief Compiles a JSON Pointer, which is copied, so need not outlive the path
+    /// @return false if pointer does not start with / or has a ~ that is not followed by 0 or 1, leaving result empty
+    bool CompileJsonPath(IAllocator allocator, const char *pointer, usize length, bool allowWildcards, JsonPath *result);
+    inline bool CompileJsonPath(IAllocator allocator, const char *pointer, JsonPath *result)
+    {
+        return CompileJsonPath(allocator, pointer, strlen(pointer), true, result);
+    }
+}
+
+#ifdef ASTRALCORE_JSON_IMPL
+
+//Steps from a node to one of its children, with overloads for each kind of document so that the walks below serve both
+inline Json::JsonElement *Json_PathChild(const Json::JsonPathSegment *segment, Json::JsonElement *element)
+{
+    if (element->elementType == Json::JsonElement_Object)
+    {
+        //small objects parsed in place have no map, see GetProperty
+        if (element->childObjects.entries == NULL && element->keys != NULL)
+        {
+            return element->FindPropertyLinear(segment->key.buffer, segment->key.length - 1);
+        }
+        u64 hash = element->childObjects.hasher.seed == HASH64_DEFAULT_SEED ? segment->mapHash : element->childObjects.HashOf(segment->key);
+        return element->childObjects.Get(segment->key, hash);
+    }
+    if (element->elementType == Json::JsonElement_Array && segment->index < element->arrayElements.length)
+    {
+        return &element->arrayElements.data[segment->index];
+    }
+    return NULL;
+}
+inline Json::JsonBfmtValue Json_PathChild(const Json::JsonPathSegment *segment, Json::JsonBfmtValue value)
+{
+    Json::JsonBfmtType type = value.GetType();
+    if (type == Json::JsonBfmt_Object)
+    {
+        return value.GetChild(segment->key.buffer, segment->key.length - 1, segment->bfmtHash);
+    }
+    if (type == Json::JsonBfmt_Array && segment->index < value.GetCount())
+    {
+        return value.GetIndex((u32)segment->index);
+    }
+    return Json::JsonBfmtValue();
+}
+inline bool Json_PathIsValid(Json::JsonElement *element)
+{
+    return element != NULL;
+}
+inline bool Json_PathIsValid(Json::JsonBfmtValue value)
+{
+    return value.IsValid();
+}
+//members of objects and elements of arrays alike, 0 for anything else
+inline usize Json_PathChildCount(Json::JsonElement *element)
+{
+    return element->elementType == Json::JsonElement_Object || element->elementType == Json::JsonElement_Array ? element->arrayElements.length : 0;
+}
+inline usize Json_PathChildCount(Json::JsonBfmtValue value)
+{
+    return value.GetCount();
+}
+inline Json::JsonElement *Json_PathChildAt(Json::JsonElement *element, usize index)
+{
+    return &element->arrayElements.data[index];
+}
+inline Json::JsonBfmtValue Json_PathChildAt(Json::JsonBfmtValue value, usize index)
+{
+    return value.GetIndex((u32)index);
+}
+
+template <typename Node>
+Node Json_PathFindFirst(const Json::JsonPath *path, usize segmentIndex, Node node)
+{
+    for (; segmentIndex < path->segmentsCount; segmentIndex++)
+    {
+        const Json::JsonPathSegment *segment = &path->segments[segmentIndex];
+        if (segment->segmentType == Json::JsonPathSegment_Wildcard)
+        {
+            usize count = Json_PathChildCount(node);
+            for (usize i = 0; i < count; i++)
+            {
+                Node found = Json_PathFindFirst(path, segmentIndex + 1, Json_PathChildAt(node, i));
+                if (Json_PathIsValid(found))
+                {
+                    return found;
+                }
+            }
+            return Node();
+        }
+        node = Json_PathChild(segment, node);
+        if (!Json_PathIsValid(node))
+        {
+            return node;
+        }
+    }
+    return node;
+}
+template <typename Node>
+usize Json_PathFindAll(const Json::JsonPath *path, usize segmentIndex, Node node, collections::vector<Node> *results)
+{
+    for (; segmentIndex < path->segmentsCount; segmentIndex++)
+    {
+        const Json::JsonPathSegment *segment = &path->segments[segmentIndex];
+        if (segment->segmentType == Json::JsonPathSegment_Wildcard)
+        {
+            usize added = 0;
+            usize count = Json_PathChildCount(node);
+            for (usize i = 0; i < count; i++)
+            {
+                added += Json_PathFindAll(path, segmentIndex + 1, Json_PathChildAt(node, i), results);
+            }
+            return added;
+        }
+        node = Json_PathChild(segment, node);
+        if (!Json_PathIsValid(node))
+        {
+            return 0;
+        }
+    }
+    results->Add(node);
+    return 1;
+}
+
+Json::JsonElement *Json::JsonPath::Find(JsonElement *root)
+{
+    if (root == NULL)
+    {
+        return NULL;
+    }
+    return Json_PathFindFirst<JsonElement *>(this, 0, root);
+}
+usize Json::JsonPath::FindAll(JsonElement *root, collections::vector<JsonElement *> *results)
+{
+    if (root == NULL)
+    {
+        return 0;
+    }
+    return Json_PathFindAll<JsonElement *>(this, 0, root, results);
+}
+Json::JsonBfmtValue Json::JsonPath::Find(JsonBfmtValue root)
+{
+    if (!root.IsValid())
+    {
+        return root;
+    }
+    return Json_PathFindFirst<JsonBfmtValue>(this, 0, root);
+}
+usize Json::JsonPath::FindAll(JsonBfmtValue root, collections::vector<JsonBfmtValue> *results)
+{
+    if (!root.IsValid())
+    {
+        return 0;
+    }
+    return Json_PathFindAll<JsonBfmtValue>(this, 0, root, results);
+}
+
+bool Json::CompileJsonPath(IAllocator allocator, const char *pointer, usize length, bool allowWildcards, JsonPath *result)
+{
+    *result = JsonPath();
+    result->allocator = allocator;
+    if (length == 0)
+    {
+        return true;
+    }
+    if (pointer[0] != '/')
+    {
+        return false;
+    }
+    usize segmentsCount = 0;
+    for (usize i = 0; i < length; i++)
+    {
+        if (pointer[i] == '/')
+        {
+            segmentsCount++;
+        }
+    }
+    //decoding never lengthens a key, so the pointer's length covers every key, less their slashes and plus their terminators
+    JsonPathSegment *segments = (JsonPathSegment *)allocator.Allocate(sizeof(JsonPathSegment) * segmentsCount + length);
+    char *keys = (char *)(segments + segmentsCount);
+
+    usize position = 1;
+    for (usize s = 0; s < segmentsCount; s++)
+    {
+        JsonPathSegment *segment = &segments[s];
+        char *key = keys;
+        usize keyLength = 0;
+        while (position < length && pointer[position] != '/')
+        {
+            char c = pointer[position];
+            if (c == '~')
+            {
+                if (position + 1 >= length || (pointer[position + 1] != '0' && pointer[position + 1] != '1'))
+                {
+                    allocator.Free(segments);
+                    return false;
+                }
+                c = pointer[position + 1] == '0' ? '~' : '/';
+                position++;
+            }
+            key[keyLength] = c;
+            keyLength++;
+            position++;
+        }
+        key[keyLength] = '\0';
+        //skip the slash that starts the next segment
+        position++;
+        keys += keyLength + 1;
+
+        segment->key.buffer = key;
+        segment->key.length = keyLength + 1;
+        segment->mapHash = collections::HashGroup_Mix(StringHasher().Hash(segment->key));
+        segment->bfmtHash = JsonBfmtHashKey(key, keyLength);
+        segment->segmentType = allowWildcards && keyLength == 1 && key[0] == '*' ? JsonPathSegment_Wildcard : JsonPathSegment_Key;
+
+        //array indices are 0 or digits without a leading zero. "-", past the last element, never matches anything
+        segment->index = JSON_PATH_NO_INDEX;
+        if (keyLength > 0 && (keyLength == 1 || key[0] != '0'))
+        {
+            usize index = 0;
+            usize i = 0;
+            while (i < keyLength && (u8)(key[i] - '0') < 10 && index <= (JSON_PATH_NO_INDEX - 10) / 10)
+            {
+                index = index * 10 + (usize)(key[i] - '0');
+                i++;
+            }
+            if (i == keyLength)
+            {
+                segment->index = index;
+            }
+        }
+    }
+    result->segments = segments;
+    result->segmentsCount = segmentsCount;
+    return true;
+}
+
+#endif
@@ -0,0 +1,713 @@
+#pragma once
+#include <stddef.h>
+#include "Json.hpp"
+#include "JsonBinary.hpp"
+
+//Reads and writes plain structs as JSON directly, without building JsonElements in between.
+//A struct is described once with JSON_STRUCT, listing the members that are read and written:
+//
+//  struct Settings { i32 width; float scale; string name; collections::Array<Vec2i> points; };
+//  JSON_STRUCT(Settings, JSON_FIELD(width), JSON_FIELD(scale), JSON_FIELD(name), JSON_FIELD(points))
+//
+//JSON_STRUCT must be used at global scope, after JSON_STRUCT has been used for the types of any struct members.
+//Members can be integers, float, double, bool, string, other described structs and collections::Array of any of these.
+//Members missing from the input keep the value they had, and null leaves a member unchanged, so defaults
+//can be set before parsing. A string or array default that the input replaces is freed with DeinitJsonValue, so it must
+//either be empty or be owned by its allocator, not point at a literal or static data. Keys that are not described are skipped
+
+namespace Json
+{
+    enum JsonFieldType
+    {
+        JsonField_I8,
+        JsonField_I16,
+        JsonField_I32,
+        JsonField_I64,
+        JsonField_U8,
+        JsonField_U16,
+        JsonField_U32,
+        JsonField_U64,
+        JsonField_Float,
+        JsonField_Double,
+        JsonField_Bool,
+        JsonField_String,
+        JsonField_Struct,
+        JsonField_Array
+    };
+    struct JsonStructInfo;
+    struct JsonTypeInfo
+    {
+        JsonFieldType fieldType;
+        usize size;
+        //for JsonField_Struct
+        const JsonStructInfo *structInfo;
+        //for JsonField_Array, the type of its elements
+        const JsonTypeInfo *elementInfo;
+
+        inline JsonTypeInfo(JsonFieldType fieldType, usize size, const JsonStructInfo *structInfo, const JsonTypeInfo *elementInfo)
+        {
+            this->fieldType = fieldType;
+            this->size = size;
+            this->structInfo = structInfo;
+            this->elementInfo = elementInfo;
+        }
+    };
+    struct JsonFieldInfo
+    {
+        const char *name;
+        usize nameLength;
+        usize offset;
+        const JsonTypeInfo *typeInfo;
+    };
+    struct JsonStructInfo
+    {
+        const char *name;
+        const JsonFieldInfo *fields;
+        usize fieldsCount;
+
+        inline JsonStructInfo(const char *name, const JsonFieldInfo *fields, usize fieldsCount)
+        {
+            this->name = name;
+            this->fields = fields;
+            this->fieldsCount = fieldsCount;
+        }
+    };
+
+    //Specialized for every type a member can have. A missing specialization means the type cannot be read or written
+    template <typename T>
+    struct JsonTypeTraits;
+
+#define JSON_SCALAR_TRAITS(type, jsonFieldType) \
+    template <> \
+    struct JsonTypeTraits<type> \
+    { \
+        static inline const JsonTypeInfo *GetTypeInfo() \
+        { \
+            static const JsonTypeInfo info = JsonTypeInfo(jsonFieldType, sizeof(type), NULL, NULL); \
+            return &info; \
+        } \
+    };
+
+    JSON_SCALAR_TRAITS(i8, JsonField_I8)
+    JSON_SCALAR_TRAITS(i16, JsonField_I16)
+    JSON_SCALAR_TRAITS(i32, JsonField_I32)
+    JSON_SCALAR_TRAITS(i64, JsonField_I64)
+    JSON_SCALAR_TRAITS(u8, JsonField_U8)
+    JSON_SCALAR_TRAITS(u16, JsonField_U16)
+    JSON_SCALAR_TRAITS(u32, JsonField_U32)
+    JSON_SCALAR_TRAITS(u64, JsonField_U64)
+    JSON_SCALAR_TRAITS(float, JsonField_Float)
+    JSON_SCALAR_TRAITS(double, JsonField_Double)
+    JSON_SCALAR_TRAITS(bool, JsonField_Bool)
+    JSON_SCALAR_TRAITS(string, JsonField_String)
+
+    //Arrays are read and written as their allocator, data and length, which are laid out the same for every T
+    template <typename T>
+    struct JsonTypeTraits<collections::Array<T>>
+    {
+        static inline const JsonTypeInfo *GetTypeInfo()
+        {
+            static const JsonTypeInfo info = JsonTypeInfo(JsonField_Array, sizeof(collections::Array<T>), NULL, JsonTypeTraits<T>::GetTypeInfo());
+            return &info;
+        }
+    };
+
+    template <typename T>
+    inline JsonFieldInfo MakeJsonField(const char *name, usize offset)
+    {
+        JsonFieldInfo result;
+        result.name = name;
+        result.nameLength = strlen(name);
+        result.offset = offset;
+        result.typeInfo = JsonTypeTraits<T>::GetTypeInfo();
+        return result;
+    }
+
+//describes a member of the struct being described by the enclosing JSON_STRUCT
+#define JSON_FIELD(member) Json::MakeJsonField<decltype(((ReflectedType *)0)->member)>(#member, offsetof(ReflectedType, member))
+#define JSON_STRUCT(type, ...) \
+    namespace Json \
+    { \
+        template <> \
+        struct JsonTypeTraits<type> \
+        { \
+            typedef type ReflectedType; \
+            static inline const JsonTypeInfo *GetTypeInfo() \
+            { \
+                static const JsonFieldInfo fields[] = { __VA_ARGS__ }; \
+                static const JsonStructInfo structInfo = JsonStructInfo(#type, fields, sizeof(fields) / sizeof(JsonFieldInfo)); \
+                static const JsonTypeInfo info = JsonTypeInfo(JsonField_Struct, sizeof(type), &structInfo, NULL); \
+                return &info; \
+            } \
+        }; \
+    }
+
+    /// @brief Parses the tokenizer's next value into result, which must be of the type typeInfo describes.
+    /// Strings and arrays are allocated with allocator, and whatever was parsed before an error stays in result
+    /// for DeinitJsonValue to free
+    bool ParseJsonValue(IAllocator allocator, JsonTokenizer *tokenizer, const JsonTypeInfo *typeInfo, void *result);
+    //writes value as the writer's next value, or as the document when nothing has been written yet
+    bool WriteJsonValue(JsonWriter *writer, const JsonTypeInfo *typeInfo, const void *value);
+    //reads a bfmt node into result, with the same rules as ParseJsonValue
+    bool ReadJsonBfmtValue(IAllocator allocator, JsonBfmtValue node, const JsonTypeInfo *typeInfo, void *result);
+    collections::Array<u8> JsonConvertValueToBfmt(IAllocator allocator, const JsonTypeInfo *typeInfo, const void *value);
+    //frees the strings and arrays within value, recursively
+    void DeinitJsonValue(const JsonTypeInfo *typeInfo, void *value);
+
+    //@return the line of the first error, or 0 if parsing succeeded
+    template <typename T>
+    inline usize ParseJsonStruct(IAllocator allocator, string contents, T *result)
+    {
+        JsonTokenizer tokenizer = JsonTokenizer(contents);
+        if (!ParseJsonValue(allocator, &tokenizer, JsonTypeTraits<T>::GetTypeInfo(), result))
+        {
+            return tokenizer.GetCurrentLine();
+        }
+        return 0;
+    }
+    template <typename T>
+    inline bool WriteJsonStruct(JsonWriter *writer, const T *value)
+    {
+        return WriteJsonValue(writer, JsonTypeTraits<T>::GetTypeInfo(), value);
+    }
+    template <typename T>
+    inline bool ReadJsonBfmtStruct(IAllocator allocator, JsonBfmtValue node, T *result)
+    {
+        return ReadJsonBfmtValue(allocator, node, JsonTypeTraits<T>::GetTypeInfo(), result);
+    }
+    template <typename T>
+    inline collections::Array<u8> JsonConvertStructToBfmt(IAllocator allocator, const T *value)
+    {
+        return JsonConvertValueToBfmt(allocator, JsonTypeTraits<T>::GetTypeInfo(), value);
+    }
+    template <typename T>
+    inline void DeinitJsonStruct(T *value)
+    {
+        DeinitJsonValue(JsonTypeTraits<T>::GetTypeInfo(), value);
+    }
+}
+
+#ifdef ASTRALCORE_JSON_IMPL
+
+//Finds a field by name, trying the one after the last match first, as keys are usually written in the order they are described
+inline const Json::JsonFieldInfo *Json_FindField(const Json::JsonStructInfo *structInfo, const char *name, usize nameLength, usize *nextField)
+{
+    for (usize i = 0; i < structInfo->fieldsCount; i++)
+    {
+        usize index = (*nextField + i) % structInfo->fieldsCount;
+        const Json::JsonFieldInfo *field = &structInfo->fields[index];
+        if (field->nameLength == nameLength && memcmp(field->name, name, nameLength) == 0)
+        {
+            *nextField = index + 1;
+            return field;
+        }
+    }
+    return NULL;
+}
+
+//stores a number into a field of an integer or floating point type, failing if it does not fit
+inline bool Json_StoreNumber(Json::JsonFieldType fieldType, Json::JsonScalar scalar, void *result)
+{
+    if (fieldType == Json::JsonField_Float || fieldType == Json::JsonField_Double)
+    {
+        double value;
+        switch (scalar.valueType)
+        {
+            case Json::JsonValue_Integer: value = (double)scalar.asInteger; break;
+            case Json::JsonValue_Unsigned: value = (double)scalar.asUnsigned; break;
+            case Json::JsonValue_Double: value = scalar.asDouble; break;
+            default: return false;
+        }
+        if (fieldType == Json::JsonField_Float)
+        {
+            *(float *)result = (float)value;
+        }
+        else
+        {
+            *(double *)result = value;
+        }
+        return true;
+    }
+    if (scalar.valueType == Json::JsonValue_Unsigned)
+    {
+        if (fieldType != Json::JsonField_U64)
+        {
+            return false;
+        }
+        *(u64 *)result = scalar.asUnsigned;
+        return true;
+    }
+    if (scalar.valueType != Json::JsonValue_Integer)
+    {
+        return false;
+    }
+    i64 value = scalar.asInteger;
+    switch (fieldType)
+    {
+        case Json::JsonField_I8:
+            if (value < -128 || value > I8Max) return false;
+            *(i8 *)result = (i8)value;
+            return true;
+        case Json::JsonField_I16:
+            if (value < -32768 || value > I16Max) return false;
+            *(i16 *)result = (i16)value;
+            return true;
+        case Json::JsonField_I32:
+            if (value < -I32Max - 1 || value > I32Max) return false;
+            *(i32 *)result = (i32)value;
+            return true;
+        case Json::JsonField_I64:
+            *(i64 *)result = value;
+            return true;
+        case Json::JsonField_U8:
+            if (value < 0 || value > U8Max) return false;
+            *(u8 *)result = (u8)value;
+            return true;
+        case Json::JsonField_U16:
+            if (value < 0 || value > U16Max) return false;
+            *(u16 *)result = (u16)value;
+            return true;
+        case Json::JsonField_U32:
+            if (value < 0 || value > U32Max) return false;
+            *(u32 *)result = (u32)value;
+            return true;
+        case Json::JsonField_U64:
+            if (value < 0) return false;
+            *(u64 *)result = (u64)value;
+            return true;
+        default:
+            return false;
+    }
+}
+
+//skips the tokenizer's next value, only checking that brackets are balanced and that it is not a lone separator
+inline bool Json_SkipValue(Json::JsonTokenizer *tokenizer)
+{
+    usize depth = 0;
+    do
+    {
+        Json::JsonToken token = tokenizer->Next();
+        switch (token.tokenType)
+        {
+            case Json::JsonToken_LBrace:
+            case Json::JsonToken_LBracket:
+                depth++;
+                break;
+            case Json::JsonToken_RBrace:
+            case Json::JsonToken_RBracket:
+                if (depth == 0)
+                {
+                    return false;
+                }
+                depth--;
+                break;
+            //a separator is only part of the value inside brackets, and a lone one is a missing value
+            case Json::JsonToken_Comma:
+            case Json::JsonToken_Colon:
+                if (depth == 0)
+                {
+                    return false;
+                }
+                break;
+            case Json::JsonToken_Invalid:
+            case Json::JsonToken_Eof:
+                return false;
+            default:
+                break;
+        }
+    } while (depth > 0);
+    return true;
+}
+
+//Grows an array's data by doubling while its length is unknown. Elements are zeroed before being read into
+inline void *Json_AddArrayElement(IAllocator allocator, collections::Array<u8> *array, usize *capacity, usize elementSize)
+{
+    if (array->length == *capacity)
+    {
+        usize newCapacity = *capacity == 0 ? 4 : *capacity * 2;
+        u8 *newData = (u8 *)allocator.Allocate(newCapacity * elementSize);
+        if (array->data != NULL)
+        {
+            memcpy(newData, array->data, array->length * elementSize);
+            allocator.Free(array->data);
+        }
+        array->data = newData;
+        *capacity = newCapacity;
+    }
+    void *element = array->data + array->length * elementSize;
+    memset(element, 0, elementSize);
+    array->length++;
+    return element;
+}
+
+bool Json::ParseJsonValue(IAllocator allocator, JsonTokenizer *tokenizer, const JsonTypeInfo *typeInfo, void *result)
+{
+    JsonToken token = tokenizer->Next();
+    if (token.tokenType == JsonToken_NullLiteral)
+    {
+        return true;
+    }
+    switch (typeInfo->fieldType)
+    {
+        case JsonField_Struct:
+        {
+            if (token.tokenType != JsonToken_LBrace)
+            {
+                return false;
+            }
+            if (tokenizer->PeekNext().tokenType == JsonToken_RBrace)
+            {
+                tokenizer->Next();
+                return true;
+            }
+            const JsonStructInfo *structInfo = typeInfo->structInfo;
+            usize nextField = 0;
+            while (true)
+            {
+                JsonToken key = tokenizer->Next();
+                if (key.tokenType != JsonToken_StringLiteral || tokenizer->Next().tokenType != JsonToken_Colon)
+                {
+                    return false;
+                }
+                const char *name = tokenizer->fileContents + key.startIndex + 1;
+                usize nameLength = key.endIndex - key.startIndex - 2;
+                //described names never need escaping, so escaped keys are decoded into a copy only to be compared
+                char decoded[64];
+                if (key.hasEscapes && nameLength <= sizeof(decoded))
+                {
+                    memcpy(decoded, name, nameLength);
+                    nameLength = UnescapeJsonString(decoded, nameLength);
+                    name = decoded;
+                }
+                const JsonFieldInfo *field = Json_FindField(structInfo, name, nameLength, &nextField);
+                if (field == NULL)
+                {
+                    if (!Json_SkipValue(tokenizer))
+                    {
+                        return false;
+                    }
+                }
+                else if (!ParseJsonValue(allocator, tokenizer, field->typeInfo, (u8 *)result + field->offset))
+                {
+                    return false;
+                }
+                JsonToken next = tokenizer->Next();
+                if (next.tokenType == JsonToken_RBrace)
+                {
+                    return true;
+                }
+                if (next.tokenType != JsonToken_Comma)
+                {
+                    return false;
+                }
+            }
+        }
+        case JsonField_Array:
+        {
+            if (token.tokenType != JsonToken_LBracket)
+            {
+                return false;
+            }
+            const JsonTypeInfo *elementInfo = typeInfo->elementInfo;
+            collections::Array<u8> *array = (collections::Array<u8> *)result;
+            //replaces the default, freeing it and anything it owns
+            DeinitJsonValue(typeInfo, result);
+            *array = collections::Array<u8>(allocator);
+            if (tokenizer->PeekNext().tokenType == JsonToken_RBracket)
+            {
+                tokenizer->Next();
+                return true;
+            }
+            usize capacity = 0;
+            while (true)
+            {
+                void *element = Json_AddArrayElement(allocator, array, &capacity, elementInfo->size);
+                if (!ParseJsonValue(allocator, tokenizer, elementInfo, element))
+                {
+                    return false;
+                }
+                JsonToken next = tokenizer->Next();
+                if (next.tokenType == JsonToken_RBracket)
+                {
+                    return true;
+                }
+                if (next.tokenType != JsonToken_Comma)
+                {
+                    return false;
+                }
+            }
+        }
+        case JsonField_String:
+        {
+            if (token.tokenType != JsonToken_StringLiteral)
+            {
+                return false;
+            }
+            string value = tokenizer->GetString(allocator, token);
+            if (token.hasEscapes)
+            {
+                value.length = UnescapeJsonString(value.buffer, value.length - 1) + 1;
+                value.buffer[value.length - 1] = '\0';
+            }
+            DeinitJsonValue(typeInfo, result);
+            *(string *)result = value;
+            return true;
+        }
+        case JsonField_Bool:
+        {
+            if (token.tokenType != JsonToken_BoolLiteral)
+            {
+                return false;
+            }
+            *(bool *)result = tokenizer->fileContents[token.startIndex] == 't';
+            return true;
+        }
+        default:
+        {
+            if (token.tokenType != JsonToken_IntegerLiteral && token.tokenType != JsonToken_FloatLiteral)
+            {
+                return false;
+            }
+            JsonScalar scalar = ParseJsonScalar(token.tokenType, tokenizer->fileContents + token.startIndex, token.endIndex - token.startIndex);
+            return Json_StoreNumber(typeInfo->fieldType, scalar, result);
+        }
+    }
+}
+
+//writes the value of a field, with any property name already written
+inline bool Json_WriteFieldValue(Json::JsonWriter *writer, const Json::JsonTypeInfo *typeInfo, const void *value)
+{
+    switch (typeInfo->fieldType)
+    {
+        case Json::JsonField_I8: return writer->WriteIntValue(*(const i8 *)value);
+        case Json::JsonField_I16: return writer->WriteIntValue(*(const i16 *)value);
+        case Json::JsonField_I32: return writer->WriteIntValue(*(const i32 *)value);
+        case Json::JsonField_I64: return writer->WriteIntValue(*(const i64 *)value);
+        case Json::JsonField_U8: return writer->WriteUintValue(*(const u8 *)value);
+        case Json::JsonField_U16: return writer->WriteUintValue(*(const u16 *)value);
+        case Json::JsonField_U32: return writer->WriteUintValue(*(const u32 *)value);
+        case Json::JsonField_U64: return writer->WriteUintValue(*(const u64 *)value);
+        case Json::JsonField_Float: return writer->WriteFloat(*(const float *)value);
+        case Json::JsonField_Double: return writer->WriteFloat(*(const double *)value);
+        case Json::JsonField_Bool: return writer->WriteBool(*(const bool *)value);
+        case Json::JsonField_String:
+        {
+            const string *text = (const string *)value;
+            return text->buffer == NULL ? writer->WriteString("", 0) : writer->WriteString(text->buffer, text->length - 1);
+        }
+        case Json::JsonField_Struct:
+        {
+            const Json::JsonStructInfo *structInfo = typeInfo->structInfo;
+            if (!writer->WriteStartObject())
+            {
+                return false;
+            }
+            for (usize i = 0; i < structInfo->fieldsCount; i++)
+            {
+                const Json::JsonFieldInfo *field = &structInfo->fields[i];
+                if (!writer->WritePropertyName(field->name, field->nameLength) || !Json_WriteFieldValue(writer, field->typeInfo, (const u8 *)value + field->offset))
+                {
+                    return false;
+                }
+            }
+            return writer->WriteEndObject();
+        }
+        case Json::JsonField_Array:
+        {
+            const collections::Array<u8> *array = (const collections::Array<u8> *)value;
+            const Json::JsonTypeInfo *elementInfo = typeInfo->elementInfo;
+            if (!writer->WriteStartArray())
+            {
+                return false;
+            }
+            for (usize i = 0; i < array->length; i++)
+            {
+                if (!Json_WriteFieldValue(writer, elementInfo, array->data + i * elementInfo->size))
+                {
+                    return false;
+                }
+            }
+            return writer->WriteEndArray();
+        }
+        default:
+            return false;
+    }
+}
+
+bool Json::WriteJsonValue(JsonWriter *writer, const JsonTypeInfo *typeInfo, const void *value)
+{
+    return Json_WriteFieldValue(writer, typeInfo, value);
+}
+
+bool Json::ReadJsonBfmtValue(IAllocator allocator, JsonBfmtValue node, const JsonTypeInfo *typeInfo, void *result)
+{
+    JsonBfmtType nodeType = node.GetType();
+    if (nodeType == JsonBfmt_Null)
+    {
+        return true;
+    }
+    switch (typeInfo->fieldType)
+    {
+        case JsonField_Struct:
+        {
+            if (nodeType != JsonBfmt_Object)
+            {
+                return false;
+            }
+            const JsonStructInfo *structInfo = typeInfo->structInfo;
+            u32 count = node.GetCount();
+            usize nextField = 0;
+            for (u32 i = 0; i < count; i++)
+            {
+                string key = node.GetKey(i).GetString();
+                const JsonFieldInfo *field = Json_FindField(structInfo, key.buffer, key.length - 1, &nextField);
+                if (field != NULL && !ReadJsonBfmtValue(allocator, node.GetIndex(i), field->typeInfo, (u8 *)result + field->offset))
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+        case JsonField_Array:
+        {
+            if (nodeType != JsonBfmt_Array)
+            {
+                return false;
+            }
+            const JsonTypeInfo *elementInfo = typeInfo->elementInfo;
+            u32 count = node.GetCount();
+            collections::Array<u8> *array = (collections::Array<u8> *)result;
+            DeinitJsonValue(typeInfo, result);
+            *array = collections::Array<u8>(allocator, count * elementInfo->size);
+            array->length = 0;
+            for (u32 i = 0; i < count; i++)
+            {
+                void *element = array->data + i * elementInfo->size;
+                memset(element, 0, elementInfo->size);
+                array->length++;
+                if (!ReadJsonBfmtValue(allocator, node.GetIndex(i), elementInfo, element))
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+        case JsonField_String:
+        {
+            if (nodeType != JsonBfmt_String)
+            {
+                return false;
+            }
+            string view = node.GetString();
+            DeinitJsonValue(typeInfo, result);
+            *(string *)result = string(allocator, view.buffer, view.length - 1);
+            return true;
+        }
+        case JsonField_Bool:
+        {
+            if (nodeType != JsonBfmt_Bool)
+            {
+                return false;
+            }
+            *(bool *)result = node.GetScalar().asBool;
+            return true;
+        }
+        default:
+            return Json_StoreNumber(typeInfo->fieldType, node.GetScalar(), result);
+    }
+}
+
+inline u32 Json_BfmtAddValue(JsonBfmtBuilder *builder, const Json::JsonTypeInfo *typeInfo, const void *value)
+{
+    switch (typeInfo->fieldType)
+    {
+        case Json::JsonField_I8: return builder->AddScalar(Json::JsonBfmt_Integer, (u64)(i64)*(const i8 *)value);
+        case Json::JsonField_I16: return builder->AddScalar(Json::JsonBfmt_Integer, (u64)(i64)*(const i16 *)value);
+        case Json::JsonField_I32: return builder->AddScalar(Json::JsonBfmt_Integer, (u64)(i64)*(const i32 *)value);
+        case Json::JsonField_I64: return builder->AddScalar(Json::JsonBfmt_Integer, (u64)*(const i64 *)value);
+        case Json::JsonField_U8: return builder->AddScalar(Json::JsonBfmt_Integer, *(const u8 *)value);
+        case Json::JsonField_U16: return builder->AddScalar(Json::JsonBfmt_Integer, *(const u16 *)value);
+        case Json::JsonField_U32: return builder->AddScalar(Json::JsonBfmt_Integer, *(const u32 *)value);
+        case Json::JsonField_U64:
+        {
+            //the same split the parser makes, so that a converted document matches one converted from text
+            u64 integer = *(const u64 *)value;
+            return builder->AddScalar(integer > I64Max ? Json::JsonBfmt_Unsigned : Json::JsonBfmt_Integer, integer);
+        }
+        case Json::JsonField_Float: return builder->AddDouble(*(const float *)value);
+        case Json::JsonField_Double: return builder->AddDouble(*(const double *)value);
+        case Json::JsonField_Bool: return builder->AddSmall(Json::JsonBfmt_Bool, *(const bool *)value ? 1 : 0);
+        case Json::JsonField_String: return builder->AddSharedString(*(const string *)value);
+        case Json::JsonField_Struct:
+        {
+            const Json::JsonStructInfo *structInfo = typeInfo->structInfo;
+            u32 offset = builder->BeginObject(structInfo->fieldsCount);
+            for (usize i = 0; i < structInfo->fieldsCount && !builder->tooLarge; i++)
+            {
+                const Json::JsonFieldInfo *field = &structInfo->fields[i];
+                u32 valueOffset = Json_BfmtAddValue(builder, field->typeInfo, (const u8 *)value + field->offset);
+                string key = string();
+                key.buffer = (char *)field->name;
+                key.length = field->nameLength + 1;
+                builder->SetMember(offset, i, key, valueOffset);
+            }
+            builder->EndObject(offset);
+            return offset;
+        }
+        case Json::JsonField_Array:
+        {
+            const collections::Array<u8> *array = (const collections::Array<u8> *)value;
+            const Json::JsonTypeInfo *elementInfo = typeInfo->elementInfo;
+            u32 offset = builder->BeginArray(array->length);
+            for (usize i = 0; i < array->length && !builder->tooLarge; i++)
+            {
+                builder->SetElement(offset, i, Json_BfmtAddValue(builder, elementInfo, array->data + i * elementInfo->size));
+            }
+            return offset;
+        }
+        default:
+            return builder->AddSmall(Json::JsonBfmt_Null, 0);
+    }
+}
+
+collections::Array<u8> Json::JsonConvertValueToBfmt(IAllocator allocator, const JsonTypeInfo *typeInfo, const void *value)
+{
+    JsonBfmtBuilder builder = JsonBfmtBuilder(allocator);
+    u32 rootOffset = Json_BfmtAddValue(&builder, typeInfo, value);
+    return builder.Finish(rootOffset);
+}
+
+void Json::DeinitJsonValue(const JsonTypeInfo *typeInfo, void *value)
+{
+    switch (typeInfo->fieldType)
+    {
+        case JsonField_String:
+            ((string *)value)->deinit();
+            break;
+        case JsonField_Struct:
+        {
+            const JsonStructInfo *structInfo = typeInfo->structInfo;
+            for (usize i = 0; i < structInfo->fieldsCount; i++)
+            {
+                DeinitJsonValue(structInfo->fields[i].typeInfo, (u8 *)value + structInfo->fields[i].offset);
+            }
+            break;
+        }
+        case JsonField_Array:
+        {
+            collections::Array<u8> *array = (collections::Array<u8> *)value;
+            const JsonTypeInfo *elementInfo = typeInfo->elementInfo;
+            for (usize i = 0; i < array->length; i++)
+            {
+                DeinitJsonValue(elementInfo, array->data + i * elementInfo->size);
+            }
+            array->deinit();
+            array->length = 0;
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+#endif
@@ -6,4 +6,5 @@
 #include "Vec4.hpp"
 #include "Quaternion.hpp"
 #include "Util.hpp"
-#include "Rectangle.hpp"
\ No newline at end of file
+#include "Rectangle.hpp"
+#include "Soa.hpp"
\ No newline at end of file
@@ -9,6 +9,26 @@
 
 namespace Maths
 {
+#ifdef USE_SSE
+	//Helpers for Matrix4x4::Invert, operating on 2x2 matrices stored as (m00, m01, m10, m11)
+
+	//A * B
+	inline __m128 Mat2Mul(__m128 A, __m128 B)
+	{
+		return _mm_add_ps(_mm_mul_ps(A, SIMD_SWIZZLE(B, 0, 3, 0, 3)), _mm_mul_ps(SIMD_SWIZZLE(A, 1, 0, 3, 2), SIMD_SWIZZLE(B, 2, 1, 2, 1)));
+	}
+	//adjugate(A) * B
+	inline __m128 Mat2AdjMul(__m128 A, __m128 B)
+	{
+		return _mm_sub_ps(_mm_mul_ps(SIMD_SWIZZLE(A, 3, 3, 0, 0), B), _mm_mul_ps(SIMD_SWIZZLE(A, 1, 1, 2, 2), SIMD_SWIZZLE(B, 2, 3, 0, 1)));
+	}
+	//A * adjugate(B)
+	inline __m128 Mat2MulAdj(__m128 A, __m128 B)
+	{
+		return _mm_sub_ps(_mm_mul_ps(A, SIMD_SWIZZLE(B, 3, 0, 3, 0)), _mm_mul_ps(SIMD_SWIZZLE(A, 1, 0, 3, 2), SIMD_SWIZZLE(B, 2, 1, 2, 1)));
+	}
+#endif
+
 	struct Matrix4x4
 	{
 		//Row 1
@@ -77,10 +97,11 @@ namespace Maths
 		Matrix4x4(float* m)
 		{
 #ifdef USE_SSE
-			row1 = _mm_load_ps(m);//_mm_set_ps(m[0], m[1], m[2], m[3]);
-			row2 = _mm_load_ps(m + 4);//_mm_set_ps(m[4], m[5], m[6], m[7]);
-			row3 = _mm_load_ps(m + 8);//_mm_set_ps(m[8], m[9], m[10], m[11]);
-			row4 = _mm_load_ps(m + 12);//_mm_set_ps(m[12], m[13], m[14], m[15]);
+			//m is usually a float array on the stack, which is not guaranteed to be 16 byte aligned
+			row1 = _mm_loadu_ps(m);
+			row2 = _mm_loadu_ps(m + 4);
+			row3 = _mm_loadu_ps(m + 8);
+			row4 = _mm_loadu_ps(m + 12);
 #else
 			M11 = m[0];
 			M12 = m[1];
@@ -291,6 +312,58 @@ namespace Maths
 		}
 		option<Matrix4x4> Invert()
 		{
+#ifdef USE_SSE
+			//block inverse: split the matrix into 2x2 blocks | A B |
+			//                                                | C D |
+			//each held in one register as (m00, m01, m10, m11), and invert using adjugates of the blocks
+			__m128 A = _mm_movelh_ps(row1, row2);
+			__m128 B = _mm_movehl_ps(row2, row1);
+			__m128 C = _mm_movelh_ps(row3, row4);
+			__m128 D = _mm_movehl_ps(row4, row3);
+
+			//(|A|, |B|, |C|, |D|)
+			__m128 blockDeterminants = _mm_sub_ps(
+				_mm_mul_ps(SIMD_SHUFFLE(row1, row3, 0, 2, 0, 2), SIMD_SHUFFLE(row2, row4, 1, 3, 1, 3)),
+				_mm_mul_ps(SIMD_SHUFFLE(row1, row3, 1, 3, 1, 3), SIMD_SHUFFLE(row2, row4, 0, 2, 0, 2)));
+			__m128 detA = SIMD_SWIZZLE(blockDeterminants, 0, 0, 0, 0);
+			__m128 detB = SIMD_SWIZZLE(blockDeterminants, 1, 1, 1, 1);
+			__m128 detC = SIMD_SWIZZLE(blockDeterminants, 2, 2, 2, 2);
+			__m128 detD = SIMD_SWIZZLE(blockDeterminants, 3, 3, 3, 3);
+
+			__m128 D_C = Mat2AdjMul(D, C);
+			__m128 A_B = Mat2AdjMul(A, B);
+			__m128 X_ = _mm_sub_ps(_mm_mul_ps(detD, A), Mat2Mul(B, D_C));
+			__m128 W_ = _mm_sub_ps(_mm_mul_ps(detA, D), Mat2Mul(C, A_B));
+			__m128 Y_ = _mm_sub_ps(_mm_mul_ps(detB, C), Mat2MulAdj(D, A_B));
+			__m128 Z_ = _mm_sub_ps(_mm_mul_ps(detC, B), Mat2MulAdj(A, D_C));
+
+			//|M| = |A||D| + |B||C| - tr((A#B)(D#C))
+			__m128 trace = Simd_HorizontalSum(_mm_mul_ps(A_B, SIMD_SWIZZLE(D_C, 0, 2, 1, 3)));
+			__m128 determinant = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(detA, detD), _mm_mul_ps(detB, detC)), trace);
+			if (fabsf(_mm_cvtss_f32(determinant)) <= 0.0f)
+			{
+				return option<Matrix4x4>();
+			}
+
+			__m128 reciprocal = _mm_div_ps(_mm_setr_ps(1.0f, -1.0f, -1.0f, 1.0f), determinant);
+			X_ = _mm_mul_ps(X_, reciprocal);
+			Y_ = _mm_mul_ps(Y_, reciprocal);
+			Z_ = _mm_mul_ps(Z_, reciprocal);
+			W_ = _mm_mul_ps(W_, reciprocal);
+
+			//the adjugate swaps and transposes the blocks, done here as part of reassembling the rows
+			Matrix4x4 result;
+			result.row1 = SIMD_SHUFFLE(X_, Y_, 3, 1, 3, 1);
+			result.row2 = SIMD_SHUFFLE(X_, Y_, 2, 0, 2, 0);
+			result.row3 = SIMD_SHUFFLE(Z_, W_, 3, 1, 3, 1);
+			result.row4 = SIMD_SHUFFLE(Z_, W_, 2, 0, 2, 0);
+			return option<Matrix4x4>(result);
+#else
+			return InvertScalar();
+#endif
+		}
+		option<Matrix4x4> InvertScalar()
+		{
 			float a = M11, b = M12, c = M13, d = M14;
 			float e = M21, f = M22, g = M23, h = M24;
 			float i = M31, j = M32, k = M33, l = M34;
@@ -357,7 +430,31 @@ namespace Maths
 
 		Matrix4x4 operator*(const Matrix4x4 &other)
 		{
-#ifdef USE_SSE
+#if defined(USE_AVX)
+			//two rows of the result at a time: each row is the sum of the rows of other,
+			//scaled by the matching elements of our row
+			Matrix4x4 result;
+			__m256 otherRow1 = _mm256_broadcast_ps(&other.row1);
+			__m256 otherRow2 = _mm256_broadcast_ps(&other.row2);
+			__m256 otherRow3 = _mm256_broadcast_ps(&other.row3);
+			__m256 otherRow4 = _mm256_broadcast_ps(&other.row4);
+			for (unsigned int i = 0; i < 2; i++)
+			{
+				__m256 rows = _mm256_loadu_ps(&M11 + i * 8);
+				__m256 sum = _mm256_mul_ps(_mm256_shuffle_ps(rows, rows, 0x00), otherRow1);
+#if defined(USE_FMA)
+				sum = _mm256_fmadd_ps(_mm256_shuffle_ps(rows, rows, 0x55), otherRow2, sum);
+				sum = _mm256_fmadd_ps(_mm256_shuffle_ps(rows, rows, 0xAA), otherRow3, sum);
+				sum = _mm256_fmadd_ps(_mm256_shuffle_ps(rows, rows, 0xFF), otherRow4, sum);
+#else
+				sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_shuffle_ps(rows, rows, 0x55), otherRow2));
+				sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_shuffle_ps(rows, rows, 0xAA), otherRow3));
+				sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_shuffle_ps(rows, rows, 0xFF), otherRow4));
+#endif
+				_mm256_storeu_ps(&result.M11 + i * 8, sum);
+			}
+			return result;
+#elif defined(USE_SSE)
 			Matrix4x4 result;
 			const __m128 BCx = other.row1;
 			const __m128 BCy = other.row2;
@@ -383,6 +480,11 @@ namespace Maths
 			}
 			return result;
 #else
+			return MultiplyScalar(other);
+#endif
+		}
+		Matrix4x4 MultiplyScalar(const Matrix4x4 &other)
+		{
 			Matrix4x4 m;
 
 			// First row
@@ -410,7 +512,6 @@ namespace Maths
 			m.M44 = M41 * other.M14 + M42 * other.M24 + M43 * other.M34 + M44 * other.M44;
 
 			return m;
-#endif
 		}
 		inline Matrix4x4 operator*=(const Matrix4x4 other)
 		{
@@ -434,7 +535,21 @@ namespace Maths
 				M41 != other.M41 || M42 != other.M42 || M43 != other.M43 || M44 != other.M44);
 		}
 
-        inline Vec3 Transform(Vec3 vec3)
+		inline Vec3 Transform(Vec3 vec3)
+		{
+#ifdef USE_SSE
+			__m128 result = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(vec3.X), row1), row4);
+			result = _mm_add_ps(result, _mm_mul_ps(_mm_set1_ps(vec3.Y), row2));
+			result = _mm_add_ps(result, _mm_mul_ps(_mm_set1_ps(vec3.Z), row3));
+			result = _mm_div_ps(result, SIMD_SWIZZLE(result, 3, 3, 3, 3));
+			float components[4];
+			_mm_storeu_ps(components, result);
+			return Vec3(components[0], components[1], components[2]);
+#else
+			return TransformScalar(vec3);
+#endif
+		}
+        inline Vec3 TransformScalar(Vec3 vec3)
         {
 			float vec4[4] = {
             vec3.X * M11 + vec3.Y * M21 + vec3.Z * M31 + M41,
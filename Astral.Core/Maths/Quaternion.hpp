@@ -28,7 +28,8 @@ namespace Maths
 		inline Quaternion(float x, float y, float z, float w)
 		{
 #ifdef USE_SSE
-			asM128 = _mm_set_ps(x, y, z, w);
+			//_mm_set_ps takes lanes from highest to lowest
+			asM128 = _mm_set_ps(w, z, y, x);
 #else
 			X = x;
 			Y = y;
@@ -39,7 +40,7 @@ namespace Maths
 		inline Quaternion(Vec3 vector, float scalar)
 		{
 #ifdef USE_SSE
-			asM128 = _mm_set_ps(vector.X, vector.Y, vector.Z, scalar);
+			asM128 = _mm_set_ps(scalar, vector.Z, vector.Y, vector.X);
 #else
 			X = vector.X;
 			Y = vector.Y;
@@ -69,10 +70,10 @@ namespace Maths
 		}
 		inline Quaternion Normalized()
 		{
-			float oneOverNormalized = 1.0f / sqrtf(X * X + Y * Y + Z * Z + W * W);
 #ifdef USE_SSE
-			return Quaternion(_mm_mul_ps(asM128, _mm_set1_ps(oneOverNormalized)));
+			return Quaternion(_mm_div_ps(asM128, _mm_sqrt_ps(Simd_Dot4(asM128, asM128))));
 #else
+			float oneOverNormalized = 1.0f / sqrtf(X * X + Y * Y + Z * Z + W * W);
 			return Quaternion(
 				X * oneOverNormalized,
 				Y * oneOverNormalized,
@@ -86,7 +87,11 @@ namespace Maths
 		}
 		static inline Quaternion Conjugate(Quaternion quat)
 		{
+#ifdef USE_SSE
+			return Quaternion(_mm_xor_ps(quat.asM128, _mm_set_ps(0.0f, -0.0f, -0.0f, -0.0f)));
+#else
 			return Quaternion(-quat.X, -quat.Y, -quat.Z, quat.W);
+#endif
 		}
 		inline Quaternion Inversed()
 		{
@@ -142,10 +147,23 @@ namespace Maths
 		}
 		static inline float Dot(Quaternion A, Quaternion B)
 		{
+#ifdef USE_SSE
+			return _mm_cvtss_f32(Simd_Dot4(A.asM128, B.asM128));
+#else
 			return A.X * B.X + A.Y * B.Y + A.Z * B.Z + A.W * B.W;
+#endif
 		}
 		static inline Quaternion Lerp(Quaternion A, Quaternion B, float amount)
 		{
+#ifdef USE_SSE
+			//take the shorter way around by flipping B when the two point away from each other
+			__m128 dot = Simd_Dot4(A.asM128, B.asM128);
+			__m128 flip = _mm_and_ps(_mm_cmplt_ps(dot, _mm_setzero_ps()), _mm_set1_ps(-0.0f));
+			__m128 b = _mm_xor_ps(B.asM128, flip);
+			__m128 amountAsM128 = _mm_set1_ps(amount);
+			__m128 result = _mm_add_ps(_mm_mul_ps(A.asM128, _mm_set1_ps(1.0f - amount)), _mm_mul_ps(b, amountAsM128));
+			return Quaternion(result).Normalized();
+#else
 			float invAmount = 1.0f - amount;
 			float dot = A.X * B.X + A.Y * B.Y + A.Z * B.Z + A.W * B.W;
 			if (dot >= 0.0f)
@@ -166,9 +184,14 @@ namespace Maths
 					invAmount * A.W - amount * B.W
 				).Normalized();
 			}
+#endif
 		}
+		//Rotation by this quaternion followed by other, ie: other * this
 		inline Quaternion Concat(Quaternion other)
 		{
+#ifdef USE_SSE
+			return other.Mult(*this);
+#else
 			float cX = other.Y * Z - other.Z * Y;
 			float cY = other.Z * X - other.X * Z;
 			float cZ = other.X * Y - other.Y * X;
@@ -181,6 +204,7 @@ namespace Maths
 				other.Z * W + Z * other.W + cZ,
 				other.W * W - dot
 			);
+#endif
 		}
 		static inline Quaternion Concat(Quaternion A, Quaternion B)
 		{
@@ -188,7 +212,11 @@ namespace Maths
 		}
 		inline Quaternion Negative()
 		{
+#ifdef USE_SSE
+			return Quaternion(_mm_xor_ps(asM128, _mm_set1_ps(-0.0f)));
+#else
 			return Quaternion(-X, -Y, -Z, -W);
+#endif
 		}
 		inline Quaternion Add(Quaternion other)
 		{
@@ -208,6 +236,23 @@ namespace Maths
 		}
 		inline Quaternion Mult(Quaternion other)
 		{
+#ifdef USE_SSE
+			//x = ax*bw + aw*bx + ay*bz - az*by, and likewise for y and z
+			//w = aw*bw - ax*bx - ay*by - az*bz
+			__m128 a = asM128;
+			__m128 b = other.asM128;
+			__m128 negateW = _mm_set_ps(-0.0f, 0.0f, 0.0f, 0.0f);
+			__m128 result = _mm_mul_ps(a, SIMD_SWIZZLE(b, 3, 3, 3, 3));
+			result = _mm_add_ps(result, _mm_xor_ps(_mm_mul_ps(SIMD_SWIZZLE(a, 3, 3, 3, 0), SIMD_SWIZZLE(b, 0, 1, 2, 0)), negateW));
+			result = _mm_add_ps(result, _mm_xor_ps(_mm_mul_ps(SIMD_SWIZZLE(a, 1, 2, 0, 1), SIMD_SWIZZLE(b, 2, 0, 1, 1)), negateW));
+			result = _mm_sub_ps(result, _mm_mul_ps(SIMD_SWIZZLE(a, 2, 0, 1, 2), SIMD_SWIZZLE(b, 1, 2, 0, 2)));
+			return Quaternion(result);
+#else
+			return MultScalar(other);
+#endif
+		}
+		inline Quaternion MultScalar(Quaternion other)
+		{
 			float cX = Y * other.Z - Z * other.Y;
 			float cY = Z * other.X - X * other.Z;
 			float cZ = X * other.Y - Y * other.X;
@@ -0,0 +1,491 @@
+#pragma once
+#include <math.h>
+#include <string.h>
+#include "Linxc.h"
+#include "allocators.hpp"
+#include "Maths/simd.h"
+#include "Maths/Vec3.hpp"
+#include "Maths/Vec4.hpp"
+#include "Maths/Quaternion.hpp"
+#include "Maths/Matrix4x4.hpp"
+
+#include "assert.h"
+
+//Every Soa container's capacity is a multiple of this, so that batch kernels can always process
+//whole blocks of BATCH_WIDTH lanes and the last partial block runs over zeroed padding instead of needing a scalar tail
+#define SOA_PADDING 8
+
+//Lanes processed per step by the batch kernels, as picked by simd.h
+#if defined(USE_AVX)
+#define BATCH_WIDTH 8
+#elif defined(USE_SSE)
+#define BATCH_WIDTH 4
+#else
+#define BATCH_WIDTH 1
+#endif
+
+namespace Maths
+{
+#if defined(USE_AVX)
+    typedef __m256 BatchFloat;
+    inline BatchFloat Batch_Load(const float *ptr) { return _mm256_loadu_ps(ptr); }
+    inline void Batch_Store(float *ptr, BatchFloat value) { _mm256_storeu_ps(ptr, value); }
+    inline BatchFloat Batch_Set1(float value) { return _mm256_set1_ps(value); }
+    inline BatchFloat Batch_Add(BatchFloat A, BatchFloat B) { return _mm256_add_ps(A, B); }
+    inline BatchFloat Batch_Sub(BatchFloat A, BatchFloat B) { return _mm256_sub_ps(A, B); }
+    inline BatchFloat Batch_Mul(BatchFloat A, BatchFloat B) { return _mm256_mul_ps(A, B); }
+    inline BatchFloat Batch_Div(BatchFloat A, BatchFloat B) { return _mm256_div_ps(A, B); }
+    inline BatchFloat Batch_Sqrt(BatchFloat A) { return _mm256_sqrt_ps(A); }
+    //A with its sign flipped wherever B is negative
+    inline BatchFloat Batch_FlipSignWhereNegative(BatchFloat A, BatchFloat B) { return _mm256_xor_ps(A, _mm256_and_ps(B, _mm256_set1_ps(-0.0f))); }
+#elif defined(USE_SSE)
+    typedef __m128 BatchFloat;
+    inline BatchFloat Batch_Load(const float *ptr) { return _mm_loadu_ps(ptr); }
+    inline void Batch_Store(float *ptr, BatchFloat value) { _mm_storeu_ps(ptr, value); }
+    inline BatchFloat Batch_Set1(float value) { return _mm_set1_ps(value); }
+    inline BatchFloat Batch_Add(BatchFloat A, BatchFloat B) { return _mm_add_ps(A, B); }
+    inline BatchFloat Batch_Sub(BatchFloat A, BatchFloat B) { return _mm_sub_ps(A, B); }
+    inline BatchFloat Batch_Mul(BatchFloat A, BatchFloat B) { return _mm_mul_ps(A, B); }
+    inline BatchFloat Batch_Div(BatchFloat A, BatchFloat B) { return _mm_div_ps(A, B); }
+    inline BatchFloat Batch_Sqrt(BatchFloat A) { return _mm_sqrt_ps(A); }
+    inline BatchFloat Batch_FlipSignWhereNegative(BatchFloat A, BatchFloat B) { return _mm_xor_ps(A, _mm_and_ps(B, _mm_set1_ps(-0.0f))); }
+#else
+    typedef float BatchFloat;
+    inline BatchFloat Batch_Load(const float *ptr) { return *ptr; }
+    inline void Batch_Store(float *ptr, BatchFloat value) { *ptr = value; }
+    inline BatchFloat Batch_Set1(float value) { return value; }
+    inline BatchFloat Batch_Add(BatchFloat A, BatchFloat B) { return A + B; }
+    inline BatchFloat Batch_Sub(BatchFloat A, BatchFloat B) { return A - B; }
+    inline BatchFloat Batch_Mul(BatchFloat A, BatchFloat B) { return A * B; }
+    inline BatchFloat Batch_Div(BatchFloat A, BatchFloat B) { return A / B; }
+    inline BatchFloat Batch_Sqrt(BatchFloat A) { return sqrtf(A); }
+    inline BatchFloat Batch_FlipSignWhereNegative(BatchFloat A, BatchFloat B) { return B < 0.0f ? -A : A; }
+#endif
+
+    inline usize Soa_PaddedCapacity(usize count)
+    {
+        return (count + SOA_PADDING - 1) / SOA_PADDING * SOA_PADDING;
+    }
+
+    //Structure of arrays storage for Vec3s, one contiguous array per component
+    struct Vec3Soa
+    {
+        IAllocator allocator;
+        float *X;
+        float *Y;
+        float *Z;
+        usize count;
+        usize capacity;
+
+        Vec3Soa()
+        {
+            allocator = IAllocator();
+            X = NULL;
+            Y = NULL;
+            Z = NULL;
+            count = 0;
+            capacity = 0;
+        }
+        /// @brief Creates storage for count zeroed vectors
+        Vec3Soa(IAllocator allocator, usize count)
+        {
+            this->allocator = allocator;
+            this->count = count;
+            this->capacity = Soa_PaddedCapacity(count);
+            //all three components share one allocation
+            X = (float *)allocator.Allocate(sizeof(float) * capacity * 3);
+            Y = X + capacity;
+            Z = Y + capacity;
+            memset(X, 0, sizeof(float) * capacity * 3);
+        }
+        //Zeroes the lanes from count up to capacity, which the batch kernels write whole blocks over
+        inline void ClearPadding()
+        {
+            usize padding = capacity - count;
+            if (padding > 0)
+            {
+                memset(X + count, 0, sizeof(float) * padding);
+                memset(Y + count, 0, sizeof(float) * padding);
+                memset(Z + count, 0, sizeof(float) * padding);
+            }
+        }
+        void deinit()
+        {
+            if (X != NULL)
+            {
+                allocator.FREEPTR(X);
+            }
+            Y = NULL;
+            Z = NULL;
+            count = 0;
+            capacity = 0;
+        }
+        inline Vec3 Get(usize index)
+        {
+            return Vec3(X[index], Y[index], Z[index]);
+        }
+        inline void Set(usize index, Vec3 value)
+        {
+            X[index] = value.X;
+            Y[index] = value.Y;
+            Z[index] = value.Z;
+        }
+        //Copies values[0..valuesCount) into the start of this
+        void Load(Vec3 *values, usize valuesCount)
+        {
+            assert(valuesCount <= count);
+            for (usize i = 0; i < valuesCount; i++)
+            {
+                Set(i, values[i]);
+            }
+        }
+        //Copies the first valuesCount vectors of this out to values
+        void Store(Vec3 *values, usize valuesCount)
+        {
+            assert(valuesCount <= count);
+            for (usize i = 0; i < valuesCount; i++)
+            {
+                values[i] = Get(i);
+            }
+        }
+    };
+
+    //Structure of arrays storage for Vec4s. Also used for batches of quaternions
+    struct Vec4Soa
+    {
+        IAllocator allocator;
+        float *X;
+        float *Y;
+        float *Z;
+        float *W;
+        usize count;
+        usize capacity;
+
+        Vec4Soa()
+        {
+            allocator = IAllocator();
+            X = NULL;
+            Y = NULL;
+            Z = NULL;
+            W = NULL;
+            count = 0;
+            capacity = 0;
+        }
+        /// @brief Creates storage for count zeroed vectors
+        Vec4Soa(IAllocator allocator, usize count)
+        {
+            this->allocator = allocator;
+            this->count = count;
+            this->capacity = Soa_PaddedCapacity(count);
+            X = (float *)allocator.Allocate(sizeof(float) * capacity * 4);
+            Y = X + capacity;
+            Z = Y + capacity;
+            W = Z + capacity;
+            memset(X, 0, sizeof(float) * capacity * 4);
+        }
+        inline void ClearPadding()
+        {
+            usize padding = capacity - count;
+            if (padding > 0)
+            {
+                memset(X + count, 0, sizeof(float) * padding);
+                memset(Y + count, 0, sizeof(float) * padding);
+                memset(Z + count, 0, sizeof(float) * padding);
+                memset(W + count, 0, sizeof(float) * padding);
+            }
+        }
+        void deinit()
+        {
+            if (X != NULL)
+            {
+                allocator.FREEPTR(X);
+            }
+            Y = NULL;
+            Z = NULL;
+            W = NULL;
+            count = 0;
+            capacity = 0;
+        }
+        inline Vec4 Get(usize index)
+        {
+            return Vec4(X[index], Y[index], Z[index], W[index]);
+        }
+        inline void Set(usize index, Vec4 value)
+        {
+            X[index] = value.X;
+            Y[index] = value.Y;
+            Z[index] = value.Z;
+            W[index] = value.W;
+        }
+        inline Quaternion GetQuaternion(usize index)
+        {
+            return Quaternion(X[index], Y[index], Z[index], W[index]);
+        }
+        inline void SetQuaternion(usize index, Quaternion value)
+        {
+            X[index] = value.X;
+            Y[index] = value.Y;
+            Z[index] = value.Z;
+            W[index] = value.W;
+        }
+        void Load(Vec4 *values, usize valuesCount)
+        {
+            assert(valuesCount <= count);
+            for (usize i = 0; i < valuesCount; i++)
+            {
+                Set(i, values[i]);
+            }
+        }
+        void Store(Vec4 *values, usize valuesCount)
+        {
+            assert(valuesCount <= count);
+            for (usize i = 0; i < valuesCount; i++)
+            {
+                values[i] = Get(i);
+            }
+        }
+    };
+
+    //The batch kernels below write to output for every element of the input, and output may be the input itself.
+    //output.count must equal the input's count: whole blocks are stored up to the input's padded capacity, and
+    //the output's padding is zeroed again afterwards
+
+    /// @brief Batch equivalent of Matrix4x4::Transform(Vec3): treats each point as (x, y, z, 1) and divides by the resulting w
+    inline void TransformPoints(Matrix4x4 &matrix, Vec3Soa &points, Vec3Soa &output)
+    {
+        assert(output.count == points.count);
+        BatchFloat m11 = Batch_Set1(matrix.M11), m12 = Batch_Set1(matrix.M12), m13 = Batch_Set1(matrix.M13), m14 = Batch_Set1(matrix.M14);
+        BatchFloat m21 = Batch_Set1(matrix.M21), m22 = Batch_Set1(matrix.M22), m23 = Batch_Set1(matrix.M23), m24 = Batch_Set1(matrix.M24);
+        BatchFloat m31 = Batch_Set1(matrix.M31), m32 = Batch_Set1(matrix.M32), m33 = Batch_Set1(matrix.M33), m34 = Batch_Set1(matrix.M34);
+        BatchFloat m41 = Batch_Set1(matrix.M41), m42 = Batch_Set1(matrix.M42), m43 = Batch_Set1(matrix.M43), m44 = Batch_Set1(matrix.M44);
+        BatchFloat one = Batch_Set1(1.0f);
+        for (usize i = 0; i < points.count; i += BATCH_WIDTH)
+        {
+            BatchFloat x = Batch_Load(points.X + i);
+            BatchFloat y = Batch_Load(points.Y + i);
+            BatchFloat z = Batch_Load(points.Z + i);
+            BatchFloat resultX = Batch_Add(Batch_Add(Batch_Mul(x, m11), Batch_Mul(y, m21)), Batch_Add(Batch_Mul(z, m31), m41));
+            BatchFloat resultY = Batch_Add(Batch_Add(Batch_Mul(x, m12), Batch_Mul(y, m22)), Batch_Add(Batch_Mul(z, m32), m42));
+            BatchFloat resultZ = Batch_Add(Batch_Add(Batch_Mul(x, m13), Batch_Mul(y, m23)), Batch_Add(Batch_Mul(z, m33), m43));
+            BatchFloat resultW = Batch_Add(Batch_Add(Batch_Mul(x, m14), Batch_Mul(y, m24)), Batch_Add(Batch_Mul(z, m34), m44));
+            BatchFloat oneOverW = Batch_Div(one, resultW);
+            Batch_Store(output.X + i, Batch_Mul(resultX, oneOverW));
+            Batch_Store(output.Y + i, Batch_Mul(resultY, oneOverW));
+            Batch_Store(output.Z + i, Batch_Mul(resultZ, oneOverW));
+        }
+        output.ClearPadding();
+    }
+    /// @brief Like TransformPoints, but for affine matrices (such as those used for skinning) where the divide by w can be skipped
+    inline void TransformPointsAffine(Matrix4x4 &matrix, Vec3Soa &points, Vec3Soa &output)
+    {
+        assert(output.count == points.count);
+        BatchFloat m11 = Batch_Set1(matrix.M11), m12 = Batch_Set1(matrix.M12), m13 = Batch_Set1(matrix.M13);
+        BatchFloat m21 = Batch_Set1(matrix.M21), m22 = Batch_Set1(matrix.M22), m23 = Batch_Set1(matrix.M23);
+        BatchFloat m31 = Batch_Set1(matrix.M31), m32 = Batch_Set1(matrix.M32), m33 = Batch_Set1(matrix.M33);
+        BatchFloat m41 = Batch_Set1(matrix.M41), m42 = Batch_Set1(matrix.M42), m43 = Batch_Set1(matrix.M43);
+        for (usize i = 0; i < points.count; i += BATCH_WIDTH)
+        {
+            BatchFloat x = Batch_Load(points.X + i);
+            BatchFloat y = Batch_Load(points.Y + i);
+            BatchFloat z = Batch_Load(points.Z + i);
+            Batch_Store(output.X + i, Batch_Add(Batch_Add(Batch_Mul(x, m11), Batch_Mul(y, m21)), Batch_Add(Batch_Mul(z, m31), m41)));
+            Batch_Store(output.Y + i, Batch_Add(Batch_Add(Batch_Mul(x, m12), Batch_Mul(y, m22)), Batch_Add(Batch_Mul(z, m32), m42)));
+            Batch_Store(output.Z + i, Batch_Add(Batch_Add(Batch_Mul(x, m13), Batch_Mul(y, m23)), Batch_Add(Batch_Mul(z, m33), m43)));
+        }
+        output.ClearPadding();
+    }
+    /// @brief Batch equivalent of Vec4::Transform, eg: for taking positions to clip space for culling
+    inline void TransformVec4s(Matrix4x4 &matrix, Vec4Soa &vectors, Vec4Soa &output)
+    {
+        assert(output.count == vectors.count);
+        BatchFloat m11 = Batch_Set1(matrix.M11), m12 = Batch_Set1(matrix.M12), m13 = Batch_Set1(matrix.M13), m14 = Batch_Set1(matrix.M14);
+        BatchFloat m21 = Batch_Set1(matrix.M21), m22 = Batch_Set1(matrix.M22), m23 = Batch_Set1(matrix.M23), m24 = Batch_Set1(matrix.M24);
+        BatchFloat m31 = Batch_Set1(matrix.M31), m32 = Batch_Set1(matrix.M32), m33 = Batch_Set1(matrix.M33), m34 = Batch_Set1(matrix.M34);
+        BatchFloat m41 = Batch_Set1(matrix.M41), m42 = Batch_Set1(matrix.M42), m43 = Batch_Set1(matrix.M43), m44 = Batch_Set1(matrix.M44);
+        for (usize i = 0; i < vectors.count; i += BATCH_WIDTH)
+        {
+            BatchFloat x = Batch_Load(vectors.X + i);
+            BatchFloat y = Batch_Load(vectors.Y + i);
+            BatchFloat z = Batch_Load(vectors.Z + i);
+            BatchFloat w = Batch_Load(vectors.W + i);
+            Batch_Store(output.X + i, Batch_Add(Batch_Add(Batch_Mul(x, m11), Batch_Mul(y, m21)), Batch_Add(Batch_Mul(z, m31), Batch_Mul(w, m41))));
+            Batch_Store(output.Y + i, Batch_Add(Batch_Add(Batch_Mul(x, m12), Batch_Mul(y, m22)), Batch_Add(Batch_Mul(z, m32), Batch_Mul(w, m42))));
+            Batch_Store(output.Z + i, Batch_Add(Batch_Add(Batch_Mul(x, m13), Batch_Mul(y, m23)), Batch_Add(Batch_Mul(z, m33), Batch_Mul(w, m43))));
+            Batch_Store(output.W + i, Batch_Add(Batch_Add(Batch_Mul(x, m14), Batch_Mul(y, m24)), Batch_Add(Batch_Mul(z, m34), Batch_Mul(w, m44))));
+        }
+        output.ClearPadding();
+    }
+
+    /// @brief results[i] = A[i] * B[i]. Each product already uses the full SIMD width (see Matrix4x4::operator*),
+    /// so matrices stay in their usual layout. results may alias A or B
+    inline void MultiplyMatrices(Matrix4x4 *A, Matrix4x4 *B, Matrix4x4 *results, usize count)
+    {
+        for (usize i = 0; i < count; i++)
+        {
+            results[i] = A[i] * B[i];
+        }
+    }
+    /// @brief results[i] = A[i] * B, eg: taking a hierarchy of local transforms to world space
+    inline void MultiplyMatrices(Matrix4x4 *A, Matrix4x4 &B, Matrix4x4 *results, usize count)
+    {
+        for (usize i = 0; i < count; i++)
+        {
+            results[i] = A[i] * B;
+        }
+    }
+
+    /// @brief Normalizes every quaternion (or Vec4) in quaternions, writing them to output
+    inline void NormalizeQuaternions(Vec4Soa &quaternions, Vec4Soa &output)
+    {
+        assert(output.count == quaternions.count);
+        for (usize i = 0; i < quaternions.count; i += BATCH_WIDTH)
+        {
+            BatchFloat x = Batch_Load(quaternions.X + i);
+            BatchFloat y = Batch_Load(quaternions.Y + i);
+            BatchFloat z = Batch_Load(quaternions.Z + i);
+            BatchFloat w = Batch_Load(quaternions.W + i);
+            BatchFloat length = Batch_Sqrt(Batch_Add(Batch_Add(Batch_Mul(x, x), Batch_Mul(y, y)), Batch_Add(Batch_Mul(z, z), Batch_Mul(w, w))));
+            Batch_Store(output.X + i, Batch_Div(x, length));
+            Batch_Store(output.Y + i, Batch_Div(y, length));
+            Batch_Store(output.Z + i, Batch_Div(z, length));
+            Batch_Store(output.W + i, Batch_Div(w, length));
+        }
+        output.ClearPadding();
+    }
+
+    /// @brief output[i] = A[i] + (B[i] - A[i]) * amount
+    inline void LerpVec3s(Vec3Soa &A, Vec3Soa &B, float amount, Vec3Soa &output)
+    {
+        assert(B.count >= A.count && output.count == A.count);
+        BatchFloat amountBatch = Batch_Set1(amount);
+        for (usize i = 0; i < A.count; i += BATCH_WIDTH)
+        {
+            BatchFloat x = Batch_Load(A.X + i);
+            BatchFloat y = Batch_Load(A.Y + i);
+            BatchFloat z = Batch_Load(A.Z + i);
+            Batch_Store(output.X + i, Batch_Add(x, Batch_Mul(Batch_Sub(Batch_Load(B.X + i), x), amountBatch)));
+            Batch_Store(output.Y + i, Batch_Add(y, Batch_Mul(Batch_Sub(Batch_Load(B.Y + i), y), amountBatch)));
+            Batch_Store(output.Z + i, Batch_Add(z, Batch_Mul(Batch_Sub(Batch_Load(B.Z + i), z), amountBatch)));
+        }
+        output.ClearPadding();
+    }
+    /// @brief output[i] = A[i] + (B[i] - A[i]) * amounts[i]. amounts must hold A.capacity floats
+    inline void LerpVec3s(Vec3Soa &A, Vec3Soa &B, float *amounts, Vec3Soa &output)
+    {
+        assert(B.count >= A.count && output.count == A.count);
+        for (usize i = 0; i < A.count; i += BATCH_WIDTH)
+        {
+            BatchFloat amountBatch = Batch_Load(amounts + i);
+            BatchFloat x = Batch_Load(A.X + i);
+            BatchFloat y = Batch_Load(A.Y + i);
+            BatchFloat z = Batch_Load(A.Z + i);
+            Batch_Store(output.X + i, Batch_Add(x, Batch_Mul(Batch_Sub(Batch_Load(B.X + i), x), amountBatch)));
+            Batch_Store(output.Y + i, Batch_Add(y, Batch_Mul(Batch_Sub(Batch_Load(B.Y + i), y), amountBatch)));
+            Batch_Store(output.Z + i, Batch_Add(z, Batch_Mul(Batch_Sub(Batch_Load(B.Z + i), z), amountBatch)));
+        }
+        output.ClearPadding();
+    }
+    /// @brief output[i] = A[i] + (B[i] - A[i]) * amount
+    inline void LerpVec4s(Vec4Soa &A, Vec4Soa &B, float amount, Vec4Soa &output)
+    {
+        assert(B.count >= A.count && output.count == A.count);
+        BatchFloat amountBatch = Batch_Set1(amount);
+        for (usize i = 0; i < A.count; i += BATCH_WIDTH)
+        {
+            BatchFloat x = Batch_Load(A.X + i);
+            BatchFloat y = Batch_Load(A.Y + i);
+            BatchFloat z = Batch_Load(A.Z + i);
+            BatchFloat w = Batch_Load(A.W + i);
+            Batch_Store(output.X + i, Batch_Add(x, Batch_Mul(Batch_Sub(Batch_Load(B.X + i), x), amountBatch)));
+            Batch_Store(output.Y + i, Batch_Add(y, Batch_Mul(Batch_Sub(Batch_Load(B.Y + i), y), amountBatch)));
+            Batch_Store(output.Z + i, Batch_Add(z, Batch_Mul(Batch_Sub(Batch_Load(B.Z + i), z), amountBatch)));
+            Batch_Store(output.W + i, Batch_Add(w, Batch_Mul(Batch_Sub(Batch_Load(B.W + i), w), amountBatch)));
+        }
+        output.ClearPadding();
+    }
+
+    /// @brief Batch equivalent of Quaternion::Lerp: interpolates along the shorter path and normalizes the result
+    inline void LerpQuaternions(Vec4Soa &A, Vec4Soa &B, float amount, Vec4Soa &output)
+    {
+        assert(B.count >= A.count && output.count == A.count);
+        BatchFloat weightA = Batch_Set1(1.0f - amount);
+        BatchFloat amountBatch = Batch_Set1(amount);
+        for (usize i = 0; i < A.count; i += BATCH_WIDTH)
+        {
+            BatchFloat ax = Batch_Load(A.X + i);
+            BatchFloat ay = Batch_Load(A.Y + i);
+            BatchFloat az = Batch_Load(A.Z + i);
+            BatchFloat aw = Batch_Load(A.W + i);
+            BatchFloat bx = Batch_Load(B.X + i);
+            BatchFloat by = Batch_Load(B.Y + i);
+            BatchFloat bz = Batch_Load(B.Z + i);
+            BatchFloat bw = Batch_Load(B.W + i);
+            BatchFloat dot = Batch_Add(Batch_Add(Batch_Mul(ax, bx), Batch_Mul(ay, by)), Batch_Add(Batch_Mul(az, bz), Batch_Mul(aw, bw)));
+            BatchFloat weightB = Batch_FlipSignWhereNegative(amountBatch, dot);
+            BatchFloat x = Batch_Add(Batch_Mul(ax, weightA), Batch_Mul(bx, weightB));
+            BatchFloat y = Batch_Add(Batch_Mul(ay, weightA), Batch_Mul(by, weightB));
+            BatchFloat z = Batch_Add(Batch_Mul(az, weightA), Batch_Mul(bz, weightB));
+            BatchFloat w = Batch_Add(Batch_Mul(aw, weightA), Batch_Mul(bw, weightB));
+            BatchFloat length = Batch_Sqrt(Batch_Add(Batch_Add(Batch_Mul(x, x), Batch_Mul(y, y)), Batch_Add(Batch_Mul(z, z), Batch_Mul(w, w))));
+            Batch_Store(output.X + i, Batch_Div(x, length));
+            Batch_Store(output.Y + i, Batch_Div(y, length));
+            Batch_Store(output.Z + i, Batch_Div(z, length));
+            Batch_Store(output.W + i, Batch_Div(w, length));
+        }
+        output.ClearPadding();
+    }
+
+    //Per lane weights for SlerpQuaternions. The dot products come from the vector code,
+    //but the trigonometry has no SIMD equivalent here so it runs once per lane
+    inline void Slerp_Weights(float *dots, float amount, float *weightsA, float *weightsB)
+    {
+        for (usize lane = 0; lane < BATCH_WIDTH; lane++)
+        {
+            float dot = fabsf(dots[lane]);
+            if (dot > 0.9995f)
+            {
+                //nearly identical rotations, sin(theta) is too close to 0 so lerp instead
+                weightsA[lane] = 1.0f - amount;
+                weightsB[lane] = amount;
+            }
+            else
+            {
+                float theta = acosf(dot);
+                float oneOverSinTheta = 1.0f / sinf(theta);
+                weightsA[lane] = sinf((1.0f - amount) * theta) * oneOverSinTheta;
+                weightsB[lane] = sinf(amount * theta) * oneOverSinTheta;
+            }
+        }
+    }
+    /// @brief Spherical interpolation from A[i] to B[i] for every pair of unit quaternions, taking the shorter path
+    inline void SlerpQuaternions(Vec4Soa &A, Vec4Soa &B, float amount, Vec4Soa &output)
+    {
+        assert(B.count >= A.count && output.count == A.count);
+        float dots[BATCH_WIDTH];
+        float weightsA[BATCH_WIDTH];
+        float weightsB[BATCH_WIDTH];
+        for (usize i = 0; i < A.count; i += BATCH_WIDTH)
+        {
+            BatchFloat ax = Batch_Load(A.X + i);
+            BatchFloat ay = Batch_Load(A.Y + i);
+            BatchFloat az = Batch_Load(A.Z + i);
+            BatchFloat aw = Batch_Load(A.W + i);
+            BatchFloat bx = Batch_Load(B.X + i);
+            BatchFloat by = Batch_Load(B.Y + i);
+            BatchFloat bz = Batch_Load(B.Z + i);
+            BatchFloat bw = Batch_Load(B.W + i);
+            BatchFloat dot = Batch_Add(Batch_Add(Batch_Mul(ax, bx), Batch_Mul(ay, by)), Batch_Add(Batch_Mul(az, bz), Batch_Mul(aw, bw)));
+            Batch_Store(dots, dot);
+            Slerp_Weights(dots, amount, weightsA, weightsB);
+
+            BatchFloat weightA = Batch_Load(weightsA);
+            //B and -B are the same rotation, use whichever is closer to A
+            BatchFloat weightB = Batch_FlipSignWhereNegative(Batch_Load(weightsB), dot);
+            Batch_Store(output.X + i, Batch_Add(Batch_Mul(ax, weightA), Batch_Mul(bx, weightB)));
+            Batch_Store(output.Y + i, Batch_Add(Batch_Mul(ay, weightA), Batch_Mul(by, weightB)));
+            Batch_Store(output.Z + i, Batch_Add(Batch_Mul(az, weightA), Batch_Mul(bz, weightB)));
+            Batch_Store(output.W + i, Batch_Add(Batch_Mul(aw, weightA), Batch_Mul(bw, weightB)));
+        }
+        output.ClearPadding();
+    }
+}
@@ -169,14 +169,22 @@ namespace Maths
         }
         inline Vec4 operator*(float other)
         {
+#ifdef USE_SSE
+            return Vec4(_mm_mul_ps(asM128, _mm_set1_ps(other)));
+#else
             return Vec4(X * other, Y * other, Z * other, W * other);
+#endif
         }
         inline void operator*=(float other)
         {
+#ifdef USE_SSE
+            asM128 = _mm_mul_ps(asM128, _mm_set1_ps(other));
+#else
             X *= other;
             Y *= other;
             Z *= other;
             W *= other;
+#endif
         }
 
         //division operators
@@ -209,15 +217,12 @@ namespace Maths
         inline Vec4 operator/(float other)
         {
             float mult = 1.0f / other;
-            return Vec4(X * mult, Y * mult, Z * mult, W * mult);
+            return *this * mult;
         }
         inline void operator/=(float other)
         {
             float mult = 1.0f / other;
-            X *= mult;
-            Y *= mult;
-            Z *= mult;
-            W *= mult;
+            *this *= mult;
         }
         inline Maths::Vec3 ToVector3()
         {
@@ -233,7 +238,7 @@ namespace Maths
 #endif
         }
 
-        inline Vec4 Transform(Matrix4x4 matrix)
+        inline Vec4 TransformScalar(const Matrix4x4 &matrix)
         {
             return Vec4(
             X * matrix.M11 + Y * matrix.M21 + Z * matrix.M31 + W * matrix.M41,
@@ -241,6 +246,19 @@ namespace Maths
             X * matrix.M13 + Y * matrix.M23 + Z * matrix.M33 + W * matrix.M43,
             X * matrix.M14 + Y * matrix.M24 + Z * matrix.M34 + W * matrix.M44);
         }
+        inline Vec4 Transform(const Matrix4x4 &matrix)
+        {
+#ifdef USE_SSE
+            //row vector times matrix: each component scales the matching row
+            __m128 result = _mm_mul_ps(SIMD_SWIZZLE(asM128, 0, 0, 0, 0), matrix.row1);
+            result = _mm_add_ps(result, _mm_mul_ps(SIMD_SWIZZLE(asM128, 1, 1, 1, 1), matrix.row2));
+            result = _mm_add_ps(result, _mm_mul_ps(SIMD_SWIZZLE(asM128, 2, 2, 2, 2), matrix.row3));
+            result = _mm_add_ps(result, _mm_mul_ps(SIMD_SWIZZLE(asM128, 3, 3, 3, 3), matrix.row4));
+            return Vec4(result);
+#else
+            return TransformScalar(matrix);
+#endif
+        }
         inline Vec4 operator*(Matrix4x4 matrix)
         {
             return this->Transform(matrix);
@@ -248,6 +266,7 @@ namespace Maths
         inline Vec4 operator*=(Matrix4x4 matrix)
         {
             *this = this->Transform(matrix);
+            return *this;
         }
 
         float Length()
@@ -286,7 +305,19 @@ namespace Maths
         }
         static inline float Dot(Vec4 A, Vec4 B)
         {
+#ifdef USE_SSE
+            return _mm_cvtss_f32(Simd_Dot4(A.asM128, B.asM128));
+#else
             return A.X * B.X + A.Y * B.Y + A.Z * B.Z + A.W * B.W;
+#endif
+        }
+        inline Vec4 Normalized()
+        {
+#ifdef USE_SSE
+            return Vec4(_mm_div_ps(asM128, _mm_sqrt_ps(Simd_Dot4(asM128, asM128))));
+#else
+            return *this / sqrtf(Dot(*this, *this));
+#endif
         }
 
         /*static inline Vec4 Cross(Vec4 A, Vec4 B)
@@ -1,9 +1,10 @@
-#define FORCE_NO_INTRINSICS
+#pragma once
 
+//Instruction sets are picked at compile time from the compiler's target flags (-msse4.1, -mavx, /arch:AVX etc).
+//Define FORCE_NO_INTRINSICS before including any Maths header to fall back to the scalar code,
+//which is also always available through the *Scalar functions as a reference implementation
 #ifndef FORCE_NO_INTRINSICS
-#if defined(__AVX2__)
-#   include <immintrin.h>
-#elif defined(__AVX__)
+#if defined(__AVX2__) || defined(__AVX__)
 #   include <immintrin.h>
 #elif defined(__SSE4_2__)
 #   include <nmmintrin.h>
@@ -17,11 +18,39 @@
 #   include<emmintrin.h>
 #endif
 
-#ifdef _M_AMD64
-#endif
-
 #if defined(__SSE4_2__) || defined(__SSE4_1__) || defined(__SSE3__) || defined(__SSE2__) || defined(__x86_64__) || defined(_M_X64) || defined(_M_IX86_FP)
 #define USE_SSE
 #endif
 
+#if defined(USE_SSE) && defined(__AVX__)
+#define USE_AVX
+#endif
+
+#if defined(USE_AVX) && defined(__FMA__)
+#define USE_FMA
+#endif
+
+#endif
+
+#ifdef USE_SSE
+//lanes of a shuffle result, listed from lane 0 up (the reverse of _MM_SHUFFLE)
+#define SIMD_SHUFFLE_MASK(x, y, z, w) ((x) | ((y) << 2) | ((z) << 4) | ((w) << 6))
+#define SIMD_SWIZZLE(vec, x, y, z, w) _mm_shuffle_ps(vec, vec, SIMD_SHUFFLE_MASK(x, y, z, w))
+#define SIMD_SHUFFLE(vec1, vec2, x, y, z, w) _mm_shuffle_ps(vec1, vec2, SIMD_SHUFFLE_MASK(x, y, z, w))
+
+//Sum of all four lanes, broadcast to every lane
+inline __m128 Simd_HorizontalSum(__m128 vec)
+{
+    __m128 swapped = SIMD_SWIZZLE(vec, 1, 0, 3, 2);
+    __m128 sums = _mm_add_ps(vec, swapped);
+    return _mm_add_ps(sums, SIMD_SWIZZLE(sums, 2, 3, 0, 1));
+}
+inline __m128 Simd_Dot4(__m128 A, __m128 B)
+{
+#if defined(__SSE4_1__)
+    return _mm_dp_ps(A, B, 0xFF);
+#else
+    return Simd_HorizontalSum(_mm_mul_ps(A, B));
+#endif
+}
 #endif
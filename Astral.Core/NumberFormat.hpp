@@ -0,0 +1,421 @@
+#pragma once
+
+#include "Linxc.h"
+#include <string.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+//Characters FormatDouble and FormatFloat may write, including a sign
+#define NUMBER_FORMAT_MAX_FLOAT_LENGTH 32
+//Characters FormatI64 and FormatU64 may write, including a sign
+#define NUMBER_FORMAT_MAX_INTEGER_LENGTH 20
+
+inline const char* NumberFormat_Digits2(usize value)
+{
+    return &"0001020304050607080910111213141516171819"
+        "2021222324252627282930313233343536373839"
+        "4041424344454647484950515253545556575859"
+        "6061626364656667686970717273747576777879"
+        "8081828384858687888990919293949596979899"[value * 2];
+}
+
+inline u32 NumberFormat_LeadingZeros64(u64 value)
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanReverse64(&index, value);
+    return 63 - (u32)index;
+#else
+    return (u32)__builtin_clzll(value);
+#endif
+}
+inline u32 CountDigits(u64 value)
+{
+    static const u64 powersOfTen[] = {
+        0ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL, 100000000ULL,
+        1000000000ULL, 10000000000ULL, 100000000000ULL, 1000000000000ULL, 10000000000000ULL,
+        100000000000000ULL, 1000000000000000ULL, 10000000000000000ULL, 100000000000000000ULL,
+        1000000000000000000ULL, 10000000000000000000ULL
+    };
+    //1233 / 4096 is just above log10(2), so this is the digit count or one more than it
+    u32 estimate = ((64 - NumberFormat_LeadingZeros64(value | 1)) * 1233) >> 12;
+    return estimate + 1 - (value < powersOfTen[estimate]);
+}
+//Writes the digits of integer to output and returns how many there were. output is not null terminated
+inline usize FormatU64(char *output, u64 integer)
+{
+    usize length = CountDigits(integer);
+    char *end = output + length;
+    //two digits at a time from the end, so the digits never need reversing
+    while (integer >= 100)
+    {
+        end -= 2;
+        memcpy(end, NumberFormat_Digits2(integer % 100), 2);
+        integer /= 100;
+    }
+    if (integer >= 10)
+    {
+        memcpy(end - 2, NumberFormat_Digits2(integer), 2);
+    }
+    else
+    {
+        end[-1] = (char)('0' + integer);
+    }
+    return length;
+}
+inline usize FormatI64(char *output, i64 integer)
+{
+    if (integer < 0)
+    {
+        *output = '-';
+        //negated as unsigned, as -I64Min does not fit in i64
+        return FormatU64(output + 1, (u64)0 - (u64)integer) + 1;
+    }
+    return FormatU64(output, (u64)integer);
+}
+
+//Floats are formatted with Grisu2, which always gives digits that read back as the same value and in almost
+//every case the fewest such digits. Numbers are handled as a 64 bit mantissa with a binary exponent
+struct NumberFormat_DiyFp
+{
+    u64 mantissa;
+    i32 exponent;
+
+    inline NumberFormat_DiyFp()
+    {
+        mantissa = 0;
+        exponent = 0;
+    }
+    inline NumberFormat_DiyFp(u64 mantissa, i32 exponent)
+    {
+        this->mantissa = mantissa;
+        this->exponent = exponent;
+    }
+    inline NumberFormat_DiyFp Subtract(NumberFormat_DiyFp other)
+    {
+        return NumberFormat_DiyFp(mantissa - other.mantissa, exponent);
+    }
+    //the upper 64 bits of the product, rounded
+    inline NumberFormat_DiyFp Multiply(NumberFormat_DiyFp other)
+    {
+        u64 aLow = mantissa & 0xFFFFFFFF;
+        u64 aHigh = mantissa >> 32;
+        u64 bLow = other.mantissa & 0xFFFFFFFF;
+        u64 bHigh = other.mantissa >> 32;
+
+        u64 lowLow = aLow * bLow;
+        u64 lowHigh = aLow * bHigh;
+        u64 highLow = aHigh * bLow;
+        u64 highHigh = aHigh * bHigh;
+
+        u64 middle = (lowLow >> 32) + (lowHigh & 0xFFFFFFFF) + (highLow & 0xFFFFFFFF);
+        middle += (u64)1 << 31;
+        return NumberFormat_DiyFp(highHigh + (lowHigh >> 32) + (highLow >> 32) + (middle >> 32), exponent + other.exponent + 64);
+    }
+    inline NumberFormat_DiyFp Normalized()
+    {
+        u32 shift = NumberFormat_LeadingZeros64(mantissa);
+        return NumberFormat_DiyFp(mantissa << shift, exponent - (i32)shift);
+    }
+};
+struct NumberFormat_CachedPower
+{
+    u64 mantissa;
+    i32 exponent;
+    i32 decimalExponent;
+};
+//10^k for every 8th k from -300 to 324, normalized to 64 bits
+inline NumberFormat_CachedPower NumberFormat_GetCachedPower(i32 binaryExponent)
+{
+    static const NumberFormat_CachedPower cachedPowers[] = {
+        { 0xAB70FE17C79AC6CAULL, -1060, -300 },
+        { 0xFF77B1FCBEBCDC4FULL, -1034, -292 },
+        { 0xBE5691EF416BD60CULL, -1007, -284 },
+        { 0x8DD01FAD907FFC3CULL, -980, -276 },
+        { 0xD3515C2831559A83ULL, -954, -268 },
+        { 0x9D71AC8FADA6C9B5ULL, -927, -260 },
+        { 0xEA9C227723EE8BCBULL, -901, -252 },
+        { 0xAECC49914078536DULL, -874, -244 },
+        { 0x823C12795DB6CE57ULL, -847, -236 },
+        { 0xC21094364DFB5637ULL, -821, -228 },
+        { 0x9096EA6F3848984FULL, -794, -220 },
+        { 0xD77485CB25823AC7ULL, -768, -212 },
+        { 0xA086CFCD97BF97F4ULL, -741, -204 },
+        { 0xEF340A98172AACE5ULL, -715, -196 },
+        { 0xB23867FB2A35B28EULL, -688, -188 },
+        { 0x84C8D4DFD2C63F3BULL, -661, -180 },
+        { 0xC5DD44271AD3CDBAULL, -635, -172 },
+        { 0x936B9FCEBB25C996ULL, -608, -164 },
+        { 0xDBAC6C247D62A584ULL, -582, -156 },
+        { 0xA3AB66580D5FDAF6ULL, -555, -148 },
+        { 0xF3E2F893DEC3F126ULL, -529, -140 },
+        { 0xB5B5ADA8AAFF80B8ULL, -502, -132 },
+        { 0x87625F056C7C4A8BULL, -475, -124 },
+        { 0xC9BCFF6034C13053ULL, -449, -116 },
+        { 0x964E858C91BA2655ULL, -422, -108 },
+        { 0xDFF9772470297EBDULL, -396, -100 },
+        { 0xA6DFBD9FB8E5B88FULL, -369, -92 },
+        { 0xF8A95FCF88747D94ULL, -343, -84 },
+        { 0xB94470938FA89BCFULL, -316, -76 },
+        { 0x8A08F0F8BF0F156BULL, -289, -68 },
+        { 0xCDB02555653131B6ULL, -263, -60 },
+        { 0x993FE2C6D07B7FACULL, -236, -52 },
+        { 0xE45C10C42A2B3B06ULL, -210, -44 },
+        { 0xAA242499697392D3ULL, -183, -36 },
+        { 0xFD87B5F28300CA0EULL, -157, -28 },
+        { 0xBCE5086492111AEBULL, -130, -20 },
+        { 0x8CBCCC096F5088CCULL, -103, -12 },
+        { 0xD1B71758E219652CULL, -77, -4 },
+        { 0x9C40000000000000ULL, -50, 4 },
+        { 0xE8D4A51000000000ULL, -24, 12 },
+        { 0xAD78EBC5AC620000ULL, 3, 20 },
+        { 0x813F3978F8940984ULL, 30, 28 },
+        { 0xC097CE7BC90715B3ULL, 56, 36 },
+        { 0x8F7E32CE7BEA5C70ULL, 83, 44 },
+        { 0xD5D238A4ABE98068ULL, 109, 52 },
+        { 0x9F4F2726179A2245ULL, 136, 60 },
+        { 0xED63A231D4C4FB27ULL, 162, 68 },
+        { 0xB0DE65388CC8ADA8ULL, 189, 76 },
+        { 0x83C7088E1AAB65DBULL, 216, 84 },
+        { 0xC45D1DF942711D9AULL, 242, 92 },
+        { 0x924D692CA61BE758ULL, 269, 100 },
+        { 0xDA01EE641A708DEAULL, 295, 108 },
+        { 0xA26DA3999AEF774AULL, 322, 116 },
+        { 0xF209787BB47D6B85ULL, 348, 124 },
+        { 0xB454E4A179DD1877ULL, 375, 132 },
+        { 0x865B86925B9BC5C2ULL, 402, 140 },
+        { 0xC83553C5C8965D3DULL, 428, 148 },
+        { 0x952AB45CFA97A0B3ULL, 455, 156 },
+        { 0xDE469FBD99A05FE3ULL, 481, 164 },
+        { 0xA59BC234DB398C25ULL, 508, 172 },
+        { 0xF6C69A72A3989F5CULL, 534, 180 },
+        { 0xB7DCBF5354E9BECEULL, 561, 188 },
+        { 0x88FCF317F22241E2ULL, 588, 196 },
+        { 0xCC20CE9BD35C78A5ULL, 614, 204 },
+        { 0x98165AF37B2153DFULL, 641, 212 },
+        { 0xE2A0B5DC971F303AULL, 667, 220 },
+        { 0xA8D9D1535CE3B396ULL, 694, 228 },
+        { 0xFB9B7CD9A4A7443CULL, 720, 236 },
+        { 0xBB764C4CA7A44410ULL, 747, 244 },
+        { 0x8BAB8EEFB6409C1AULL, 774, 252 },
+        { 0xD01FEF10A657842CULL, 800, 260 },
+        { 0x9B10A4E5E9913129ULL, 827, 268 },
+        { 0xE7109BFBA19C0C9DULL, 853, 276 },
+        { 0xAC2820D9623BF429ULL, 880, 284 },
+        { 0x80444B5E7AA7CF85ULL, 907, 292 },
+        { 0xBF21E44003ACDD2DULL, 933, 300 },
+        { 0x8E679C2F5E44FF8FULL, 960, 308 },
+        { 0xD433179D9C8CB841ULL, 986, 316 },
+        { 0x9E19DB92B4E31BA9ULL, 1013, 324 }
+    };
+    //picks a power that brings the product's binary exponent into [-60, -32], where its integer part fits in 32 bits
+    i32 f = -60 - binaryExponent - 1;
+    //78913 / 2^18 is log10(2)
+    i32 k = (f * 78913) / (1 << 18) + (f > 0);
+    i32 index = (300 + k + 7) / 8;
+    return cachedPowers[index];
+}
+//nudges the last digit down while that brings it closer to the exact value and stays in range
+inline void NumberFormat_Round(char *digits, usize length, u64 distance, u64 delta, u64 rest, u64 tenToTheK)
+{
+    while (rest < distance && delta - rest >= tenToTheK && (rest + tenToTheK < distance || distance - rest > rest + tenToTheK - distance))
+    {
+        digits[length - 1]--;
+        rest += tenToTheK;
+    }
+}
+//Generates the fewest digits that fall between low and high, the scaled boundaries of the value
+inline usize NumberFormat_GenerateDigits(char *digits, i32 *decimalExponent, NumberFormat_DiyFp low, NumberFormat_DiyFp value, NumberFormat_DiyFp high)
+{
+    u64 delta = high.Subtract(low).mantissa;
+    u64 distance = high.Subtract(value).mantissa;
+    u32 shift = (u32)-high.exponent;
+    u64 one = (u64)1 << shift;
+
+    u32 integral = (u32)(high.mantissa >> shift);
+    u64 fractional = high.mantissa & (one - 1);
+
+    usize length = 0;
+    u32 digitsLeft = CountDigits(integral);
+    u32 divisor = 1;
+    for (u32 i = 1; i < digitsLeft; i++)
+    {
+        divisor *= 10;
+    }
+    while (digitsLeft > 0)
+    {
+        digits[length] = (char)('0' + integral / divisor);
+        length++;
+        integral %= divisor;
+        digitsLeft--;
+        u64 rest = ((u64)integral << shift) + fractional;
+        if (rest <= delta)
+        {
+            *decimalExponent += (i32)digitsLeft;
+            NumberFormat_Round(digits, length, distance, delta, rest, (u64)divisor << shift);
+            return length;
+        }
+        divisor /= 10;
+    }
+    i32 fractionalDigits = 0;
+    while (true)
+    {
+        fractional *= 10;
+        digits[length] = (char)('0' + (fractional >> shift));
+        length++;
+        fractional &= one - 1;
+        fractionalDigits++;
+        delta *= 10;
+        distance *= 10;
+        if (fractional <= delta)
+        {
+            break;
+        }
+    }
+    *decimalExponent -= fractionalDigits;
+    NumberFormat_Round(digits, length, distance, delta, fractional, one);
+    return length;
+}
+//the digits of a positive, finite value given as its mantissa and exponent, where mantissaBits counts the hidden bit
+inline usize NumberFormat_Grisu2(char *digits, i32 *decimalExponent, u64 bits, u32 mantissaBits, i32 exponentBias)
+{
+    u64 hiddenBit = (u64)1 << (mantissaBits - 1);
+    u64 fraction = bits & (hiddenBit - 1);
+    i32 biasedExponent = (i32)(bits >> (mantissaBits - 1));
+    i32 minExponent = 1 - exponentBias;
+
+    NumberFormat_DiyFp value = biasedExponent == 0 ? NumberFormat_DiyFp(fraction, minExponent) : NumberFormat_DiyFp(fraction + hiddenBit, biasedExponent - exponentBias);
+    //halfway to the neighbouring values on either side, the lower of which is nearer when crossing a power of two
+    bool lowerIsCloser = fraction == 0 && biasedExponent > 1;
+    NumberFormat_DiyFp high = NumberFormat_DiyFp(2 * value.mantissa + 1, value.exponent - 1).Normalized();
+    NumberFormat_DiyFp low = lowerIsCloser ? NumberFormat_DiyFp(4 * value.mantissa - 1, value.exponent - 2) : NumberFormat_DiyFp(2 * value.mantissa - 1, value.exponent - 1);
+    low = NumberFormat_DiyFp(low.mantissa << (low.exponent - high.exponent), high.exponent);
+    value = value.Normalized();
+
+    NumberFormat_CachedPower cached = NumberFormat_GetCachedPower(high.exponent);
+    NumberFormat_DiyFp power = NumberFormat_DiyFp(cached.mantissa, cached.exponent);
+    NumberFormat_DiyFp scaledValue = value.Multiply(power);
+    NumberFormat_DiyFp scaledLow = low.Multiply(power);
+    NumberFormat_DiyFp scaledHigh = high.Multiply(power);
+    //the products may be off by one, so narrow the range to stay within the true boundaries
+    scaledLow.mantissa++;
+    scaledHigh.mantissa--;
+
+    *decimalExponent = -cached.decimalExponent;
+    return NumberFormat_GenerateDigits(digits, decimalExponent, scaledLow, scaledValue, scaledHigh);
+}
+//Lays digits * 10^decimalExponent out in place, as plain decimals from 10^-4 up to 10^maxExponent and in
+//scientific notation outside of them. Whole numbers keep a .0 so that they still read as floats
+inline usize NumberFormat_Layout(char *output, usize length, i32 decimalExponent, i32 maxExponent)
+{
+    i32 digitCount = (i32)length;
+    //position of the decimal point relative to the first digit
+    i32 point = digitCount + decimalExponent;
+
+    if (digitCount <= point && point <= maxExponent)
+    {
+        //digits000.0
+        memset(output + digitCount, '0', (usize)(point - digitCount));
+        output[point] = '.';
+        output[point + 1] = '0';
+        return (usize)point + 2;
+    }
+    if (0 < point && point <= maxExponent)
+    {
+        //dig.its
+        memmove(output + point + 1, output + point, (usize)(digitCount - point));
+        output[point] = '.';
+        return length + 1;
+    }
+    if (-4 < point && point <= 0)
+    {
+        //0.000digits
+        memmove(output + 2 - point, output, length);
+        output[0] = '0';
+        output[1] = '.';
+        memset(output + 2, '0', (usize)-point);
+        return 2 + (usize)-point + length;
+    }
+    //d.igitse-12
+    usize written = 1;
+    if (digitCount > 1)
+    {
+        memmove(output + 2, output + 1, length - 1);
+        output[1] = '.';
+        written = length + 1;
+    }
+    output[written] = 'e';
+    written++;
+    i32 exponent = point - 1;
+    if (exponent < 0)
+    {
+        output[written] = '-';
+        written++;
+        exponent = -exponent;
+    }
+    return written + FormatU64(output + written, (u64)exponent);
+}
+//Writes the shortest decimal that reads back as exactly value and returns its length, which is at most
+//NUMBER_FORMAT_MAX_FLOAT_LENGTH. output is not null terminated. Infinities and NaN are written as inf, -inf and nan
+inline usize FormatDouble(char *output, double value)
+{
+    u64 bits;
+    memcpy(&bits, &value, sizeof(double));
+    usize sign = 0;
+    if (bits >> 63)
+    {
+        output[0] = '-';
+        sign = 1;
+        bits &= ~((u64)1 << 63);
+    }
+    if ((bits >> 52) == 0x7FF)
+    {
+        if ((bits & (((u64)1 << 52) - 1)) != 0)
+        {
+            memcpy(output, "nan", 3);
+            return 3;
+        }
+        memcpy(output + sign, "inf", 3);
+        return sign + 3;
+    }
+    if (bits == 0)
+    {
+        memcpy(output + sign, "0.0", 3);
+        return sign + 3;
+    }
+    i32 decimalExponent;
+    usize length = NumberFormat_Grisu2(output + sign, &decimalExponent, bits, 53, 1075);
+    return sign + NumberFormat_Layout(output + sign, length, decimalExponent, 15);
+}
+//Like FormatDouble, but with the fewest digits that read back as the same float
+inline usize FormatFloat(char *output, float value)
+{
+    u32 bits;
+    memcpy(&bits, &value, sizeof(float));
+    usize sign = 0;
+    if (bits >> 31)
+    {
+        output[0] = '-';
+        sign = 1;
+        bits &= ~((u32)1 << 31);
+    }
+    if ((bits >> 23) == 0xFF)
+    {
+        if ((bits & (((u32)1 << 23) - 1)) != 0)
+        {
+            memcpy(output, "nan", 3);
+            return 3;
+        }
+        memcpy(output + sign, "inf", 3);
+        return sign + 3;
+    }
+    if (bits == 0)
+    {
+        memcpy(output + sign, "0.0", 3);
+        return sign + 3;
+    }
+    i32 decimalExponent;
+    usize length = NumberFormat_Grisu2(output + sign, &decimalExponent, bits, 24, 150);
+    return sign + NumberFormat_Layout(output + sign, length, decimalExponent, 7);
+}
@@ -0,0 +1,531 @@
+#pragma once
+#include <string.h>
+#include "Linxc.h"
+#include "allocators.hpp"
+#include "threading.hpp"
+#include "atomics.hpp"
+#include "queue.hpp"
+
+//most requests that one read or write call is allowed to cover
+#define ASYNCIO_MAX_COALESCED 16
+//upper bound on how long an idle I/O thread or a waiting caller sleeps before checking again, in milliseconds
+#define ASYNCIO_SLEEP_TIMEOUT 10
+
+namespace io
+{
+    enum AsyncIOOperation
+    {
+        AsyncIO_Read,
+        AsyncIO_Write
+    };
+    //requests of a higher priority are always started before any of a lower one, unless another thread is busy with the higher one's file
+    enum AsyncIOPriority
+    {
+        AsyncIOPriority_High,
+        AsyncIOPriority_Normal,
+        AsyncIOPriority_Low,
+        AsyncIOPriority_Count
+    };
+    enum AsyncIOState
+    {
+        AsyncIOState_Idle,
+        AsyncIOState_Pending,
+        AsyncIOState_Done,
+        AsyncIOState_Failed
+    };
+
+    //Called on the I/O thread once a request finishes, with the request's userData and the number of bytes read or written,
+    //or -1 if it failed. Reads that reach the end of the file transfer fewer bytes than asked for without failing
+    def_delegate(AsyncIOCallback, void, void *, i64);
+
+    //Tracks one request for polling or waiting on. Owned by the caller, and must stay alive until the request is done
+    struct AsyncIOHandle
+    {
+        volatile i64 state;
+        volatile i64 bytesTransferred;
+
+        inline AsyncIOHandle()
+        {
+            state = AsyncIOState_Idle;
+            bytesTransferred = 0;
+        }
+        inline bool IsDone()
+        {
+            return threading::AtomicLoad(&state) >= AsyncIOState_Done;
+        }
+        inline bool Succeeded()
+        {
+            return threading::AtomicLoad(&state) == AsyncIOState_Done;
+        }
+    };
+
+    struct AsyncIORequest
+    {
+        AsyncIOOperation operation;
+        //file to open for the request, or NULL to use fileDescriptor, which is left open
+        const char *path;
+        i64 fileDescriptor;
+        u64 offset;
+        //the bytes to write, or where to read into. Must stay alive until the request is done
+        void *buffer;
+        usize length;
+        //writes to a path only: empty the file before writing
+        bool truncate;
+        AsyncIOPriority priority;
+        AsyncIOCallback callback;
+        void *userData;
+        AsyncIOHandle *handle;
+
+        inline AsyncIORequest()
+        {
+            operation = AsyncIO_Read;
+            path = NULL;
+            fileDescriptor = -1;
+            offset = 0;
+            buffer = NULL;
+            length = 0;
+            truncate = false;
+            priority = AsyncIOPriority_Normal;
+            callback = NULL;
+            userData = NULL;
+            handle = NULL;
+        }
+        inline AsyncIORequest(AsyncIOOperation operation, const char *path, u64 offset, void *buffer, usize length)
+        {
+            *this = AsyncIORequest();
+            this->operation = operation;
+            this->path = path;
+            this->offset = offset;
+            this->buffer = buffer;
+            this->length = length;
+        }
+    };
+
+    typedef struct AsyncIOServiceImpl *AsyncIOService;
+
+    /// @brief Starts threads that carry out file reads and writes in the background.
+    /// Requests queued back to back that continue on from each other in the same file are done with one vectored read or write.
+    /// Requests to the same path or file descriptor never run at once, and of one priority are carried out in the order queued
+    /// @param threadCount number of I/O threads. More than one only helps when requests go to several files or devices
+    AsyncIOService CreateAsyncIOService(IAllocator allocator, usize threadCount = 1);
+    /// @brief Finishes every queued request, then stops the threads
+    void DestroyAsyncIOService(AsyncIOService service);
+    /// @brief Queues count requests. Their paths and buffers are not copied, so must stay alive until each is done
+    void SubmitAsyncIO(AsyncIOService service, AsyncIORequest *requests, usize count);
+    /// @brief Blocks until the handle's request is done
+    void WaitForAsyncIO(AsyncIOService service, AsyncIOHandle *handle);
+    //number of requests queued or in progress
+    usize GetPendingAsyncIOCount(AsyncIOService service);
+}
+
+#ifdef ASTRALCORE_THREADING_IMPL
+
+#if WINDOWS
+#define WIN32_LEAN_AND_MEAN
+#include <io.h>
+#include <Windows.h>
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/uio.h>
+#endif
+
+namespace io
+{
+    typedef struct AsyncIOServiceImpl
+    {
+        IAllocator allocator;
+        usize threadCount;
+        threading::Thread *threads;
+
+        threading::ThreadLock queueLock;
+        collections::queue<AsyncIORequest> queues[AsyncIOPriority_Count];
+        //the first request of each batch being carried out, one per busy thread. Requests for their files stay queued until they finish
+        AsyncIORequest **running;
+        usize runningCount;
+
+        //requests queued or in progress
+        volatile i64 pendingCount;
+        //requests still in the queues
+        volatile i64 queuedCount;
+        //bumped whenever a request may have become free to take, which is what idle threads wait on
+        volatile i64 wakeGeneration;
+        volatile i64 waitingCount;
+        volatile i64 shuttingDown;
+        threading::ConditionVariable wakeSignal;
+        threading::ConditionVariable doneSignal;
+    } AsyncIOServiceImpl;
+
+    struct AsyncIO_SleepContext
+    {
+        AsyncIOServiceImpl *service;
+        //wakeGeneration when the thread last found nothing it could take
+        i64 generation;
+    };
+    bool AsyncIO_ShouldSleep(void *context)
+    {
+        AsyncIO_SleepContext *sleep = (AsyncIO_SleepContext *)context;
+        return threading::AtomicLoad(&sleep->service->wakeGeneration) == sleep->generation && threading::AtomicLoad(&sleep->service->shuttingDown) == 0;
+    }
+    bool AsyncIO_IsNotDone(void *context)
+    {
+        return !((AsyncIOHandle *)context)->IsDone();
+    }
+
+    inline bool AsyncIO_SameFile(AsyncIORequest *a, AsyncIORequest *b)
+    {
+        if (a->path == NULL || b->path == NULL)
+        {
+            return a->path == b->path && a->fileDescriptor == b->fileDescriptor;
+        }
+        return a->path == b->path || strcmp(a->path, b->path) == 0;
+    }
+    //whether next picks up where previous ends, so that both can be done in one call
+    inline bool AsyncIO_Continues(AsyncIORequest *previous, AsyncIORequest *next)
+    {
+        return next->operation == previous->operation && !next->truncate && next->offset == previous->offset + previous->length && AsyncIO_SameFile(previous, next);
+    }
+
+    //whether a batch for the same file as request is being carried out on another thread
+    inline bool AsyncIO_IsRunning(AsyncIOServiceImpl *service, AsyncIORequest *request)
+    {
+        for (usize i = 0; i < service->runningCount; i++)
+        {
+            if (AsyncIO_SameFile(service->running[i], request))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+    //Takes the first request of the highest priority waiting whose file no other thread is working on, along with those right behind it that continue on from it.
+    //Only one thread touches a file at a time, so requests to it are carried out in the order they were queued
+    usize AsyncIO_TakeBatch(AsyncIOServiceImpl *service, AsyncIORequest *batch, i64 *generation)
+    {
+        usize count = 0;
+        threading::LockThreadLock(service->queueLock);
+        *generation = threading::AtomicLoad(&service->wakeGeneration);
+        for (usize p = 0; p < AsyncIOPriority_Count && count == 0; p++)
+        {
+            collections::queue<AsyncIORequest> *queue = &service->queues[p];
+            for (usize i = 0; i < queue->count; i++)
+            {
+                if (AsyncIO_IsRunning(service, queue->PeekAt(i)))
+                {
+                    continue;
+                }
+                batch[0] = queue->DequeueAt(i);
+                count = 1;
+                while (count < ASYNCIO_MAX_COALESCED && i < queue->count && AsyncIO_Continues(&batch[count - 1], queue->PeekAt(i)))
+                {
+                    batch[count] = queue->DequeueAt(i);
+                    count++;
+                }
+                break;
+            }
+        }
+        if (count > 0)
+        {
+            service->running[service->runningCount] = &batch[0];
+            service->runningCount++;
+            threading::AtomicFetchAdd(&service->queuedCount, -(i64)count);
+        }
+        threading::UnlockThreadLock(service->queueLock);
+        return count;
+    }
+    //Lets other threads take requests for the batch's file again
+    void AsyncIO_FinishBatch(AsyncIOServiceImpl *service, AsyncIORequest *batch)
+    {
+        threading::LockThreadLock(service->queueLock);
+        for (usize i = 0; i < service->runningCount; i++)
+        {
+            if (service->running[i] == batch)
+            {
+                service->runningCount--;
+                service->running[i] = service->running[service->runningCount];
+                break;
+            }
+        }
+        threading::AtomicFetchAdd(&service->wakeGeneration, (i64)1);
+        threading::UnlockThreadLock(service->queueLock);
+        //requests held back for this file may be all that is left, with every other thread asleep
+        if (threading::AtomicLoad(&service->queuedCount) > 0)
+        {
+            threading::SetSignalled(service->wakeSignal);
+        }
+    }
+
+    inline void AsyncIO_Complete(AsyncIORequest *request, i64 bytesTransferred)
+    {
+        if (request->callback != NULL)
+        {
+            request->callback(request->userData, bytesTransferred);
+        }
+        //set last, so that whoever sees the handle done knows the callback has run
+        if (request->handle != NULL)
+        {
+            threading::AtomicStore(&request->handle->bytesTransferred, bytesTransferred);
+            threading::AtomicStore(&request->handle->state, (i64)(bytesTransferred < 0 ? AsyncIOState_Failed : AsyncIOState_Done));
+        }
+    }
+
+#if WINDOWS
+    void AsyncIO_RunBatch(AsyncIORequest *batch, usize count)
+    {
+        bool isWrite = batch[0].operation == AsyncIO_Write;
+        HANDLE file;
+        if (batch[0].path != NULL)
+        {
+            DWORD disposition = isWrite ? (batch[0].truncate ? CREATE_ALWAYS : OPEN_ALWAYS) : OPEN_EXISTING;
+            file = CreateFileA(batch[0].path, isWrite ? GENERIC_WRITE : GENERIC_READ, FILE_SHARE_READ, NULL, disposition, FILE_ATTRIBUTE_NORMAL, NULL);
+        }
+        else
+        {
+            file = (HANDLE)_get_osfhandle((int)batch[0].fileDescriptor);
+        }
+        //there is no vectored ReadFile for buffered handles, so coalesced requests only share the open
+        for (usize i = 0; i < count; i++)
+        {
+            i64 transferred = file == INVALID_HANDLE_VALUE ? -1 : 0;
+            while (transferred >= 0 && (usize)transferred < batch[i].length)
+            {
+                u64 position = batch[i].offset + (u64)transferred;
+                OVERLAPPED overlapped = {};
+                overlapped.Offset = (DWORD)position;
+                overlapped.OffsetHigh = (DWORD)(position >> 32);
+                usize remaining = batch[i].length - (usize)transferred;
+                DWORD chunk = remaining > 0x40000000 ? 0x40000000 : (DWORD)remaining;
+                DWORD bytes = 0;
+                u8 *target = (u8 *)batch[i].buffer + transferred;
+                BOOL success = isWrite ? WriteFile(file, target, chunk, &bytes, &overlapped) : ReadFile(file, target, chunk, &bytes, &overlapped);
+                if (!success)
+                {
+                    transferred = GetLastError() == ERROR_HANDLE_EOF ? transferred : -1;
+                    break;
+                }
+                if (bytes == 0)
+                {
+                    break;
+                }
+                transferred += bytes;
+            }
+            AsyncIO_Complete(&batch[i], transferred);
+        }
+        if (batch[0].path != NULL && file != INVALID_HANDLE_VALUE)
+        {
+            CloseHandle(file);
+        }
+    }
+#else
+    /// @brief Reads or writes all of iov starting at offset, carrying on after partial transfers
+    /// @return bytes transferred, which is short at the end of the file or, with failed set, where an error stopped it
+    i64 AsyncIO_TransferV(int fd, bool isWrite, struct iovec *iov, usize count, u64 offset, bool *failed)
+    {
+        *failed = false;
+        i64 transferred = 0;
+        usize first = 0;
+        while (first < count)
+        {
+            ssize_t bytes = isWrite ? pwritev(fd, iov + first, (int)(count - first), (off_t)(offset + transferred)) : preadv(fd, iov + first, (int)(count - first), (off_t)(offset + transferred));
+            if (bytes < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (bytes < 0)
+            {
+                *failed = true;
+                return transferred;
+            }
+            if (bytes == 0)
+            {
+                break;
+            }
+            transferred += bytes;
+            while (first < count && (usize)bytes >= iov[first].iov_len)
+            {
+                bytes -= iov[first].iov_len;
+                first++;
+            }
+            if (first < count)
+            {
+                iov[first].iov_base = (u8 *)iov[first].iov_base + bytes;
+                iov[first].iov_len -= bytes;
+            }
+        }
+        return transferred;
+    }
+    void AsyncIO_RunBatch(AsyncIORequest *batch, usize count)
+    {
+        bool isWrite = batch[0].operation == AsyncIO_Write;
+        int fd = (int)batch[0].fileDescriptor;
+        if (batch[0].path != NULL)
+        {
+            int flags = isWrite ? O_WRONLY | O_CREAT | (batch[0].truncate ? O_TRUNC : 0) : O_RDONLY;
+            fd = open(batch[0].path, flags, 0644);
+        }
+        i64 transferred = 0;
+        bool failed = true;
+        if (fd >= 0)
+        {
+            struct iovec iov[ASYNCIO_MAX_COALESCED];
+            for (usize i = 0; i < count; i++)
+            {
+                iov[i].iov_base = batch[i].buffer;
+                iov[i].iov_len = batch[i].length;
+            }
+            transferred = AsyncIO_TransferV(fd, isWrite, iov, count, batch[0].offset, &failed);
+            if (batch[0].path != NULL)
+            {
+                close(fd);
+            }
+        }
+        //split what was transferred back out between the requests, in order. After an error, every request it cut short failed
+        for (usize i = 0; i < count; i++)
+        {
+            i64 start = (i64)(batch[i].offset - batch[0].offset);
+            i64 result = transferred > start ? transferred - start : 0;
+            if (result >= (i64)batch[i].length)
+            {
+                result = (i64)batch[i].length;
+            }
+            else if (failed)
+            {
+                result = -1;
+            }
+            AsyncIO_Complete(&batch[i], result);
+        }
+    }
+#endif
+
+    THREAD_RESULT AsyncIO_WorkerMain(void *args)
+    {
+        AsyncIOServiceImpl *service = (AsyncIOServiceImpl *)args;
+        AsyncIORequest batch[ASYNCIO_MAX_COALESCED];
+        AsyncIO_SleepContext sleep;
+        sleep.service = service;
+        while (true)
+        {
+            usize count = AsyncIO_TakeBatch(service, batch, &sleep.generation);
+            if (count == 0)
+            {
+                //the queues are only checked empty here, so shutting down still finishes everything submitted before it
+                if (threading::AtomicLoad(&service->shuttingDown) != 0)
+                {
+                    break;
+                }
+                threading::AwaitSignalledIf(service->wakeSignal, &AsyncIO_ShouldSleep, &sleep, ASYNCIO_SLEEP_TIMEOUT);
+                continue;
+            }
+            AsyncIO_RunBatch(batch, count);
+            AsyncIO_FinishBatch(service, batch);
+            threading::AtomicFetchAdd(&service->pendingCount, -(i64)count);
+            if (threading::AtomicLoad(&service->waitingCount) > 0)
+            {
+                threading::SetAllSignalled(service->doneSignal);
+            }
+        }
+        return 0;
+    }
+
+    AsyncIOService CreateAsyncIOService(IAllocator allocator, usize threadCount)
+    {
+        if (threadCount == 0)
+        {
+            threadCount = 1;
+        }
+        AsyncIOServiceImpl *service = (AsyncIOServiceImpl *)allocator.Allocate(sizeof(AsyncIOServiceImpl));
+        service->allocator = allocator;
+        service->threadCount = threadCount;
+        service->queueLock = threading::CreateThreadLock();
+        for (usize p = 0; p < AsyncIOPriority_Count; p++)
+        {
+            service->queues[p] = collections::queue<AsyncIORequest>(allocator);
+        }
+        service->running = (AsyncIORequest **)allocator.Allocate(sizeof(AsyncIORequest *) * threadCount);
+        service->runningCount = 0;
+        service->pendingCount = 0;
+        service->queuedCount = 0;
+        service->wakeGeneration = 0;
+        service->waitingCount = 0;
+        service->shuttingDown = 0;
+        service->wakeSignal = threading::CreateConditionVariable();
+        service->doneSignal = threading::CreateConditionVariable();
+        service->threads = (threading::Thread *)allocator.Allocate(sizeof(threading::Thread) * threadCount);
+        for (usize i = 0; i < threadCount; i++)
+        {
+            service->threads[i] = threading::StartThread(&AsyncIO_WorkerMain, service);
+        }
+        return service;
+    }
+    void DestroyAsyncIOService(AsyncIOService service)
+    {
+        if (service == NULL)
+        {
+            return;
+        }
+        threading::AtomicStore(&service->shuttingDown, (i64)1);
+        threading::SetAllSignalled(service->wakeSignal);
+        for (usize i = 0; i < service->threadCount; i++)
+        {
+            threading::JoinThread(service->threads[i]);
+        }
+        IAllocator allocator = service->allocator;
+        for (usize p = 0; p < AsyncIOPriority_Count; p++)
+        {
+            service->queues[p].deinit();
+        }
+        allocator.Free(service->threads);
+        allocator.Free(service->running);
+        threading::DestroyThreadLock(service->queueLock);
+        threading::DestroyConditionVariable(service->wakeSignal);
+        threading::DestroyConditionVariable(service->doneSignal);
+        allocator.FREEPTR(service);
+    }
+    void SubmitAsyncIO(AsyncIOService service, AsyncIORequest *requests, usize count)
+    {
+        if (count == 0)
+        {
+            return;
+        }
+        threading::LockThreadLock(service->queueLock);
+        for (usize i = 0; i < count; i++)
+        {
+            if (requests[i].handle != NULL)
+            {
+                requests[i].handle->bytesTransferred = 0;
+                threading::AtomicStore(&requests[i].handle->state, (i64)AsyncIOState_Pending);
+            }
+            usize priority = (usize)requests[i].priority < AsyncIOPriority_Count ? (usize)requests[i].priority : (usize)AsyncIOPriority_Normal;
+            service->queues[priority].Enqueue(requests[i]);
+        }
+        threading::AtomicFetchAdd(&service->pendingCount, (i64)count);
+        threading::AtomicFetchAdd(&service->queuedCount, (i64)count);
+        threading::AtomicFetchAdd(&service->wakeGeneration, (i64)1);
+        threading::UnlockThreadLock(service->queueLock);
+        if (count > 1 && service->threadCount > 1)
+        {
+            threading::SetAllSignalled(service->wakeSignal);
+        }
+        else
+        {
+            threading::SetSignalled(service->wakeSignal);
+        }
+    }
+    void WaitForAsyncIO(AsyncIOService service, AsyncIOHandle *handle)
+    {
+        threading::AtomicFetchAdd(&service->waitingCount, (i64)1);
+        while (!handle->IsDone())
+        {
+            threading::AwaitSignalledIf(service->doneSignal, &AsyncIO_IsNotDone, handle, ASYNCIO_SLEEP_TIMEOUT);
+        }
+        threading::AtomicFetchAdd(&service->waitingCount, (i64)-1);
+    }
+    usize GetPendingAsyncIOCount(AsyncIOService service)
+    {
+        i64 pending = threading::AtomicLoad(&service->pendingCount);
+        return pending > 0 ? (usize)pending : 0;
+    }
+}
+
+#endif
@@ -0,0 +1,89 @@
+#pragma once
+#include "Linxc.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+//Thin wrappers around the compiler's atomic intrinsics, so that lock free code
+//does not need <atomic>. Only 64 bit integer types (i64, u64, usize) are supported.
+namespace threading
+{
+    template<typename T>
+    inline T AtomicLoad(volatile T *ptr)
+    {
+#if defined(_MSC_VER)
+        T value = *ptr;
+        _ReadWriteBarrier();
+        return value;
+#else
+        return __atomic_load_n(ptr, __ATOMIC_ACQUIRE);
+#endif
+    }
+    template<typename T>
+    inline T AtomicLoadRelaxed(volatile T *ptr)
+    {
+#if defined(_MSC_VER)
+        return *ptr;
+#else
+        return __atomic_load_n(ptr, __ATOMIC_RELAXED);
+#endif
+    }
+    template<typename T>
+    inline void AtomicStore(volatile T *ptr, T value)
+    {
+#if defined(_MSC_VER)
+        _ReadWriteBarrier();
+        *ptr = value;
+#else
+        __atomic_store_n(ptr, value, __ATOMIC_RELEASE);
+#endif
+    }
+    template<typename T>
+    inline void AtomicStoreRelaxed(volatile T *ptr, T value)
+    {
+#if defined(_MSC_VER)
+        *ptr = value;
+#else
+        __atomic_store_n(ptr, value, __ATOMIC_RELAXED);
+#endif
+    }
+    //Adds value and returns what was stored before the addition
+    template<typename T>
+    inline T AtomicFetchAdd(volatile T *ptr, T value)
+    {
+#if defined(_MSC_VER)
+        return (T)_InterlockedExchangeAdd64((volatile long long *)ptr, (long long)value);
+#else
+        return __atomic_fetch_add(ptr, value, __ATOMIC_SEQ_CST);
+#endif
+    }
+    //Stores desired if the current value equals expected. Returns whether the exchange happened
+    template<typename T>
+    inline bool AtomicCompareExchange(volatile T *ptr, T expected, T desired)
+    {
+#if defined(_MSC_VER)
+        return (T)_InterlockedCompareExchange64((volatile long long *)ptr, (long long)desired, (long long)expected) == expected;
+#else
+        return __atomic_compare_exchange_n(ptr, &expected, desired, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+#endif
+    }
+    inline void AtomicThreadFence()
+    {
+#if defined(_MSC_VER)
+        _ReadWriteBarrier();
+        _mm_mfence();
+#else
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+#endif
+    }
+    //Hint to the CPU that we are in a spin loop
+    inline void SpinPause()
+    {
+#if defined(_MSC_VER)
+        _mm_pause();
+#elif defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#endif
+    }
+}
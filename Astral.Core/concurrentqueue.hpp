@@ -0,0 +1,459 @@
+#pragma once
+#include "Linxc.h"
+#include "allocators.hpp"
+#include "atomics.hpp"
+#include "threading.hpp"
+
+//size that the head and tail indices are padded out to, so that producers and consumers do not share a cache line
+#define CONCURRENTQUEUE_CACHE_LINE 64
+//number of failed attempts a blocking Enqueue/Dequeue spins for before yielding its timeslice
+#define CONCURRENTQUEUE_SPINS 64
+
+namespace collections
+{
+    inline usize ConcurrentQueue_RoundCapacity(usize capacity)
+    {
+        usize result = 2;
+        while (result < capacity)
+        {
+            result *= 2;
+        }
+        return result;
+    }
+    inline void ConcurrentQueue_Backoff(u32 *attempts)
+    {
+        if (*attempts < CONCURRENTQUEUE_SPINS)
+        {
+            *attempts += 1;
+            threading::SpinPause();
+        }
+        else
+        {
+            threading::YieldThread();
+        }
+    }
+
+    //Bounded lock free multi producer, multi consumer FIFO queue (Vyukov's design).
+    //Every slot carries a sequence number telling producers and consumers whose turn it is to use it,
+    //so the only contended writes are the CAS on the head or tail.
+    //The queue holds its indices inline: share it by pointer, never copy it once other threads are using it.
+    //Blocking Enqueue and Dequeue need threading.hpp to be implemented (see ASTRALCORE_THREADING_IMPL)
+    template<typename T>
+    struct mpmcqueue
+    {
+        struct Cell
+        {
+            volatile usize sequence;
+            T value;
+        };
+
+        IAllocator allocator;
+        Cell *cells;
+        usize mask;
+        u8 padding0[CONCURRENTQUEUE_CACHE_LINE];
+        volatile usize enqueuePosition;
+        u8 padding1[CONCURRENTQUEUE_CACHE_LINE - sizeof(usize)];
+        volatile usize dequeuePosition;
+        u8 padding2[CONCURRENTQUEUE_CACHE_LINE - sizeof(usize)];
+
+        mpmcqueue()
+        {
+            allocator = IAllocator{};
+            cells = NULL;
+            mask = 0;
+            enqueuePosition = 0;
+            dequeuePosition = 0;
+        }
+        /// @param capacity maximum number of items held at once, rounded up to a power of two
+        mpmcqueue(IAllocator allocator, usize capacity)
+        {
+            this->allocator = allocator;
+            capacity = ConcurrentQueue_RoundCapacity(capacity);
+            cells = (Cell *)allocator.Allocate(sizeof(Cell) * capacity);
+            for (usize i = 0; i < capacity; i++)
+            {
+                cells[i].sequence = i;
+            }
+            mask = capacity - 1;
+            enqueuePosition = 0;
+            dequeuePosition = 0;
+        }
+        void deinit()
+        {
+            if (cells != NULL)
+            {
+                allocator.FREEPTR(cells);
+            }
+            mask = 0;
+            enqueuePosition = 0;
+            dequeuePosition = 0;
+        }
+        inline usize Capacity()
+        {
+            return mask + 1;
+        }
+        //Number of items in the queue. Only a snapshot while other threads are using it
+        inline usize Count()
+        {
+            usize tail = threading::AtomicLoad(&enqueuePosition);
+            usize head = threading::AtomicLoad(&dequeuePosition);
+            return tail > head ? tail - head : 0;
+        }
+
+        bool TryEnqueue(T item)
+        {
+            Cell *cell;
+            usize position = threading::AtomicLoadRelaxed(&enqueuePosition);
+            while (true)
+            {
+                cell = &cells[position & mask];
+                i64 difference = (i64)threading::AtomicLoad(&cell->sequence) - (i64)position;
+                if (difference == 0)
+                {
+                    if (threading::AtomicCompareExchange(&enqueuePosition, position, position + 1))
+                    {
+                        break;
+                    }
+                }
+                else if (difference < 0)
+                {
+                    //the slot still holds an item from the previous lap, so the queue is full
+                    return false;
+                }
+                position = threading::AtomicLoadRelaxed(&enqueuePosition);
+            }
+            cell->value = item;
+            threading::AtomicStore(&cell->sequence, position + 1);
+            return true;
+        }
+        bool TryDequeue(T *result)
+        {
+            Cell *cell;
+            usize position = threading::AtomicLoadRelaxed(&dequeuePosition);
+            while (true)
+            {
+                cell = &cells[position & mask];
+                i64 difference = (i64)threading::AtomicLoad(&cell->sequence) - (i64)(position + 1);
+                if (difference == 0)
+                {
+                    if (threading::AtomicCompareExchange(&dequeuePosition, position, position + 1))
+                    {
+                        break;
+                    }
+                }
+                else if (difference < 0)
+                {
+                    //nothing has been written to the slot yet, so the queue is empty
+                    return false;
+                }
+                position = threading::AtomicLoadRelaxed(&dequeuePosition);
+            }
+            *result = cell->value;
+            //hand the slot to the producer one lap ahead
+            threading::AtomicStore(&cell->sequence, position + mask + 1);
+            return true;
+        }
+        //Enqueues as many of items as currently fit, claiming them with a single CAS. Returns how many were enqueued
+        usize TryEnqueueMany(T *items, usize count)
+        {
+            usize position;
+            usize claimed;
+            while (true)
+            {
+                position = threading::AtomicLoadRelaxed(&enqueuePosition);
+                claimed = 0;
+                while (claimed < count && claimed <= mask && threading::AtomicLoad(&cells[(position + claimed) & mask].sequence) == position + claimed)
+                {
+                    claimed++;
+                }
+                if (claimed == 0)
+                {
+                    if ((i64)threading::AtomicLoad(&cells[position & mask].sequence) - (i64)position < 0)
+                    {
+                        return 0;
+                    }
+                    //another producer claimed position first
+                    continue;
+                }
+                if (threading::AtomicCompareExchange(&enqueuePosition, position, position + claimed))
+                {
+                    break;
+                }
+            }
+            for (usize i = 0; i < claimed; i++)
+            {
+                Cell *cell = &cells[(position + i) & mask];
+                cell->value = items[i];
+                threading::AtomicStore(&cell->sequence, position + i + 1);
+            }
+            return claimed;
+        }
+        //Dequeues up to maxCount items into results, claiming them with a single CAS. Returns how many were dequeued
+        usize TryDequeueMany(T *results, usize maxCount)
+        {
+            usize position;
+            usize claimed;
+            while (true)
+            {
+                position = threading::AtomicLoadRelaxed(&dequeuePosition);
+                claimed = 0;
+                while (claimed < maxCount && claimed <= mask && threading::AtomicLoad(&cells[(position + claimed) & mask].sequence) == position + claimed + 1)
+                {
+                    claimed++;
+                }
+                if (claimed == 0)
+                {
+                    if ((i64)threading::AtomicLoad(&cells[position & mask].sequence) - (i64)(position + 1) < 0)
+                    {
+                        return 0;
+                    }
+                    continue;
+                }
+                if (threading::AtomicCompareExchange(&dequeuePosition, position, position + claimed))
+                {
+                    break;
+                }
+            }
+            for (usize i = 0; i < claimed; i++)
+            {
+                Cell *cell = &cells[(position + i) & mask];
+                results[i] = cell->value;
+                threading::AtomicStore(&cell->sequence, position + i + mask + 1);
+            }
+            return claimed;
+        }
+
+        //Blocks until there is room for item
+        void Enqueue(T item)
+        {
+            u32 attempts = 0;
+            while (!TryEnqueue(item))
+            {
+                ConcurrentQueue_Backoff(&attempts);
+            }
+        }
+        //Blocks until an item is available
+        T Dequeue()
+        {
+            T result;
+            u32 attempts = 0;
+            while (!TryDequeue(&result))
+            {
+                ConcurrentQueue_Backoff(&attempts);
+            }
+            return result;
+        }
+        //Blocks until all count items have been enqueued
+        void EnqueueMany(T *items, usize count)
+        {
+            u32 attempts = 0;
+            while (count > 0)
+            {
+                usize enqueued = TryEnqueueMany(items, count);
+                if (enqueued == 0)
+                {
+                    ConcurrentQueue_Backoff(&attempts);
+                    continue;
+                }
+                attempts = 0;
+                items += enqueued;
+                count -= enqueued;
+            }
+        }
+        //Blocks until at least one item is available, then dequeues up to maxCount. Returns how many were dequeued
+        usize DequeueMany(T *results, usize maxCount)
+        {
+            u32 attempts = 0;
+            usize dequeued;
+            while ((dequeued = TryDequeueMany(results, maxCount)) == 0 && maxCount > 0)
+            {
+                ConcurrentQueue_Backoff(&attempts);
+            }
+            return dequeued;
+        }
+    };
+
+    //Bounded lock free queue for exactly one producer thread and one consumer thread.
+    //Each side keeps a private copy of the other's index and only rereads the shared one
+    //when the copy says the queue is full (or empty), so most operations touch no shared cache line.
+    //As with mpmcqueue, share it by pointer and never copy it while in use
+    template<typename T>
+    struct spscqueue
+    {
+        IAllocator allocator;
+        T *items;
+        usize mask;
+        u8 padding0[CONCURRENTQUEUE_CACHE_LINE];
+        //written by the consumer
+        volatile usize head;
+        usize cachedTail;
+        u8 padding1[CONCURRENTQUEUE_CACHE_LINE - 2 * sizeof(usize)];
+        //written by the producer
+        volatile usize tail;
+        usize cachedHead;
+        u8 padding2[CONCURRENTQUEUE_CACHE_LINE - 2 * sizeof(usize)];
+
+        spscqueue()
+        {
+            allocator = IAllocator{};
+            items = NULL;
+            mask = 0;
+            head = 0;
+            cachedTail = 0;
+            tail = 0;
+            cachedHead = 0;
+        }
+        /// @param capacity maximum number of items held at once, rounded up to a power of two
+        spscqueue(IAllocator allocator, usize capacity)
+        {
+            this->allocator = allocator;
+            capacity = ConcurrentQueue_RoundCapacity(capacity);
+            items = (T *)allocator.Allocate(sizeof(T) * capacity);
+            mask = capacity - 1;
+            head = 0;
+            cachedTail = 0;
+            tail = 0;
+            cachedHead = 0;
+        }
+        void deinit()
+        {
+            if (items != NULL)
+            {
+                allocator.FREEPTR(items);
+            }
+            mask = 0;
+            head = 0;
+            cachedTail = 0;
+            tail = 0;
+            cachedHead = 0;
+        }
+        inline usize Capacity()
+        {
+            return mask + 1;
+        }
+        inline usize Count()
+        {
+            return threading::AtomicLoad(&tail) - threading::AtomicLoad(&head);
+        }
+
+        //Producer only
+        bool TryEnqueue(T item)
+        {
+            usize position = threading::AtomicLoadRelaxed(&tail);
+            if (position - cachedHead > mask)
+            {
+                cachedHead = threading::AtomicLoad(&head);
+                if (position - cachedHead > mask)
+                {
+                    return false;
+                }
+            }
+            items[position & mask] = item;
+            threading::AtomicStore(&tail, position + 1);
+            return true;
+        }
+        //Consumer only
+        bool TryDequeue(T *result)
+        {
+            usize position = threading::AtomicLoadRelaxed(&head);
+            if (position == cachedTail)
+            {
+                cachedTail = threading::AtomicLoad(&tail);
+                if (position == cachedTail)
+                {
+                    return false;
+                }
+            }
+            *result = items[position & mask];
+            threading::AtomicStore(&head, position + 1);
+            return true;
+        }
+        //Producer only. Enqueues as many of items as currently fit and publishes them together
+        usize TryEnqueueMany(T *toEnqueue, usize count)
+        {
+            usize position = threading::AtomicLoadRelaxed(&tail);
+            usize space = mask + 1 - (position - cachedHead);
+            if (space < count)
+            {
+                cachedHead = threading::AtomicLoad(&head);
+                space = mask + 1 - (position - cachedHead);
+            }
+            usize enqueued = count < space ? count : space;
+            for (usize i = 0; i < enqueued; i++)
+            {
+                items[(position + i) & mask] = toEnqueue[i];
+            }
+            if (enqueued > 0)
+            {
+                threading::AtomicStore(&tail, position + enqueued);
+            }
+            return enqueued;
+        }
+        //Consumer only. Dequeues up to maxCount items into results
+        usize TryDequeueMany(T *results, usize maxCount)
+        {
+            usize position = threading::AtomicLoadRelaxed(&head);
+            usize available = cachedTail - position;
+            if (available < maxCount)
+            {
+                cachedTail = threading::AtomicLoad(&tail);
+                available = cachedTail - position;
+            }
+            usize dequeued = maxCount < available ? maxCount : available;
+            for (usize i = 0; i < dequeued; i++)
+            {
+                results[i] = items[(position + i) & mask];
+            }
+            if (dequeued > 0)
+            {
+                threading::AtomicStore(&head, position + dequeued);
+            }
+            return dequeued;
+        }
+
+        void Enqueue(T item)
+        {
+            u32 attempts = 0;
+            while (!TryEnqueue(item))
+            {
+                ConcurrentQueue_Backoff(&attempts);
+            }
+        }
+        T Dequeue()
+        {
+            T result;
+            u32 attempts = 0;
+            while (!TryDequeue(&result))
+            {
+                ConcurrentQueue_Backoff(&attempts);
+            }
+            return result;
+        }
+        void EnqueueMany(T *toEnqueue, usize count)
+        {
+            u32 attempts = 0;
+            while (count > 0)
+            {
+                usize enqueued = TryEnqueueMany(toEnqueue, count);
+                if (enqueued == 0)
+                {
+                    ConcurrentQueue_Backoff(&attempts);
+                    continue;
+                }
+                attempts = 0;
+                toEnqueue += enqueued;
+                count -= enqueued;
+            }
+        }
+        usize DequeueMany(T *results, usize maxCount)
+        {
+            u32 attempts = 0;
+            usize dequeued;
+            while ((dequeued = TryDequeueMany(results, maxCount)) == 0 && maxCount > 0)
+            {
+                ConcurrentQueue_Backoff(&attempts);
+            }
+            return dequeued;
+        }
+    };
+}
@@ -0,0 +1,444 @@
+#pragma once
+#include "Linxc.h"
+#include "string.hpp"
+#include "vector.hpp"
+#include "hashmap.hpp"
+#include "ArenaAllocator.hpp"
+#include "path.hpp"
+#include "jobs.hpp"
+
+namespace io
+{
+    struct ScannedFile
+    {
+        //the root path given to ScanDirectory, then / and the file's path under it
+        string path;
+        u64 size;
+        //last write time in nanoseconds, since 1970 on POSIX and 1601 on Windows
+        i64 modifiedTime;
+    };
+
+    //Every file found under a directory, which can be kept around to find what changed in a later scan
+    struct DirectoryScan
+    {
+        //holds every path in the scan
+        ArenaAllocator arena;
+        //in no particular order
+        collections::vector<ScannedFile> files;
+        //when scanned against a previous scan, the indices in files of those that are new or changed size or modified time
+        collections::vector<usize> changedFiles;
+        //when scanned against a previous scan, the paths of its files that no longer exist
+        collections::vector<string> removedFiles;
+        //whether files have their size and modifiedTime, which a later scan needs to compare against this one
+        bool hasFileInfo;
+
+        inline DirectoryScan()
+        {
+            arena = ArenaAllocator();
+            files = collections::vector<ScannedFile>();
+            changedFiles = collections::vector<usize>();
+            removedFiles = collections::vector<string>();
+            hasFileInfo = false;
+        }
+        inline void deinit()
+        {
+            files.deinit();
+            changedFiles.deinit();
+            removedFiles.deinit();
+            arena.deinit();
+        }
+    };
+
+    struct DirectoryScanOptions
+    {
+        //file names to keep, see path::MatchesPattern, or NULL for every file
+        const char *pattern;
+        //fills in size and modifiedTime. On POSIX this costs a stat for every file kept, which is otherwise avoided
+        bool readFileInfo;
+        //scan to compare against, which turns on readFileInfo. Need not have used the same pattern, but must have had file info
+        DirectoryScan *previous;
+
+        inline DirectoryScanOptions()
+        {
+            pattern = NULL;
+            readFileInfo = false;
+            previous = NULL;
+        }
+    };
+
+    /// @brief Finds every file under rootPath, with each subdirectory scanned as its own job on jobSystem, or on the calling thread if it is NULL.
+    /// Entry types come from the directory listing itself where the file system provides them, rather than a stat per entry.
+    /// Symbolic links to files are listed, but those to directories are not followed, so that links cannot form loops.
+    /// allocator is called from several threads, so must be thread safe
+    /// @return false if rootPath could not be opened, or options.previous was scanned without readFileInfo.
+    /// Subdirectories that cannot be opened are skipped
+    bool ScanDirectory(IAllocator allocator, threading::JobSystem jobSystem, const char *rootPath, DirectoryScanOptions options, DirectoryScan *result);
+}
+
+#ifdef ASTRALCORE_THREADING_IMPL
+
+#if WINDOWS
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#else
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#endif
+
+namespace io
+{
+    //What the jobs running on one thread have found. Only that thread touches it until the scan is over
+    struct DirectoryScan_Slot
+    {
+        ArenaAllocator arena;
+        collections::vector<ScannedFile> files;
+        //keeps slots used by different threads off the same cache line
+        u8 padding[64];
+    };
+    struct DirectoryScan_Context
+    {
+        threading::JobSystem jobSystem;
+        const char *pattern;
+        bool readFileInfo;
+        threading::JobCounter counter;
+        DirectoryScan_Slot *slots;
+        //held for the whole job by any thread outside the pool, as they all share the last slot. That is the calling thread,
+        //but also any other thread that runs queued jobs while it waits on a counter of its own
+        threading::ThreadLock outsideLock;
+    };
+    struct DirectoryScan_Directory
+    {
+        DirectoryScan_Context *context;
+        string path;
+        //next subdirectory found in the same listing
+        DirectoryScan_Directory *next;
+    };
+
+    //the worker's own slot, or the one after the workers' for threads outside the pool, which must hold outsideLock while using it
+    inline DirectoryScan_Slot *DirectoryScan_GetSlot(DirectoryScan_Context *context, bool *isOutside)
+    {
+        *isOutside = false;
+        if (context->jobSystem == NULL)
+        {
+            return &context->slots[0];
+        }
+        i64 workerIndex = threading::GetCurrentWorkerIndex(context->jobSystem);
+        if (workerIndex >= 0)
+        {
+            return &context->slots[workerIndex];
+        }
+        *isOutside = true;
+        return &context->slots[threading::GetWorkerCount(context->jobSystem)];
+    }
+    inline string DirectoryScan_JoinPath(IAllocator allocator, string directory, const char *name, usize nameLength)
+    {
+        usize directoryLength = directory.length - 1;
+        string result = string();
+        result.buffer = (char *)allocator.Allocate(directoryLength + nameLength + 2);
+        result.length = directoryLength + nameLength + 2;
+        memcpy(result.buffer, directory.buffer, directoryLength);
+        result.buffer[directoryLength] = '/';
+        memcpy(result.buffer + directoryLength + 1, name, nameLength);
+        result.buffer[directoryLength + nameLength + 1] = '\0';
+        return result;
+    }
+
+    //Lists one directory, keeping its files and collecting its subdirectories, which are only scanned
+    //once the listing is closed so that deep trees do not hold a handle open per level
+    DirectoryScan_Directory *DirectoryScan_List(DirectoryScan_Directory *directory, DirectoryScan_Slot *slot, usize *subdirectoriesCount)
+    {
+        DirectoryScan_Context *context = directory->context;
+        IAllocator allocator = slot->arena.AsAllocator();
+        DirectoryScan_Directory *subdirectories = NULL;
+        *subdirectoriesCount = 0;
+#if WINDOWS
+        string search = DirectoryScan_JoinPath(allocator, directory->path, "*", 1);
+        WIN32_FIND_DATAA findData;
+        HANDLE handle = FindFirstFileExA(search.buffer, FindExInfoBasic, &findData, FindExSearchNameMatch, NULL, FIND_FIRST_EX_LARGE_FETCH);
+        if (handle == INVALID_HANDLE_VALUE)
+        {
+            return NULL;
+        }
+        do
+        {
+            const char *name = findData.cFileName;
+            if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0')))
+            {
+                continue;
+            }
+            if ((findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0)
+            {
+                //junctions and directory links are not followed
+                if ((findData.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT) != 0)
+                {
+                    continue;
+                }
+                DirectoryScan_Directory *subdirectory = (DirectoryScan_Directory *)allocator.Allocate(sizeof(DirectoryScan_Directory));
+                subdirectory->context = context;
+                subdirectory->path = DirectoryScan_JoinPath(allocator, directory->path, name, strlen(name));
+                subdirectory->next = subdirectories;
+                subdirectories = subdirectory;
+                *subdirectoriesCount += 1;
+                continue;
+            }
+            if (context->pattern != NULL && !path::MatchesPattern(context->pattern, name))
+            {
+                continue;
+            }
+            //the listing has everything readFileInfo asks for, so there is no reason to leave it out
+            ScannedFile file;
+            file.path = DirectoryScan_JoinPath(allocator, directory->path, name, strlen(name));
+            file.size = ((u64)findData.nFileSizeHigh << 32) | findData.nFileSizeLow;
+            file.modifiedTime = (i64)((((u64)findData.ftLastWriteTime.dwHighDateTime << 32) | findData.ftLastWriteTime.dwLowDateTime) * 100);
+            slot->files.Add(file);
+        } while (FindNextFileA(handle, &findData));
+        FindClose(handle);
+#else
+        DIR *listing = opendir(directory->path.buffer);
+        if (listing == NULL)
+        {
+            return NULL;
+        }
+        int listingFd = dirfd(listing);
+        struct dirent *entry;
+        while ((entry = readdir(listing)) != NULL)
+        {
+            const char *name = entry->d_name;
+            if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0')))
+            {
+                continue;
+            }
+            struct stat status;
+            bool hasStatus = false;
+            unsigned char type = entry->d_type;
+            //some file systems do not fill in d_type
+            if (type == DT_UNKNOWN)
+            {
+                if (fstatat(listingFd, name, &status, AT_SYMLINK_NOFOLLOW) != 0)
+                {
+                    continue;
+                }
+                hasStatus = true;
+                type = S_ISDIR(status.st_mode) ? DT_DIR : S_ISREG(status.st_mode) ? DT_REG : S_ISLNK(status.st_mode) ? DT_LNK : DT_UNKNOWN;
+            }
+            if (type == DT_LNK)
+            {
+                if (fstatat(listingFd, name, &status, 0) != 0 || !S_ISREG(status.st_mode))
+                {
+                    continue;
+                }
+                hasStatus = true;
+                type = DT_REG;
+            }
+
+            if (type == DT_DIR)
+            {
+                DirectoryScan_Directory *subdirectory = (DirectoryScan_Directory *)allocator.Allocate(sizeof(DirectoryScan_Directory));
+                subdirectory->context = context;
+                subdirectory->path = DirectoryScan_JoinPath(allocator, directory->path, name, strlen(name));
+                subdirectory->next = subdirectories;
+                subdirectories = subdirectory;
+                *subdirectoriesCount += 1;
+            }
+            else if (type == DT_REG)
+            {
+                if (context->pattern != NULL && !path::MatchesPattern(context->pattern, name))
+                {
+                    continue;
+                }
+                ScannedFile file;
+                file.size = 0;
+                file.modifiedTime = 0;
+                if (context->readFileInfo)
+                {
+                    if (!hasStatus && fstatat(listingFd, name, &status, 0) != 0)
+                    {
+                        continue;
+                    }
+                    file.size = (u64)status.st_size;
+#if defined(__APPLE__)
+                    file.modifiedTime = (i64)status.st_mtimespec.tv_sec * 1000000000 + status.st_mtimespec.tv_nsec;
+#else
+                    file.modifiedTime = (i64)status.st_mtim.tv_sec * 1000000000 + status.st_mtim.tv_nsec;
+#endif
+                }
+                file.path = DirectoryScan_JoinPath(allocator, directory->path, name, strlen(name));
+                slot->files.Add(file);
+            }
+        }
+        closedir(listing);
+#endif
+        return subdirectories;
+    }
+
+    void DirectoryScan_Run(void *data)
+    {
+        DirectoryScan_Directory *directory = (DirectoryScan_Directory *)data;
+        DirectoryScan_Context *context = directory->context;
+        bool isOutside;
+        DirectoryScan_Slot *slot = DirectoryScan_GetSlot(context, &isOutside);
+        if (context->jobSystem == NULL)
+        {
+            usize subdirectoriesCount;
+            DirectoryScan_Directory *subdirectory = DirectoryScan_List(directory, slot, &subdirectoriesCount);
+            for (; subdirectory != NULL; subdirectory = subdirectory->next)
+            {
+                DirectoryScan_Run(subdirectory);
+            }
+            return;
+        }
+        //RunJobs only queues jobs from outside the pool, so nothing below can run another of this scan's jobs on this thread
+        if (isOutside)
+        {
+            threading::LockThreadLock(context->outsideLock);
+        }
+        usize subdirectoriesCount;
+        DirectoryScan_Directory *subdirectory = DirectoryScan_List(directory, slot, &subdirectoriesCount);
+        if (subdirectoriesCount > 0)
+        {
+            //queued before this job returns, so the counter cannot reach zero while there is still work
+            threading::Job *jobs = (threading::Job *)slot->arena.AsAllocator().Allocate(sizeof(threading::Job) * subdirectoriesCount);
+            for (usize i = 0; subdirectory != NULL; subdirectory = subdirectory->next, i++)
+            {
+                jobs[i] = threading::Job(&DirectoryScan_Run, subdirectory);
+            }
+            threading::RunJobs(context->jobSystem, jobs, subdirectoriesCount, &context->counter);
+        }
+        if (isOutside)
+        {
+            threading::UnlockThreadLock(context->outsideLock);
+        }
+    }
+
+    //Fills in changedFiles and removedFiles
+    void DirectoryScan_Compare(IAllocator allocator, DirectoryScan *result, DirectoryScan *previous)
+    {
+        collections::hashmap<string, usize, StringHasher, StringEql> previousIndices = collections::hashmap<string, usize, StringHasher, StringEql>(allocator, StringHasher(), StringEql());
+        previousIndices.Reserve(previous->files.count);
+        for (usize i = 0; i < previous->files.count; i++)
+        {
+            previousIndices.Add(previous->files.ptr[i].path, i);
+        }
+        bool *found = (bool *)allocator.Allocate(previous->files.count + 1);
+        memset(found, 0, previous->files.count + 1);
+
+        for (usize i = 0; i < result->files.count; i++)
+        {
+            ScannedFile *file = &result->files.ptr[i];
+            usize *previousIndex = previousIndices.Get(file->path);
+            if (previousIndex == NULL)
+            {
+                result->changedFiles.Add(i);
+                continue;
+            }
+            found[*previousIndex] = true;
+            ScannedFile *previousFile = &previous->files.ptr[*previousIndex];
+            if (previousFile->size != file->size || previousFile->modifiedTime != file->modifiedTime)
+            {
+                result->changedFiles.Add(i);
+            }
+        }
+        //copied, so that the previous scan can be deinit
+        IAllocator pathAllocator = result->arena.AsAllocator();
+        for (usize i = 0; i < previous->files.count; i++)
+        {
+            if (!found[i])
+            {
+                result->removedFiles.Add(previous->files.ptr[i].path.Clone(pathAllocator));
+            }
+        }
+        allocator.Free(found);
+        previousIndices.deinit();
+    }
+
+    bool ScanDirectory(IAllocator allocator, threading::JobSystem jobSystem, const char *rootPath, DirectoryScanOptions options, DirectoryScan *result)
+    {
+        *result = DirectoryScan();
+        //every file would look changed against the zeroed sizes and times
+        if (options.previous != NULL && !options.previous->hasFileInfo)
+        {
+            return false;
+        }
+        result->arena = ArenaAllocator(allocator);
+        result->files = collections::vector<ScannedFile>(allocator);
+        result->changedFiles = collections::vector<usize>(allocator);
+        result->removedFiles = collections::vector<string>(allocator);
+
+        DirectoryScan_Context context;
+        context.jobSystem = jobSystem;
+        context.pattern = options.pattern;
+        context.readFileInfo = options.readFileInfo || options.previous != NULL;
+#if WINDOWS
+        result->hasFileInfo = true;
+#else
+        result->hasFileInfo = context.readFileInfo;
+#endif
+        context.counter = threading::JobCounter();
+        context.outsideLock = jobSystem == NULL ? NULL : threading::CreateThreadLock();
+        usize slotsCount = jobSystem == NULL ? 1 : threading::GetWorkerCount(jobSystem) + 1;
+        context.slots = (DirectoryScan_Slot *)allocator.Allocate(sizeof(DirectoryScan_Slot) * slotsCount);
+        for (usize i = 0; i < slotsCount; i++)
+        {
+            context.slots[i].arena = ArenaAllocator(allocator);
+            context.slots[i].files = collections::vector<ScannedFile>(allocator);
+        }
+
+        //a trailing slash would otherwise be doubled up in every path
+        usize rootLength = strlen(rootPath);
+        while (rootLength > 1 && (rootPath[rootLength - 1] == '/' || rootPath[rootLength - 1] == '\\'))
+        {
+            rootLength--;
+        }
+        DirectoryScan_Directory root;
+        root.context = &context;
+        root.path = string(result->arena.AsAllocator(), rootPath, rootLength);
+        root.next = NULL;
+
+        bool opened;
+#if WINDOWS
+        DWORD attributes = GetFileAttributesA(root.path.buffer);
+        opened = attributes != INVALID_FILE_ATTRIBUTES && (attributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+#else
+        struct stat rootStatus;
+        opened = stat(root.path.buffer, &rootStatus) == 0 && S_ISDIR(rootStatus.st_mode);
+#endif
+        if (opened)
+        {
+            threading::Job rootJob = threading::Job(&DirectoryScan_Run, &root);
+            if (jobSystem == NULL)
+            {
+                DirectoryScan_Run(&root);
+            }
+            else
+            {
+                threading::RunJobs(jobSystem, &rootJob, 1, &context.counter);
+                threading::WaitForCounter(jobSystem, &context.counter);
+            }
+        }
+
+        for (usize i = 0; i < slotsCount; i++)
+        {
+            DirectoryScan_Slot *slot = &context.slots[i];
+            for (usize j = 0; j < slot->files.count; j++)
+            {
+                result->files.Add(slot->files.ptr[j]);
+            }
+            slot->files.deinit();
+            result->arena.TakeChunks(&slot->arena);
+        }
+        allocator.Free(context.slots);
+        if (context.outsideLock != NULL)
+        {
+            threading::DestroyThreadLock(context.outsideLock);
+        }
+
+        if (opened && options.previous != NULL)
+        {
+            DirectoryScan_Compare(allocator, result, options.previous);
+        }
+        return opened;
+    }
+}
+
+#endif
@@ -0,0 +1,514 @@
+#pragma once
+#include "Linxc.h"
+#include "io.hpp"
+#include "hash.hpp"
+#include "hashmap.hpp"
+#include "ByteStreamOps.hpp"
+#include "sorting.hpp"
+#include <stdio.h>
+
+//"FCCH" read as a little endian u32
+#define FILECACHE_INDEX_MAGIC 0x48434346u
+#define FILECACHE_INDEX_VERSION 2
+#define FILECACHE_INDEX_NAME "index.bin"
+
+//An on disk cache of artifacts cooked from source files, such as the bfmt form of a json file, so that tools started again
+//on unchanged inputs can skip reading and converting them:
+//
+//  io::FileCache cache;
+//  io::OpenFileCache(allocator, "build/cache", 256 * 1024 * 1024, &cache);
+//  io::MappedFile cooked = cache.MapArtifact("assets/level.json", "bfmt");
+//  if (!cooked.IsValid()) { ...cook it... cache.StoreArtifact("assets/level.json", "bfmt", data, length); }
+//  cache.Save();
+//
+//Each source path is remembered with its size, modification time and the hash of its contents, so a source that has not
+//changed is validated with a single stat and never read. Artifacts are stored by content hash and artifact name, so
+//copies of a file share them, and once their total size passes the budget the least recently used ones are deleted.
+//Artifact files are replaced whole by renaming, but the index is not shared safely between processes writing at once
+namespace io
+{
+    struct FileCacheSource
+    {
+        u64 size;
+        i64 modifiedTime;
+        u64 contentHash;
+    };
+    struct FileCacheArtifact
+    {
+        u64 size;
+        //the cache's clock at its last store or map, which orders artifacts for eviction
+        u64 lastUsed;
+    };
+    struct FileCache
+    {
+        IAllocator allocator;
+        //without a trailing slash
+        string directory;
+        u64 maxBytes;
+        //total size of the artifacts in the index
+        u64 totalBytes;
+        u64 clock;
+        //source path, as it was given, to what it held when it was last hashed
+        collections::hashmap<string, FileCacheSource, StringHasher, StringEql> sources;
+        //artifact file name, the content hash in hex followed by . and the artifact's name, to its size and last use
+        collections::hashmap<string, FileCacheArtifact, StringHasher, StringEql> artifacts;
+        //whether the index differs from the one on disk
+        bool dirty;
+
+        inline FileCache()
+        {
+            allocator = IAllocator{};
+            directory = string();
+            maxBytes = 0;
+            totalBytes = 0;
+            clock = 0;
+            sources = collections::hashmap<string, FileCacheSource, StringHasher, StringEql>();
+            artifacts = collections::hashmap<string, FileCacheArtifact, StringHasher, StringEql>();
+            dirty = false;
+        }
+        //frees the cache without saving it
+        void deinit();
+        /// @brief Gets the hash of a file's contents, which is only computed if the file's size or modification time changed
+        /// since it was last hashed
+        /// @return false if the file cannot be read
+        bool GetContentHash(const char *path, u64 *hash);
+        /// @brief Maps the artifact cooked from the current contents of the source file at path
+        /// @return an invalid file if there is none, or the source cannot be read
+        MappedFile MapArtifact(const char *path, const char *artifactName);
+        /// @brief Stores the artifact cooked from the current contents of the source file at path, replacing any before it,
+        /// then evicts the least recently used artifacts until the cache is within its budget
+        /// @return false if the source cannot be read, length is 0 or over the budget, or the artifact cannot be written
+        bool StoreArtifact(const char *path, const char *artifactName, const void *data, usize length);
+        //deletes the least recently used artifacts until their total size is at most budget
+        void Evict(u64 budget);
+        /// @brief Writes the index, if it changed, so that the next OpenFileCache on the directory picks up from here
+        /// @return false if it could not be written
+        bool Save();
+    };
+    /// @brief Opens the cache in directory, creating the directory if needed, and loads its index. Files named as the cache
+    /// names its artifacts that the index does not know of, such as those left by a process that never saved, are deleted.
+    /// Any other file in the directory is left alone
+    /// @return false if the directory cannot be created. result is left empty but usable if the index is missing or invalid
+    bool OpenFileCache(IAllocator allocator, const char *directory, u64 maxBytes, FileCache *result);
+}
+
+//directory/name, null terminated
+inline string FileCache_JoinPath(IAllocator allocator, string directory, const char *name)
+{
+    usize nameLength = strlen(name);
+    string result = string(allocator, directory.length + nameLength + 1);
+    memcpy(result.buffer, directory.buffer, directory.length - 1);
+    result.buffer[directory.length - 1] = '/';
+    memcpy(result.buffer + directory.length, name, nameLength + 1);
+    return result;
+}
+inline string FileCache_ArtifactName(IAllocator allocator, u64 contentHash, const char *artifactName)
+{
+    usize artifactNameLength = strlen(artifactName);
+    string result = string(allocator, 16 + 1 + artifactNameLength + 1);
+    const char *digits = "0123456789abcdef";
+    for (usize i = 0; i < 16; i++)
+    {
+        result.buffer[i] = digits[(contentHash >> (60 - i * 4)) & 0xF];
+    }
+    result.buffer[16] = '.';
+    memcpy(result.buffer + 17, artifactName, artifactNameLength + 1);
+    return result;
+}
+//whether name is one the cache writes: an artifact, the content hash in hex followed by . and the artifact's name, or the
+//temporary file of one, or of the index
+inline bool FileCache_IsCacheFileName(const char *name)
+{
+    if (strcmp(name, FILECACHE_INDEX_NAME ".tmp") == 0)
+    {
+        return true;
+    }
+    for (usize i = 0; i < 16; i++)
+    {
+        if (!((name[i] >= '0' && name[i] <= '9') || (name[i] >= 'a' && name[i] <= 'f')))
+        {
+            return false;
+        }
+    }
+    return name[16] == '.' && name[17] != '\0';
+}
+//a key to look up the maps with, which points at text and must not be deinit
+inline string FileCache_View(const char *text)
+{
+    string result = string();
+    result.buffer = (char *)text;
+    result.length = strlen(text) + 1;
+    return result;
+}
+//renames from over to, which need not exist
+inline bool FileCache_Replace(const char *from, const char *to)
+{
+#if WINDOWS
+    return MoveFileExA(from, to, MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    return rename(from, to) == 0;
+#endif
+}
+//drops an artifact from the index, and deletes its file if deleteFile is set
+inline void FileCache_RemoveArtifact(io::FileCache *cache, string name, bool deleteFile)
+{
+    usize index = cache->artifacts.FindSlot(name);
+    if (index == cache->artifacts.capacity)
+    {
+        return;
+    }
+    //the map owns the key, so take it out before freeing it
+    string key = cache->artifacts.entries[index].key;
+    cache->totalBytes -= cache->artifacts.entries[index].value.size;
+    cache->artifacts.Remove(key);
+    if (deleteFile)
+    {
+        string fullPath = FileCache_JoinPath(cache->allocator, cache->directory, key.buffer);
+        remove(fullPath.buffer);
+        fullPath.deinit();
+    }
+    key.deinit();
+    cache->dirty = true;
+}
+
+struct FileCache_EvictionCandidate
+{
+    string name;
+    u64 lastUsed;
+};
+inline i8 FileCache_CompareLastUsed(FileCache_EvictionCandidate &A, FileCache_EvictionCandidate &B)
+{
+    return A.lastUsed < B.lastUsed ? -1 : (A.lastUsed > B.lastUsed ? 1 : 0);
+}
+
+inline bool FileCache_ReadIndex(io::FileCache *cache, string contents)
+{
+    //the length counts the terminator ReadFile adds
+    ByteStreamReader reader = ByteStreamReader(contents.buffer, contents.length - 1);
+    if (reader.Read<u32>() != FILECACHE_INDEX_MAGIC || reader.Read<u32>() != FILECACHE_INDEX_VERSION)
+    {
+        return false;
+    }
+    cache->clock = reader.Read<u64>();
+    u64 sourcesCount = reader.ReadVarint();
+    u64 artifactsCount = reader.ReadVarint();
+    for (u64 i = 0; i < sourcesCount && !reader.failed; i++)
+    {
+        string path = reader.ReadPrefixedString(cache->allocator);
+        io::FileCacheSource source = reader.Read<io::FileCacheSource>();
+        if (reader.failed)
+        {
+            path.deinit();
+            break;
+        }
+        cache->sources.Add(path, source);
+    }
+    for (u64 i = 0; i < artifactsCount && !reader.failed; i++)
+    {
+        string name = reader.ReadPrefixedString(cache->allocator);
+        io::FileCacheArtifact artifact = reader.Read<io::FileCacheArtifact>();
+        if (reader.failed)
+        {
+            name.deinit();
+            break;
+        }
+        cache->artifacts.Add(name, artifact);
+        cache->totalBytes += artifact.size;
+    }
+    return !reader.failed;
+}
+inline void FileCache_ClearMaps(io::FileCache *cache)
+{
+    auto sourcesIterator = cache->sources.GetIterator();
+    foreach (entry, sourcesIterator)
+    {
+        entry->key.deinit();
+    }
+    cache->sources.Clear();
+    auto artifactsIterator = cache->artifacts.GetIterator();
+    foreach (entry, artifactsIterator)
+    {
+        entry->key.deinit();
+    }
+    cache->artifacts.Clear();
+    cache->totalBytes = 0;
+}
+
+inline void io::FileCache::deinit()
+{
+    if (sources.entries != NULL)
+    {
+        FileCache_ClearMaps(this);
+        sources.deinit();
+        artifacts.deinit();
+    }
+    directory.deinit();
+    totalBytes = 0;
+}
+
+inline bool io::FileCache::GetContentHash(const char *path, u64 *hash)
+{
+    u64 size;
+    i64 modifiedTime;
+    if (!GetFileInfo(path, &size, &modifiedTime))
+    {
+        return false;
+    }
+    FileCacheSource *source = sources.Get(FileCache_View(path));
+    if (source != NULL && source->size == size && source->modifiedTime == modifiedTime)
+    {
+        *hash = source->contentHash;
+        return true;
+    }
+
+    u64 contentHash = Hash64("", 0);
+    if (size > 0)
+    {
+        MappedFile mapped = MapFile(path, MapFileHint_Sequential);
+        if (!mapped.IsValid())
+        {
+            return false;
+        }
+        contentHash = Hash64(mapped.data, mapped.length);
+        usize mappedLength = mapped.length;
+        mapped.deinit();
+        //written to since the stat, so the hash may not match either size or time. Use it, but check again next time
+        if (mappedLength != size)
+        {
+            *hash = contentHash;
+            return true;
+        }
+    }
+    FileCacheSource updated;
+    updated.size = size;
+    updated.modifiedTime = modifiedTime;
+    updated.contentHash = contentHash;
+    if (source != NULL)
+    {
+        *source = updated;
+    }
+    else
+    {
+        sources.Add(string(allocator, path), updated);
+    }
+    dirty = true;
+    *hash = contentHash;
+    return true;
+}
+
+inline io::MappedFile io::FileCache::MapArtifact(const char *path, const char *artifactName)
+{
+    u64 contentHash;
+    if (!GetContentHash(path, &contentHash))
+    {
+        return MappedFile();
+    }
+    string name = FileCache_ArtifactName(allocator, contentHash, artifactName);
+    MappedFile result = MappedFile();
+    FileCacheArtifact *artifact = artifacts.Get(name);
+    if (artifact != NULL)
+    {
+        string fullPath = FileCache_JoinPath(allocator, directory, name.buffer);
+        result = MapFile(fullPath.buffer, MapFileHint_WillNeed);
+        fullPath.deinit();
+        if (result.IsValid() && result.length == artifact->size)
+        {
+            clock++;
+            artifact->lastUsed = clock;
+            dirty = true;
+        }
+        else
+        {
+            //deleted or cut short behind the index's back
+            result.deinit();
+            FileCache_RemoveArtifact(this, name, true);
+        }
+    }
+    name.deinit();
+    return result;
+}
+
+inline bool io::FileCache::StoreArtifact(const char *path, const char *artifactName, const void *data, usize length)
+{
+    u64 contentHash;
+    if (length == 0 || length > maxBytes || !GetContentHash(path, &contentHash))
+    {
+        return false;
+    }
+    string name = FileCache_ArtifactName(allocator, contentHash, artifactName);
+    string fullPath = FileCache_JoinPath(allocator, directory, name.buffer);
+    //written beside the artifact and renamed over it, so that it is never seen half written
+    string temporaryPath = string(allocator, fullPath.buffer);
+    temporaryPath.Append(".tmp");
+
+    bool written = false;
+    FILE *fs = fopen(temporaryPath.buffer, "wb");
+    if (fs != NULL)
+    {
+        written = fwrite(data, 1, length, fs) == length;
+        written = fclose(fs) == 0 && written;
+        if (!written || !FileCache_Replace(temporaryPath.buffer, fullPath.buffer))
+        {
+            remove(temporaryPath.buffer);
+            written = false;
+        }
+    }
+    temporaryPath.deinit();
+    fullPath.deinit();
+    if (!written)
+    {
+        name.deinit();
+        return false;
+    }
+
+    clock++;
+    FileCacheArtifact *existing = artifacts.Get(name);
+    if (existing != NULL)
+    {
+        totalBytes -= existing->size;
+        existing->size = length;
+        existing->lastUsed = clock;
+        name.deinit();
+    }
+    else
+    {
+        FileCacheArtifact artifact;
+        artifact.size = length;
+        artifact.lastUsed = clock;
+        artifacts.Add(name, artifact);
+    }
+    totalBytes += length;
+    dirty = true;
+    Evict(maxBytes);
+    return true;
+}
+
+inline void io::FileCache::Evict(u64 budget)
+{
+    if (totalBytes <= budget)
+    {
+        return;
+    }
+    //the names stay put in memory as entries are removed, so they can be collected before removing any
+    collections::Array<FileCache_EvictionCandidate> candidates = collections::Array<FileCache_EvictionCandidate>(allocator, artifacts.count);
+    usize count = 0;
+    auto iterator = artifacts.GetIterator();
+    foreach (entry, iterator)
+    {
+        candidates.data[count].name = entry->key;
+        candidates.data[count].lastUsed = entry->value.lastUsed;
+        count++;
+    }
+    FileCache_EvictionCandidate *scratch = (FileCache_EvictionCandidate *)allocator.Allocate(sizeof(FileCache_EvictionCandidate) * (count / 2 + 1));
+    TimSort(candidates.data, count, &FileCache_CompareLastUsed, scratch);
+    allocator.Free(scratch);
+
+    for (usize i = 0; i < count && totalBytes > budget; i++)
+    {
+        FileCache_RemoveArtifact(this, candidates.data[i].name, true);
+    }
+    candidates.deinit();
+}
+
+inline bool io::FileCache::Save()
+{
+    if (!dirty)
+    {
+        return true;
+    }
+    string indexPath = FileCache_JoinPath(allocator, directory, FILECACHE_INDEX_NAME);
+    string temporaryPath = string(allocator, indexPath.buffer);
+    temporaryPath.Append(".tmp");
+
+    bool written = false;
+    FILE *fs = fopen(temporaryPath.buffer, "wb");
+    if (fs != NULL)
+    {
+        ByteStreamWriter writer = ByteStreamWriter::CreateForFile(allocator, fs);
+        writer.Write<u32>(FILECACHE_INDEX_MAGIC);
+        writer.Write<u32>(FILECACHE_INDEX_VERSION);
+        writer.Write<u64>(clock);
+        writer.WriteVarint(sources.count);
+        writer.WriteVarint(artifacts.count);
+        auto sourcesIterator = sources.GetIterator();
+        foreach (entry, sourcesIterator)
+        {
+            writer.WritePrefixedString(entry->key);
+            writer.Write<FileCacheSource>(entry->value);
+        }
+        auto artifactsIterator = artifacts.GetIterator();
+        foreach (entry, artifactsIterator)
+        {
+            writer.WritePrefixedString(entry->key);
+            writer.Write<FileCacheArtifact>(entry->value);
+        }
+        writer.deinit();
+        written = !writer.failed;
+        written = fclose(fs) == 0 && written;
+        if (!written || !FileCache_Replace(temporaryPath.buffer, indexPath.buffer))
+        {
+            remove(temporaryPath.buffer);
+            written = false;
+        }
+    }
+    temporaryPath.deinit();
+    indexPath.deinit();
+    if (written)
+    {
+        dirty = false;
+    }
+    return written;
+}
+
+inline bool io::OpenFileCache(IAllocator allocator, const char *directory, u64 maxBytes, FileCache *result)
+{
+    *result = FileCache();
+    result->allocator = allocator;
+    result->maxBytes = maxBytes;
+    result->directory = string(allocator, directory);
+    if (result->directory.length > 2 && result->directory.buffer[result->directory.length - 2] == '/')
+    {
+        result->directory.buffer[result->directory.length - 2] = '\0';
+        result->directory.length--;
+    }
+    result->sources = collections::hashmap<string, FileCacheSource, StringHasher, StringEql>(allocator, StringHasher(), StringEql());
+    result->artifacts = collections::hashmap<string, FileCacheArtifact, StringHasher, StringEql>(allocator, StringHasher(), StringEql());
+
+    //with a slash on the end, so that the last directory is created too
+    string withSlash = string(allocator, result->directory.buffer);
+    withSlash.Append("/");
+    RecursiveCreateDirectories(withSlash.buffer);
+    withSlash.deinit();
+    if (!DirectoryExists(result->directory.buffer))
+    {
+        return false;
+    }
+
+    string indexPath = FileCache_JoinPath(allocator, result->directory, FILECACHE_INDEX_NAME);
+    string contents = ReadFile(allocator, indexPath.buffer, true);
+    indexPath.deinit();
+    if (contents.buffer != NULL)
+    {
+        if (!FileCache_ReadIndex(result, contents))
+        {
+            FileCache_ClearMaps(result);
+            result->clock = 0;
+        }
+        contents.deinit();
+    }
+
+    //artifacts written by a process that did not save, and leftover temporary files. The directory may be shared or
+    //mistyped, so nothing the cache would not have written is touched
+    collections::Array<string> files = GetFilesInDirectory(allocator, result->directory.buffer);
+    for (usize i = 0; i < files.length; i++)
+    {
+        const char *name = files.data[i].buffer + result->directory.length;
+        if (FileCache_IsCacheFileName(name) && !result->artifacts.Contains(FileCache_View(name)))
+        {
+            remove(files.data[i].buffer);
+        }
+        files.data[i].deinit();
+    }
+    files.deinit();
+    return true;
+}
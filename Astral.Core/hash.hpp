@@ -4,33 +4,273 @@
 #include "string.h"
 #include "Maths/Util.hpp"
 
-inline u32 GetHash(u8* buffer, usize len)
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define HASH_USE_SSE2
+#endif
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#endif
+
+inline bool IsLittleEndian()
+{
+    i32 n = 1;
+    return *((u8*)&n) == 1;
+}
+
+inline u16 ByteSwapU16(u16 num)
+{
+    return (u16)((num >> 8) | (num << 8));
+}
+inline u32 ByteSwapU32(u32 num)
+{
+    return ((num & 0xff000000u) >> 24) | ((num & 0x00ff0000u) >> 8) | ((num & 0x0000ff00u) << 8) | (num << 24);
+}
+inline u64 ByteSwapU64(u64 num)
+{
+    num = (num & 0x00000000FFFFFFFFllu) << 32 | (num & 0xFFFFFFFF00000000llu) >> 32;
+    num = (num & 0x0000FFFF0000FFFFllu) << 16 | (num & 0xFFFF0000FFFF0000llu) >> 16;
+    num = (num & 0x00FF00FF00FF00FFllu) << 8  | (num & 0xFF00FF00FF00FF00llu) >> 8;
+    return num;
+}
+//Hash64 is a wyhash style 64 bit hash. Short inputs are read with at most two
+//overlapping loads, medium inputs are consumed 48 bytes per step across three independent lanes,
+//and inputs of HASH64_LONG_INPUT bytes or more go through an 8 lane accumulator that uses SSE2 when available.
+
+#define HASH64_DEFAULT_SEED 0xc70f6907llu
+#define HASH64_LONG_INPUT 256
+#define HASH64_STRIPE 64
+//stripes between accumulator scrambles
+#define HASH64_STRIPES_PER_BLOCK 16
+
+const u64 Hash64Secret[4] = {0xa0761d6478bd642fllu, 0xe7037ed1a0b428dbllu, 0x8ebc6af09c88c6e3llu, 0x589965cc75374cc3llu};
+const u64 Hash64LongSecret[8] = {
+    0xbe4ba423396cfeb8llu, 0x1cad21f72c81017cllu, 0xdb979083e96dd4dellu, 0x1f67b3b7a4a44072llu,
+    0x78e5c0cc4ee679cbllu, 0x2172ffcc7dd05a82llu, 0x8e2443f7744608b8llu, 0x4c263a81e69035e0llu
+};
+#define HASH64_PRIME32 0x9e3779b1u
+
+//64x64 -> 128 bit multiply, leaving the low half in A and the high half in B
+inline void Hash64_Mum(u64 *A, u64 *B)
+{
+#if defined(__SIZEOF_INT128__)
+    __uint128_t r = *A;
+    r *= *B;
+    *A = (u64)r;
+    *B = (u64)(r >> 64);
+#elif defined(_MSC_VER) && defined(_M_X64)
+    *A = _umul128(*A, *B, B);
+#else
+    u64 ha = *A >> 32, hb = *B >> 32, la = (u32)*A, lb = (u32)*B;
+    u64 rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+    u64 t = rl + (rm0 << 32);
+    u64 c = t < rl;
+    u64 lo = t + (rm1 << 32);
+    c += lo < t;
+    u64 hi = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+    *A = lo;
+    *B = hi;
+#endif
+}
+inline u64 Hash64_Mix(u64 A, u64 B)
+{
+    Hash64_Mum(&A, &B);
+    return A ^ B;
+}
+inline u64 Hash64_Read8(const u8 *ptr)
+{
+    u64 v;
+    memcpy(&v, ptr, 8);
+    return IsLittleEndian() ? v : ByteSwapU64(v);
+}
+inline u64 Hash64_Read4(const u8 *ptr)
+{
+    u32 v;
+    memcpy(&v, ptr, 4);
+    return IsLittleEndian() ? v : ByteSwapU32(v);
+}
+inline u64 Hash64_Read3(const u8 *ptr, usize len)
+{
+    return (((u64)ptr[0]) << 16) | (((u64)ptr[len >> 1]) << 8) | ptr[len - 1];
+}
+
+inline void Hash64_AccumulateStripeScalar(u64 *acc, const u8 *ptr, const u64 *key)
 {
-    u32 hash = 7;
-    for (usize i = 0; i < len; i++)
+    u64 data[8];
+    for (u32 i = 0; i < 8; i++)
     {
-        hash = hash * 31 + buffer[i];
+        data[i] = Hash64_Read8(ptr + i * 8);
+    }
+    for (u32 i = 0; i < 8; i++)
+    {
+        u64 dataKey = data[i] ^ key[i];
+        acc[i] += data[i ^ 1] + (dataKey & 0xffffffffllu) * (dataKey >> 32);
+    }
+}
+inline void Hash64_ScrambleScalar(u64 *acc, const u64 *key)
+{
+    for (u32 i = 0; i < 8; i++)
+    {
+        u64 a = acc[i];
+        a ^= a >> 47;
+        a ^= key[i];
+        acc[i] = a * HASH64_PRIME32;
+    }
+}
+#ifdef HASH_USE_SSE2
+inline void Hash64_AccumulateSSE2(u64 *acc, const u8 *ptr, usize stripes, const u64 *key)
+{
+    __m128i *accVec = (__m128i *)acc;
+    for (usize s = 0; s < stripes; s++)
+    {
+        const u8 *stripe = ptr + s * HASH64_STRIPE;
+        for (u32 i = 0; i < 4; i++)
+        {
+            __m128i data = _mm_loadu_si128((const __m128i *)(stripe + i * 16));
+            __m128i dataKey = _mm_xor_si128(data, _mm_loadu_si128((const __m128i *)(key + i * 2)));
+            //lo32 * hi32 of each 64 bit lane
+            __m128i product = _mm_mul_epu32(dataKey, _mm_shuffle_epi32(dataKey, _MM_SHUFFLE(0, 3, 0, 1)));
+            //swap the two 64 bit lanes, matching data[i ^ 1] in the scalar version
+            __m128i swapped = _mm_shuffle_epi32(data, _MM_SHUFFLE(1, 0, 3, 2));
+            __m128i a = _mm_loadu_si128(accVec + i);
+            _mm_storeu_si128(accVec + i, _mm_add_epi64(a, _mm_add_epi64(product, swapped)));
+        }
     }
-    return hash;
 }
+inline void Hash64_ScrambleSSE2(u64 *acc, const u64 *key)
+{
+    __m128i *accVec = (__m128i *)acc;
+    const __m128i prime = _mm_set1_epi32((i32)HASH64_PRIME32);
+    for (u32 i = 0; i < 4; i++)
+    {
+        __m128i a = _mm_loadu_si128(accVec + i);
+        a = _mm_xor_si128(a, _mm_srli_epi64(a, 47));
+        a = _mm_xor_si128(a, _mm_loadu_si128((const __m128i *)(key + i * 2)));
+        //64 bit lane * 32 bit prime, split into two 32x32 multiplies
+        __m128i lo = _mm_mul_epu32(a, prime);
+        __m128i hi = _mm_mul_epu32(_mm_srli_epi64(a, 32), prime);
+        _mm_storeu_si128(accVec + i, _mm_add_epi64(lo, _mm_slli_epi64(hi, 32)));
+    }
+}
+#endif
 
-inline u32 GetHash(const char* ptr)
+inline u64 Hash64_Long(const u8 *ptr, usize len, u64 seed)
+{
+    u64 key[8];
+    for (u32 i = 0; i < 8; i++)
+    {
+        key[i] = Hash64LongSecret[i] + seed;
+    }
+    u64 acc[8] = {
+        HASH64_PRIME32, Hash64Secret[0], Hash64Secret[1], Hash64Secret[2],
+        Hash64Secret[3], 0x85ebca77c2b2ae63llu, 0x27d4eb2f165667c5llu, 0x9e3779b185ebca87llu
+    };
+
+    //the final (possibly partial) stripe is always handled separately below
+    usize fullStripes = (len - 1) / HASH64_STRIPE;
+    const u8 *at = ptr;
+    while (fullStripes > 0)
+    {
+        usize stripes = fullStripes < HASH64_STRIPES_PER_BLOCK ? fullStripes : HASH64_STRIPES_PER_BLOCK;
+#ifdef HASH_USE_SSE2
+        Hash64_AccumulateSSE2(acc, at, stripes, key);
+#else
+        for (usize s = 0; s < stripes; s++)
+        {
+            Hash64_AccumulateStripeScalar(acc, at + s * HASH64_STRIPE, key);
+        }
+#endif
+        at += stripes * HASH64_STRIPE;
+        fullStripes -= stripes;
+        if (stripes == HASH64_STRIPES_PER_BLOCK)
+        {
+#ifdef HASH_USE_SSE2
+            Hash64_ScrambleSSE2(acc, key);
+#else
+            Hash64_ScrambleScalar(acc, key);
+#endif
+        }
+    }
+    //last 64 bytes of the input, overlapping the previous stripe if need be
+    Hash64_AccumulateStripeScalar(acc, ptr + len - HASH64_STRIPE, key);
+
+    u64 result = len * 0x9e3779b185ebca87llu;
+    for (u32 i = 0; i < 8; i += 2)
+    {
+        result += Hash64_Mix(acc[i] ^ Hash64Secret[i >> 1], acc[i + 1] ^ seed);
+    }
+    return Hash64_Mix(result ^ Hash64Secret[0], result ^ Hash64Secret[1]);
+}
+
+inline u64 Hash64Seeded(const void *data, usize len, u64 seed)
 {
-    u32 hash = 7;
-    usize i = 0;
-    while (true)
+    const u8 *ptr = (const u8 *)data;
+    if (len >= HASH64_LONG_INPUT)
     {
-        if (ptr[i] == '\0')
+        return Hash64_Long(ptr, len, seed);
+    }
+    seed ^= Hash64_Mix(seed ^ Hash64Secret[0], Hash64Secret[1]);
+    u64 A, B;
+    if (len <= 16)
+    {
+        if (len >= 4)
+        {
+            A = (Hash64_Read4(ptr) << 32) | Hash64_Read4(ptr + ((len >> 3) << 2));
+            B = (Hash64_Read4(ptr + len - 4) << 32) | Hash64_Read4(ptr + len - 4 - ((len >> 3) << 2));
+        }
+        else if (len > 0)
         {
-            break;
+            A = Hash64_Read3(ptr, len);
+            B = 0;
         }
         else
         {
-            hash = hash * 31 + ptr[i];
+            A = 0;
+            B = 0;
         }
-        i += 1;
     }
-    return hash;
+    else
+    {
+        usize i = len;
+        if (i > 48)
+        {
+            u64 see1 = seed, see2 = seed;
+            do
+            {
+                seed = Hash64_Mix(Hash64_Read8(ptr) ^ Hash64Secret[1], Hash64_Read8(ptr + 8) ^ seed);
+                see1 = Hash64_Mix(Hash64_Read8(ptr + 16) ^ Hash64Secret[2], Hash64_Read8(ptr + 24) ^ see1);
+                see2 = Hash64_Mix(Hash64_Read8(ptr + 32) ^ Hash64Secret[3], Hash64_Read8(ptr + 40) ^ see2);
+                ptr += 48;
+                i -= 48;
+            } while (i > 48);
+            seed ^= see1 ^ see2;
+        }
+        while (i > 16)
+        {
+            seed = Hash64_Mix(Hash64_Read8(ptr) ^ Hash64Secret[1], Hash64_Read8(ptr + 8) ^ seed);
+            i -= 16;
+            ptr += 16;
+        }
+        A = Hash64_Read8(ptr + i - 16);
+        B = Hash64_Read8(ptr + i - 8);
+    }
+    A ^= Hash64Secret[1];
+    B ^= seed;
+    Hash64_Mum(&A, &B);
+    return Hash64_Mix(A ^ Hash64Secret[0] ^ len, B ^ Hash64Secret[1]);
+}
+inline u64 Hash64(const void *data, usize len)
+{
+    return Hash64Seeded(data, len, HASH64_DEFAULT_SEED);
+}
+inline u32 GetHash(u8* buffer, usize len)
+{
+    return (u32)Hash64(buffer, len);
+}
+
+inline u32 GetHash(const char* ptr)
+{
+    return (u32)Hash64(ptr, strlen(ptr));
 }
 
 template<typename T>
@@ -57,6 +297,87 @@ bool IntegerEql(T A, T B)
     return A == B;
 }
 
+//Hashing policies used by collections::hashmap and collections::hashset.
+//A hasher is any struct with a u64 Hash(K) member and an equality policy is any struct
+//with a bool Equals(K, K) member. They are called directly rather than through
+//a function pointer, so they can be inlined, and can carry per-instance state such as a seed.
+
+//Wraps a plain hash function pointer, for maps constructed the old way
+template<typename K>
+struct FunctionHasher
+{
+    u32 (*func)(K);
+
+    inline FunctionHasher()
+    {
+        func = NULL;
+    }
+    inline FunctionHasher(u32 (*func)(K))
+    {
+        this->func = func;
+    }
+    inline u64 Hash(K key)
+    {
+        return func(key);
+    }
+};
+template<typename K>
+struct FunctionEql
+{
+    bool (*func)(K, K);
+
+    inline FunctionEql()
+    {
+        func = NULL;
+    }
+    inline FunctionEql(bool (*func)(K, K))
+    {
+        this->func = func;
+    }
+    inline bool Equals(K A, K B)
+    {
+        return func(A, B);
+    }
+};
+template<typename T>
+struct IntegerHasher
+{
+    u64 seed;
+
+    inline IntegerHasher(u64 seed = 0)
+    {
+        this->seed = seed;
+    }
+    inline u64 Hash(T integer)
+    {
+        return (u64)integer ^ seed;
+    }
+};
+template<typename T>
+struct PointerHasher
+{
+    u64 seed;
+
+    inline PointerHasher(u64 seed = 0)
+    {
+        this->seed = seed;
+    }
+    inline u64 Hash(T *ptr)
+    {
+        //discard the alignment bits, which are always 0
+        return ((usize)ptr >> 3) ^ seed;
+    }
+};
+//Compares with operator==
+template<typename T>
+struct OperatorEql
+{
+    inline bool Equals(T A, T B)
+    {
+        return A == B;
+    }
+};
+
 inline u32 CombineHash(u32 left, u32 right)
 {
     return left ^ (right + 0x9e3779b9 + (left << 6) + (left >> 2));
@@ -71,34 +392,14 @@ inline bool i32Eql(i32 A, i32 B)
     return A == B;
 }
 
-inline bool IsLittleEndian()
-{
-    i32 n = 1;
-    return *((u8*)&n) == 1;
-}
-
-inline u16 ByteSwapU16(u16 num)
-{
-    return ((num & 0xffu) >> 8) | (num << 8);
-}
-inline u32 ByteSwapU32(u32 num)
-{
-    return ((num & 0xff000000u) >> 24) | ((num & 0x00ff0000u) >> 8) | ((num & 0x0000ff00u) << 8) | (num << 24);
-}
-inline u64 ByteSwapU64(u64 num)
-{
-    num = (num & 0x00000000FFFFFFFFllu) << 32 | (num & 0xFFFFFFFF00000000llu) >> 32;
-    num = (num & 0x0000FFFF0000FFFFllu) << 16 | (num & 0xFFFF0000FFFF0000llu) >> 16;
-    num = (num & 0x00FF00FF00FF00FFllu) << 8  | (num & 0xFF00FF00FF00FF00llu) >> 8;
-    return num;
-}
 inline u64 Murmur2Seeded(u8* ptr, u64 len, u64 seed)
 {
     u64 m = 0xc6a4a7935bd1e995llu;
     u64 h1 = seed ^ (len * m);
     for (u32 i = 0; i < len / 8; i += 1)
     {
-        u64 v = ((u64*)ptr)[i];
+        u64 v;
+        memcpy(&v, ptr + i * 8, 8);
         if (!IsLittleEndian())
         {
             v = ByteSwapU64(v);
@@ -139,11 +440,11 @@ inline u32 Murmur3Seeded(u8* ptr, u64 len, u32 seed)
     u32 h1 = seed;
     for (u32 i = 0; i < (len >> 2); i++) //divide by 4
     {
-        u32 v = ((u32*)ptr)[i];
-        u32 k1 = v;
+        u32 k1;
+        memcpy(&k1, ptr + i * 4, 4);
         if (!IsLittleEndian())
         {
-            v = ByteSwapU32(v);
+            k1 = ByteSwapU32(k1);
         }
         k1 *= c1;
         k1 = Maths::rotl32(k1, 15);
@@ -154,17 +455,18 @@ inline u32 Murmur3Seeded(u8* ptr, u64 len, u32 seed)
         h1 += 0xe6546b64;
     }
     {
+        //read the tail a byte at a time so that we never read past the end of the buffer
         u32 k1 = 0;
         const u32 offset = len & 0xfffffffc;
         const u32 rest = len & 3;
         if (rest == 3) {
-            k1 ^= *((u32*)&ptr[offset + 2]) << 16;
+            k1 ^= (u32)ptr[offset + 2] << 16;
         }
         if (rest >= 2) {
-            k1 ^= *((u32*)&ptr[offset + 1]) << 8;
+            k1 ^= (u32)ptr[offset + 1] << 8;
         }
         if (rest >= 1) {
-            k1 ^= *((u32 *)&ptr[offset]);
+            k1 ^= (u32)ptr[offset];
             k1 *= c1;
             k1 = Maths::rotl32(k1, 15);
             k1 *= c2;
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "Linxc.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define HASHGROUP_USE_SSE2
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+//number of control bytes probed at once
+#define HASHGROUP_WIDTH 16
+//control byte of a slot that holds nothing. Full slots store the 7 bit fingerprint (0-127) instead
+#define HASHGROUP_EMPTY ((i8)-128)
+
+namespace collections
+{
+    inline u32 HashGroup_LowestBit(u32 mask)
+    {
+#if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanForward(&index, mask);
+        return (u32)index;
+#else
+        return (u32)__builtin_ctz(mask);
+#endif
+    }
+
+    //Returns a bitmask of which of the HASHGROUP_WIDTH control bytes starting at ctrl equal fingerprint
+    inline u32 HashGroup_Match(const i8 *ctrl, i8 fingerprint)
+    {
+#ifdef HASHGROUP_USE_SSE2
+        __m128i group = _mm_loadu_si128((const __m128i *)ctrl);
+        return (u32)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(fingerprint), group));
+#else
+        u32 result = 0;
+        for (u32 i = 0; i < HASHGROUP_WIDTH; i++)
+        {
+            if (ctrl[i] == fingerprint)
+            {
+                result |= 1u << i;
+            }
+        }
+        return result;
+#endif
+    }
+    //Returns a bitmask of which of the HASHGROUP_WIDTH control bytes starting at ctrl are empty
+    inline u32 HashGroup_MatchEmpty(const i8 *ctrl)
+    {
+#ifdef HASHGROUP_USE_SSE2
+        //empty is the only control byte with the sign bit set
+        __m128i group = _mm_loadu_si128((const __m128i *)ctrl);
+        return (u32)_mm_movemask_epi8(group);
+#else
+        u32 result = 0;
+        for (u32 i = 0; i < HASHGROUP_WIDTH; i++)
+        {
+            if (ctrl[i] < 0)
+            {
+                result |= 1u << i;
+            }
+        }
+        return result;
+#endif
+    }
+
+    //Spreads a (possibly weak, such as IntegerHash) hash across 64 bits so that both
+    //the slot index and the fingerprint are well distributed
+    inline u64 HashGroup_Mix(u64 hash)
+    {
+        return hash * 0x9e3779b97f4a7c15llu;
+    }
+    inline usize HashGroup_HomeSlot(u64 mixed, usize mask)
+    {
+        return (usize)(mixed >> 25) & mask;
+    }
+    inline i8 HashGroup_Fingerprint(u64 mixed)
+    {
+        return (i8)(mixed >> 57);
+    }
+}
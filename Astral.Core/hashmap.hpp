@@ -1,9 +1,16 @@
 #pragma once
 
 #define HASHMAP_MAX_WEIGHT 0.8f
+//smallest table allocated, which must be at least HASHGROUP_WIDTH. Kept small as maps of large values are often nearly empty
+#define HASHMAP_MIN_CAPACITY 16
+//number of keys AddMany hashes ahead of inserting them
+#define HASHMAP_BATCH_SIZE 64
 
 #include "Linxc.h"
 #include "vector.hpp"
+#include "hashgroup.hpp"
+#include "hash.hpp"
+#include <string.h>
 #include <stdio.h>
 
 #ifndef foreach
@@ -12,7 +19,13 @@
 
 namespace collections
 {
-    template <typename K, typename V>
+    //Flat open addressing hashmap. Each slot has a control byte holding either
+    //HASHGROUP_EMPTY or a 7 bit fingerprint of the key's hash, and lookups compare
+    //HASHGROUP_WIDTH control bytes at a time before touching any entries.
+    //Probing is linear, so removal shifts later entries back instead of leaving tombstones.
+    //Hasher and Eql are policies (see hash.hpp). The defaults wrap plain function pointers,
+    //use a functor such as StringHasher to have the hash calls inlined.
+    template <typename K, typename V, typename Hasher = FunctionHasher<K>, typename Eql = FunctionEql<K>>
     struct hashmap
     {
         IAllocator allocator;
@@ -20,289 +33,365 @@ namespace collections
         {
             K key;
             V value;
+            //the full mixed hash, so that rehashing and removal never call the hasher again,
+            //and so that fingerprint collisions are rejected without calling Eql
+            u64 hash;
 
             Entry(K key, V value)
             {
                 this->key = key;
                 this->value = value;
-            }
-        };
-        struct Bucket
-        {
-            bool initialized;
-            collections::vector<Entry> entries;
-
-            Bucket()
-            {
-                initialized = false;
-                entries = collections::vector<Entry>();
-            }
-            Bucket(IAllocator allocator)
-            {
-                initialized = false;
-                entries = collections::vector<Entry>(allocator);
+                this->hash = 0;
             }
         };
         def_delegate(HashFunc, u32, K);
         def_delegate(EqlFunc, bool, K, K);
 
-        HashFunc hashFunc;
-        EqlFunc eqlFunc;
+        Hasher hasher;
+        Eql eql;
 
-        Bucket *buckets;
-        usize bucketsCount;
-        usize filledBuckets;
+        //capacity + HASHGROUP_WIDTH control bytes. The final HASHGROUP_WIDTH bytes mirror
+        //the first ones so that a group probe near the end of the table does not need to wrap
+        i8 *ctrl;
+        Entry *entries;
+        usize capacity;
         usize count;
 
         hashmap()
         {
             this->allocator = IAllocator{};
-            this->hashFunc = NULL;
-            this->eqlFunc = NULL;
+            this->hasher = Hasher();
+            this->eql = Eql();
+            this->ctrl = NULL;
+            this->entries = NULL;
+            this->capacity = 0;
             this->count = 0;
-            this->filledBuckets = 0;
-            this->bucketsCount = 32;
-            this->buckets = NULL;
         }
         hashmap(IAllocator myAllocator, HashFunc hashFunction, EqlFunc eqlFunc)
         {
             this->allocator = myAllocator;
-            this->hashFunc = hashFunction;
-            this->eqlFunc = eqlFunc;
+            this->hasher = Hasher(hashFunction);
+            this->eql = Eql(eqlFunc);
             this->count = 0;
-            this->filledBuckets = 0;
-            this->bucketsCount = 32;
-            this->buckets = (Bucket*)this->allocator.Allocate(this->bucketsCount * sizeof(Bucket));
-            for (usize i = 0; i < this->bucketsCount; i++)
+            AllocateTable(HASHMAP_MIN_CAPACITY);
+        }
+        hashmap(IAllocator myAllocator, Hasher hasher, Eql eql)
+        {
+            this->allocator = myAllocator;
+            this->hasher = hasher;
+            this->eql = eql;
+            this->count = 0;
+            AllocateTable(HASHMAP_MIN_CAPACITY);
+        }
+        void deinit()
+        {
+            if (entries != NULL)
             {
-                this->buckets[i] = Bucket(this->allocator);
+                allocator.FREEPTR(entries);
+                ctrl = NULL;
             }
+            capacity = 0;
+            count = 0;
         }
-        void deinit()
+        void Clear()
+        {
+            if (ctrl != NULL)
+            {
+                memset(ctrl, HASHGROUP_EMPTY, capacity + HASHGROUP_WIDTH);
+                count = 0;
+            }
+        }
+
+        //entries and control bytes share a single allocation
+        void AllocateTable(usize newCapacity)
+        {
+            u8 *memory = (u8 *)this->allocator.Allocate(newCapacity * sizeof(Entry) + newCapacity + HASHGROUP_WIDTH);
+            this->entries = (Entry *)memory;
+            this->ctrl = (i8 *)(memory + newCapacity * sizeof(Entry));
+            this->capacity = newCapacity;
+            memset(this->ctrl, HASHGROUP_EMPTY, newCapacity + HASHGROUP_WIDTH);
+        }
+        inline void SetCtrl(usize index, i8 value)
+        {
+            ctrl[index] = value;
+            if (index < HASHGROUP_WIDTH)
+            {
+                ctrl[capacity + index] = value;
+            }
+        }
+        inline u64 HashOf(K key)
         {
-            if (buckets != NULL)
+            return HashGroup_Mix(hasher.Hash(key));
+        }
+
+        //Finds the slot holding key, or returns capacity if it is not in the map
+        inline usize FindSlot(K key)
+        {
+            if (count == 0)
+            {
+                return capacity;
+            }
+            return FindSlot(key, HashOf(key));
+        }
+        usize FindSlot(K key, u64 mixed)
+        {
+            i8 fingerprint = HashGroup_Fingerprint(mixed);
+            usize mask = capacity - 1;
+            usize position = HashGroup_HomeSlot(mixed, mask);
+            while (true)
             {
-                for (usize i = 0; i < bucketsCount; i++)
+                u32 matches = HashGroup_Match(ctrl + position, fingerprint);
+                while (matches != 0)
                 {
-                    if (buckets[i].initialized)
+                    usize index = (position + HashGroup_LowestBit(matches)) & mask;
+                    if (entries[index].hash == mixed && eql.Equals(entries[index].key, key))
                     {
-                        buckets[i].entries.deinit();
+                        return index;
                     }
-                    //buckets[i].entries.~();
+                    matches &= matches - 1;
                 }
-                allocator.FREEPTR(buckets);
+                if (HashGroup_MatchEmpty(ctrl + position) != 0)
+                {
+                    return capacity;
+                }
+                position = (position + HASHGROUP_WIDTH) & mask;
             }
         }
-        void Clear()
+        //Places an entry known not to be in the map without checking for duplicates or capacity
+        usize InsertNew(u64 mixed, Entry entry)
         {
-            if (buckets != NULL)
+            usize mask = capacity - 1;
+            usize position = HashGroup_HomeSlot(mixed, mask);
+            while (true)
             {
-                for (usize i = 0; i < bucketsCount; i++)
+                u32 empties = HashGroup_MatchEmpty(ctrl + position);
+                if (empties != 0)
                 {
-                    if (buckets[i].initialized)
-                    {
-                        buckets[i].entries.Clear();
-                    }
+                    usize index = (position + HashGroup_LowestBit(empties)) & mask;
+                    SetCtrl(index, HashGroup_Fingerprint(mixed));
+                    entries[index] = entry;
+                    entries[index].hash = mixed;
+                    return index;
                 }
-                count = 0;
+                position = (position + HASHGROUP_WIDTH) & mask;
+            }
+        }
+        void Rehash(usize newCapacity)
+        {
+            i8 *oldCtrl = ctrl;
+            Entry *oldEntries = entries;
+            usize oldCapacity = capacity;
+
+            AllocateTable(newCapacity);
+            for (usize i = 0; i < oldCapacity; i++)
+            {
+                if (oldCtrl[i] >= 0)
+                {
+                    InsertNew(oldEntries[i].hash, oldEntries[i]);
+                }
+            }
+            if (oldEntries != NULL)
+            {
+                this->allocator.Free(oldEntries);
             }
         }
         void EnsureCapacity()
         {
-            //in all likelihood, we may have to fill an additional bucket
-            //on adding a new item. Thus, we may have to resize the underlying buffer if the weight
-            //is more than 0.75
-            if (filledBuckets + 1.0f >= bucketsCount * HASHMAP_MAX_WEIGHT)
+            if (capacity == 0)
+            {
+                AllocateTable(HASHMAP_MIN_CAPACITY);
+            }
+            else if (count + 1.0f >= capacity * HASHMAP_MAX_WEIGHT)
             {
-                usize newSize = bucketsCount * 2;
+                Rehash(capacity * 2);
+            }
+        }
 
-                Bucket *newBuckets = (Bucket*)this->allocator.Allocate(newSize * sizeof(Bucket));
+        //Grows the table so that minCount entries fit without another rehash
+        void Reserve(usize minCount)
+        {
+            usize newCapacity = capacity == 0 ? HASHMAP_MIN_CAPACITY : capacity;
+            while (minCount + 1.0f >= newCapacity * HASHMAP_MAX_WEIGHT)
+            {
+                newCapacity *= 2;
+            }
+            if (capacity == 0)
+            {
+                AllocateTable(newCapacity);
+            }
+            else if (newCapacity != capacity)
+            {
+                Rehash(newCapacity);
+            }
+        }
 
-                for (usize i = 0; i < newSize; i++)
+        //Adds numEntries key/value pairs, growing the table at most once. Keys are hashed
+        //a batch at a time ahead of probing so that the hash computations can overlap
+        void AddMany(K *keys, V *values, usize numEntries)
+        {
+            Reserve(count + numEntries);
+            u64 hashes[HASHMAP_BATCH_SIZE];
+            for (usize start = 0; start < numEntries; start += HASHMAP_BATCH_SIZE)
+            {
+                usize batchSize = numEntries - start < HASHMAP_BATCH_SIZE ? numEntries - start : HASHMAP_BATCH_SIZE;
+                for (usize i = 0; i < batchSize; i++)
                 {
-                    newBuckets[i] = Bucket(this->allocator);
+                    hashes[i] = HashOf(keys[start + i]);
                 }
-                for (usize i = 0; i < bucketsCount; i++)
+                for (usize i = 0; i < batchSize; i++)
                 {
-                    if (buckets[i].initialized)
+                    usize existing = count > 0 ? FindSlot(keys[start + i], hashes[i]) : capacity;
+                    if (existing != capacity)
+                    {
+                        entries[existing].value = values[start + i];
+                    }
+                    else
                     {
-                        for (usize j = 0; j < buckets[i].entries.count; j++)
-                        {
-                            u32 newKeyHash = hashFunc(buckets[i].entries.ptr[j].key);
-                            usize newIndex = newKeyHash % newSize;
-                            newBuckets[newIndex].initialized = true;
-                            newBuckets[newIndex].entries.Add(Entry(buckets[i].entries.ptr[j].key, buckets[i].entries.ptr[j].value));
-                        }
-                        buckets[i].entries.deinit();
+                        InsertNew(hashes[i], Entry(keys[start + i], values[start + i]));
+                        count++;
                     }
                 }
-
-                this->allocator.FREEPTR(buckets);
-                buckets = newBuckets;
-                bucketsCount = newSize;
             }
         }
 
         V* Add(K key, V value)
         {
-            EnsureCapacity();
-            u32 hash = hashFunc(key);
-            usize index = hash % bucketsCount;
-
-            if (!buckets[index].initialized)
-            {
-                buckets[index].initialized = true;
-
-                filledBuckets++;
-            }
-            for (usize i = 0; i < buckets[index].entries.count; i++)
+            u64 mixed = HashOf(key);
+            if (count > 0)
             {
-                if (eqlFunc(buckets[index].entries.Get(i)->key, key))
+                usize existing = FindSlot(key, mixed);
+                if (existing != capacity)
                 {
-                    buckets[index].entries.Get(i)->value = value;
-                    return &buckets[index].entries.Get(i)->value;
+                    entries[existing].value = value;
+                    return &entries[existing].value;
                 }
             }
+            EnsureCapacity();
+            usize index = InsertNew(mixed, Entry(key, value));
             count++;
-
-            Entry newEntry = Entry(key, value);
-
-            buckets[index].entries.Add(newEntry);
-            return &buckets[index].entries.Get(buckets[index].entries.count - 1)->value;
+            return &entries[index].value;
         }
 
         bool Remove(K key)
         {
-            u32 hash = hashFunc(key);
-            usize index = hash % bucketsCount;
-
-            if (buckets[index].initialized)
+            usize hole = FindSlot(key);
+            if (hole == capacity)
+            {
+                return false;
+            }
+            //backward shift: pull later entries of the same probe run into the hole
+            //so that no lookup ever stops early on it
+            usize mask = capacity - 1;
+            usize next = (hole + 1) & mask;
+            while (ctrl[next] != HASHGROUP_EMPTY)
             {
-                for (usize i = 0; i < buckets[index].entries.count; i++)
+                usize home = HashGroup_HomeSlot(entries[next].hash, mask);
+                if (((next - home) & mask) >= ((next - hole) & mask))
                 {
-                    if (eqlFunc(buckets[index].entries.Get(i)->key, key))
-                    {
-                        buckets[index].entries.RemoveAt_Swap(i);
-
-                        count--;
-
-                        return true;
-                    }
+                    entries[hole] = entries[next];
+                    SetCtrl(hole, ctrl[next]);
+                    hole = next;
                 }
+                next = (next + 1) & mask;
             }
-            return false;
+            SetCtrl(hole, HASHGROUP_EMPTY);
+            count--;
+            return true;
         }
 
         V *Get(K key)
         {
-            u32 hash = hashFunc(key);
-            usize index = hash % bucketsCount;
+            usize index = FindSlot(key);
+            if (index != capacity)
+            {
+                return &entries[index].value;
+            }
+            return NULL;
+        }
 
-            if (buckets[index].initialized)
+        //mixed must be HashOf(key), which callers looking up the same key many times can compute once
+        V *Get(K key, u64 mixed)
+        {
+            if (count == 0)
             {
-                for (usize i = 0; i < buckets[index].entries.count; i++)
-                {
-                    if (eqlFunc(buckets[index].entries.Get(i)->key, key))
-                    {
-                        return &buckets[index].entries.Get(i)->value;
-                    }
-                }
+                return NULL;
+            }
+            usize index = FindSlot(key, mixed);
+            if (index != capacity)
+            {
+                return &entries[index].value;
             }
             return NULL;
         }
 
         V GetCopyOr(K key, V valueOnNotFound)
         {
-            u32 hash = hashFunc(key);
-            usize index = hash % bucketsCount;
-
-            if (buckets[index].initialized)
+            usize index = FindSlot(key);
+            if (index != capacity)
             {
-                for (usize i = 0; i < buckets[index].entries.count; i++)
-                {
-                    if (eqlFunc(buckets[index].entries.Get(i)->key, key))
-                    {
-                        return buckets[index].entries.Get(i)->value;
-                    }
-                }
+                return entries[index].value;
             }
             return valueOnNotFound;
         }
 
         bool Contains(K key)
         {
-            u32 hash = hashFunc(key);
-            usize index = hash % bucketsCount;
-
-            if (!buckets[index].initialized)
-            {
-                return false;
-            }
-
-            for (usize i = 0; i < buckets[index].entries.count; i++)
-            {
-                if (eqlFunc(key, buckets[index].entries.Get(i)->key))
-                {
-                    return true;
-                }
-            }
-            return false;
+            return FindSlot(key) != capacity;
         }
 
-        hashmap<K, V> Clone(IAllocator newAllocator)
+        hashmap<K, V, Hasher, Eql> Clone(IAllocator newAllocator)
         {
-            hashmap<K, V> result = hashmap<K, V>(newAllocator, this->hashFunc, this->eqlFunc);
-
-            for (usize i = 0; i < bucketsCount; i++)
+            hashmap<K, V, Hasher, Eql> result = hashmap<K, V, Hasher, Eql>();
+            result.allocator = newAllocator;
+            result.hasher = this->hasher;
+            result.eql = this->eql;
+            if (capacity > 0)
             {
-                if (buckets[i].initialized)
+                //same hasher and capacity, so every entry can stay in its slot
+                result.AllocateTable(capacity);
+                memcpy(result.ctrl, ctrl, capacity + HASHGROUP_WIDTH);
+                for (usize i = 0; i < capacity; i++)
                 {
-                    for (usize j = 0; j < buckets[i].entries.count; j++)
+                    if (ctrl[i] >= 0)
                     {
-                        result.Add(buckets[i].entries.Get(j)->key, buckets[i].entries.Get(j)->value);
+                        result.entries[i] = entries[i];
                     }
                 }
+                result.count = count;
             }
-
             return result;
         }
 
         struct Iterator
         {
-            hashmap<K, V> *map;
+            hashmap<K, V, Hasher, Eql> *map;
             usize i;
-            usize j;
             bool completed;
 
-            Iterator(hashmap<K, V> *map)
+            Iterator(hashmap<K, V, Hasher, Eql> *map)
             {
                 this->map = map;
                 i = 0;
-                j = 0;
                 completed = false;
             }
 
             Entry* Next()
             {
-                if (i >= map->bucketsCount || completed)
+                if (completed)
                 {
                     return NULL;
                 }
-                while (!map->buckets[i].initialized || j >= map->buckets[i].entries.count)
+                while (i < map->capacity)
                 {
+                    usize index = i;
                     i++;
-                    if (i >= map->bucketsCount)
-                    {
-                        completed = true;
-                        return NULL;
-                    }
-                    if (map->buckets[i].initialized && map->buckets[i].entries.count > 0)
+                    if (map->ctrl[index] >= 0)
                     {
-                        j = 0;
-                        break;
+                        return &map->entries[index];
                     }
                 }
-                return &map->buckets[i].entries.ptr[j++];
+                completed = true;
+                return NULL;
             }
         };
         inline Iterator GetIterator()
@@ -310,4 +399,4 @@ namespace collections
             return Iterator(this);
         }
     };
-}
\ No newline at end of file
+}
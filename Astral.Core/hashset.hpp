@@ -1,9 +1,14 @@
 #pragma once
 
 #define HASHSET_MAX_WEIGHT 0.8f
+//smallest table allocated, which must be at least HASHGROUP_WIDTH
+#define HASHSET_MIN_CAPACITY 16
 
 #include "Linxc.h"
 #include "vector.hpp"
+#include "hashgroup.hpp"
+#include "hash.hpp"
+#include <string.h>
 
 #ifndef foreach
 #define foreach(instance, iterator) for (auto instance = iterator.Next(); !iterator.completed; instance = iterator.Next())
@@ -11,218 +16,240 @@
 
 namespace collections
 {
-    template <typename T>
+    //Flat open addressing hashset, laid out the same way as collections::hashmap
+    template <typename T, typename Hasher = FunctionHasher<T>, typename Eql = FunctionEql<T>>
     struct hashset
     {
-        struct Bucket
-        {
-            bool initialized;
-            u32 keyHash;
-            collections::vector<T> entries;
-        };
         def_delegate(HashFunc, u32, T);
         def_delegate(EqlFunc, bool, T, T);
 
         IAllocator allocator;
-        HashFunc hashFunc;
-        EqlFunc eqlFunc;
+        Hasher hasher;
+        Eql eql;
 
-        Bucket *buckets;
-        usize bucketsCount;
-        usize filledBuckets;
+        i8 *ctrl;
+        T *values;
+        //full mixed hash of every value, kept alongside so that the values array stays dense
+        u64 *hashes;
+        usize capacity;
         usize count;
 
         hashset()
         {
             this->allocator = IAllocator{};
-            this->hashFunc = NULL;
-            this->eqlFunc = NULL;
+            this->hasher = Hasher();
+            this->eql = Eql();
+            this->ctrl = NULL;
+            this->values = NULL;
+            this->hashes = NULL;
+            this->capacity = 0;
             this->count = 0;
-            this->filledBuckets = 0;
-            this->bucketsCount = 32;
-            this->buckets = NULL;
         }
         hashset(IAllocator allocator, HashFunc hashFunction, EqlFunc eqlFunc)
         {
             this->allocator = allocator;
-            this->hashFunc = hashFunction;
-            this->eqlFunc = eqlFunc;
+            this->hasher = Hasher(hashFunction);
+            this->eql = Eql(eqlFunc);
             this->count = 0;
-            this->filledBuckets = 0;
-            this->bucketsCount = 32;
-            this->buckets = (Bucket*)allocator.Allocate(this->bucketsCount * sizeof(Bucket));
-            for (usize i = 0; i < this->bucketsCount; i++)
+            AllocateTable(HASHSET_MIN_CAPACITY);
+        }
+        hashset(IAllocator allocator, Hasher hasher, Eql eql)
+        {
+            this->allocator = allocator;
+            this->hasher = hasher;
+            this->eql = eql;
+            this->count = 0;
+            AllocateTable(HASHSET_MIN_CAPACITY);
+        }
+        void deinit()
+        {
+            if (hashes != NULL)
             {
-                this->buckets[i].initialized = false;
+                this->allocator.FREEPTR(hashes);
+                values = NULL;
+                ctrl = NULL;
             }
+            capacity = 0;
+            count = 0;
         }
-        void deinit()
+        //hashes, values and control bytes share a single allocation
+        void AllocateTable(usize newCapacity)
+        {
+            u8 *memory = (u8 *)this->allocator.Allocate(newCapacity * (sizeof(u64) + sizeof(T)) + newCapacity + HASHGROUP_WIDTH);
+            this->hashes = (u64 *)memory;
+            this->values = (T *)(memory + newCapacity * sizeof(u64));
+            this->ctrl = (i8 *)(memory + newCapacity * (sizeof(u64) + sizeof(T)));
+            this->capacity = newCapacity;
+            memset(this->ctrl, HASHGROUP_EMPTY, newCapacity + HASHGROUP_WIDTH);
+        }
+        inline void SetCtrl(usize index, i8 value)
+        {
+            ctrl[index] = value;
+            if (index < HASHGROUP_WIDTH)
+            {
+                ctrl[capacity + index] = value;
+            }
+        }
+        inline u64 HashOf(T value)
+        {
+            return HashGroup_Mix(hasher.Hash(value));
+        }
+        //Finds the slot holding value, or returns capacity if it is not in the set
+        usize FindSlot(T value, u64 mixed)
         {
-            for (usize i = 0; i < bucketsCount; i++)
+            i8 fingerprint = HashGroup_Fingerprint(mixed);
+            usize mask = capacity - 1;
+            usize position = HashGroup_HomeSlot(mixed, mask);
+            while (true)
             {
-                if (buckets[i].initialized)
+                u32 matches = HashGroup_Match(ctrl + position, fingerprint);
+                while (matches != 0)
                 {
-                    buckets[i].entries.deinit();
+                    usize index = (position + HashGroup_LowestBit(matches)) & mask;
+                    if (hashes[index] == mixed && eql.Equals(values[index], value))
+                    {
+                        return index;
+                    }
+                    matches &= matches - 1;
                 }
+                if (HashGroup_MatchEmpty(ctrl + position) != 0)
+                {
+                    return capacity;
+                }
+                position = (position + HASHGROUP_WIDTH) & mask;
             }
-            this->allocator.FREEPTR(buckets);
         }
-        void EnsureCapacity()
+        void InsertNew(u64 mixed, T value)
         {
-            //in all likelihood, we may have to fill an additional bucket
-            //on adding a new item. Thus, we may have to resize the underlying buffer if the weight
-            //is more than 0.75
-            if (filledBuckets + 1.0f >= bucketsCount * HASHMAP_MAX_WEIGHT)
+            usize mask = capacity - 1;
+            usize position = HashGroup_HomeSlot(mixed, mask);
+            while (true)
             {
-                usize newSize = bucketsCount * 2;
-
-                Bucket *newBuckets = (Bucket*)this->allocator.Allocate(newSize * sizeof(Bucket));
-
-                for (usize i = 0; i < newSize; i++)
+                u32 empties = HashGroup_MatchEmpty(ctrl + position);
+                if (empties != 0)
                 {
-                    newBuckets[i].entries = collections::vector<T>(this->allocator);
-                    newBuckets[i].initialized = false;
+                    usize index = (position + HashGroup_LowestBit(empties)) & mask;
+                    SetCtrl(index, HashGroup_Fingerprint(mixed));
+                    values[index] = value;
+                    hashes[index] = mixed;
+                    return;
                 }
-                for (usize i = 0; i < bucketsCount; i++)
+                position = (position + HASHGROUP_WIDTH) & mask;
+            }
+        }
+        void EnsureCapacity()
+        {
+            if (capacity == 0)
+            {
+                AllocateTable(HASHSET_MIN_CAPACITY);
+            }
+            else if (count + 1.0f >= capacity * HASHSET_MAX_WEIGHT)
+            {
+                i8 *oldCtrl = ctrl;
+                T *oldValues = values;
+                u64 *oldHashes = hashes;
+                usize oldCapacity = capacity;
+
+                AllocateTable(capacity * 2);
+                for (usize i = 0; i < oldCapacity; i++)
                 {
-                    if (buckets[i].initialized)
+                    if (oldCtrl[i] >= 0)
                     {
-                        for (usize j = 0; j < buckets[i].entries.count; j++)
-                        {
-                            u32 newKeyHash = hashFunc(buckets[i].entries.ptr[j]);
-                            usize newIndex = newKeyHash % newSize;
-                            newBuckets[newIndex].initialized = true;
-                            newBuckets[newIndex].entries.Add(buckets[i].entries.ptr[j]);
-                        }
-                        buckets[i].entries.deinit();
+                        InsertNew(oldHashes[i], oldValues[i]);
                     }
                 }
-
-                this->allocator.FREEPTR(buckets);
-                buckets = newBuckets;
-                bucketsCount = newSize;
+                this->allocator.Free(oldHashes);
             }
         }
         bool Add(T value)
         {
-            EnsureCapacity();
-            u32 hash = hashFunc(value);
-            usize index = hash % bucketsCount;
-
-            if (!buckets[index].initialized)
-            {
-                buckets[index].initialized = true;
-                buckets[index].keyHash = hash;
-                buckets[index].entries = collections::vector<T>(allocator);
-
-                filledBuckets++;
-            }
-
-            for (usize i = 0; i < buckets[index].entries.count; i++)
+            u64 mixed = HashOf(value);
+            if (count > 0 && FindSlot(value, mixed) != capacity)
             {
-                if (eqlFunc(*buckets[index].entries.Get(i), value))
-                {
-                    return false;
-                }
+                return false;
             }
+            EnsureCapacity();
+            InsertNew(mixed, value);
             count++;
-            buckets[index].entries.Add(value);
             return true;
         }
         bool Remove(T value)
         {
-            u32 hash = hashFunc(value);
-            usize index = hash % bucketsCount;
-
-            if (buckets[index].initialized)
+            if (count == 0)
+            {
+                return false;
+            }
+            usize hole = FindSlot(value, HashOf(value));
+            if (hole == capacity)
             {
-                for (usize i = 0; i < buckets[index].entries.count; i++)
+                return false;
+            }
+            //backward shift deletion, see hashmap::Remove
+            usize mask = capacity - 1;
+            usize next = (hole + 1) & mask;
+            while (ctrl[next] != HASHGROUP_EMPTY)
+            {
+                usize home = HashGroup_HomeSlot(hashes[next], mask);
+                if (((next - home) & mask) >= ((next - hole) & mask))
                 {
-                    if (eqlFunc(*buckets[index].entries.Get(i), value))
-                    {
-                        //buckets[index].entries.Get(i)->value.V~();
-                        buckets[index].entries.RemoveAt_Swap(i);
-                        count--;
-
-                        return true;
-                    }
+                    values[hole] = values[next];
+                    hashes[hole] = hashes[next];
+                    SetCtrl(hole, ctrl[next]);
+                    hole = next;
                 }
+                next = (next + 1) & mask;
             }
-            return false;
+            SetCtrl(hole, HASHGROUP_EMPTY);
+            count--;
+            return true;
         }
         bool Contains(T value)
         {
-            u32 hash = hashFunc(value);
-            u32 index = hash % bucketsCount;
-
-            if (!buckets[index].initialized)
+            if (count == 0)
             {
                 return false;
             }
-
-            if (buckets[index].entries.count > 0)
-            {
-                for (usize i = 0; i < buckets[index].entries.count; i++)
-                {
-                    if (eqlFunc(value, *buckets[index].entries.Get(i)))
-                    {
-                        return true;
-                    }
-                }
-            }
-            return false;
+            return FindSlot(value, HashOf(value)) != capacity;
         }
         void Clear()
         {
-            if (buckets != NULL)
+            if (ctrl != NULL)
             {
-                for (usize i = 0; i < bucketsCount; i++)
-                {
-                    if (buckets[i].initialized)
-                    {
-                        buckets[i].entries.Clear();
-                    }
-                }
+                memset(ctrl, HASHGROUP_EMPTY, capacity + HASHGROUP_WIDTH);
                 count = 0;
             }
         }
 
         struct Iterator
         {
-            hashset<T> *set;
+            hashset<T, Hasher, Eql> *set;
             usize i;
-            usize j;
             bool completed;
 
-            Iterator(hashset<T> *set)
+            Iterator(hashset<T, Hasher, Eql> *set)
             {
                 this->set = set;
                 i = 0;
-                j = 0;
                 completed = false;
             }
 
             T* Next()
             {
-                if (i >= set->bucketsCount || completed)
+                if (completed)
                 {
                     return NULL;
                 }
-                while (!set->buckets[i].initialized || j >= set->buckets[i].entries.count)
+                while (i < set->capacity)
                 {
+                    usize index = i;
                     i++;
-                    if (i >= set->bucketsCount)
-                    {
-                        completed = true;
-                        return NULL;
-                    }
-                    if (set->buckets[i].initialized && set->buckets[i].entries.count > 0)
+                    if (set->ctrl[index] >= 0)
                     {
-                        j = 0;
-                        break;
+                        return &set->values[index];
                     }
                 }
-                return &set->buckets[i].entries.ptr[j++];
+                completed = true;
+                return NULL;
             }
         };
         inline Iterator GetIterator()
@@ -230,4 +257,4 @@ namespace collections
             return Iterator(this);
         }
     };
-}
\ No newline at end of file
+}
@@ -18,36 +18,191 @@
 #if POSIX
 #include <unistd.h>
 #include <dirent.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/mman.h>
 #endif
 
 namespace io
 {
+    /// @brief Reads a whole file into a null terminated string, sized up front with fstat so that it takes a single read.
+    /// The string is empty if the file could not be opened
     inline string ReadFile(IAllocator allocator, const char* path, bool isBinary)
     {
         string result = string(allocator);
-
+#if WINDOWS
+        //text mode turns \r\n into \n, so the size from fstat is only an upper bound on what fread returns
         FILE *fs = fopen(path, isBinary ? "rb" : "r");
-        if (fs != NULL)
+        if (fs == NULL)
+        {
+            return result;
+        }
+        struct _stat64 status;
+        if (_fstat64(_fileno(fs), &status) == 0)
+        {
+            usize size = (usize)status.st_size;
+            char *buffer = (char *)allocator.Allocate(size + 1);
+            if (buffer != NULL)
+            {
+                size = fread(buffer, sizeof(char), size, fs);
+                buffer[size] = '\0';
+                result.buffer = buffer;
+                result.length = size + 1;
+            }
+        }
+        fclose(fs);
+#else
+        //text and binary mode are the same here
+        (void)isBinary;
+        int fd = open(path, O_RDONLY);
+        if (fd < 0)
+        {
+            return result;
+        }
+        struct stat status;
+        if (fstat(fd, &status) == 0)
         {
+            //files such as those in /proc report a size of 0, so keep reading past the size until read says the file is done
+            usize capacity = status.st_size > 0 ? (usize)status.st_size : 4096;
             usize size = 0;
-            while (fgetc(fs) != EOF)
+            char *buffer = (char *)allocator.Allocate(capacity + 1);
+            while (buffer != NULL)
             {
-                size += 1;
+                ssize_t bytesRead = read(fd, buffer + size, capacity - size);
+                if (bytesRead < 0 && errno == EINTR)
+                {
+                    continue;
+                }
+                if (bytesRead <= 0)
+                {
+                    break;
+                }
+                size += (usize)bytesRead;
+                if (size == capacity && status.st_size == 0)
+                {
+                    char *larger = (char *)allocator.Allocate(capacity * 2 + 1);
+                    if (larger != NULL)
+                    {
+                        memcpy(larger, buffer, size);
+                    }
+                    allocator.Free(buffer);
+                    buffer = larger;
+                    capacity *= 2;
+                }
+                else if (size == capacity)
+                {
+                    break;
+                }
             }
-            fseek(fs, 0, SEEK_SET);
-
-            char* buffer = (char*)allocator.Allocate(size + 1);
             if (buffer != NULL)
             {
-                fread(buffer, sizeof(char), size, fs);
-                
                 buffer[size] = '\0';
                 result.buffer = buffer;
                 result.length = size + 1;
             }
+        }
+        close(fd);
+#endif
+        return result;
+    }
+
+    enum MapFileHints
+    {
+        MapFileHint_None = 0,
+        //the file will be read from front to back, so the OS can read further ahead and drop pages sooner
+        MapFileHint_Sequential = 1,
+        //the whole file will be needed soon, so the OS can start reading it in now
+        MapFileHint_WillNeed = 2
+    };
+
+    //A read only view of a whole file, paged in by the OS as it is touched rather than copied into memory up front
+    struct MappedFile
+    {
+        const u8 *data;
+        usize length;
 
-            fclose(fs);
+        inline MappedFile()
+        {
+            data = NULL;
+            length = 0;
+        }
+        //false if the file could not be opened or mapped, which includes empty files as there is nothing to map
+        inline bool IsValid()
+        {
+            return data != NULL;
+        }
+        inline void deinit()
+        {
+            if (data != NULL)
+            {
+#if WINDOWS
+                UnmapViewOfFile(data);
+#else
+                munmap((void *)data, length);
+#endif
+            }
+            data = NULL;
+            length = 0;
+        }
+    };
+
+    /// @brief Maps the file at path into memory. The mapping stays valid after the file is closed, until deinit.
+    /// Changes made to the file while it is mapped may or may not show up in data
+    /// @param hints MapFileHints or'd together
+    inline MappedFile MapFile(const char *path, u32 hints = MapFileHint_None)
+    {
+        MappedFile result = MappedFile();
+#if WINDOWS
+        DWORD flags = (hints & MapFileHint_Sequential) != 0 ? FILE_FLAG_SEQUENTIAL_SCAN : FILE_ATTRIBUTE_NORMAL;
+        HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, flags, NULL);
+        if (file == INVALID_HANDLE_VALUE)
+        {
+            return result;
         }
+        LARGE_INTEGER size;
+        if (GetFileSizeEx(file, &size) && size.QuadPart > 0)
+        {
+            HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+            if (mapping != NULL)
+            {
+                //the view keeps the mapping and file alive once their handles are closed
+                void *view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+                if (view != NULL)
+                {
+                    result.data = (const u8 *)view;
+                    result.length = (usize)size.QuadPart;
+                }
+                CloseHandle(mapping);
+            }
+        }
+        CloseHandle(file);
+#else
+        int fd = open(path, O_RDONLY);
+        if (fd < 0)
+        {
+            return result;
+        }
+        struct stat status;
+        if (fstat(fd, &status) == 0 && status.st_size > 0)
+        {
+            //the mapping holds its own reference to the file, so fd can be closed straight away
+            void *view = mmap(NULL, (usize)status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (view != MAP_FAILED)
+            {
+                if ((hints & MapFileHint_Sequential) != 0)
+                {
+                    madvise(view, (usize)status.st_size, MADV_SEQUENTIAL);
+                }
+                if ((hints & MapFileHint_WillNeed) != 0)
+                {
+                    madvise(view, (usize)status.st_size, MADV_WILLNEED);
+                }
+                result.data = (const u8 *)view;
+                result.length = (usize)status.st_size;
+            }
+        }
+        close(fd);
+#endif
         return result;
     }
 
@@ -69,6 +224,35 @@ namespace io
         return false;
     }
 
+    /// @brief Gets a file's size and last modification time, in nanoseconds, with a single stat and without opening it.
+    /// Times are only comparable with each other, as their epoch differs between platforms
+    /// @return false if there is no file at path
+    inline bool GetFileInfo(const char *path, u64 *size, i64 *modifiedTime)
+    {
+#if WINDOWS
+        WIN32_FILE_ATTRIBUTE_DATA attributes;
+        if (!GetFileAttributesExA(path, GetFileExInfoStandard, &attributes) || (attributes.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0)
+        {
+            return false;
+        }
+        *size = ((u64)attributes.nFileSizeHigh << 32) | attributes.nFileSizeLow;
+        *modifiedTime = (i64)((((u64)attributes.ftLastWriteTime.dwHighDateTime << 32) | attributes.ftLastWriteTime.dwLowDateTime) * 100);
+#else
+        struct stat status;
+        if (stat(path, &status) != 0 || S_ISDIR(status.st_mode))
+        {
+            return false;
+        }
+        *size = (u64)status.st_size;
+#if defined(__APPLE__)
+        *modifiedTime = (i64)status.st_mtimespec.tv_sec * 1000000000 + status.st_mtimespec.tv_nsec;
+#else
+        *modifiedTime = (i64)status.st_mtim.tv_sec * 1000000000 + status.st_mtim.tv_nsec;
+#endif
+#endif
+        return true;
+    }
+
     inline bool NewDirectory(const char* path)
     {
         if (!io::DirectoryExists(path))
@@ -85,30 +269,28 @@ namespace io
 
     inline void RecursiveCreateDirectories(const char* finalDirPath)
     {
-        ArenaAllocator arena = ArenaAllocator(GetCAllocator());
-        IAllocator alloc = arena.AsAllocator();
-
-        collections::Array<string> paths = SplitString(alloc, finalDirPath, '/');
-        if (paths.length <= 1) //C:/ is not a valid file
+        if (strchr(finalDirPath, '/') == NULL) //C:/ is not a valid file
         {
             return;
         }
-        string currentPath = paths.data[0].Clone(alloc);
-
-        for (usize i = 0; i < paths.length; i++)
+        //each parent is cut off in place with a terminator and created, as creating one that already exists fails harmlessly
+        string path = string(GetCAllocator(), finalDirPath);
+        for (usize i = 1; i < path.length; i++)
         {
-            if (i > 0)
+            char c = path.buffer[i];
+            if (c != '/' && c != '\0')
             {
-                currentPath.Append("/");
-                currentPath.Append(paths.data[i].buffer);
-            }
-            if (!io::DirectoryExists(currentPath.buffer))
-            {
-                io::NewDirectory(currentPath.buffer);
+                continue;
             }
+            path.buffer[i] = '\0';
+        #if WINDOWS
+            CreateDirectoryA(path.buffer, NULL);
+        #else
+            mkdir(path.buffer, 0755);
+        #endif
+            path.buffer[i] = c;
         }
-
-        arena.deinit();
+        path.deinit();
     }
 
     inline FILE* CreateDirectoriesAndFile(const char* path)
@@ -118,6 +300,7 @@ namespace io
         collections::Array<string> paths = SplitString(alloc, path, '/');
         if (paths.length <= 1) //C:/ is not a valid file
         {
+            arena.deinit();
             return NULL;
         }
         FILE* file = NULL;
@@ -190,31 +373,33 @@ namespace io
 
         return results.ToOwnedArrayWith(allocator);
 #else
-        collections::vector<string> results = collections::vector<string>(GetCAllocator());
-
-        struct dirent *dent;
-        DIR *srcdir = opendir(dirPath);
-        while((dent = readdir(srcdir)) != NULL)
+        collections::vector<string> results = collections::vector<string>(defaultAllocator);
+        struct dirent *dir;
+        DIR *d = opendir(dirPath);
+        if (d != NULL)
         {
-            struct stat st;
-
-            if(strcmp(dent->d_name, ".") == 0 || strcmp(dent->d_name, "..") == 0)
-            {
-                continue;
-            }
-            if (fstatat(dirfd(srcdir), dent->d_name, &st, 0) < 0)
+            while ((dir = readdir(d)) != NULL)
             {
-                continue;
-            }
+                struct stat st;
 
-            if (S_ISDIR(st.st_mode))
-            {
-                //dircount++
-                string fullPath = string(allocator, dirPath);
-                fullPath.Append("/");
-                fullPath.Append(dent->d_name);
-                results.Add(fullPath);
+                if(strcmp(dir->d_name, ".") == 0 || strcmp(dir->d_name, "..") == 0)
+                {
+                    continue;
+                }
+                if (fstatat(dirfd(d), dir->d_name, &st, 0) < 0)
+                {
+                    continue;
+                }
+
+                if (!S_ISDIR(st.st_mode))
+                {
+                    string fullPath = string(allocator, dirPath);
+                    fullPath.Append("/");
+                    fullPath.Append(dir->d_name);
+                    results.Add(fullPath);
+                }
             }
+            closedir(d);
         }
 
         return results.ToOwnedArrayWith(allocator);
@@ -272,16 +457,16 @@ namespace io
             {
                 struct stat st;
 
-                if(strcmp(dent->d_name, ".") == 0 || strcmp(dent->d_name, "..") == 0)
+                if(strcmp(dir->d_name, ".") == 0 || strcmp(dir->d_name, "..") == 0)
                 {
                     continue;
                 }
-                if (fstatat(dirfd(srcdir), dent->d_name, &st, 0) < 0)
+                if (fstatat(dirfd(d), dir->d_name, &st, 0) < 0)
                 {
                     continue;
                 }
 
-                if (!S_ISDIR(st.st_mode))
+                if (S_ISDIR(st.st_mode))
                 {
                     string fullPath = string(allocator, dirPath);
                     fullPath.Append("/");
@@ -0,0 +1,512 @@
+#pragma once
+#include "Linxc.h"
+#include "allocators.hpp"
+#include "threading.hpp"
+#include "atomics.hpp"
+
+//number of jobs each worker's deque can hold. Jobs pushed onto a full deque run immediately on the pushing thread
+#define JOBS_DEQUE_CAPACITY 4096
+//how many times an idle worker looks for work before going to sleep
+#define JOBS_IDLE_SPINS 64
+//upper bound on how long a sleeping worker waits before checking for work again, in milliseconds
+#define JOBS_SLEEP_TIMEOUT 10
+
+namespace threading
+{
+    def_delegate(JobFunc, void, void*);
+    def_delegate(ParallelForFunc, void, void*, usize, usize);
+
+    //Counts jobs that have not finished yet. Attach one to a batch of jobs and wait on it
+    //with WaitForCounter to express that later work depends on the batch
+    struct JobCounter
+    {
+        volatile i64 value;
+
+        inline JobCounter()
+        {
+            value = 0;
+        }
+        inline bool IsDone()
+        {
+            return AtomicLoad(&value) <= 0;
+        }
+    };
+
+    struct Job
+    {
+        JobFunc func;
+        void *data;
+        JobCounter *counter;
+
+        inline Job()
+        {
+            func = NULL;
+            data = NULL;
+            counter = NULL;
+        }
+        inline Job(JobFunc func, void *data)
+        {
+            this->func = func;
+            this->data = data;
+            this->counter = NULL;
+        }
+    };
+
+    typedef struct JobSystemImpl *JobSystem;
+
+    /// @brief Starts a pool of worker threads, each of which owns a deque of jobs and steals from the others when its own runs dry
+    /// @param workerCount number of worker threads, 0 uses one less than the hardware thread count (the calling thread helps out whenever it waits)
+    JobSystem CreateJobSystem(IAllocator allocator, usize workerCount = 0);
+    /// @brief Asks every worker to finish the job it is running and return, then joins them.
+    /// Jobs that are still queued are dropped, so wait on their counters first
+    void DestroyJobSystem(JobSystem system);
+    usize GetWorkerCount(JobSystem system);
+    //Index of the calling worker thread within system, or -1 if the caller is not one of its workers
+    i64 GetCurrentWorkerIndex(JobSystem system);
+
+    /// @brief Queues count jobs. If counter is not NULL, it is incremented by count now and decremented as each job completes
+    void RunJobs(JobSystem system, Job *jobs, usize count, JobCounter *counter);
+    /// @brief Queues count jobs that only start once dependency reaches zero. counter is incremented immediately,
+    /// so waiting on it also waits for dependency
+    void RunJobsAfter(JobSystem system, Job *jobs, usize count, JobCounter *counter, JobCounter *dependency);
+    /// @brief Blocks until counter reaches zero. The calling thread runs queued jobs while it waits,
+    /// so this may be called from within a job without starving the pool
+    void WaitForCounter(JobSystem system, JobCounter *counter);
+    /// @brief Calls func(data, begin, end) over subranges of [start, end) in parallel and waits for all of them
+    /// @param grainSize number of indices per job, 0 picks a size that gives each worker several jobs
+    void ParallelFor(JobSystem system, usize start, usize end, usize grainSize, ParallelForFunc func, void *data);
+}
+
+#ifdef ASTRALCORE_THREADING_IMPL
+
+#include <string.h>
+#include "queue.hpp"
+
+namespace threading
+{
+    //Chase-Lev work stealing deque (Le et al, "Correct and Efficient Work-Stealing for Weak Memory Models").
+    //Only the owning worker pushes and pops at the bottom, any thread may steal from the top
+    struct JobDeque
+    {
+        volatile i64 top;
+        u8 topPadding[56];
+        volatile i64 bottom;
+        u8 bottomPadding[56];
+        Job *jobs;
+        i64 mask;
+
+        bool Push(Job job)
+        {
+            i64 b = AtomicLoadRelaxed(&bottom);
+            i64 t = AtomicLoad(&top);
+            if (b - t > mask)
+            {
+                return false;
+            }
+            jobs[b & mask] = job;
+            AtomicStore(&bottom, b + 1);
+            return true;
+        }
+        bool Pop(Job *result)
+        {
+            i64 b = AtomicLoadRelaxed(&bottom) - 1;
+            AtomicStoreRelaxed(&bottom, b);
+            AtomicThreadFence();
+            i64 t = AtomicLoadRelaxed(&top);
+            if (t > b)
+            {
+                //empty
+                AtomicStoreRelaxed(&bottom, b + 1);
+                return false;
+            }
+            *result = jobs[b & mask];
+            if (t == b)
+            {
+                //last job, race any thieves for it
+                bool won = AtomicCompareExchange(&top, t, t + 1);
+                AtomicStoreRelaxed(&bottom, b + 1);
+                return won;
+            }
+            return true;
+        }
+        bool Steal(Job *result)
+        {
+            i64 t = AtomicLoad(&top);
+            AtomicThreadFence();
+            i64 b = AtomicLoad(&bottom);
+            if (t >= b)
+            {
+                return false;
+            }
+            *result = jobs[t & mask];
+            return AtomicCompareExchange(&top, t, t + 1);
+        }
+    };
+
+    struct JobWorkerArgs
+    {
+        JobSystemImpl *system;
+        i64 index;
+    };
+
+    typedef struct JobSystemImpl
+    {
+        IAllocator allocator;
+        usize workerCount;
+        Thread *threads;
+        JobDeque *deques;
+        JobWorkerArgs *workerArgs;
+
+        //threads outside the pool cannot touch a worker's deque, so they submit here instead
+        ThreadLock injectedLock;
+        collections::queue<Job> injected;
+        volatile i64 injectedCount;
+
+        //jobs queued but not yet picked up, used to decide whether idle workers may sleep
+        volatile i64 pendingCount;
+        volatile i64 sleepingCount;
+        volatile i64 shuttingDown;
+        ConditionVariable wakeSignal;
+    } JobSystemImpl;
+
+    thread_local JobSystemImpl *currentJobSystem = NULL;
+    thread_local i64 currentJobWorker = -1;
+
+    inline void ExecuteJob(Job job)
+    {
+        job.func(job.data);
+        if (job.counter != NULL)
+        {
+            AtomicFetchAdd(&job.counter->value, (i64)-1);
+        }
+    }
+
+    bool JobSystem_ShouldSleep(void *context)
+    {
+        JobSystemImpl *system = (JobSystemImpl *)context;
+        return AtomicLoad(&system->pendingCount) <= 0 && AtomicLoad(&system->shuttingDown) == 0;
+    }
+
+    void JobSystem_Wake(JobSystemImpl *system, usize count)
+    {
+        if (AtomicLoad(&system->sleepingCount) > 0)
+        {
+            if (count > 1)
+            {
+                SetAllSignalled(system->wakeSignal);
+            }
+            else
+            {
+                SetSignalled(system->wakeSignal);
+            }
+        }
+    }
+
+    //Looks for a job in the worker's own deque, then the injection queue, then the other workers' deques
+    bool JobSystem_FindJob(JobSystemImpl *system, i64 workerIndex, Job *result)
+    {
+        if (workerIndex >= 0 && system->deques[workerIndex].Pop(result))
+        {
+            AtomicFetchAdd(&system->pendingCount, (i64)-1);
+            return true;
+        }
+        if (AtomicLoad(&system->injectedCount) > 0)
+        {
+            LockThreadLock(system->injectedLock);
+            bool found = false;
+            if (system->injected.count > 0)
+            {
+                *result = system->injected.Dequeue();
+                AtomicFetchAdd(&system->injectedCount, (i64)-1);
+                found = true;
+            }
+            UnlockThreadLock(system->injectedLock);
+            if (found)
+            {
+                AtomicFetchAdd(&system->pendingCount, (i64)-1);
+                return true;
+            }
+        }
+        //start at the next worker along so that thieves spread out instead of all hitting worker 0
+        usize start = workerIndex >= 0 ? (usize)workerIndex + 1 : 0;
+        for (usize i = 0; i < system->workerCount; i++)
+        {
+            usize victim = (start + i) % system->workerCount;
+            if ((i64)victim == workerIndex)
+            {
+                continue;
+            }
+            if (system->deques[victim].Steal(result))
+            {
+                AtomicFetchAdd(&system->pendingCount, (i64)-1);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    THREAD_RESULT JobSystem_WorkerMain(void *args)
+    {
+        JobWorkerArgs *workerArgs = (JobWorkerArgs *)args;
+        JobSystemImpl *system = workerArgs->system;
+        currentJobSystem = system;
+        currentJobWorker = workerArgs->index;
+
+        u32 idleSpins = 0;
+        while (AtomicLoad(&system->shuttingDown) == 0)
+        {
+            Job job;
+            if (JobSystem_FindJob(system, workerArgs->index, &job))
+            {
+                ExecuteJob(job);
+                idleSpins = 0;
+                continue;
+            }
+            idleSpins++;
+            if (idleSpins < JOBS_IDLE_SPINS)
+            {
+                SpinPause();
+                continue;
+            }
+            idleSpins = 0;
+            AtomicFetchAdd(&system->sleepingCount, (i64)1);
+            AwaitSignalledIf(system->wakeSignal, &JobSystem_ShouldSleep, system, JOBS_SLEEP_TIMEOUT);
+            AtomicFetchAdd(&system->sleepingCount, (i64)-1);
+        }
+        return 0;
+    }
+
+    JobSystem CreateJobSystem(IAllocator allocator, usize workerCount)
+    {
+        if (workerCount == 0)
+        {
+            u32 hardwareThreads = GetHardwareThreadCount();
+            workerCount = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+        }
+        JobSystemImpl *system = (JobSystemImpl *)allocator.Allocate(sizeof(JobSystemImpl));
+        system->allocator = allocator;
+        system->workerCount = workerCount;
+        system->injectedLock = CreateThreadLock();
+        system->injected = collections::queue<Job>(allocator);
+        system->injectedCount = 0;
+        system->pendingCount = 0;
+        system->sleepingCount = 0;
+        system->shuttingDown = 0;
+        system->wakeSignal = CreateConditionVariable();
+
+        system->deques = (JobDeque *)allocator.Allocate(sizeof(JobDeque) * workerCount);
+        system->workerArgs = (JobWorkerArgs *)allocator.Allocate(sizeof(JobWorkerArgs) * workerCount);
+        system->threads = (Thread *)allocator.Allocate(sizeof(Thread) * workerCount);
+        for (usize i = 0; i < workerCount; i++)
+        {
+            system->deques[i].top = 0;
+            system->deques[i].bottom = 0;
+            system->deques[i].jobs = (Job *)allocator.Allocate(sizeof(Job) * JOBS_DEQUE_CAPACITY);
+            system->deques[i].mask = JOBS_DEQUE_CAPACITY - 1;
+            system->workerArgs[i].system = system;
+            system->workerArgs[i].index = (i64)i;
+        }
+        //only start the threads once every deque exists, as workers steal from each other straight away
+        for (usize i = 0; i < workerCount; i++)
+        {
+            system->threads[i] = StartThread(&JobSystem_WorkerMain, &system->workerArgs[i]);
+        }
+        return system;
+    }
+    void DestroyJobSystem(JobSystem system)
+    {
+        if (system == NULL)
+        {
+            return;
+        }
+        AtomicStore(&system->shuttingDown, (i64)1);
+        SetAllSignalled(system->wakeSignal);
+        for (usize i = 0; i < system->workerCount; i++)
+        {
+            JoinThread(system->threads[i]);
+        }
+        IAllocator allocator = system->allocator;
+        for (usize i = 0; i < system->workerCount; i++)
+        {
+            allocator.Free(system->deques[i].jobs);
+        }
+        allocator.Free(system->deques);
+        allocator.Free(system->workerArgs);
+        allocator.Free(system->threads);
+        system->injected.deinit();
+        DestroyThreadLock(system->injectedLock);
+        DestroyConditionVariable(system->wakeSignal);
+        allocator.FREEPTR(system);
+    }
+    usize GetWorkerCount(JobSystem system)
+    {
+        return system->workerCount;
+    }
+    i64 GetCurrentWorkerIndex(JobSystem system)
+    {
+        return currentJobSystem == system ? currentJobWorker : -1;
+    }
+
+    void RunJobs(JobSystem system, Job *jobs, usize count, JobCounter *counter)
+    {
+        if (count == 0)
+        {
+            return;
+        }
+        if (counter != NULL)
+        {
+            AtomicFetchAdd(&counter->value, (i64)count);
+        }
+        i64 workerIndex = GetCurrentWorkerIndex(system);
+        if (workerIndex >= 0)
+        {
+            JobDeque *deque = &system->deques[workerIndex];
+            for (usize i = 0; i < count; i++)
+            {
+                Job job = jobs[i];
+                job.counter = counter;
+                AtomicFetchAdd(&system->pendingCount, (i64)1);
+                if (!deque->Push(job))
+                {
+                    //deque is full, run it here rather than growing
+                    AtomicFetchAdd(&system->pendingCount, (i64)-1);
+                    ExecuteJob(job);
+                }
+            }
+        }
+        else
+        {
+            LockThreadLock(system->injectedLock);
+            for (usize i = 0; i < count; i++)
+            {
+                Job job = jobs[i];
+                job.counter = counter;
+                system->injected.Enqueue(job);
+            }
+            AtomicFetchAdd(&system->injectedCount, (i64)count);
+            AtomicFetchAdd(&system->pendingCount, (i64)count);
+            UnlockThreadLock(system->injectedLock);
+        }
+        JobSystem_Wake(system, count);
+    }
+
+    struct JobContinuation
+    {
+        JobSystemImpl *system;
+        JobCounter *counter;
+        JobCounter *dependency;
+        usize count;
+        Job *jobs;
+    };
+    void JobContinuation_Run(void *data)
+    {
+        JobContinuation *continuation = (JobContinuation *)data;
+        JobSystemImpl *system = continuation->system;
+        WaitForCounter(system, continuation->dependency);
+
+        //this job itself holds one count on the counter until it returns, so the counter
+        //cannot reach zero between here and the jobs being queued
+        RunJobs(system, continuation->jobs, continuation->count, continuation->counter);
+        system->allocator.FREEPTR(continuation);
+    }
+    void RunJobsAfter(JobSystem system, Job *jobs, usize count, JobCounter *counter, JobCounter *dependency)
+    {
+        if (dependency == NULL || dependency->IsDone())
+        {
+            RunJobs(system, jobs, count, counter);
+            return;
+        }
+        if (count == 0)
+        {
+            return;
+        }
+        //the continuation and its copy of the jobs share one allocation
+        JobContinuation *continuation = (JobContinuation *)system->allocator.Allocate(sizeof(JobContinuation) + sizeof(Job) * count);
+        continuation->system = system;
+        continuation->counter = counter;
+        continuation->dependency = dependency;
+        continuation->count = count;
+        continuation->jobs = (Job *)(continuation + 1);
+        for (usize i = 0; i < count; i++)
+        {
+            continuation->jobs[i] = jobs[i];
+        }
+        Job gate = Job(&JobContinuation_Run, continuation);
+        RunJobs(system, &gate, 1, counter);
+    }
+    void WaitForCounter(JobSystem system, JobCounter *counter)
+    {
+        i64 workerIndex = GetCurrentWorkerIndex(system);
+        u32 idleSpins = 0;
+        while (!counter->IsDone())
+        {
+            Job job;
+            if (JobSystem_FindJob(system, workerIndex, &job))
+            {
+                ExecuteJob(job);
+                idleSpins = 0;
+            }
+            else if (idleSpins < JOBS_IDLE_SPINS)
+            {
+                idleSpins++;
+                SpinPause();
+            }
+            else
+            {
+                //the remaining jobs are running on other threads
+                YieldThread();
+            }
+        }
+    }
+
+    struct ParallelForRange
+    {
+        ParallelForFunc func;
+        void *data;
+        usize begin;
+        usize end;
+    };
+    void ParallelForRange_Run(void *data)
+    {
+        ParallelForRange *range = (ParallelForRange *)data;
+        range->func(range->data, range->begin, range->end);
+    }
+    void ParallelFor(JobSystem system, usize start, usize end, usize grainSize, ParallelForFunc func, void *data)
+    {
+        if (end <= start)
+        {
+            return;
+        }
+        usize length = end - start;
+        if (grainSize == 0)
+        {
+            //around 4 jobs per thread (including the caller) keeps everyone busy when ranges are uneven
+            usize targetJobs = (system->workerCount + 1) * 4;
+            grainSize = (length + targetJobs - 1) / targetJobs;
+        }
+        usize jobCount = (length + grainSize - 1) / grainSize;
+        if (jobCount == 1)
+        {
+            func(data, start, end);
+            return;
+        }
+
+        //ranges and jobs share one allocation
+        ParallelForRange *ranges = (ParallelForRange *)system->allocator.Allocate((sizeof(ParallelForRange) + sizeof(Job)) * jobCount);
+        Job *jobs = (Job *)(ranges + jobCount);
+        for (usize i = 0; i < jobCount; i++)
+        {
+            ranges[i].func = func;
+            ranges[i].data = data;
+            ranges[i].begin = start + i * grainSize;
+            ranges[i].end = ranges[i].begin + grainSize < end ? ranges[i].begin + grainSize : end;
+            jobs[i] = Job(&ParallelForRange_Run, &ranges[i]);
+        }
+        JobCounter counter = JobCounter();
+        RunJobs(system, jobs, jobCount, &counter);
+        WaitForCounter(system, &counter);
+        system->allocator.Free(ranges);
+    }
+}
+
+#endif
@@ -0,0 +1,230 @@
+#pragma once
+#include "Linxc.h"
+#include "sorting.hpp"
+#include "jobs.hpp"
+
+//arrays smaller than this are not worth splitting across threads
+#define SORT_PARALLEL_THRESHOLD 16384
+
+//Number of elements of a that come before output index k when stably merging a and b
+template<typename T>
+usize Sort_MergeSplit(T* a, usize leftLength, T* b, usize rightLength, usize k, i8(*comparator)(T&, T&))
+{
+    usize lo = k > rightLength ? k - rightLength : 0;
+    usize hi = k < leftLength ? k : leftLength;
+    while (lo < hi)
+    {
+        usize i = lo + ((hi - lo) >> 1);
+        usize j = k - i;
+        if (j > 0 && comparator(a[i], b[j - 1]) <= 0)
+        {
+            lo = i + 1;
+        }
+        else
+        {
+            hi = i;
+        }
+    }
+    return lo;
+}
+
+template<typename T>
+struct ParallelSortContext
+{
+    i8(*comparator)(T&, T&);
+    T* source;
+    T* destination;
+    usize arrayLength;
+    usize blockCount;
+    //size of the sorted blocks being merged pairwise this pass
+    usize blockLength;
+    //number of pieces each merged pair is split into
+    usize piecesPerPair;
+};
+template<typename T>
+void ParallelSort_SortBlocks(void* data, usize begin, usize end)
+{
+    ParallelSortContext<T>* context = (ParallelSortContext<T>*)data;
+    for (usize block = begin; block < end; block++)
+    {
+        usize start = block * context->blockLength;
+        if (start >= context->arrayLength)
+        {
+            continue;
+        }
+        usize stop = start + context->blockLength < context->arrayLength ? start + context->blockLength : context->arrayLength;
+        //each block borrows the matching section of the scratch buffer
+        TimSort(context->source + start, stop - start, context->comparator, context->destination + start);
+    }
+}
+template<typename T>
+void ParallelSort_MergePieces(void* data, usize begin, usize end)
+{
+    ParallelSortContext<T>* context = (ParallelSortContext<T>*)data;
+    for (usize piece = begin; piece < end; piece++)
+    {
+        usize pair = piece / context->piecesPerPair;
+        usize pieceIndex = piece % context->piecesPerPair;
+
+        usize leftStart = pair * context->blockLength * 2;
+        if (leftStart >= context->arrayLength)
+        {
+            continue;
+        }
+        usize rightStart = leftStart + context->blockLength < context->arrayLength ? leftStart + context->blockLength : context->arrayLength;
+        usize rightEnd = rightStart + context->blockLength < context->arrayLength ? rightStart + context->blockLength : context->arrayLength;
+        T* a = context->source + leftStart;
+        T* b = context->source + rightStart;
+        usize leftLength = rightStart - leftStart;
+        usize rightLength = rightEnd - rightStart;
+        usize total = leftLength + rightLength;
+
+        //split the output evenly, then find where each split falls in a and b
+        usize outputStart = total * pieceIndex / context->piecesPerPair;
+        usize outputEnd = total * (pieceIndex + 1) / context->piecesPerPair;
+        usize i0 = Sort_MergeSplit(a, leftLength, b, rightLength, outputStart, context->comparator);
+        usize i1 = Sort_MergeSplit(a, leftLength, b, rightLength, outputEnd, context->comparator);
+        usize j0 = outputStart - i0;
+        usize j1 = outputEnd - i1;
+        usize minGallop = SORT_MIN_GALLOP;
+        Sort_MergeForward(a + i0, i1 - i0, b + j0, j1 - j0, context->destination + leftStart + outputStart, &minGallop, context->comparator);
+    }
+}
+template<typename T>
+void ParallelSort_Copy(void* data, usize begin, usize end)
+{
+    ParallelSortContext<T>* context = (ParallelSortContext<T>*)data;
+    for (usize i = begin; i < end; i++)
+    {
+        context->destination[i] = context->source[i];
+    }
+}
+
+/// @brief Stable sort spread across the job system's threads. Blocks are TimSorted in parallel, then merged
+/// pairwise, with every pairwise merge also split between threads so that the last passes still use all of them
+/// @param scratch buffer of at least arrayLength elements
+template<typename T>
+void ParallelTimSort(threading::JobSystem system, T* array, usize arrayLength, i8(*comparator)(T&, T&), T* scratch)
+{
+    usize threadCount = threading::GetWorkerCount(system) + 1;
+    if (arrayLength < SORT_PARALLEL_THRESHOLD || threadCount < 2)
+    {
+        TimSort(array, arrayLength, comparator, scratch);
+        return;
+    }
+    usize blockCount = 1;
+    while (blockCount < threadCount && arrayLength / (blockCount * 2) >= SORT_PARALLEL_THRESHOLD / 4)
+    {
+        blockCount *= 2;
+    }
+
+    ParallelSortContext<T> context;
+    context.comparator = comparator;
+    context.source = array;
+    context.destination = scratch;
+    context.arrayLength = arrayLength;
+    context.blockCount = blockCount;
+    context.blockLength = (arrayLength + blockCount - 1) / blockCount;
+    context.piecesPerPair = 1;
+    threading::ParallelFor(system, 0, blockCount, 1, &ParallelSort_SortBlocks<T>, &context);
+
+    //merge pairs of blocks back and forth between array and scratch
+    usize pairCount = blockCount / 2;
+    while (pairCount > 0)
+    {
+        context.piecesPerPair = (threadCount * 2 + pairCount - 1) / pairCount;
+        threading::ParallelFor(system, 0, pairCount * context.piecesPerPair, 1, &ParallelSort_MergePieces<T>, &context);
+        T* temp = context.source;
+        context.source = context.destination;
+        context.destination = temp;
+        context.blockLength *= 2;
+        pairCount /= 2;
+    }
+    if (context.source != array)
+    {
+        context.destination = array;
+        threading::ParallelFor(system, 0, arrayLength, 0, &ParallelSort_Copy<T>, &context);
+    }
+}
+/// @brief Parallel stable sort, allocating the scratch buffer once from scratchAllocator
+template<typename T>
+void ParallelTimSort(threading::JobSystem system, T* array, usize arrayLength, i8(*comparator)(T&, T&), IAllocator scratchAllocator)
+{
+    if (arrayLength < 2)
+        return;
+    T* scratch = (T*)scratchAllocator.Allocate(sizeof(T) * arrayLength);
+    ParallelTimSort(system, array, arrayLength, comparator, scratch);
+    scratchAllocator.Free(scratch);
+}
+
+template<typename T, typename KeyExtractor>
+struct ParallelRadixContext
+{
+    T* array;
+    usize length;
+    usize chunkLength;
+    usize countsLength;
+    KeyExtractor* extractor;
+    //countsLength counters for every chunk
+    usize* chunkCounts;
+};
+template<usize DigitBits, typename T, typename KeyExtractor>
+void ParallelRadix_CountChunks(void* data, usize begin, usize end)
+{
+    ParallelRadixContext<T, KeyExtractor>* context = (ParallelRadixContext<T, KeyExtractor>*)data;
+    for (usize chunk = begin; chunk < end; chunk++)
+    {
+        usize start = chunk * context->chunkLength;
+        usize stop = start + context->chunkLength < context->length ? start + context->chunkLength : context->length;
+        usize* counts = context->chunkCounts + chunk * context->countsLength;
+        memset(counts, 0, sizeof(usize) * context->countsLength);
+        if (start < stop)
+        {
+            RadixSort_Histogram<DigitBits>(context->array, start, stop, context->extractor, counts);
+        }
+    }
+}
+
+/// @brief RadixSort with the counting pass split across the job system's threads. The scatter passes
+/// stay on the calling thread since each one depends on the order left by the previous one
+template<usize DigitBits = 8, typename T, typename KeyExtractor>
+void ParallelRadixSort(threading::JobSystem system, T* array, usize length, KeyExtractor extractor, IAllocator scratchAllocator, T* scratch = NULL)
+{
+    usize chunkCount = threading::GetWorkerCount(system) + 1;
+    if (length < SORT_PARALLEL_THRESHOLD || chunkCount < 2)
+    {
+        RadixSort<DigitBits>(array, length, extractor, scratchAllocator, scratch);
+        return;
+    }
+    ParallelRadixContext<T, KeyExtractor> context;
+    context.array = array;
+    context.length = length;
+    context.chunkLength = (length + chunkCount - 1) / chunkCount;
+    context.countsLength = RadixSort_CountsLength(array, &extractor, DigitBits);
+    context.extractor = &extractor;
+    context.chunkCounts = (usize*)scratchAllocator.Allocate(sizeof(usize) * context.countsLength * chunkCount);
+    threading::ParallelFor(system, 0, chunkCount, 1, &ParallelRadix_CountChunks<DigitBits, T, KeyExtractor>, &context);
+
+    //fold every chunk's histograms into the first
+    usize* counts = context.chunkCounts;
+    for (usize chunk = 1; chunk < chunkCount; chunk++)
+    {
+        usize* chunkCounts = context.chunkCounts + chunk * context.countsLength;
+        for (usize i = 0; i < context.countsLength; i++)
+        {
+            counts[i] += chunkCounts[i];
+        }
+    }
+
+    bool ownsScratch = scratch == NULL;
+    if (ownsScratch)
+    {
+        scratch = (T*)scratchAllocator.Allocate(sizeof(T) * length);
+    }
+    RadixSort_Scatter<DigitBits>(array, length, scratch, &extractor, counts);
+    if (ownsScratch)
+    {
+        scratchAllocator.Free(scratch);
+    }
+    scratchAllocator.Free(context.chunkCounts);
+}
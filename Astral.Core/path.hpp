@@ -138,4 +138,63 @@ namespace path
         path.deinit();
         return result;
     }
+    //Matches a file name against a pattern in which * stands for any run of characters and ? for any one character.
+    //The pattern may list several alternatives separated by ;, such as "*.png;*.json". Matching is case sensitive
+    inline bool MatchesPattern(const char *pattern, const char *fileName)
+    {
+        const char *alternative = pattern;
+        while (true)
+        {
+            const char *p = alternative;
+            const char *n = fileName;
+            //where to resume from when what followed the last * stops matching
+            const char *starPattern = NULL;
+            const char *starName = NULL;
+            bool matched;
+            while (true)
+            {
+                if (*p == '*')
+                {
+                    p++;
+                    starPattern = p;
+                    starName = n;
+                    continue;
+                }
+                bool patternEnded = *p == '\0' || *p == ';';
+                if (*n == '\0')
+                {
+                    matched = patternEnded;
+                    break;
+                }
+                if (!patternEnded && (*p == '?' || *p == *n))
+                {
+                    p++;
+                    n++;
+                    continue;
+                }
+                if (starPattern == NULL)
+                {
+                    matched = false;
+                    break;
+                }
+                //let the last * take one more character, and try again from there
+                starName++;
+                p = starPattern;
+                n = starName;
+            }
+            if (matched)
+            {
+                return true;
+            }
+            while (*alternative != '\0' && *alternative != ';')
+            {
+                alternative++;
+            }
+            if (*alternative == '\0')
+            {
+                return false;
+            }
+            alternative++;
+        }
+    }
 }
\ No newline at end of file
@@ -106,6 +106,32 @@ namespace collections
             }
             return &items[firstItemIndex];
         }
+        //the item index places behind the front, where 0 is what Peek returns
+        T *PeekAt(usize index)
+        {
+            if (index >= count)
+            {
+                return NULL;
+            }
+            return &items[(firstItemIndex + index) % capacity];
+        }
+        //removes the item index places behind the front, moving those ahead of it back to close the gap
+        T DequeueAt(usize index)
+        {
+            if (index >= count)
+            {
+                return T();
+            }
+            T removed = items[(firstItemIndex + index) % capacity];
+            for (usize i = index; i > 0; i--)
+            {
+                items[(firstItemIndex + i) % capacity] = items[(firstItemIndex + i - 1) % capacity];
+            }
+            items[firstItemIndex] = T();
+            firstItemIndex = (firstItemIndex + 1) % capacity;
+            count--;
+            return removed;
+        }
         void Clear()
         {
             count = 0;
@@ -3,62 +3,344 @@
 #include "array.hpp"
 #include "assert.h"
 #include "Maths/Util.hpp"
+#include <string.h>
 
 #define SORT_SUBARRAY_SIZE 32
+//runs of fewer than this many elements are extended with binary insertion sort before merging
+#define SORT_MIN_MERGE 32
+//initial number of consecutive wins from one run before a merge switches to galloping
+#define SORT_MIN_GALLOP 7
+//large enough for any array that fits in memory, see listsort.txt in CPython
+#define SORT_MAX_RUNS 85
 
 template<typename T>
 void InsertionSort(T* array, usize left, usize right, i8(*comparator)(T&, T&))
 {
-    for (i64 i = left + 1; i <= right; i++) 
+    for (i64 i = (i64)left + 1; i <= (i64)right; i++) 
     { 
         T temp = array[i]; 
         i64 j = i - 1; 
-        while (j >= left && comparator(array[j], temp) > 0) 
+        while (j >= (i64)left && comparator(array[j], temp) > 0) 
         { 
             array[j + 1] = array[j]; 
             j--;
-            if (j == -1) //WHY IS THIS NEEDED?
-            {
-                break;
-            }
         }
         array[j + 1] = temp; 
     }
 }
 
+//Returns the index in array[0..length) that key would be inserted at to go before any equal elements.
+//Searches outwards from hint first, so runs of matches near hint are found in O(log distance)
 template<typename T>
-void MergeSort(T* array, i64 left, i64 mid, i64 right, i8(*comparator)(T&, T&))
-{
-    i64 leftArrLength = mid - left + 1;
-    i64 rightArrLength = right - mid;
-    //Original array is broken into two parts: left and right subarray
-    collections::Array<T> leftArr = collections::Array<T>(GetCAllocator(), leftArrLength);
-    collections::Array<T> rightArr = collections::Array<T>(GetCAllocator(), rightArrLength);
-
-    //Fill in the subarrays
-    for (i64 index = 0; index < leftArrLength; index++)
-        leftArr.data[index] = array[left + index];
-    for (i64 index = 0; index < rightArrLength; index++)
-        rightArr.data[index] = array[mid + 1 + index];
-
-    //Merge the subarrays after comparing
-    int i = 0, j = 0, k = left;
-    while (i < leftArrLength && j < rightArrLength)
-    {
-        if (comparator(leftArr.data[i], rightArr.data[j]) <= 0)//(leftArr[i]?.CompareTo(rightArr[j]) ?? 0) <= 0)
-            array[k++] = leftArr.data[i++];
+usize Sort_GallopLeft(T& key, T* array, usize length, usize hint, i8(*comparator)(T&, T&))
+{
+    i64 lastOffset = 0;
+    i64 offset = 1;
+    if (comparator(key, array[hint]) > 0)
+    {
+        //array[hint] < key, gallop towards the end
+        i64 maxOffset = (i64)(length - hint);
+        while (offset < maxOffset && comparator(key, array[hint + offset]) > 0)
+        {
+            lastOffset = offset;
+            offset = offset * 2 + 1;
+        }
+        if (offset > maxOffset)
+        {
+            offset = maxOffset;
+        }
+        lastOffset += (i64)hint;
+        offset += (i64)hint;
+    }
+    else
+    {
+        //key <= array[hint], gallop towards the start
+        i64 maxOffset = (i64)hint + 1;
+        while (offset < maxOffset && comparator(key, array[hint - offset]) <= 0)
+        {
+            lastOffset = offset;
+            offset = offset * 2 + 1;
+        }
+        if (offset > maxOffset)
+        {
+            offset = maxOffset;
+        }
+        i64 temp = lastOffset;
+        lastOffset = (i64)hint - offset;
+        offset = (i64)hint - temp;
+    }
+    //array[lastOffset] < key <= array[offset], binary search the gap
+    lastOffset++;
+    while (lastOffset < offset)
+    {
+        i64 middle = lastOffset + ((offset - lastOffset) >> 1);
+        if (comparator(key, array[middle]) > 0)
+        {
+            lastOffset = middle + 1;
+        }
         else
-            array[k++] = rightArr.data[j++];
+        {
+            offset = middle;
+        }
+    }
+    return (usize)offset;
+}
+//Like Sort_GallopLeft, but returns the index after any elements equal to key
+template<typename T>
+usize Sort_GallopRight(T& key, T* array, usize length, usize hint, i8(*comparator)(T&, T&))
+{
+    i64 lastOffset = 0;
+    i64 offset = 1;
+    if (comparator(key, array[hint]) < 0)
+    {
+        i64 maxOffset = (i64)hint + 1;
+        while (offset < maxOffset && comparator(key, array[hint - offset]) < 0)
+        {
+            lastOffset = offset;
+            offset = offset * 2 + 1;
+        }
+        if (offset > maxOffset)
+        {
+            offset = maxOffset;
+        }
+        i64 temp = lastOffset;
+        lastOffset = (i64)hint - offset;
+        offset = (i64)hint - temp;
+    }
+    else
+    {
+        i64 maxOffset = (i64)(length - hint);
+        while (offset < maxOffset && comparator(key, array[hint + offset]) >= 0)
+        {
+            lastOffset = offset;
+            offset = offset * 2 + 1;
+        }
+        if (offset > maxOffset)
+        {
+            offset = maxOffset;
+        }
+        lastOffset += (i64)hint;
+        offset += (i64)hint;
     }
+    lastOffset++;
+    while (lastOffset < offset)
+    {
+        i64 middle = lastOffset + ((offset - lastOffset) >> 1);
+        if (comparator(key, array[middle]) < 0)
+        {
+            offset = middle;
+        }
+        else
+        {
+            lastOffset = middle + 1;
+        }
+    }
+    return (usize)offset;
+}
 
-    //Copy any remaining elements left, if any
-    while (i < leftArrLength)
-        array[k++] = leftArr.data[i++];
-    while (j < rightArrLength)
-        array[k++] = rightArr.data[j++];
+//Stable merge of the sorted runs a and b into output, front to back. output must either not overlap
+//a or b, or be exactly b - leftLength (merging in place with a copied out to scratch).
+//Switches to galloping once one run wins minGallop times in a row, which makes merging
+//partially ordered data close to a pair of memcpys. minGallop is adjusted to how well galloping pays off
+template<typename T>
+void Sort_MergeForward(T* a, usize leftLength, T* b, usize rightLength, T* output, usize* minGallop, i8(*comparator)(T&, T&))
+{
+    usize i = 0;
+    usize j = 0;
+    usize k = 0;
+    while (i < leftLength && j < rightLength)
+    {
+        usize leftWins = 0;
+        usize rightWins = 0;
+        while (i < leftLength && j < rightLength)
+        {
+            if (comparator(b[j], a[i]) < 0)
+            {
+                output[k++] = b[j++];
+                rightWins++;
+                leftWins = 0;
+                if (rightWins >= *minGallop)
+                {
+                    break;
+                }
+            }
+            else
+            {
+                output[k++] = a[i++];
+                leftWins++;
+                rightWins = 0;
+                if (leftWins >= *minGallop)
+                {
+                    break;
+                }
+            }
+        }
+        if (i >= leftLength || j >= rightLength)
+        {
+            break;
+        }
+        while (true)
+        {
+            //everything in a up to and including elements equal to b[j] goes first
+            leftWins = Sort_GallopRight(b[j], a + i, leftLength - i, 0, comparator);
+            for (usize n = 0; n < leftWins; n++)
+            {
+                output[k++] = a[i++];
+            }
+            if (i >= leftLength)
+            {
+                break;
+            }
+            rightWins = Sort_GallopLeft(a[i], b + j, rightLength - j, 0, comparator);
+            for (usize n = 0; n < rightWins; n++)
+            {
+                output[k++] = b[j++];
+            }
+            if (j >= rightLength)
+            {
+                break;
+            }
+            if (*minGallop > 1)
+            {
+                *minGallop -= 1;
+            }
+            if (leftWins < SORT_MIN_GALLOP && rightWins < SORT_MIN_GALLOP)
+            {
+                break;
+            }
+        }
+        //galloping stopped paying off, make it harder to get back into
+        *minGallop += 2;
+    }
+    while (i < leftLength)
+    {
+        output[k++] = a[i++];
+    }
+    if (output + k != b + j)
+    {
+        while (j < rightLength)
+        {
+            output[k++] = b[j++];
+        }
+    }
+}
+//Stable merge of the sorted runs a and b into output, back to front. output must either not overlap
+//a or b, or be exactly a (merging in place with b copied out to scratch)
+template<typename T>
+void Sort_MergeBackward(T* a, usize leftLength, T* b, usize rightLength, T* output, usize* minGallop, i8(*comparator)(T&, T&))
+{
+    usize i = leftLength;
+    usize j = rightLength;
+    usize k = leftLength + rightLength;
+    while (i > 0 && j > 0)
+    {
+        usize leftWins = 0;
+        usize rightWins = 0;
+        while (i > 0 && j > 0)
+        {
+            if (comparator(b[j - 1], a[i - 1]) < 0)
+            {
+                output[--k] = a[--i];
+                leftWins++;
+                rightWins = 0;
+                if (leftWins >= *minGallop)
+                {
+                    break;
+                }
+            }
+            else
+            {
+                output[--k] = b[--j];
+                rightWins++;
+                leftWins = 0;
+                if (rightWins >= *minGallop)
+                {
+                    break;
+                }
+            }
+        }
+        if (i == 0 || j == 0)
+        {
+            break;
+        }
+        while (true)
+        {
+            //everything in a greater than b[j - 1] goes last
+            leftWins = i - Sort_GallopRight(b[j - 1], a, i, i - 1, comparator);
+            for (usize n = 0; n < leftWins; n++)
+            {
+                output[--k] = a[--i];
+            }
+            if (i == 0)
+            {
+                break;
+            }
+            rightWins = j - Sort_GallopLeft(a[i - 1], b, j, j - 1, comparator);
+            for (usize n = 0; n < rightWins; n++)
+            {
+                output[--k] = b[--j];
+            }
+            if (j == 0)
+            {
+                break;
+            }
+            if (*minGallop > 1)
+            {
+                *minGallop -= 1;
+            }
+            if (leftWins < SORT_MIN_GALLOP && rightWins < SORT_MIN_GALLOP)
+            {
+                break;
+            }
+        }
+        *minGallop += 2;
+    }
+    while (j > 0)
+    {
+        output[--k] = b[--j];
+    }
+    if (output != a)
+    {
+        while (i > 0)
+        {
+            output[--k] = a[--i];
+        }
+    }
+}
 
-    leftArr.deinit();
-    rightArr.deinit();
+//Merges the sorted ranges array[left..mid] and array[mid + 1..right] (inclusive).
+//scratch must hold at least the smaller of the two ranges. Pass NULL to have one allocated
+template<typename T>
+void MergeSort(T* array, i64 left, i64 mid, i64 right, i8(*comparator)(T&, T&), T* scratch = NULL)
+{
+    usize leftLength = (usize)(mid - left + 1);
+    usize rightLength = (usize)(right - mid);
+    usize minGallop = SORT_MIN_GALLOP;
+    bool ownsScratch = scratch == NULL;
+    if (ownsScratch)
+    {
+        scratch = (T*)GetCAllocator().Allocate(sizeof(T) * (leftLength <= rightLength ? leftLength : rightLength));
+    }
+    if (leftLength <= rightLength)
+    {
+        for (usize i = 0; i < leftLength; i++)
+        {
+            scratch[i] = array[left + i];
+        }
+        Sort_MergeForward(scratch, leftLength, array + mid + 1, rightLength, array + left, &minGallop, comparator);
+    }
+    else
+    {
+        for (usize i = 0; i < rightLength; i++)
+        {
+            scratch[i] = array[mid + 1 + i];
+        }
+        Sort_MergeBackward(array + left, leftLength, scratch, rightLength, array + left, &minGallop, comparator);
+    }
+    if (ownsScratch)
+    {
+        GetCAllocator().Free(scratch);
+    }
 }
 
 template<typename T>
@@ -101,42 +383,388 @@ void BitonicSort(T* array, usize arrayLength)
     }
 }
 
-//32 is used as a compromize between fast Insertion Sorts and fewer merges
-//A power of two is used for the most efficiency, since the resulting arrays will also be powers of two (unless the array length isn't, then the last one will just be the remainder.)
-//Insertion Sort is very efficient with small arrays, but not with large arrays.  A value of 64 or higher results in slower initial sorting, but faster merging
-//A value of 16 or lower results in faster initial sorting, but slower merging since more merging has to be done
-#define SUBARRAY_SIZE 32
+//Everything TimSort tracks while merging runs of one array
+template<typename T>
+struct TimSortState
+{
+    T* array;
+    T* scratch;
+    i8(*comparator)(T&, T&);
+    usize minGallop;
+    usize runCount;
+    usize runStarts[SORT_MAX_RUNS];
+    usize runLengths[SORT_MAX_RUNS];
 
-template<typename T> 
-void TimSort(T* array, usize arrayLength, i8(*comparator)(T&, T&))
+    //Finds the natural run starting at start, reversing it if it is strictly descending. Returns its length
+    usize CountRun(usize start, usize end)
+    {
+        usize runEnd = start + 1;
+        if (runEnd == end)
+        {
+            return 1;
+        }
+        if (comparator(array[runEnd], array[start]) < 0)
+        {
+            //strictly descending, so that reversing it keeps the sort stable
+            runEnd++;
+            while (runEnd < end && comparator(array[runEnd], array[runEnd - 1]) < 0)
+            {
+                runEnd++;
+            }
+            for (usize lo = start, hi = runEnd - 1; lo < hi; lo++, hi--)
+            {
+                T temp = array[lo];
+                array[lo] = array[hi];
+                array[hi] = temp;
+            }
+        }
+        else
+        {
+            runEnd++;
+            while (runEnd < end && comparator(array[runEnd], array[runEnd - 1]) >= 0)
+            {
+                runEnd++;
+            }
+        }
+        return runEnd - start;
+    }
+    //Sorts array[start..end) given that array[start..sortedEnd) is already sorted
+    void BinaryInsertionSort(usize start, usize end, usize sortedEnd)
+    {
+        for (usize i = sortedEnd; i < end; i++)
+        {
+            T pivot = array[i];
+            usize lo = start;
+            usize hi = i;
+            while (lo < hi)
+            {
+                usize middle = lo + ((hi - lo) >> 1);
+                if (comparator(pivot, array[middle]) < 0)
+                {
+                    hi = middle;
+                }
+                else
+                {
+                    lo = middle + 1;
+                }
+            }
+            for (usize j = i; j > lo; j--)
+            {
+                array[j] = array[j - 1];
+            }
+            array[lo] = pivot;
+        }
+    }
+    void MergeAt(usize index)
+    {
+        usize leftStart = runStarts[index];
+        usize leftLength = runLengths[index];
+        usize rightStart = runStarts[index + 1];
+        usize rightLength = runLengths[index + 1];
+
+        runLengths[index] = leftLength + rightLength;
+        if (index == runCount - 3)
+        {
+            runStarts[index + 1] = runStarts[index + 2];
+            runLengths[index + 1] = runLengths[index + 2];
+        }
+        runCount--;
+
+        //elements of the left run that are already <= the whole right run stay where they are
+        usize skip = Sort_GallopRight(array[rightStart], array + leftStart, leftLength, 0, comparator);
+        leftStart += skip;
+        leftLength -= skip;
+        if (leftLength == 0)
+        {
+            return;
+        }
+        //and so do elements of the right run that are >= the whole left run
+        rightLength = Sort_GallopLeft(array[leftStart + leftLength - 1], array + rightStart, rightLength, rightLength - 1, comparator);
+        if (rightLength == 0)
+        {
+            return;
+        }
+        if (leftLength <= rightLength)
+        {
+            for (usize i = 0; i < leftLength; i++)
+            {
+                scratch[i] = array[leftStart + i];
+            }
+            Sort_MergeForward(scratch, leftLength, array + rightStart, rightLength, array + leftStart, &minGallop, comparator);
+        }
+        else
+        {
+            for (usize i = 0; i < rightLength; i++)
+            {
+                scratch[i] = array[rightStart + i];
+            }
+            Sort_MergeBackward(array + leftStart, leftLength, scratch, rightLength, array + leftStart, &minGallop, comparator);
+        }
+    }
+    //Merges runs until the run lengths on the stack shrink faster than the fibonacci sequence,
+    //which keeps merges balanced and bounds the stack depth
+    void MergeCollapse()
+    {
+        while (runCount > 1)
+        {
+            usize n = runCount - 2;
+            if ((n > 0 && runLengths[n - 1] <= runLengths[n] + runLengths[n + 1]) || (n > 1 && runLengths[n - 2] <= runLengths[n - 1] + runLengths[n]))
+            {
+                if (runLengths[n - 1] < runLengths[n + 1])
+                {
+                    n--;
+                }
+            }
+            else if (runLengths[n] > runLengths[n + 1])
+            {
+                break;
+            }
+            MergeAt(n);
+        }
+    }
+    void MergeForceCollapse()
+    {
+        while (runCount > 1)
+        {
+            usize n = runCount - 2;
+            if (n > 0 && runLengths[n - 1] < runLengths[n + 1])
+            {
+                n--;
+            }
+            MergeAt(n);
+        }
+    }
+};
+
+inline usize TimSort_MinRun(usize length)
+{
+    usize remainder = 0;
+    while (length >= 64)
+    {
+        remainder |= length & 1;
+        length >>= 1;
+    }
+    return length + remainder;
+}
+
+/// @brief Stable sort that finds the ascending and descending runs already in the data, extends
+/// short ones with binary insertion sort and merges them with galloping merges
+/// @param scratch buffer of at least arrayLength / 2 + 1 elements. All merges share it
+template<typename T>
+void TimSort(T* array, usize arrayLength, i8(*comparator)(T&, T&), T* scratch)
 {
     if (arrayLength < 2)
         return;
 
-    //Sort the subarrays using insertion sort
-    for (i64 i = 0; i < arrayLength; i += SUBARRAY_SIZE)
-        InsertionSort<T>(array, i, MIN(i + SUBARRAY_SIZE - 1, arrayLength - 1), comparator);
+    TimSortState<T> state;
+    state.array = array;
+    state.scratch = scratch;
+    state.comparator = comparator;
+    state.minGallop = SORT_MIN_GALLOP;
+    state.runCount = 0;
 
-    if (arrayLength <= SUBARRAY_SIZE)
+    usize minRun = TimSort_MinRun(arrayLength);
+    usize start = 0;
+    while (start < arrayLength)
+    {
+        usize runLength = state.CountRun(start, arrayLength);
+        if (runLength < minRun)
+        {
+            usize forced = arrayLength - start < minRun ? arrayLength - start : minRun;
+            state.BinaryInsertionSort(start, start + forced, start + runLength);
+            runLength = forced;
+        }
+        state.runStarts[state.runCount] = start;
+        state.runLengths[state.runCount] = runLength;
+        state.runCount++;
+        state.MergeCollapse();
+        start += runLength;
+    }
+    state.MergeForceCollapse();
+}
+/// @brief Stable TimSort, allocating the scratch buffer once from scratchAllocator
+template<typename T>
+void TimSort(T* array, usize arrayLength, i8(*comparator)(T&, T&), IAllocator scratchAllocator)
+{
+    if (arrayLength < 2)
         return;
+    T* scratch = (T*)scratchAllocator.Allocate(sizeof(T) * (arrayLength / 2 + 1));
+    TimSort(array, arrayLength, comparator, scratch);
+    scratchAllocator.Free(scratch);
+}
+template<typename T> 
+void TimSort(T* array, usize arrayLength, i8(*comparator)(T&, T&))
+{
+    TimSort(array, arrayLength, comparator, GetCAllocator());
+}
 
-    //Merge the subarrays
-    for (i64 size = SUBARRAY_SIZE; size < arrayLength; size *= 2)
+//Radix sort keys must be unsigned integers that order the same way as the values they stand for.
+//These map other types onto such keys
+inline u32 RadixKey_Signed32(i32 value)
+{
+    return (u32)value ^ 0x80000000u;
+}
+inline u64 RadixKey_Signed64(i64 value)
+{
+    return (u64)value ^ 0x8000000000000000llu;
+}
+//Positive floats only need their sign bit set, negative floats need every bit flipped
+//so that larger magnitudes sort lower. NaNs end up at either end depending on their sign
+inline u32 RadixKey_Float(float value)
+{
+    u32 bits;
+    memcpy(&bits, &value, sizeof(u32));
+    return bits ^ ((u32)(-(i32)(bits >> 31)) | 0x80000000u);
+}
+inline u64 RadixKey_Double(double value)
+{
+    u64 bits;
+    memcpy(&bits, &value, sizeof(u64));
+    return bits ^ ((u64)(-(i64)(bits >> 63)) | 0x8000000000000000llu);
+}
+
+//Key extractors for sorting plain arrays of numbers. To sort structs, write one with a Key
+//method that returns the field to sort by (converted with one of the RadixKey functions if needed)
+template<typename T>
+struct UnsignedRadixKey
+{
+    inline T Key(T &item)
     {
-        for (i64 left = 0; left < arrayLength; left += 2 * size)
-        {
-            i64 mid = left + size - 1;
-            i64 right = MIN(left + (2 * size) - 1, arrayLength - 1);
+        return item;
+    }
+};
+struct Signed32RadixKey
+{
+    inline u32 Key(i32 &item)
+    {
+        return RadixKey_Signed32(item);
+    }
+};
+struct Signed64RadixKey
+{
+    inline u64 Key(i64 &item)
+    {
+        return RadixKey_Signed64(item);
+    }
+};
+struct FloatRadixKey
+{
+    inline u32 Key(float &item)
+    {
+        return RadixKey_Float(item);
+    }
+};
+struct DoubleRadixKey
+{
+    inline u64 Key(double &item)
+    {
+        return RadixKey_Double(item);
+    }
+};
 
-            //Sanity check for if the left subarray is the final subarray
-            //'mid' ends up being greater than 'count' if this were the case, which causes problems in
-            //  Merge() which sets the length of the right subarray to 'right - mid'
-            if (mid >= arrayLength)
-                continue;
+//Adds every digit of the keys of array[begin..end) to counts, which holds one histogram per pass
+template<usize DigitBits, typename T, typename KeyExtractor>
+void RadixSort_Histogram(T* array, usize begin, usize end, KeyExtractor* extractor, usize* counts)
+{
+    typedef decltype(extractor->Key(*array)) K;
+    const usize passes = (sizeof(K) * 8 + DigitBits - 1) / DigitBits;
+    const usize buckets = (usize)1 << DigitBits;
+    const K mask = (K)(buckets - 1);
+    for (usize i = begin; i < end; i++)
+    {
+        K key = extractor->Key(array[i]);
+        for (usize pass = 0; pass < passes; pass++)
+        {
+            counts[pass * buckets + (usize)((key >> (pass * DigitBits)) & mask)]++;
+        }
+    }
+}
+//Runs the scatter passes once counts holds the histograms of the whole array
+template<usize DigitBits, typename T, typename KeyExtractor>
+void RadixSort_Scatter(T* array, usize length, T* scratch, KeyExtractor* extractor, usize* counts)
+{
+    typedef decltype(extractor->Key(*array)) K;
+    const usize passes = (sizeof(K) * 8 + DigitBits - 1) / DigitBits;
+    const usize buckets = (usize)1 << DigitBits;
+    const K mask = (K)(buckets - 1);
 
-            MergeSort<T>(array, left, mid, right, comparator);
+    T* source = array;
+    T* destination = scratch;
+    for (usize pass = 0; pass < passes; pass++)
+    {
+        usize* offsets = counts + pass * buckets;
+        //every key has the same digit here (common for the high digits of small keys), nothing would move
+        bool skip = false;
+        usize total = 0;
+        for (usize bucket = 0; bucket < buckets; bucket++)
+        {
+            usize count = offsets[bucket];
+            if (count == length)
+            {
+                skip = true;
+                break;
+            }
+            offsets[bucket] = total;
+            total += count;
+        }
+        if (skip)
+        {
+            continue;
         }
+        usize shift = pass * DigitBits;
+        for (usize i = 0; i < length; i++)
+        {
+            usize digit = (usize)((extractor->Key(source[i]) >> shift) & mask);
+            destination[offsets[digit]++] = source[i];
+        }
+        T* temp = source;
+        source = destination;
+        destination = temp;
+    }
+    if (source != array)
+    {
+        for (usize i = 0; i < length; i++)
+        {
+            array[i] = source[i];
+        }
+    }
+}
+//array and extractor are only used for their types, so that the key type is found without a null object
+template<typename T, typename KeyExtractor>
+inline usize RadixSort_CountsLength(T* array, KeyExtractor* extractor, usize digitBits)
+{
+    typedef decltype(extractor->Key(*array)) K;
+    return ((sizeof(K) * 8 + digitBits - 1) / digitBits) << digitBits;
+}
+
+/// @brief Stable least significant digit radix sort. Makes one pass over the array to count every digit,
+/// then one scatter pass per digit, skipping digits that are the same for every key.
+/// @param DigitBits bits per digit, usually 8, 11 or 16. Wider digits mean fewer passes but histograms that spill out of cache
+/// @param extractor has a Key(T&) method returning an unsigned integer key, see UnsignedRadixKey and FloatRadixKey
+/// @param scratch buffer of at least length elements, or NULL to have one allocated from scratchAllocator.
+/// The histograms are always allocated from scratchAllocator
+template<usize DigitBits = 8, typename T, typename KeyExtractor>
+void RadixSort(T* array, usize length, KeyExtractor extractor, IAllocator scratchAllocator, T* scratch = NULL)
+{
+    if (length < 2)
+        return;
+    usize countsLength = RadixSort_CountsLength(array, &extractor, DigitBits);
+    usize* counts = (usize*)scratchAllocator.Allocate(sizeof(usize) * countsLength);
+    memset(counts, 0, sizeof(usize) * countsLength);
+    bool ownsScratch = scratch == NULL;
+    if (ownsScratch)
+    {
+        scratch = (T*)scratchAllocator.Allocate(sizeof(T) * length);
+    }
+
+    RadixSort_Histogram<DigitBits>(array, 0, length, &extractor, counts);
+    RadixSort_Scatter<DigitBits>(array, length, scratch, &extractor, counts);
+
+    if (ownsScratch)
+    {
+        scratchAllocator.Free(scratch);
     }
+    scratchAllocator.Free(counts);
 }
 
 #define IMPL_COMPARATORS(nameOfType, compareVar) inline bool operator<(nameOfType &other) { return this->compareVar < other.compareVar;} inline bool operator>(nameOfType &other) { return this->compareVar > other.compareVar;} inline bool operator<=(nameOfType &other) { return this->compareVar <= other.compareVar;} inline bool operator>=(nameOfType &other) { return this->compareVar >= other.compareVar;} inline bool operator==(nameOfType &other) { return this->compareVar == other.compareVar;} inline bool operator!=(nameOfType &other) { return this->compareVar != other.compareVar;}
@@ -9,15 +9,8 @@
 #include "stdio.h"
 #include "math.h"
 #include "vector.hpp"
-
-inline const char* digits2(usize value)
-{
-    return &"0001020304050607080910111213141516171819"
-        "2021222324252627282930313233343536373839"
-        "4041424344454647484950515253545556575859"
-        "6061626364656667686970717273747576777879"
-        "8081828384858687888990919293949596979899"[value * 2];
-}
+#include "hash.hpp"
+#include "NumberFormat.hpp"
 
 #ifdef WINDOWS
 typedef wchar_t char_t;
@@ -120,7 +113,11 @@ struct string
     }
     inline string *Append(const char *other)
     {
-        usize otherLen = strlen(other);
+        return Append(other, strlen(other));
+    }
+    //appends the first otherLen characters of other, which need not be null terminated
+    inline string *Append(const char *other, usize otherLen)
+    {
         usize newLength = otherLen + this->length;
         if (this->length == 0)
         {
@@ -149,94 +146,24 @@ struct string
     }
     inline string *Append(i64 integer)
     {
-        //max integer is 19 characters, with - sign its 20
-        char chars[20];
-        chars[19] = '\0';
-        usize index = 19;
-        i64 positive = integer < 0 ? -integer : integer;
-        while (positive > 100)
-        {
-            index -= 2;
-            memcpy(chars + index, digits2(positive % 100), 2);
-            positive /= 100;
-        }
-        if (positive < 10)
-        {
-            index -= 1;
-            chars[index] = '0' + positive;
-
-            if (integer < 0)
-            {
-                index -= 1;
-                *(chars + index) = '-';
-            }
-            
-            return this->Append(chars + index);
-        }
-        index -= 2;
-        memcpy(chars + index, digits2(positive), 2);
-        if (integer < 0)
-        {
-            index -= 1;
-            *(chars + index) = '-';
-        }
-        return this->Append(chars + index);
+        char chars[NUMBER_FORMAT_MAX_INTEGER_LENGTH];
+        return this->Append(chars, FormatI64(chars, integer));
     }
     inline string *Append(u64 integer)
     {
-        //max integer is 20 characters
-        char chars[21];
-        chars[20] = '\0';
-        usize index = 20;
-        while (integer > 100)
-        {
-            index -= 2;
-            memcpy(chars + index, digits2(integer % 100), 2);
-            integer /= 100;
-        }
-        if (integer < 10)
-        {
-            index -= 1;
-            chars[index] = '0' + integer;
-
-            return this->Append(chars + index);
-        }
-        index -= 2;
-        memcpy(chars + index, digits2(integer), 2);
-        this->Append(chars + index);
-        return this;
+        char chars[NUMBER_FORMAT_MAX_INTEGER_LENGTH];
+        return this->Append(chars, FormatU64(chars, integer));
     }
+    //the shortest text that reads back as the same value
     inline string *Append(double value)
     {
-        if (value == 0.0)
-        {
-            return this->Append("0.0");
-        }
-        char chars[16];
-        i32 result = snprintf(chars, 16, "%lf", value);
-        if (result >= 16)
-        {
-            result = 16;
-        }
-        chars[result - 1] = '\0';
-        this->Append(chars);
-        return this;
+        char chars[NUMBER_FORMAT_MAX_FLOAT_LENGTH];
+        return this->Append(chars, FormatDouble(chars, value));
     }
     inline string *Append(float value)
     {
-        if (value == 0.0f)
-        {
-            return this->Append("0.0");
-        }
-        char chars[16];
-        i32 result = snprintf(chars, 16, "%f", value);
-        if (result >= 16)
-        {
-            result = 16;
-        }
-        chars[result - 1] = '\0';
-        this->Append(chars);
-        return this;
+        char chars[NUMBER_FORMAT_MAX_FLOAT_LENGTH];
+        return this->Append(chars, FormatFloat(chars, value));
     }
 
     inline string *PrependDeinit(string other)
@@ -447,36 +374,47 @@ inline bool stringEql(string A, string B)
 
 inline u32 stringHash(string A)
 {
-    if (A.buffer == NULL)
+    if (A.buffer == NULL || A.length == 0)
     {
         return 7;
     }
-    u32 hash = 7;
-    for (usize i = 0; i < A.length - 1; i++)
-    {
-        hash = hash * 31 + A.buffer[i];
-    }
-
-    return hash;
+    return (u32)Hash64(A.buffer, A.length - 1);
 }
 
-inline u32 charHash(const char *A)
+//Seeded hashing policy for string keys. Give each map its own seed
+//when the keys come from untrusted input, such as Json files
+struct StringHasher
 {
-    u32 hash = 7;
-    usize i = 0;
-    while (true)
+    u64 seed;
+
+    inline StringHasher(u64 seed = HASH64_DEFAULT_SEED)
     {
-        if (A[i] == '\0')
+        this->seed = seed;
+    }
+    inline u64 Hash(string A)
+    {
+        if (A.buffer == NULL || A.length == 0)
         {
-            break;
+            return seed;
         }
-        else
+        return Hash64Seeded(A.buffer, A.length - 1, seed);
+    }
+};
+struct StringEql
+{
+    inline bool Equals(string A, string B)
+    {
+        if (A.buffer == NULL || B.buffer == NULL)
         {
-            hash = hash * 31 + A[i];
+            return A.buffer == B.buffer;
         }
-        i += 1;
+        return A.length == B.length && memcmp(A.buffer, B.buffer, A.length) == 0;
     }
-    return hash;
+};
+
+inline u32 charHash(const char *A)
+{
+    return (u32)Hash64(A, strlen(A));
 }
 
 inline option<usize> FindFirst(const char *buffer, char character)
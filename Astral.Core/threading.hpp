@@ -14,6 +14,11 @@ namespace threading
     void SetAllSignalled(ConditionVariable variable);
     void ExitSignalled(ConditionVariable variable);
     void AwaitSignalled(ConditionVariable variable, u64 timeout);
+    def_delegate(WaitPredicate, bool, void*);
+    /// @brief Sleeps on the variable only if shouldWait(context) returns true, with the check made under the variable's lock so that a SetSignalled issued after the check cannot be missed.
+    /// Unlike AwaitSignalled, the lock is always released before returning. A timeout of 0 waits indefinitely
+    /// @returns whether the thread went to sleep
+    bool AwaitSignalledIf(ConditionVariable variable, WaitPredicate shouldWait, void *context, u64 timeout);
 
     ThreadLock CreateThreadLock();
     void DestroyThreadLock(ThreadLock lock);
@@ -21,6 +26,8 @@ namespace threading
     void UnlockThreadLock(ThreadLock lock);
 
     void YieldThread();
+    //Number of logical processors available to the process
+    u32 GetHardwareThreadCount();
 
 #ifdef POSIX
 #define THREAD_RESULT void*
@@ -31,6 +38,11 @@ namespace threading
 
     def_delegate(ThreadFunc, THREAD_RESULT, void*);
     Thread StartThread(ThreadFunc func, void *inputArgs);
+    /// @brief Blocks until the thread returns from its function, then frees the handle.
+    /// Prefer this over ShutdownThread, having the thread check a flag and return on its own
+    void JoinThread(Thread thread);
+    /// @brief Forcibly stops the thread and frees the handle without waiting for it. Any locks it held are never released.
+    /// On POSIX the thread only stops at its next cancellation point, so one in a pure compute loop keeps running
     void ShutdownThread(Thread thread);
 }
 
@@ -61,12 +73,10 @@ namespace threading
 
     ConditionVariable CreateConditionVariable()
     {
-        ConditionVariableImpl result;
-        InitializeConditionVariable(&result.handle);
-        InitializeCriticalSection(&result.criticalSection);
-
+        //critical sections cannot be moved once initialized, so initialize them in place
         ConditionVariable ptr = (ConditionVariable)malloc(sizeof(ConditionVariableImpl));
-        *ptr = result;
+        InitializeConditionVariable(&ptr->handle);
+        InitializeCriticalSection(&ptr->criticalSection);
         return ptr;
     }
     void DestroyConditionVariable(ConditionVariable variable)
@@ -76,11 +86,15 @@ namespace threading
     }
     void SetSignalled(ConditionVariable variable)
     {
+        EnterCriticalSection(&variable->criticalSection);
         WakeConditionVariable(&variable->handle);
+        LeaveCriticalSection(&variable->criticalSection);
     }
     void SetAllSignalled(ConditionVariable variable)
     {
+        EnterCriticalSection(&variable->criticalSection);
         WakeAllConditionVariable(&variable->handle);
+        LeaveCriticalSection(&variable->criticalSection);
     }
     void ExitSignalled(ConditionVariable variable)
     {
@@ -95,10 +109,27 @@ namespace threading
             LeaveCriticalSection(&variable->criticalSection);
         }
     }
+    bool AwaitSignalledIf(ConditionVariable variable, WaitPredicate shouldWait, void *context, u64 timeout)
+    {
+        EnterCriticalSection(&variable->criticalSection);
+        bool waited = shouldWait(context);
+        if (waited)
+        {
+            SleepConditionVariableCS(&variable->handle, &variable->criticalSection, timeout == 0 ? INFINITE : (DWORD)timeout);
+        }
+        LeaveCriticalSection(&variable->criticalSection);
+        return waited;
+    }
     void YieldThread()
     {
         SwitchToThread();
     }
+    u32 GetHardwareThreadCount()
+    {
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+        return info.dwNumberOfProcessors > 0 ? (u32)info.dwNumberOfProcessors : 1;
+    }
 
     ThreadLock CreateThreadLock()
     {
@@ -126,16 +157,26 @@ namespace threading
         thread->handle = CreateThread(NULL, 0, func, inputArgs, 0, NULL);
         return thread;
     }
+    void JoinThread(Thread thread)
+    {
+        WaitForSingleObject(thread->handle, INFINITE);
+        CloseHandle(thread->handle);
+        free(thread);
+    }
     void ShutdownThread(Thread thread)
     {
         TerminateThread(thread->handle, 0);
+        CloseHandle(thread->handle);
         free(thread);
     }
 }
 
 #endif
 #ifdef POSIX
-#include "pthreads.h"
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
 
 namespace threading
 {
@@ -155,12 +196,10 @@ namespace threading
 
     ConditionVariable CreateConditionVariable()
     {
-        ConditionVariableImpl result;
-        pthread_cond_init(&result->handle, NULL);
-        pthread_mutex_init(&result->mutex, NULL);
-
+        //pthread objects may not be copied once initialized, so initialize them in place
         ConditionVariable ptr = (ConditionVariable)malloc(sizeof(ConditionVariableImpl));
-        *ptr = result;
+        pthread_cond_init(&ptr->handle, NULL);
+        pthread_mutex_init(&ptr->mutex, NULL);
         return ptr;
     }
     void DestroyConditionVariable(ConditionVariable variable)
@@ -193,6 +232,42 @@ namespace threading
             pthread_mutex_unlock(&variable->mutex);
         }
     }
+    bool AwaitSignalledIf(ConditionVariable variable, WaitPredicate shouldWait, void *context, u64 timeout)
+    {
+        pthread_mutex_lock(&variable->mutex);
+        bool waited = shouldWait(context);
+        if (waited)
+        {
+            if (timeout == 0)
+            {
+                pthread_cond_wait(&variable->handle, &variable->mutex);
+            }
+            else
+            {
+                struct timespec deadline;
+                clock_gettime(CLOCK_REALTIME, &deadline);
+                deadline.tv_sec += (time_t)(timeout / 1000);
+                deadline.tv_nsec += (long)((timeout % 1000) * 1000000);
+                if (deadline.tv_nsec >= 1000000000)
+                {
+                    deadline.tv_sec += 1;
+                    deadline.tv_nsec -= 1000000000;
+                }
+                pthread_cond_timedwait(&variable->handle, &variable->mutex, &deadline);
+            }
+        }
+        pthread_mutex_unlock(&variable->mutex);
+        return waited;
+    }
+    void YieldThread()
+    {
+        sched_yield();
+    }
+    u32 GetHardwareThreadCount()
+    {
+        long count = sysconf(_SC_NPROCESSORS_ONLN);
+        return count > 0 ? (u32)count : 1;
+    }
 
     ThreadLock CreateThreadLock()
     {
@@ -220,9 +295,16 @@ namespace threading
         pthread_create(&thread->handle, NULL, func, inputArgs);
         return thread;
     }
+    void JoinThread(Thread thread)
+    {
+        pthread_join(thread->handle, NULL);
+        free(thread);
+    }
     void ShutdownThread(Thread thread)
     {
-        pthread_cancel(&thread->handle);
+        //a thread that never reaches a cancellation point would never be joined, so it is left to be cleaned up whenever it does stop
+        pthread_cancel(thread->handle);
+        pthread_detach(thread->handle);
         free(thread);
     }
 }
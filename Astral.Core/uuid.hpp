@@ -103,7 +103,7 @@ struct uuid
     }
     inline u32 GetHashCode()
     {
-        return Murmur3(byte, 16);
+        return (u32)Hash64(byte, 16);
     }
     inline void GetAsString(char* buffer)
     {